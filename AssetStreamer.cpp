@@ -0,0 +1,65 @@
+#include "AssetStreamer.h"
+
+AssetStreamer::AssetStreamer() : m_Running(true), m_InFlight(0) {
+    m_Worker = std::thread(&AssetStreamer::WorkerLoop, this);
+}
+
+AssetStreamer::~AssetStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Running = false;
+    }
+    m_Cond.notify_all();
+    if (m_Worker.joinable()) m_Worker.join();
+}
+
+void AssetStreamer::RequestModel(const std::string& path, Callback onLoaded) {
+    auto job = std::make_unique<Job>();
+    job->path = path;
+    job->onLoaded = std::move(onLoaded);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Requests.push_back(std::move(job));
+    }
+    m_InFlight++;
+    m_Cond.notify_one();
+}
+
+void AssetStreamer::Update(unsigned int maxUploads) {
+    for (unsigned int i = 0; i < maxUploads; ++i) {
+        std::unique_ptr<Job> job;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Completed.empty()) return;
+            job = std::move(m_Completed.front());
+            m_Completed.pop_front();
+        }
+
+        // GL上传只能在主线程进行
+        std::shared_ptr<Model> model;
+        if (job->ok)
+            model = std::make_shared<Model>(job->data);
+        else
+            model = std::make_shared<Model>(job->path.c_str()); // 缓存缺失时同步导入
+        m_InFlight--;
+        job->onLoaded(model);
+    }
+}
+
+void AssetStreamer::WorkerLoop() {
+    while (true) {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Cond.wait(lock, [this] { return !m_Running || !m_Requests.empty(); });
+            if (!m_Running) return;
+            job = std::move(m_Requests.front());
+            m_Requests.pop_front();
+        }
+
+        job->ok = Model::DecodeCooked(job->path, job->data);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Completed.push_back(std::move(job));
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "Model.h"
+
+// 后台资源流送：工作线程解码烘焙模型和纹理，主线程按帧预算上传GL对象
+class AssetStreamer {
+public:
+    using Callback = std::function<void(std::shared_ptr<Model>)>;
+
+    AssetStreamer();
+    ~AssetStreamer();
+
+    // 请求异步加载模型；完成后在主线程的Update中回调
+    void RequestModel(const std::string& path, Callback onLoaded);
+
+    // 主线程每帧调用，最多上传maxUploads个完成的模型
+    void Update(unsigned int maxUploads = 1);
+
+    size_t PendingCount() const { return m_InFlight; }
+
+private:
+    struct Job {
+        std::string path;
+        Callback onLoaded;
+        ModelData data;
+        bool ok = false;
+    };
+
+    std::thread m_Worker;
+    std::atomic<bool> m_Running;
+    std::atomic<size_t> m_InFlight;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Cond;
+    std::deque<std::unique_ptr<Job>> m_Requests;
+    std::deque<std::unique_ptr<Job>> m_Completed;
+
+    void WorkerLoop();
+};
@@ -0,0 +1,109 @@
+#include "BindlessTextures.h"
+#include <cstring>
+#include <iostream>
+
+BindlessTextures& BindlessTextures::Get() {
+    static BindlessTextures instance;
+    return instance;
+}
+
+const std::vector<std::string>& BindlessTextures::ShaderDefines() {
+    static const std::vector<std::string> defines = { "BINDLESS", "GLSL_VERSION 400" };
+    return defines;
+}
+
+bool BindlessTextures::Init(GLADloadproc getProc) {
+    // 着色器需要GLSL 4.00（BINDLESS变体改写#version），3.3上下文即使报告扩展也不使用
+    GLint major = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    if (major < 4) {
+        std::cout << "BINDLESS: OpenGL 4.0 context required, using texture binding" << std::endl;
+        return false;
+    }
+
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    bool supported = false;
+    for (GLint i = 0; i < count && !supported; ++i) {
+        const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        supported = name && std::strcmp(name, "GL_ARB_bindless_texture") == 0;
+    }
+    if (!supported) {
+        std::cout << "BINDLESS: GL_ARB_bindless_texture not supported, using texture binding" << std::endl;
+        return false;
+    }
+
+    m_GetTextureHandle = (PFNGETTEXTUREHANDLEPROC)getProc("glGetTextureHandleARB");
+    m_MakeResident = (PFNMAKEHANDLERESIDENTPROC)getProc("glMakeTextureHandleResidentARB");
+    m_MakeNonResident = (PFNMAKEHANDLERESIDENTPROC)getProc("glMakeTextureHandleNonResidentARB");
+    if (!m_GetTextureHandle || !m_MakeResident || !m_MakeNonResident) {
+        std::cout << "BINDLESS: failed to load extension functions, using texture binding" << std::endl;
+        return false;
+    }
+
+    m_Handles.assign(MAX_HANDLES, 0);
+    for (int i = MAX_HANDLES - 1; i >= 0; --i)
+        m_FreeSlots.push_back(i);
+
+    glGenBuffers(1, &m_UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+    glBufferData(GL_UNIFORM_BUFFER, MAX_HANDLES * sizeof(GLuint64), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, UBO_BINDING, m_UBO);
+
+    m_Enabled = true;
+    std::cout << "BINDLESS: using resident texture handles" << std::endl;
+    return true;
+}
+
+int BindlessTextures::Register(GLuint id) {
+    if (!m_Enabled) return -1;
+    auto it = m_Slots.find(id);
+    if (it != m_Slots.end()) return it->second;
+    if (m_FreeSlots.empty()) {
+        std::cout << "BINDLESS: handle table full, texture " << id << " not registered" << std::endl;
+        return -1;
+    }
+
+    GLuint64 handle = m_GetTextureHandle(id);
+    if (!handle) return -1;
+    m_MakeResident(handle);
+
+    int slot = m_FreeSlots.back();
+    m_FreeSlots.pop_back();
+    m_Handles[slot] = handle;
+    m_Slots[id] = slot;
+    m_Dirty = true;
+    return slot;
+}
+
+void BindlessTextures::Unregister(GLuint id) {
+    auto it = m_Slots.find(id);
+    if (it == m_Slots.end()) return;
+    m_MakeNonResident(m_Handles[it->second]);
+    m_Handles[it->second] = 0;
+    m_FreeSlots.push_back(it->second);
+    m_Slots.erase(it);
+    m_Dirty = true;
+}
+
+int BindlessTextures::GetIndex(GLuint id) const {
+    auto it = m_Slots.find(id);
+    return it == m_Slots.end() ? -1 : it->second;
+}
+
+bool BindlessTextures::Apply(const Shader& shader) {
+    if (!m_Enabled) return false;
+    GLuint block = glGetUniformBlockIndex(shader.ID, "TextureHandles");
+    if (block == GL_INVALID_INDEX) return false;
+    glUniformBlockBinding(shader.ID, block, UBO_BINDING);
+
+    if (m_Dirty) {
+        // std140下uvec4数组与GLuint64数组的内存布局一致（每元素两个句柄）
+        glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, m_Handles.size() * sizeof(GLuint64), m_Handles.data());
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        m_Dirty = false;
+    }
+    return true;
+}
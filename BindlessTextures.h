@@ -0,0 +1,50 @@
+#pragma once
+#include <glad/glad.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Shader.h"
+
+// ARB_bindless_texture后端：每张纹理一个常驻的64位句柄，句柄表放在UBO里，
+// 着色器（BINDLESS变体）按下标取句柄构造采样器，绘制时不再绑定纹理单元
+// glad只生成了核心函数，扩展函数在Init中手动加载；不支持时保持原来的绑定路径
+// BINDLESS变体以GLSL 4.00编译（ShaderDefines），没有句柄的纹理（下标-1）在同一次绘制中仍走绑定路径
+class BindlessTextures {
+public:
+    static const int MAX_HANDLES = 2048;        // 1024个uvec4 = 16KB，UBO最小保证大小
+    static const GLuint UBO_BINDING = 0;
+    // Init成功后加入着色器宏：启用句柄采样并把#version提升到400
+    static const std::vector<std::string>& ShaderDefines();
+
+    static BindlessTextures& Get();
+
+    // 查询扩展并加载函数指针（getProc与gladLoadGLLoader使用的相同）
+    bool Init(GLADloadproc getProc);
+    bool IsEnabled() const { return m_Enabled; }
+
+    // 创建句柄并常驻；纹理参数此后不可再修改。返回句柄表下标，失败返回-1
+    int Register(GLuint id);
+    // 删除纹理前调用
+    void Unregister(GLuint id);
+    int GetIndex(GLuint id) const;
+
+    // 上传变化的句柄表并绑定到着色器的TextureHandles块；着色器不是BINDLESS变体时返回false
+    bool Apply(const Shader& shader);
+
+private:
+    BindlessTextures() = default;
+
+    typedef GLuint64(APIENTRYP PFNGETTEXTUREHANDLEPROC)(GLuint texture);
+    typedef void (APIENTRYP PFNMAKEHANDLERESIDENTPROC)(GLuint64 handle);
+
+    PFNGETTEXTUREHANDLEPROC m_GetTextureHandle = nullptr;
+    PFNMAKEHANDLERESIDENTPROC m_MakeResident = nullptr;
+    PFNMAKEHANDLERESIDENTPROC m_MakeNonResident = nullptr;
+
+    bool m_Enabled = false;
+    bool m_Dirty = false;
+    GLuint m_UBO = 0;
+    std::vector<GLuint64> m_Handles;
+    std::vector<int> m_FreeSlots;
+    std::unordered_map<GLuint, int> m_Slots;
+};
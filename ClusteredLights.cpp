@@ -0,0 +1,383 @@
+#include "ClusteredLights.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define CLUSTER_USE_SSE 1
+#endif
+
+ClusteredLights::ClusteredLights(int workerThreads) : m_Overflow(0) {
+    // 纹理缓冲：光源表（RGBA32F，每个光源6个纹素）
+    glGenBuffers(1, &m_LightBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_LightBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, MAX_LIGHTS * sizeof(GPULight), nullptr, GL_STREAM_DRAW);
+    glGenTextures(1, &m_LightTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, m_LightTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_LightBuffer);
+
+    // 每簇(偏移, 数量)
+    glGenBuffers(1, &m_GridBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_GridBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, CLUSTER_COUNT * sizeof(glm::uvec2), nullptr, GL_STREAM_DRAW);
+    glGenTextures(1, &m_GridTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, m_GridTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, m_GridBuffer);
+
+    // 紧凑的光源下标（16位，MAX_LIGHTS < 65536），容量不足时按需扩大
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    m_MaxTexels = (size_t)std::max(maxTexels, 65536);
+    m_IndexCapacity = std::min((size_t)CLUSTER_COUNT * 16, m_MaxTexels);
+    glGenBuffers(1, &m_IndexBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_IndexBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, m_IndexCapacity * sizeof(uint16_t), nullptr, GL_STREAM_DRAW);
+    glGenTextures(1, &m_IndexTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, m_IndexTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R16UI, m_IndexBuffer);
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    m_ClusterItems.resize((size_t)CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER);
+    m_ClusterCounts.assign(CLUSTER_COUNT, 0);
+    m_Grid.resize(CLUSTER_COUNT);
+    for (auto* bounds : { &m_MinX, &m_MinY, &m_MinZ, &m_MaxX, &m_MaxY, &m_MaxZ })
+        bounds->assign(CLUSTER_COUNT + 4, 0.0f);
+
+    // 主线程处理第0段，其余段由工作线程处理
+    int threads = workerThreads >= 0 ? workerThreads : (int)std::thread::hardware_concurrency() - 1;
+    threads = std::max(0, std::min(threads, SLICES - 1));
+    for (int i = 0; i < threads; ++i)
+        m_Workers.emplace_back(&ClusteredLights::WorkerLoop, this, i + 1);
+}
+
+ClusteredLights::~ClusteredLights() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Running = false;
+    }
+    m_StartCond.notify_all();
+    for (auto& worker : m_Workers)
+        worker.join();
+}
+
+// ================== 光源 ==================
+void ClusteredLights::Clear() {
+    m_Lights.clear();
+}
+
+int ClusteredLights::AddLight(const GPULight& light) {
+    if ((int)m_Lights.size() >= MAX_LIGHTS) return -1;
+    m_Lights.push_back(light);
+    return (int)m_Lights.size() - 1;
+}
+
+int ClusteredLights::AddPointLight(const PointLight& light, int shadowTile) {
+    GPULight gpu;
+    float range = AttenuationRange(light.constant, light.linear, light.quadratic, light.diffuse);
+    gpu.positionRange = glm::vec4(light.position, range);
+    gpu.diffuseType = glm::vec4(light.diffuse, 0.0f);
+    gpu.specularShadow = glm::vec4(light.specular, (float)shadowTile);
+    gpu.ambientCosInner = glm::vec4(light.ambient, 1.0f);
+    gpu.directionCosOuter = glm::vec4(0.0f, 0.0f, -1.0f, -1.0f);
+    gpu.attenuation = glm::vec4(light.constant, light.linear, light.quadratic, 0.0f);
+    return AddLight(gpu);
+}
+
+int ClusteredLights::AddSpotLight(const SpotLight& light, int shadowTile) {
+    GPULight gpu;
+    float range = AttenuationRange(light.constant, light.linear, light.quadratic, light.diffuse);
+    gpu.positionRange = glm::vec4(light.position, range);
+    gpu.diffuseType = glm::vec4(light.diffuse, 1.0f);
+    gpu.specularShadow = glm::vec4(light.specular, (float)shadowTile);
+    gpu.ambientCosInner = glm::vec4(light.ambient, light.cutOff);
+    gpu.directionCosOuter = glm::vec4(glm::normalize(light.direction), light.outerCutOff);
+    gpu.attenuation = glm::vec4(light.constant, light.linear, light.quadratic, 0.0f);
+    return AddLight(gpu);
+}
+
+// ================== 簇划分 ==================
+int ClusteredLights::SliceOf(float depth) const {
+    if (depth <= m_Near) return 0;
+    int slice = (int)std::floor(std::log(depth) * m_DepthScale + m_DepthBias);
+    return std::max(0, std::min(slice, SLICES - 1));
+}
+
+// 投影变化时重建：每个簇取tile四角射线在层近/远深度处的8个点的AABB
+void ClusteredLights::BuildClusters() {
+    float logRatio = std::log(m_Far / m_Near);
+    m_DepthScale = (float)SLICES / logRatio;
+    m_DepthBias = -(float)SLICES * std::log(m_Near) / logRatio;
+
+    // tile角点在NDC近平面上的射线（视空间，z = -1）
+    glm::mat4 invProjection = glm::inverse(m_Projection);
+    std::vector<glm::vec3> rays((TILES_X + 1) * (TILES_Y + 1));
+    for (int y = 0; y <= TILES_Y; ++y) {
+        for (int x = 0; x <= TILES_X; ++x) {
+            glm::vec4 p = invProjection * glm::vec4(-1.0f + 2.0f * x / TILES_X, -1.0f + 2.0f * y / TILES_Y, -1.0f, 1.0f);
+            glm::vec3 v = glm::vec3(p) / p.w;
+            rays[y * (TILES_X + 1) + x] = v / -v.z;
+        }
+    }
+
+    for (int z = 0; z < SLICES; ++z) {
+        float zNear = m_Near * std::pow(m_Far / m_Near, (float)z / SLICES);
+        float zFar = m_Near * std::pow(m_Far / m_Near, (float)(z + 1) / SLICES);
+        for (int y = 0; y < TILES_Y; ++y) {
+            for (int x = 0; x < TILES_X; ++x) {
+                glm::vec3 bmin(FLT_MAX), bmax(-FLT_MAX);
+                for (int corner = 0; corner < 4; ++corner) {
+                    const glm::vec3& ray = rays[(y + (corner >> 1)) * (TILES_X + 1) + x + (corner & 1)];
+                    for (float depth : { zNear, zFar }) {
+                        glm::vec3 p = ray * depth;
+                        bmin = glm::min(bmin, p);
+                        bmax = glm::max(bmax, p);
+                    }
+                }
+                int c = x + TILES_X * (y + TILES_Y * z);
+                m_MinX[c] = bmin.x; m_MinY[c] = bmin.y; m_MinZ[c] = bmin.z;
+                m_MaxX[c] = bmax.x; m_MaxY[c] = bmax.y; m_MaxZ[c] = bmax.z;
+            }
+        }
+    }
+}
+
+// 视空间包围球及其覆盖的tile/层范围；minZ > maxZ表示在视锥外
+void ClusteredLights::ComputeSphere(const GPULight& light, const glm::mat4& view, CullSphere& sphere) const {
+    glm::vec3 position = glm::vec3(light.positionRange);
+    float range = light.positionRange.w;
+    glm::vec3 center = position;
+    float radius = range;
+    if (light.diffuseType.w > 0.5f) {
+        // 聚光灯：锥体的最小包围球（张角超过90度时退回整球）
+        glm::vec3 direction = glm::vec3(light.directionCosOuter);
+        float cosOuter = light.directionCosOuter.w;
+        if (cosOuter > 0.7071f) {
+            radius = range / (2.0f * cosOuter);
+            center = position + direction * radius;
+        }
+        else if (cosOuter > 0.0f) {
+            radius = range * std::sqrt(1.0f - cosOuter * cosOuter);
+            center = position + direction * (range * cosOuter);
+        }
+    }
+
+    sphere.center = glm::vec3(view * glm::vec4(center, 1.0f));
+    sphere.radius = radius;
+    sphere.minX = sphere.minY = sphere.minZ = 0;
+    sphere.maxX = TILES_X - 1;
+    sphere.maxY = TILES_Y - 1;
+    sphere.maxZ = -1;
+
+    float depth = -sphere.center.z;
+    if (radius <= 0.0f || depth + radius < m_Near || depth - radius > m_Far) return;
+    sphere.minZ = SliceOf(depth - radius);
+    sphere.maxZ = SliceOf(depth + radius);
+
+    // 整个球在近平面之前时，投影包围盒的8个角求屏幕范围；否则覆盖所有tile
+    if (depth - radius > m_Near) {
+        glm::vec2 ndcMin(FLT_MAX), ndcMax(-FLT_MAX);
+        for (int corner = 0; corner < 8; ++corner) {
+            glm::vec3 offset((corner & 1) ? radius : -radius, (corner & 2) ? radius : -radius, (corner & 4) ? radius : -radius);
+            glm::vec4 clip = m_Projection * glm::vec4(sphere.center + offset, 1.0f);
+            glm::vec2 ndc = glm::vec2(clip) / clip.w;
+            ndcMin = glm::min(ndcMin, ndc);
+            ndcMax = glm::max(ndcMax, ndc);
+        }
+        if (ndcMax.x < -1.0f || ndcMax.y < -1.0f || ndcMin.x > 1.0f || ndcMin.y > 1.0f) {
+            sphere.maxZ = -1;
+            return;
+        }
+        sphere.minX = std::max(0, (int)std::floor((ndcMin.x * 0.5f + 0.5f) * TILES_X));
+        sphere.maxX = std::min(TILES_X - 1, (int)std::floor((ndcMax.x * 0.5f + 0.5f) * TILES_X));
+        sphere.minY = std::max(0, (int)std::floor((ndcMin.y * 0.5f + 0.5f) * TILES_Y));
+        sphere.maxY = std::min(TILES_Y - 1, (int)std::floor((ndcMax.y * 0.5f + 0.5f) * TILES_Y));
+    }
+}
+
+// 处理第partition段深度层：清空这些层的列表，再把与之相交的光源逐簇测试后写入
+void ClusteredLights::AssignSlices(int partition, int partitions) {
+    int sliceBegin = partition * SLICES / partitions;
+    int sliceEnd = (partition + 1) * SLICES / partitions;
+    std::fill(m_ClusterCounts.begin() + sliceBegin * TILES_X * TILES_Y,
+        m_ClusterCounts.begin() + sliceEnd * TILES_X * TILES_Y, 0);
+
+    int overflow = 0;
+    for (size_t i = 0; i < m_Spheres.size(); ++i) {
+        const CullSphere& s = m_Spheres[i];
+        int zBegin = std::max(s.minZ, sliceBegin);
+        int zEnd = std::min(s.maxZ + 1, sliceEnd);
+        if (zBegin >= zEnd) continue;
+        float radius2 = s.radius * s.radius;
+
+#ifdef CLUSTER_USE_SSE
+        const __m128 cx = _mm_set1_ps(s.center.x);
+        const __m128 cy = _mm_set1_ps(s.center.y);
+        const __m128 cz = _mm_set1_ps(s.center.z);
+        const __m128 r2 = _mm_set1_ps(radius2);
+        const __m128 zero = _mm_setzero_ps();
+#endif
+        for (int z = zBegin; z < zEnd; ++z) {
+            for (int y = s.minY; y <= s.maxY; ++y) {
+                int row = TILES_X * (y + TILES_Y * z);
+                for (int x = s.minX; x <= s.maxX; x += 4) {
+                    int c = row + x;
+                    int mask;
+#ifdef CLUSTER_USE_SSE
+                    // 点到AABB的距离平方，4个簇一组
+                    __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_MinX[c]), cx),
+                        _mm_sub_ps(cx, _mm_loadu_ps(&m_MaxX[c]))), zero);
+                    __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_MinY[c]), cy),
+                        _mm_sub_ps(cy, _mm_loadu_ps(&m_MaxY[c]))), zero);
+                    __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_MinZ[c]), cz),
+                        _mm_sub_ps(cz, _mm_loadu_ps(&m_MaxZ[c]))), zero);
+                    __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                    mask = _mm_movemask_ps(_mm_cmple_ps(d2, r2));
+#else
+                    mask = 0;
+                    for (int k = 0; k < 4; ++k) {
+                        float dx = std::max(std::max(m_MinX[c + k] - s.center.x, s.center.x - m_MaxX[c + k]), 0.0f);
+                        float dy = std::max(std::max(m_MinY[c + k] - s.center.y, s.center.y - m_MaxY[c + k]), 0.0f);
+                        float dz = std::max(std::max(m_MinZ[c + k] - s.center.z, s.center.z - m_MaxZ[c + k]), 0.0f);
+                        if (dx * dx + dy * dy + dz * dz <= radius2) mask |= 1 << k;
+                    }
+#endif
+                    // 超出本行范围的簇不计入
+                    int valid = s.maxX - x + 1;
+                    if (valid < 4) mask &= (1 << valid) - 1;
+                    for (int k = 0; mask; ++k, mask >>= 1) {
+                        if (!(mask & 1)) continue;
+                        int& count = m_ClusterCounts[c + k];
+                        if (count < MAX_LIGHTS_PER_CLUSTER)
+                            m_ClusterItems[(size_t)(c + k) * MAX_LIGHTS_PER_CLUSTER + count++] = (uint16_t)i;
+                        else
+                            ++overflow;
+                    }
+                }
+            }
+        }
+    }
+    if (overflow) m_Overflow += overflow;
+}
+
+void ClusteredLights::WorkerLoop(int partition) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while (true) {
+        m_StartCond.wait(lock, [&]() { return !m_Running || m_Generation != seen; });
+        if (!m_Running) return;
+        seen = m_Generation;
+        lock.unlock();
+        AssignSlices(partition, (int)m_Workers.size() + 1);
+        lock.lock();
+        if (--m_Pending == 0)
+            m_DoneCond.notify_one();
+    }
+}
+
+void ClusteredLights::Update(const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane,
+    int screenWidth, int screenHeight) {
+    auto start = std::chrono::high_resolution_clock::now();
+    if (projection != m_Projection || nearPlane != m_Near || farPlane != m_Far) {
+        m_Projection = projection;
+        m_Near = nearPlane;
+        m_Far = farPlane;
+        BuildClusters();
+    }
+    m_ScreenWidth = screenWidth;
+    m_ScreenHeight = screenHeight;
+
+    m_Spheres.resize(m_Lights.size());
+    for (size_t i = 0; i < m_Lights.size(); ++i)
+        ComputeSphere(m_Lights[i], view, m_Spheres[i]);
+
+    // 光源较少时直接在主线程分配，避免唤醒线程的开销
+    m_Overflow = 0;
+    if (m_Workers.empty() || m_Lights.size() < 64) {
+        AssignSlices(0, 1);
+    }
+    else {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            ++m_Generation;
+            m_Pending = (int)m_Workers.size();
+        }
+        m_StartCond.notify_all();
+        AssignSlices(0, (int)m_Workers.size() + 1);
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_DoneCond.wait(lock, [this]() { return m_Pending == 0; });
+    }
+
+    // 压缩为连续的下标表
+    m_Indices.clear();
+    m_MaxPerCluster = 0;
+    for (int c = 0; c < CLUSTER_COUNT; ++c) {
+        int count = m_ClusterCounts[c];
+        if (m_Indices.size() + count > m_MaxTexels) {
+            m_Overflow += count;
+            count = 0;
+        }
+        m_Grid[c] = glm::uvec2((unsigned int)m_Indices.size(), (unsigned int)count);
+        const uint16_t* items = &m_ClusterItems[(size_t)c * MAX_LIGHTS_PER_CLUSTER];
+        m_Indices.insert(m_Indices.end(), items, items + count);
+        m_MaxPerCluster = std::max(m_MaxPerCluster, count);
+    }
+    m_IndexCount = m_Indices.size();
+
+    // 上传（先重新分配存储，避免等待上一帧仍在使用的缓冲）
+    glBindBuffer(GL_TEXTURE_BUFFER, m_LightBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, MAX_LIGHTS * sizeof(GPULight), nullptr, GL_STREAM_DRAW);
+    if (!m_Lights.empty())
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, m_Lights.size() * sizeof(GPULight), m_Lights.data());
+
+    glBindBuffer(GL_TEXTURE_BUFFER, m_GridBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, CLUSTER_COUNT * sizeof(glm::uvec2), m_Grid.data(), GL_STREAM_DRAW);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, m_IndexBuffer);
+    if (m_Indices.size() > m_IndexCapacity)
+        m_IndexCapacity = std::min(std::max(m_Indices.size(), m_IndexCapacity * 2), m_MaxTexels);
+    glBufferData(GL_TEXTURE_BUFFER, m_IndexCapacity * sizeof(uint16_t), nullptr, GL_STREAM_DRAW);
+    if (!m_Indices.empty())
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, m_Indices.size() * sizeof(uint16_t), m_Indices.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    m_AssignMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void ClusteredLights::Apply(const Shader& shader) const {
+    glActiveTexture(GL_TEXTURE0 + LIGHT_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, m_LightTexture);
+    glActiveTexture(GL_TEXTURE0 + GRID_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, m_GridTexture);
+    glActiveTexture(GL_TEXTURE0 + INDEX_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, m_IndexTexture);
+    shader.setInt("clusterLights", LIGHT_UNIT);
+    shader.setInt("clusterGrid", GRID_UNIT);
+    shader.setInt("clusterIndices", INDEX_UNIT);
+    shader.setBool("clusteredLighting", true);
+    shader.setInt("clusterLightCount", (int)m_Lights.size());
+    shader.setVec2("clusterTileSize", glm::vec2((float)m_ScreenWidth / TILES_X, (float)m_ScreenHeight / TILES_Y));
+    shader.setVec2("clusterDepthParams", glm::vec2(m_DepthScale, m_DepthBias));
+}
+
+void ClusteredLights::PrintStats() const {
+    int overflow = m_Overflow;
+    std::cout << "CLUSTERED LIGHTS: " << m_Lights.size() << " lights | " << m_IndexCount << " indices in "
+        << CLUSTER_COUNT << " clusters (max " << m_MaxPerCluster << " per cluster) | "
+        << m_AssignMs << " ms assign+upload on " << (m_Workers.size() + 1) << " threads";
+    if (overflow) std::cout << " | " << overflow << " dropped (cluster full)";
+    std::cout << std::endl;
+}
+
+void ClusteredLights::Cleanup() {
+    glDeleteTextures(1, &m_LightTexture);
+    glDeleteTextures(1, &m_GridTexture);
+    glDeleteTextures(1, &m_IndexTexture);
+    glDeleteBuffers(1, &m_LightBuffer);
+    glDeleteBuffers(1, &m_GridBuffer);
+    glDeleteBuffers(1, &m_IndexBuffer);
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Light.h"
+#include "Shader.h"
+
+// 分簇前向渲染（clustered forward+）的光源剔除
+//   划分：视锥在屏幕上分TILES_X * TILES_Y个tile，深度按指数分SLICES层（近处更细），每个簇一个视空间AABB
+//   分配：CPU上按光源的包围球（聚光灯为锥体的包围球）先求tile/层的范围，再逐簇做球-AABB测试（SSE一次4个簇），
+//         按深度层划分给多个线程，每个簇的列表只由一个线程写入
+//   上传：光源表、每簇(偏移, 数量)和紧凑的光源下标表放在纹理缓冲（samplerBuffer/usamplerBuffer）中，
+//         shader.frag/pbr.frag按片段所在的簇只遍历相关光源
+//   每帧：Clear后重新Add全部局部光源，再用当前相机Update
+class ClusteredLights {
+public:
+    static const int TILES_X = 16;
+    static const int TILES_Y = 9;
+    static const int SLICES = 24;
+    static const int CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+    static const int MAX_LIGHTS = 4096;
+    static const int MAX_LIGHTS_PER_CLUSTER = 128;
+    static const GLuint LIGHT_UNIT = 16;    // 纹理缓冲的纹理单元（阴影/IBL占用到15；启动时检查GL_MAX_TEXTURE_IMAGE_UNITS）
+    static const GLuint GRID_UNIT = 17;
+    static const GLuint INDEX_UNIT = 18;
+
+    // workerThreads < 0时按CPU核数
+    explicit ClusteredLights(int workerThreads = -1);
+    ~ClusteredLights();
+
+    void Clear();
+    // 返回光源下标，超出MAX_LIGHTS时返回-1；shadowTile为阴影图集中的首个tile
+    int AddPointLight(const PointLight& light, int shadowTile = -1);
+    int AddSpotLight(const SpotLight& light, int shadowTile = -1);
+    int GetLightCount() const { return (int)m_Lights.size(); }
+
+    // 按相机参数划分簇、分配光源并上传
+    void Update(const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane,
+        int screenWidth, int screenHeight);
+    // 绑定纹理缓冲并设置簇参数（clusteredLighting = true）
+    void Apply(const Shader& shader) const;
+
+    void PrintStats() const;
+    void Cleanup();
+
+private:
+    // 与着色器FetchLight对应：每个光源6个RGBA32F纹素
+    struct GPULight {
+        glm::vec4 positionRange;     // xyz 位置，w 范围
+        glm::vec4 diffuseType;       // rgb 漫反射，w 类型（0 点光源，1 聚光灯）
+        glm::vec4 specularShadow;    // rgb 镜面，w 阴影tile（-1为无阴影）
+        glm::vec4 ambientCosInner;   // rgb 环境光，w 内锥角余弦
+        glm::vec4 directionCosOuter; // xyz 方向，w 外锥角余弦
+        glm::vec4 attenuation;       // constant, linear, quadratic, 0
+    };
+
+    // 分配用：视空间包围球和深度层范围
+    struct CullSphere {
+        glm::vec3 center;
+        float radius;
+        int minX, maxX, minY, maxY, minZ, maxZ;
+    };
+
+    std::vector<GPULight> m_Lights;
+    std::vector<CullSphere> m_Spheres;
+
+    // 簇的视空间AABB（SoA，末尾留4个元素的余量供SSE整组读取）
+    std::vector<float> m_MinX, m_MinY, m_MinZ, m_MaxX, m_MaxY, m_MaxZ;
+    glm::mat4 m_Projection = glm::mat4(0.0f);
+    float m_Near = 0.0f, m_Far = 0.0f;
+    int m_ScreenWidth = 0, m_ScreenHeight = 0;
+    float m_DepthScale = 0.0f, m_DepthBias = 0.0f;   // slice = log(depth) * scale + bias
+
+    // 每簇的临时列表（MAX_LIGHTS_PER_CLUSTER个槽）和紧凑结果
+    std::vector<uint16_t> m_ClusterItems;
+    std::vector<int> m_ClusterCounts;
+    std::vector<glm::uvec2> m_Grid;
+    std::vector<uint16_t> m_Indices;
+    std::atomic<int> m_Overflow;     // 簇已满丢弃的条目数
+
+    // 上一帧统计
+    float m_AssignMs = 0.0f;
+    size_t m_IndexCount = 0;
+    int m_MaxPerCluster = 0;
+
+    GLuint m_LightBuffer = 0, m_LightTexture = 0;
+    GLuint m_GridBuffer = 0, m_GridTexture = 0;
+    GLuint m_IndexBuffer = 0, m_IndexTexture = 0;
+    size_t m_IndexCapacity = 0;
+    size_t m_MaxTexels = 0;
+
+    // 工作线程：每帧按代号唤醒，各自处理一段深度层
+    std::vector<std::thread> m_Workers;
+    std::mutex m_Mutex;
+    std::condition_variable m_StartCond;
+    std::condition_variable m_DoneCond;
+    uint64_t m_Generation = 0;
+    int m_Pending = 0;
+    bool m_Running = true;
+
+    int AddLight(const GPULight& light);
+    void BuildClusters();
+    void ComputeSphere(const GPULight& light, const glm::mat4& view, CullSphere& sphere) const;
+    int SliceOf(float depth) const;
+    void AssignSlices(int partition, int partitions);
+    void WorkerLoop(int partition);
+};
@@ -0,0 +1,128 @@
+#include "DeferredRenderer.h"
+#include <iostream>
+#include "ResidencyManager.h"
+
+static GLuint CreateTarget(GLenum internalFormat, GLenum format, GLenum type, int width, int height) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+    // 光照阶段按像素texelFetch，不需要过滤
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+DeferredRenderer::DeferredRenderer(int width, int height)
+    : m_Width(width), m_Height(height) {
+    glGenVertexArrays(1, &m_EmptyVAO);
+    m_LightingShader = std::make_unique<Shader>("shaders/fullscreen.vert", "shaders/deferred_lighting.frag");
+    CreateTargets();
+}
+
+void DeferredRenderer::CreateTargets() {
+    albedoTexture = CreateTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, m_Width, m_Height);
+    normalTexture = CreateTarget(GL_RGBA16, GL_RGBA, GL_UNSIGNED_SHORT, m_Width, m_Height);
+    emissionTexture = CreateTarget(GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, m_Width, m_Height);
+    depthTexture = CreateTarget(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT, m_Width, m_Height);
+
+    glGenFramebuffers(1, &gBufferFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, gBufferFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, emissionTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    const GLenum drawBuffers[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    glDrawBuffers(3, drawBuffers);
+
+    // 检查帧缓冲完整性
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR::DEFERRED: G-buffer not complete!" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    ResidencyManager& residency = ResidencyManager::Get();
+    residency.TrackTexture(albedoTexture, ResidencyManager::TextureBytes(m_Width, m_Height, 4, false), "G-buffer albedo");
+    residency.TrackTexture(normalTexture, ResidencyManager::TextureBytes(m_Width, m_Height, 8, false), "G-buffer normal");
+    residency.TrackTexture(emissionTexture, ResidencyManager::TextureBytes(m_Width, m_Height, 4, false), "G-buffer emission");
+    residency.TrackTexture(depthTexture, ResidencyManager::TextureBytes(m_Width, m_Height, 4, false), "G-buffer depth");
+}
+
+void DeferredRenderer::DestroyTargets() {
+    ResidencyManager& residency = ResidencyManager::Get();
+    GLuint textures[4] = { albedoTexture, normalTexture, emissionTexture, depthTexture };
+    for (GLuint texture : textures)
+        residency.UntrackTexture(texture);
+    glDeleteTextures(4, textures);
+    glDeleteFramebuffers(1, &gBufferFBO);
+    albedoTexture = normalTexture = emissionTexture = depthTexture = 0;
+    gBufferFBO = 0;
+}
+
+void DeferredRenderer::Resize(int width, int height) {
+    if (width == m_Width && height == m_Height) return;
+    if (width <= 0 || height <= 0) return;   // 最小化
+    DestroyTargets();
+    m_Width = width;
+    m_Height = height;
+    CreateTargets();
+}
+
+void DeferredRenderer::BeginGeometryPass() {
+    glBindFramebuffer(GL_FRAMEBUFFER, gBufferFBO);
+    glViewport(0, 0, m_Width, m_Height);
+    // 着色模型写在反照率的alpha中，几何阶段不能混合
+    m_BlendEnabled = glIsEnabled(GL_BLEND);
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    // 深度清为1（光照阶段据此跳过背景），颜色全部清零
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void DeferredRenderer::LightingPass(GLuint targetFBO, const glm::mat4& view, const glm::mat4& projection,
+    const glm::vec3& viewPos, const std::function<void(Shader&)>& applyLights) {
+    glBindFramebuffer(GL_FRAMEBUFFER, targetFBO);
+    glViewport(0, 0, m_Width, m_Height);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    glDisable(GL_DEPTH_TEST);
+
+    Shader& shader = *m_LightingShader;
+    shader.use();
+    const GLuint textures[4] = { albedoTexture, normalTexture, emissionTexture, depthTexture };
+    const GLuint units[4] = { ALBEDO_UNIT, NORMAL_UNIT, EMISSION_UNIT, DEPTH_UNIT };
+    for (int i = 0; i < 4; ++i) {
+        glActiveTexture(GL_TEXTURE0 + units[i]);
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+    }
+    shader.setInt("gAlbedo", ALBEDO_UNIT);
+    shader.setInt("gNormalMaterial", NORMAL_UNIT);
+    shader.setInt("gEmission", EMISSION_UNIT);
+    shader.setInt("gDepth", DEPTH_UNIT);
+    shader.setMat4("inverseViewProjection", glm::inverse(projection * view));
+    shader.setMat4("view", view);
+    shader.setVec3("viewPos", viewPos);
+    if (applyLights) applyLights(shader);
+
+    glBindVertexArray(m_EmptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    if (depthTest) glEnable(GL_DEPTH_TEST);
+    if (m_BlendEnabled) glEnable(GL_BLEND);
+}
+
+void DeferredRenderer::PrintStats() const {
+    size_t bytes = (size_t)m_Width * m_Height * (4 + 8 + 4 + 4);
+    std::cout << "DEFERRED: G-buffer " << m_Width << "x" << m_Height << ", "
+        << bytes / (1024.0f * 1024.0f) << " MB" << std::endl;
+}
+
+void DeferredRenderer::Cleanup() {
+    DestroyTargets();
+    glDeleteVertexArrays(1, &m_EmptyVAO);
+    m_EmptyVAO = 0;
+    m_LightingShader.reset();
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <functional>
+#include <memory>
+#include "Shader.h"
+
+// 延迟着色：几何阶段把表面属性写入紧凑的G-buffer，光照阶段对每个屏幕像素只计算一次
+//   G-buffer（编码见shaders/gbuffer.glsl，颜色16字节 + 深度4字节/像素）：
+//     0 RGBA8          反照率/漫反射色 + 着色模型（不受光/Phong/PBR）
+//     1 RGBA16         八面体编码法线 + 粗糙度/金属度（Phong为高光指数/强度）
+//     2 R11F_G11F_B10F 与光源无关的颜色（PBR的IBL环境光和天鹅绒项，按对象选择的探针在几何阶段采样）
+//     深度 DEPTH_COMPONENT24，光照阶段由深度和逆视图投影矩阵重建世界坐标
+//   几何阶段：shader.frag/pbr.frag的DEFERRED变体，材质采样与前向路径相同，只绘制不透明物体
+//   光照阶段：一个全屏三角形（deferred_lighting.frag），局部光源复用ClusteredLights的簇，
+//         每个像素只遍历所在簇的光源；阴影、Phong和PBR函数与前向着色器共用（#include）
+//   光照开销只与像素数和每簇光源数有关，与场景的三角形数量、过度绘制无关
+class DeferredRenderer {
+public:
+    // 光照阶段G-buffer的纹理单元（该程序没有材质纹理，阴影/分簇光源的单元不变）
+    static const GLuint ALBEDO_UNIT = 0;
+    static const GLuint NORMAL_UNIT = 1;
+    static const GLuint EMISSION_UNIT = 2;
+    static const GLuint DEPTH_UNIT = 3;
+
+    GLuint gBufferFBO = 0;
+    GLuint albedoTexture = 0;
+    GLuint normalTexture = 0;
+    GLuint emissionTexture = 0;
+    GLuint depthTexture = 0;
+
+    DeferredRenderer(int width, int height);
+
+    // 窗口尺寸变化时重建G-buffer
+    void Resize(int width, int height);
+    // 绑定并清空G-buffer，之后用DEFERRED变体绘制不透明物体（混合在光照阶段结束后恢复）
+    void BeginGeometryPass();
+    // 全屏光照，结果写入targetFBO（调用方已清屏，背景像素保留清屏颜色）
+    // applyLights设置阴影、分簇光源、平行光和brightness等与前向着色器相同的uniform
+    void LightingPass(GLuint targetFBO, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos,
+        const std::function<void(Shader&)>& applyLights);
+
+    // 热重载登记用
+    Shader* GetLightingShader() { return m_LightingShader.get(); }
+    void PrintStats() const;
+    void Cleanup();
+
+private:
+    int m_Width = 0, m_Height = 0;
+    GLuint m_EmptyVAO = 0;
+    GLboolean m_BlendEnabled = GL_FALSE;
+    std::unique_ptr<Shader> m_LightingShader;
+
+    void CreateTargets();
+    void DestroyTargets();
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cfloat>
+#include <cmath>
+
+// 轴对齐包围盒
+struct AABB {
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    bool IsValid() const { return min.x <= max.x; }
+    glm::vec3 Center() const { return (min + max) * 0.5f; }
+    glm::vec3 Extent() const { return (max - min) * 0.5f; }
+
+    void Expand(const glm::vec3& p) {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+    void Expand(const AABB& other) {
+        if (!other.IsValid()) return;
+        Expand(other.min);
+        Expand(other.max);
+    }
+
+    // 变换后重新求包围盒（Arvo方法）
+    AABB Transform(const glm::mat4& m) const {
+        AABB out;
+        if (!IsValid()) return out;
+        glm::vec3 center = glm::vec3(m * glm::vec4(Center(), 1.0f));
+        glm::vec3 extent = Extent();
+        glm::vec3 newExtent(0.0f);
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                newExtent[i] += std::abs(m[j][i]) * extent[j];
+        out.min = center - newExtent;
+        out.max = center + newExtent;
+        return out;
+    }
+
+    // 点到包围盒的距离（内部为0）
+    float Distance(const glm::vec3& p) const {
+        glm::vec3 d = glm::max(glm::max(min - p, p - max), glm::vec3(0.0f));
+        return glm::length(d);
+    }
+
+    bool Intersects(const AABB& other) const {
+        return min.x <= other.max.x && max.x >= other.min.x &&
+            min.y <= other.max.y && max.y >= other.min.y &&
+            min.z <= other.max.z && max.z >= other.min.z;
+    }
+};
+
+// 视锥体（从view-projection矩阵提取6个平面）
+struct Frustum {
+    glm::vec4 planes[6];
+
+    static Frustum FromMatrix(const glm::mat4& m) {
+        Frustum f;
+        glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+        f.planes[0] = row3 + row0;  // 左
+        f.planes[1] = row3 - row0;  // 右
+        f.planes[2] = row3 + row1;  // 下
+        f.planes[3] = row3 - row1;  // 上
+        f.planes[4] = row3 + row2;  // 近
+        f.planes[5] = row3 - row2;  // 远
+        for (auto& p : f.planes)
+            p /= glm::length(glm::vec3(p));
+        return f;
+    }
+
+    bool Intersects(const AABB& box) const {
+        if (!box.IsValid()) return false;
+        for (const auto& p : planes) {
+            // 取沿平面法线方向最远的顶点
+            glm::vec3 v(p.x > 0.0f ? box.max.x : box.min.x,
+                p.y > 0.0f ? box.max.y : box.min.y,
+                p.z > 0.0f ? box.max.z : box.min.z);
+            if (glm::dot(glm::vec3(p), v) + p.w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
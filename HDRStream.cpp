@@ -0,0 +1,267 @@
+#include "HDRStream.h"
+#include "IBLBaker.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+static const float PI = 3.14159265359f;
+static const size_t READ_BUFFER_SIZE = 64 * 1024;
+
+// ================== RGBE解码 ==================
+bool RGBEReader::Open(const std::string& path) {
+    m_File.open(path, std::ios::binary);
+    if (!m_File) return false;
+    m_Buffer.resize(READ_BUFFER_SIZE);
+
+    // 文件头：魔数行、若干键值行、空行、分辨率行
+    std::string line;
+    if (!ReadLine(line) || line.compare(0, 2, "#?") != 0) return false;
+    while (ReadLine(line) && !line.empty()) {
+        if (line.compare(0, 7, "FORMAT=") == 0 && line != "FORMAT=32-bit_rle_rgbe")
+            return false;
+    }
+    if (!ReadLine(line)) return false;
+    int width = 0, height = 0;
+    if (std::sscanf(line.c_str(), "-Y %d +X %d", &height, &width) != 2 || width <= 0 || height <= 0)
+        return false;
+
+    m_Width = width;
+    m_Height = height;
+    m_NextRow = 0;
+    m_Scanline.resize((size_t)width * 4);
+    return true;
+}
+
+bool RGBEReader::ReadLine(std::string& line) {
+    line.clear();
+    for (;;) {
+        int c = ReadByte();
+        if (c < 0) return false;
+        if (c == '\n') return true;
+        line.push_back((char)c);
+    }
+}
+
+int RGBEReader::ReadByte() {
+    if (m_BufferPos == m_BufferEnd) {
+        m_File.read(reinterpret_cast<char*>(m_Buffer.data()), m_Buffer.size());
+        m_BufferPos = 0;
+        m_BufferEnd = (size_t)m_File.gcount();
+        if (m_BufferEnd == 0) return -1;
+    }
+    return m_Buffer[m_BufferPos++];
+}
+
+bool RGBEReader::ReadBytes(uint8_t* dst, size_t count) {
+    while (count > 0) {
+        if (m_BufferPos == m_BufferEnd) {
+            int c = ReadByte();
+            if (c < 0) return false;
+            *dst++ = (uint8_t)c;
+            --count;
+            continue;
+        }
+        size_t n = std::min(count, m_BufferEnd - m_BufferPos);
+        std::memcpy(dst, m_Buffer.data() + m_BufferPos, n);
+        m_BufferPos += n;
+        dst += n;
+        count -= n;
+    }
+    return true;
+}
+
+bool RGBEReader::ReadScanline() {
+    uint8_t* line = m_Scanline.data();
+    if (!ReadBytes(line, 4)) return false;
+
+    // 新式RLE行以 2 2 宽度高字节 宽度低字节 开头，否则为未压缩行
+    if (m_Width < 8 || m_Width > 0x7fff || line[0] != 2 || line[1] != 2 || (line[2] & 0x80)) {
+        if (line[0] == 1 && line[1] == 1 && line[2] == 1) return false;    // 旧式RLE，不支持
+        return ReadBytes(line + 4, (size_t)(m_Width - 1) * 4);
+    }
+    if (((line[2] << 8) | line[3]) != m_Width) return false;
+
+    // 四个通道依次存放，每个通道为游程/字面量段
+    for (int channel = 0; channel < 4; ++channel) {
+        int x = 0;
+        while (x < m_Width) {
+            int count = ReadByte();
+            if (count < 0) return false;
+            if (count > 128) {
+                count -= 128;
+                int value = ReadByte();
+                if (value < 0 || x + count > m_Width) return false;
+                for (int i = 0; i < count; ++i)
+                    line[(size_t)(x + i) * 4 + channel] = (uint8_t)value;
+            }
+            else {
+                if (count == 0 || x + count > m_Width) return false;
+                for (int i = 0; i < count; ++i) {
+                    int value = ReadByte();
+                    if (value < 0) return false;
+                    line[(size_t)(x + i) * 4 + channel] = (uint8_t)value;
+                }
+            }
+            x += count;
+        }
+    }
+    return true;
+}
+
+bool RGBEReader::ReadRows(int count, float* out) {
+    if (count <= 0 || m_NextRow + count > m_Height) return false;
+    for (int row = 0; row < count; ++row) {
+        if (!ReadScanline()) return false;
+        const uint8_t* rgbe = m_Scanline.data();
+        float* dst = out + (size_t)row * m_Width * 3;
+        for (int x = 0; x < m_Width; ++x, rgbe += 4, dst += 3) {
+            // 与stbi_loadf相同的转换（不加0.5偏移）
+            float scale = rgbe[3] ? std::ldexp(1.0f, rgbe[3] - (128 + 8)) : 0.0f;
+            dst[0] = rgbe[0] * scale;
+            dst[1] = rgbe[1] * scale;
+            dst[2] = rgbe[2] * scale;
+        }
+        ++m_NextRow;
+    }
+    return true;
+}
+
+// ================== 分块重采样 ==================
+// 与equirectangular_to_cubemap.frag相同的映射：u = atan(z, x) / 2PI + 0.5, v = asin(y) / PI + 0.5
+// v以翻转后的图像为准（stbi_set_flip_vertically_on_load(true)），文件第r行对应 v = 1 - (r + 0.5) / H
+struct EquirectTap {
+    int x0, x1;         // 经度方向环绕
+    int row0, row1;     // 翻转后的行号，纬度方向钳制，row1 >= row0
+    float tx, ty;
+};
+
+static EquirectTap ComputeTap(const glm::vec3& dir, int width, int height) {
+    float u = std::atan2(dir.z, dir.x) / (2.0f * PI) + 0.5f;
+    float v = std::asin(std::min(std::max(dir.y, -1.0f), 1.0f)) / PI + 0.5f;
+    float fx = u * width - 0.5f, fy = v * height - 0.5f;
+    int x0 = (int)std::floor(fx), y0 = (int)std::floor(fy);
+    EquirectTap tap;
+    tap.tx = fx - x0;
+    tap.ty = fy - y0;
+    tap.x1 = ((x0 + 1) % width + width) % width;
+    tap.x0 = (x0 % width + width) % width;
+    tap.row1 = std::min(std::max(y0 + 1, 0), height - 1);
+    tap.row0 = std::min(std::max(y0, 0), height - 1);
+    return tap;
+}
+
+EquirectCubeResampler::EquirectCubeResampler(int srcWidth, int srcHeight, int faceSize)
+    : m_Width(srcWidth), m_Height(srcHeight), m_FaceSize(faceSize) {
+    m_Faces.Allocate(faceSize, faceSize, 6, 1, 3);
+    m_PrevRow.resize((size_t)srcWidth * 3);
+
+    // 两遍计数排序：纹素依赖翻转后的row0与row1两行，文件中row0在后（文件行 H-1-row0），以它分桶
+    size_t texelsPerFace = (size_t)faceSize * faceSize;
+    auto bucketOf = [&](int face, int x, int y) {
+        EquirectTap tap = ComputeTap(FloatCubemap::TexelDirection(face, x, y, faceSize), srcWidth, srcHeight);
+        return srcHeight - 1 - tap.row0;
+    };
+    m_BucketStart.assign((size_t)srcHeight + 1, 0);
+    for (int face = 0; face < 6; ++face)
+        for (int y = 0; y < faceSize; ++y)
+            for (int x = 0; x < faceSize; ++x)
+                ++m_BucketStart[bucketOf(face, x, y) + 1];
+    for (int row = 0; row < srcHeight; ++row)
+        m_BucketStart[row + 1] += m_BucketStart[row];
+
+    std::vector<uint32_t> fill(m_BucketStart.begin(), m_BucketStart.end() - 1);
+    m_Texels.resize(6 * texelsPerFace);
+    for (int face = 0; face < 6; ++face)
+        for (int y = 0; y < faceSize; ++y)
+            for (int x = 0; x < faceSize; ++x)
+                m_Texels[fill[bucketOf(face, x, y)]++] = (uint32_t)(face * texelsPerFace + (size_t)y * faceSize + x);
+}
+
+const float* EquirectCubeResampler::Row(int fileRow, const float* band, int bandFirst) const {
+    if (fileRow >= bandFirst) return band + (size_t)(fileRow - bandFirst) * m_Width * 3;
+    return m_PrevRow.data();    // 只可能是上一块的最后一行
+}
+
+void EquirectCubeResampler::AddRows(const float* rows, int count) {
+    int bandFirst = m_NextRow;
+    size_t texelsPerFace = (size_t)m_FaceSize * m_FaceSize;
+    for (int fileRow = bandFirst; fileRow < bandFirst + count; ++fileRow) {
+        for (uint32_t i = m_BucketStart[fileRow]; i < m_BucketStart[fileRow + 1]; ++i) {
+            uint32_t texel = m_Texels[i];
+            int face = (int)(texel / texelsPerFace);
+            int y = (int)(texel % texelsPerFace) / m_FaceSize;
+            int x = (int)(texel % texelsPerFace) % m_FaceSize;
+            EquirectTap tap = ComputeTap(FloatCubemap::TexelDirection(face, x, y, m_FaceSize), m_Width, m_Height);
+
+            const float* r0 = Row(m_Height - 1 - tap.row0, rows, bandFirst);
+            const float* r1 = Row(m_Height - 1 - tap.row1, rows, bandFirst);
+            uint16_t* out = &m_Faces.data[m_Faces.LevelOffset(0, face) + ((size_t)y * m_FaceSize + x) * 3];
+            for (int c = 0; c < 3; ++c) {
+                float c00 = r0[tap.x0 * 3 + c], c10 = r0[tap.x1 * 3 + c];
+                float c01 = r1[tap.x0 * 3 + c], c11 = r1[tap.x1 * 3 + c];
+                float value = (c00 + (c10 - c00) * tap.tx) * (1.0f - tap.ty) + (c01 + (c11 - c01) * tap.tx) * tap.ty;
+                out[c] = IBLCache::FloatToHalf(value);
+            }
+        }
+    }
+    std::memcpy(m_PrevRow.data(), rows + (size_t)(count - 1) * m_Width * 3, m_PrevRow.size() * sizeof(float));
+    m_NextRow += count;
+}
+
+// ================== 加载入口 ==================
+bool HDRStream::LoadCubemap(const std::string& path, int faceSize, IBLImage& faces, SH9Color& sh) {
+    auto start = std::chrono::steady_clock::now();
+
+    RGBEReader reader;
+    if (reader.Open(path)) {
+        int width = reader.Width(), height = reader.Height();
+        EquirectCubeResampler resampler(width, height, faceSize);
+        SHProjector projector(width, height);
+        std::vector<float> band((size_t)BAND_ROWS * width * 3);
+        bool decoded = true;
+        while (reader.NextRow() < height) {
+            int first = reader.NextRow();
+            int count = std::min(BAND_ROWS, height - first);
+            if (!reader.ReadRows(count, band.data())) {
+                // 旧式RLE行可能出现在任意位置，文件头无法提前判断；交给stbi_loadf，真正损坏的文件由它报错
+                std::cout << "HDRStream: " << path << " row " << first << " is not streamable, loading whole" << std::endl;
+                decoded = false;
+                break;
+            }
+            resampler.AddRows(band.data(), count);
+            for (int i = 0; i < count; ++i)
+                projector.AddRow(band.data() + (size_t)i * width * 3, height - 1 - (first + i), 3);
+        }
+        if (decoded) {
+            faces = std::move(resampler.Result());
+            sh = projector.Finish();
+
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "HDRStream: " << path << " " << width << "x" << height << " streamed in "
+                << BAND_ROWS << "-row bands (" << band.size() * sizeof(float) / 1024 << " KB band buffer) in "
+                << ms << " ms" << std::endl;
+            return true;
+        }
+    }
+
+    // 非标准方向、XYZE或旧式RLE（含流式解码中途遇到的）：整张加载后按同样的方式重采样
+    stbi_set_flip_vertically_on_load(true);
+    int width, height, components;
+    float* pixels = stbi_loadf(path.c_str(), &width, &height, &components, 3);
+    if (!pixels) {
+        std::cerr << "Failed to load HDR image: " << path << std::endl;
+        return false;
+    }
+    std::cout << "HDRStream: " << path << " loaded whole (" << width << "x" << height << ")" << std::endl;
+    EquirectCubeResampler resampler(width, height, faceSize);
+    for (int row = 0; row < height; ++row)
+        resampler.AddRows(pixels + (size_t)(height - 1 - row) * width * 3, 1);
+    faces = std::move(resampler.Result());
+    sh = SphericalHarmonics::ProjectEquirect(pixels, width, height, 3);
+    stbi_image_free(pixels);
+    return true;
+}
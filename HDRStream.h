@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "IBLCache.h"
+#include "SphericalHarmonics.h"
+
+// Radiance HDR（RGBE）流式解码：按扫描线分块读取，不依赖GL，烘焙工具和运行时共用
+// 只支持标准方向（-Y H +X W）和32-bit_rle_rgbe格式，其余情况由调用者回退到stbi_loadf
+class RGBEReader {
+public:
+    bool Open(const std::string& path);
+    int Width() const { return m_Width; }
+    int Height() const { return m_Height; }
+    int NextRow() const { return m_NextRow; }
+
+    // 按文件顺序（自上而下）解码count行到RGB浮点，out至少 count * Width() * 3
+    bool ReadRows(int count, float* out);
+
+private:
+    bool ReadScanline();
+    bool ReadLine(std::string& line);
+    // 自带读缓冲，RLE解码按字节读取
+    int ReadByte();
+    bool ReadBytes(uint8_t* dst, size_t count);
+
+    std::ifstream m_File;
+    int m_Width = 0, m_Height = 0;
+    int m_NextRow = 0;
+    std::vector<uint8_t> m_Scanline;    // 一行RGBE，[x][4]
+    std::vector<uint8_t> m_Buffer;
+    size_t m_BufferPos = 0, m_BufferEnd = 0;
+};
+
+// 等距柱状图 -> 立方体贴图的逐块重采样，映射与双线性过滤与equirectangular_to_cubemap.frag一致
+// 预先把每个目标纹素按其依赖的最后一行源像素分桶，某行到达时即可完成对应纹素，
+// 因此只需保留当前块和上一块的最后一行
+class EquirectCubeResampler {
+public:
+    EquirectCubeResampler(int srcWidth, int srcHeight, int faceSize);
+
+    // rows为文件顺序（自上而下）的连续count行RGB浮点，必须按顺序送入
+    void AddRows(const float* rows, int count);
+    // 全部行送入后，6个面的半精度结果（mip0）
+    IBLImage& Result() { return m_Faces; }
+
+private:
+    const float* Row(int fileRow, const float* band, int bandFirst) const;
+
+    int m_Width, m_Height, m_FaceSize;
+    int m_NextRow = 0;
+    std::vector<uint32_t> m_BucketStart;    // 每个源行一个桶，[H+1]
+    std::vector<uint32_t> m_Texels;         // 按桶排列的目标纹素索引（face * N * N + y * N + x）
+    std::vector<float> m_PrevRow;           // 上一块的最后一行
+    IBLImage m_Faces;
+};
+
+class HDRStream {
+public:
+    static const int BAND_ROWS = 32;
+
+    // 流式加载HDR环境贴图：分块解码，直接写入立方体贴图各面（半精度）并累加漫反射球谐
+    // 峰值内存 = 一个分块 + 目标面，不再持有整张浮点图像；格式不受支持时回退到stbi_loadf
+    static bool LoadCubemap(const std::string& path, int faceSize, IBLImage& faces, SH9Color& sh);
+};
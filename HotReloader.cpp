@@ -0,0 +1,200 @@
+#include "HotReloader.h"
+#include <iostream>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+HotReloader::HotReloader(const std::vector<std::string>& roots)
+    : m_Roots(roots), m_Running(true) {
+#ifdef __linux__
+    m_Thread = std::thread(&HotReloader::WatchLoop, this);
+#else
+    m_Thread = std::thread(&HotReloader::PollLoop, this);
+#endif
+}
+
+HotReloader::~HotReloader() {
+    m_Running = false;
+    if (m_Thread.joinable()) m_Thread.join();
+}
+
+std::string HotReloader::Normalize(const std::string& path) {
+    return fs::path(path).lexically_normal().generic_string();
+}
+
+void HotReloader::RegisterShader(Shader* shader) {
+    IndexShader(shader);
+}
+
+void HotReloader::IndexShader(Shader* shader) {
+    auto add = [this, shader](const std::string& file) {
+        auto& deps = m_ShaderDeps[Normalize(file)];
+        if (std::find(deps.begin(), deps.end(), shader) == deps.end())
+            deps.push_back(shader);
+    };
+    add(shader->GetVertexPath());
+    add(shader->GetFragmentPath());
+    if (!shader->GetGeometryPath().empty())
+        add(shader->GetGeometryPath());
+    for (const auto& file : shader->GetIncludes())
+        add(file);
+}
+
+void HotReloader::RegisterModel(Model* model) {
+    m_Models.push_back(model);
+    IndexModel(model);
+}
+
+void HotReloader::IndexModel(Model* model) {
+    // 模型源文件以及同名的附属文件（.mtl/.bin）
+    fs::path src(Normalize(model->GetPath()));
+    m_ModelDeps[src.generic_string()].push_back(model);
+    for (const char* ext : { ".mtl", ".bin" }) {
+        fs::path sibling = src;
+        sibling.replace_extension(ext);
+        m_ModelDeps[sibling.generic_string()].push_back(model);
+    }
+    for (const auto& file : model->GetTextureFiles())
+        m_TextureDeps[file].push_back(model);
+}
+
+void HotReloader::NotifyChanged(const std::string& file) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Pending.insert(Normalize(file));
+}
+
+void HotReloader::ProcessPending() {
+    std::unordered_set<std::string> changed;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        changed.swap(m_Pending);
+    }
+    if (changed.empty()) return;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::unordered_set<Shader*> shaders;
+    std::unordered_set<Model*> models;
+
+    for (const auto& file : changed) {
+        auto s = m_ShaderDeps.find(file);
+        if (s != m_ShaderDeps.end())
+            shaders.insert(s->second.begin(), s->second.end());
+        auto m = m_ModelDeps.find(file);
+        if (m != m_ModelDeps.end())
+            models.insert(m->second.begin(), m->second.end());
+    }
+
+    for (Shader* shader : shaders) {
+        if (shader->Reload()) {
+            IndexShader(shader);
+            std::cout << "HOTRELOAD::SHADER " << shader->GetFragmentPath() << std::endl;
+        }
+    }
+
+    // 整体重导入的模型会顺带重新加载纹理
+    for (Model* model : models) {
+        model->Reload();
+        std::cout << "HOTRELOAD::MODEL " << model->GetPath() << std::endl;
+    }
+    if (!models.empty()) {
+        m_TextureDeps.clear();
+        m_ModelDeps.clear();
+        for (Model* model : m_Models) IndexModel(model);
+    }
+
+    for (const auto& file : changed) {
+        auto t = m_TextureDeps.find(file);
+        if (t == m_TextureDeps.end()) continue;
+        for (Model* model : t->second) {
+            if (models.count(model)) continue;
+            model->ReloadTexture(file);
+        }
+        std::cout << "HOTRELOAD::TEXTURE " << file << std::endl;
+    }
+
+    float ms = std::chrono::duration<float, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "HOTRELOAD: " << changed.size() << " file(s) in " << ms << " ms" << std::endl;
+}
+
+// ================== 监视线程 ==================
+void HotReloader::WatchLoop() {
+#ifdef __linux__
+    int fd = inotify_init1(IN_NONBLOCK);
+    if (fd < 0) {
+        std::cerr << "HOTRELOAD: inotify unavailable, falling back to polling" << std::endl;
+        PollLoop();
+        return;
+    }
+
+    // inotify不递归，逐个目录添加监视
+    std::unordered_map<int, std::string> watchDirs;
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+    auto addWatch = [&](const std::string& dir) {
+        int wd = inotify_add_watch(fd, dir.c_str(), mask);
+        if (wd >= 0) watchDirs[wd] = dir;
+    };
+    for (const auto& root : m_Roots) {
+        std::error_code ec;
+        if (!fs::is_directory(root, ec)) continue;
+        addWatch(root);
+        for (auto it = fs::recursive_directory_iterator(root, ec); it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_directory(ec)) addWatch(it->path().generic_string());
+        }
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (m_Running) {
+        pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 200) <= 0) continue;
+
+        ssize_t len;
+        while ((len = read(fd, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + len; ) {
+                auto* ev = reinterpret_cast<inotify_event*>(p);
+                p += sizeof(inotify_event) + ev->len;
+                auto dir = watchDirs.find(ev->wd);
+                if (dir == watchDirs.end() || ev->len == 0) continue;
+
+                std::string file = dir->second + '/' + ev->name;
+                if (ev->mask & IN_ISDIR) {
+                    if (ev->mask & IN_CREATE) addWatch(file);
+                }
+                else if (ev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                    NotifyChanged(file);
+                }
+            }
+        }
+    }
+    close(fd);
+#else
+    PollLoop();
+#endif
+}
+
+void HotReloader::PollLoop() {
+    std::unordered_map<std::string, fs::file_time_type> stamps;
+    bool first = true;
+    while (m_Running) {
+        for (const auto& root : m_Roots) {
+            std::error_code ec;
+            for (auto it = fs::recursive_directory_iterator(root, ec); it != fs::recursive_directory_iterator(); it.increment(ec)) {
+                if (!it->is_regular_file(ec)) continue;
+                std::string file = it->path().generic_string();
+                auto time = it->last_write_time(ec);
+                auto& known = stamps[file];
+                if (!first && known != time) NotifyChanged(file);
+                known = time;
+            }
+        }
+        first = false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "Shader.h"
+#include "Model.h"
+
+// 着色器/纹理/模型热重载
+// 后台线程监视目录（Linux用inotify，其余平台轮询修改时间），
+// 主线程在帧边界调用ProcessPending，通过反向依赖索引只重建受影响的资源
+class HotReloader {
+public:
+    HotReloader(const std::vector<std::string>& roots);
+    ~HotReloader();
+
+    void RegisterShader(Shader* shader);
+    void RegisterModel(Model* model);
+
+    // 在帧开始处调用（需要GL上下文）
+    void ProcessPending();
+
+private:
+    std::vector<std::string> m_Roots;
+    std::thread m_Thread;
+    std::atomic<bool> m_Running;
+
+    std::mutex m_Mutex;
+    std::unordered_set<std::string> m_Pending;  // 已改动、待处理的文件
+
+    // 反向依赖索引：文件 -> 依赖它的资源
+    std::unordered_map<std::string, std::vector<Shader*>> m_ShaderDeps;
+    std::unordered_map<std::string, std::vector<Model*>> m_TextureDeps;
+    std::unordered_map<std::string, std::vector<Model*>> m_ModelDeps;
+    std::vector<Model*> m_Models;
+
+    void WatchLoop();
+    void PollLoop();
+    void NotifyChanged(const std::string& file);
+    void IndexModel(Model* model);
+    // 着色器源文件和#include的文件，重载后包含关系可能变化，重复登记会跳过已有的依赖
+    void IndexShader(Shader* shader);
+    static std::string Normalize(const std::string& path);
+};
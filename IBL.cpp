@@ -1,46 +1,95 @@
 #include "IBL.h"
 #include "Shader.h"
-#include "stb_image.h"
+#include "ResidencyManager.h"
+#include "IBLBaker.h"
+#include "SphericalHarmonics.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include "HDRStream.h"
 #include <iostream>
 #include <vector>
 #include <glm/gtc/matrix_transform.hpp>
 
-// ================== ȫȾԴ ==================
-// 嶥
+// 预滤波与BRDF积分每次绘制的最大样本数：参考档位的上万个样本分成多次绘制累加，
+// 避免单次绘制耗时过长触发驱动超时（TDR）
+static const int SAMPLES_PER_PASS = 1024;
+
+// 与prefilter.frag相同的样本序列下，V = N时全部样本的NdotL之和（与N无关）
+static float PrefilterTotalWeight(float roughness, int sampleCount) {
+    float a = roughness * roughness;
+    float total = 0.0f;
+    for (int i = 0; i < sampleCount; ++i) {
+        uint32_t bits = (uint32_t)i;
+        bits = (bits << 16u) | (bits >> 16u);
+        bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+        bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+        bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+        bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+        float xi = float(bits) * 2.3283064365386963e-10f;
+        float cosTheta = std::sqrt((1.0f - xi) / (1.0f + (a * a - 1.0f) * xi));
+        total += std::max(2.0f * cosTheta * cosTheta - 1.0f, 0.0f);
+    }
+    return total;
+}
+
+// 按SAMPLES_PER_PASS分批绘制，加性混合累加到当前颜色附件；批次之间只清深度并提交命令
+template <typename DrawPass>
+static void DrawSampleBatches(const Shader& shader, int sampleCount, DrawPass draw) {
+    GLfloat clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    for (int start = 0; start < sampleCount; start += SAMPLES_PER_PASS) {
+        shader.setInt("sampleStart", start);
+        shader.setInt("sampleEnd", std::min(start + SAMPLES_PER_PASS, sampleCount));
+        if (start > 0) glClear(GL_DEPTH_BUFFER_BIT);
+        draw();
+        glFlush();
+    }
+    glDisable(GL_BLEND);
+}
+
+// ================== 全局渲染辅助资源 ==================
+// 立方体顶点数据
 float cubeVertices[] = {
-    // 
+    // 背面
     -1.0f, -1.0f, -1.0f,
      1.0f, -1.0f, -1.0f,
      1.0f,  1.0f, -1.0f,
     -1.0f,  1.0f, -1.0f,
-    // ǰ
+    // 前面
     -1.0f, -1.0f,  1.0f,
      1.0f, -1.0f,  1.0f,
      1.0f,  1.0f,  1.0f,
     -1.0f,  1.0f,  1.0f,
-    // 
+    // 左面
     -1.0f, -1.0f, -1.0f,
     -1.0f,  1.0f, -1.0f,
     -1.0f,  1.0f,  1.0f,
     -1.0f, -1.0f,  1.0f,
-    // 
+    // 右面
      1.0f, -1.0f, -1.0f,
      1.0f,  1.0f, -1.0f,
      1.0f,  1.0f,  1.0f,
      1.0f, -1.0f,  1.0f,
-     // 
+     // 底面
      -1.0f, -1.0f, -1.0f,
       1.0f, -1.0f, -1.0f,
       1.0f, -1.0f,  1.0f,
      -1.0f, -1.0f,  1.0f,
-     // 
+     // 顶面
      -1.0f,  1.0f, -1.0f,
       1.0f,  1.0f, -1.0f,
       1.0f,  1.0f,  1.0f,
      -1.0f,  1.0f,  1.0f
 };
 
-// 
+// 立方体索引
 unsigned int cubeIndices[] = {
     0, 1, 2, 2, 3, 0,
     4, 5, 6, 6, 7, 4,
@@ -50,12 +99,121 @@ unsigned int cubeIndices[] = {
     20, 21, 22, 22, 23, 20
 };
 
-// ȾVAO/VBO
+// 渲染立方体的VAO/VBO
 unsigned int cubeVAO = 0, cubeVBO = 0, cubeEBO = 0;
 
-// ================== IBLʵ ==================
-IBL::IBL(const std::string& hdrPath) {
-    // ʼͼ󣨹ؼ޸
+// ================== IBL类实现 ==================
+IBL::IBL(const std::string& hdrPath, bool useSH, IBLQuality quality, IBLFormat format, bool useCache) {
+    InitCaptureViews();
+    m_Params = MakeParams(useSH, quality);
+    m_Format = ResolveFormat(format);
+
+    // 烘焙参数 + 着色器哈希 + HDR内容哈希 -> 缓存键
+    std::string cachePath = IBLCache::CachePath(hdrPath);
+    uint64_t contentHash = 0;
+    bool hashed = useCache && IBLCache::HashFile(hdrPath, contentHash);
+    uint64_t key = IBLCache::MakeKey(contentHash, m_Params);
+
+    glGenFramebuffers(1, &m_captureFBO);
+    glGenRenderbuffers(1, &m_captureRBO);
+
+    IBLCacheData cache;
+    if (hashed && IBLCache::Load(cachePath, key, cache)) {
+        UploadFromCache(cache);
+        std::cout << "IBL: loaded baked maps from " << cachePath << std::endl;
+    }
+    else {
+        auto bakeStart = std::chrono::steady_clock::now();
+        if (!Bake(hdrPath)) return;
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bakeStart).count();
+        std::cout << "IBL: baked " << hdrPath << " (" << IBLBakeParams::QualityName(quality) << ") in " << ms
+            << " ms [env " << m_Timings.env << ", irradiance " << m_Timings.irradiance << ", prefilter "
+            << m_Timings.prefilter << ", brdf " << m_Timings.brdf << "]" << std::endl;
+
+        // 读回全部产物写入缓存，下次启动直接上传
+        if (hashed || m_Format != IBLFormat::RGB16F)
+            ReadBack(cache);
+        if (hashed)
+            IBLCache::Save(cachePath, key, cache);
+
+        // 烘焙只能渲染到RGB16F，紧凑格式由读回的数据重新创建
+        if (m_Format != IBLFormat::RGB16F) {
+            GLuint textures[] = { m_envCubemap, m_irradianceMap, m_prefilterMap, m_brdfLUT };
+            glDeleteTextures(4, textures);
+            m_irradianceMap = 0;
+            UploadFromCache(cache);
+        }
+    }
+
+    TrackResidency();
+}
+
+IBL::IBL(const IBLCacheData& cache, const IBLBakeParams& params, IBLFormat format) {
+    m_Params = params;
+    m_Format = ResolveFormat(format);
+    UploadFromCache(cache);
+    TrackResidency();
+}
+
+IBL::IBL(int captureSize, bool useSH, IBLQuality quality) {
+    InitCaptureViews();
+    m_Dynamic = true;
+    m_Params = MakeParams(useSH, quality);
+    m_Params.envSize = captureSize;
+    m_Params.prefilterSize = std::min(m_Params.prefilterSize, captureSize);
+    m_Params.prefilterMips = std::min(m_Params.prefilterMips, (int)std::log2((float)m_Params.prefilterSize) + 1);
+    m_CapturePosition = glm::vec3(0.0f);
+
+    // 深度缓冲按捕获尺寸分配一次，预滤波和卷积的目标都不大于它
+    glGenFramebuffers(1, &m_captureFBO);
+    glGenRenderbuffers(1, &m_captureRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_captureRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, captureSize, captureSize);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_captureFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_captureRBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // 预滤波/辐照度双缓冲：后台在多帧内逐步更新，完成一轮后与前台交换
+    int envLevels = (int)std::log2((float)captureSize) + 1;
+    m_envCubemap = CreateCubemap(captureSize, envLevels, true, nullptr);
+    m_prefilterMap = CreateCubemap(m_Params.prefilterSize, m_Params.prefilterMips, true, nullptr);
+    m_prefilterBack = CreateCubemap(m_Params.prefilterSize, m_Params.prefilterMips, true, nullptr);
+    if (useSH) {
+        // 漫反射球谐：读回环境贴图的小尺寸mip（PBO异步），在本轮最后一步投影
+        m_SHReadbackMip = 0;
+        while ((captureSize >> m_SHReadbackMip) > 16) ++m_SHReadbackMip;
+        int size = std::max(1, captureSize >> m_SHReadbackMip);
+        glGenBuffers(1, &m_SHReadback);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_SHReadback);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)6 * size * size * 3 * sizeof(float), nullptr, GL_STREAM_READ);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    else {
+        m_irradianceMap = CreateCubemap(m_Params.irradianceSize, 1, false, nullptr);
+        m_irradianceBack = CreateCubemap(m_Params.irradianceSize, 1, false, nullptr);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_captureFBO);
+    PrecomputeBRDFLUT();
+    glBindFramebuffer(GL_FRAMEBUFFER, m_captureFBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_captureRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, captureSize, captureSize);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    m_PrefilterShader = MakePrefilterShader();
+    if (!useSH)
+        m_IrradianceShader = MakeIrradianceShader();
+
+    int steps = CaptureStepCount();
+    m_StepQueries.resize(steps);
+    glGenQueries(steps, m_StepQueries.data());
+    m_StepQueryPending.assign(steps, false);
+    m_StepCostMs.assign(steps, 0.0f);
+    TrackResidency();
+}
+
+void IBL::InitCaptureViews() {
+    // 初始化视图矩阵（关键修复）
     captureViews = {
         glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)),
         glm::lookAt(glm::vec3(0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)),
@@ -64,83 +222,380 @@ IBL::IBL(const std::string& hdrPath) {
         glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, -1.0f, 0.0f)),
         glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f))
     };
+}
 
-    // 1. HDRͼ
-    stbi_set_flip_vertically_on_load(true);
-    int width, height, nrComponents;
-    float* data = stbi_loadf(hdrPath.c_str(), &width, &height, &nrComponents, 0);
-    if (!data) {
-        std::cerr << "Failed to load HDR image: " << hdrPath << std::endl;
-        return;
+IBLBakeParams IBL::MakeParams(bool useSH, IBLQuality quality) {
+    IBLBakeParams params = IBLBakeParams::ForQuality(quality);
+    params.shIrradiance = useSH;
+    params.shaderHash = IBLCache::HashBakeShaders();
+    return params;
+}
+
+IBLFormat IBL::ResolveFormat(IBLFormat format) {
+    if (format == IBLFormat::BC6H && !SupportsBC6H()) {
+        std::cout << "IBL: BPTC compression not supported, using R11G11B10F" << std::endl;
+        return IBLFormat::R11G11B10F;
     }
+    return format;
+}
 
-    unsigned int hdrTexture;
-    glGenTextures(1, &hdrTexture);
-    glBindTexture(GL_TEXTURE_2D, hdrTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    stbi_image_free(data);
+void IBL::TrackResidency() {
+    if (!IsValid()) return;
+    // 登记显存占用（不提供restore，预算管理器不会驱逐）
+    ResidencyManager& residency = ResidencyManager::Get();
+    int bpp = (int)IBLFormats::BytesPerTexel(m_Format);
+    size_t envBytes = 6 * ResidencyManager::TextureBytes(m_Params.envSize, m_Params.envSize, bpp, true);
+    size_t irradianceBytes = m_irradianceMap ? 6 * ResidencyManager::TextureBytes(m_Params.irradianceSize, m_Params.irradianceSize, bpp, false) : 0;
+    size_t prefilterBytes = 6 * ResidencyManager::TextureBytes(m_Params.prefilterSize, m_Params.prefilterSize, bpp, true);
+    size_t brdfBytes = ResidencyManager::TextureBytes(m_Params.brdfSize, m_Params.brdfSize, 4, false);
+    residency.TrackTexture(m_envCubemap, envBytes, "IBL");
+    if (m_irradianceMap)
+        residency.TrackTexture(m_irradianceMap, irradianceBytes, "IBL");
+    residency.TrackTexture(m_prefilterMap, prefilterBytes, "IBL");
+    std::cout << "IBL: cubemaps stored as " << IBLFormats::Name(m_Format) << ", "
+        << (envBytes + prefilterBytes) / (1024.0 * 1024.0) << " MB (env + prefilter)" << std::endl;
+    residency.TrackTexture(m_brdfLUT, brdfBytes, "IBL");
+    m_ResidentBytes = envBytes + irradianceBytes + prefilterBytes + brdfBytes;
+    // 动态探针的后台缓冲
+    if (m_prefilterBack) {
+        residency.TrackTexture(m_prefilterBack, prefilterBytes, "IBL");
+        m_ResidentBytes += prefilterBytes;
+    }
+    if (m_irradianceBack) {
+        residency.TrackTexture(m_irradianceBack, irradianceBytes, "IBL");
+        m_ResidentBytes += irradianceBytes;
+    }
+}
 
-    // 2. ͼ
-    glGenTextures(1, &m_envCubemap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_envCubemap);
-    for (unsigned int i = 0; i < 6; ++i) {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F,
-            512, 512, 0, GL_RGB, GL_FLOAT, nullptr);
+// 创建立方体贴图并分配levels级存储；image非空时直接上传缓存数据
+GLuint IBL::CreateCubemap(int size, int levels, bool mipFilter, const IBLImage* image,
+    IBLFormat format, const std::vector<uint8_t>* bc6h) {
+    GLuint id;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (format == IBLFormat::RGB16F || !image) {
+        for (int mip = 0; mip < levels; ++mip) {
+            int mipSize = std::max(1, size >> mip);
+            for (unsigned int i = 0; i < 6; ++i) {
+                const void* pixels = image ? &image->data[image->LevelOffset(mip, i)] : nullptr;
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, mip, GL_RGB16F,
+                    mipSize, mipSize, 0, GL_RGB, GL_HALF_FLOAT, pixels);
+            }
+        }
     }
+    else if (format == IBLFormat::BC6H) {
+        // 优先使用离线压缩的块，缺失或尺寸不符时在加载时编码
+        std::vector<uint8_t> encoded;
+        const std::vector<uint8_t>* blocks = bc6h;
+        if (!blocks || blocks->size() != IBLFormats::BC6HOffset(*image, image->mips, 0)) {
+            encoded = IBLFormats::EncodeBC6H(*image);
+            blocks = &encoded;
+        }
+        for (int mip = 0; mip < levels; ++mip) {
+            int mipSize = image->MipWidth(mip);
+            for (unsigned int i = 0; i < 6; ++i)
+                glCompressedTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, mip, GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT,
+                    mipSize, mipSize, 0, (GLsizei)IBLFormats::BC6HLevelSize(mipSize, mipSize),
+                    &(*blocks)[IBLFormats::BC6HOffset(*image, mip, i)]);
+        }
+    }
+    else {
+        std::vector<uint32_t> packed = IBLFormats::PackImage(*image, format);
+        GLenum internalFormat = format == IBLFormat::RGB9E5 ? GL_RGB9_E5 : GL_R11F_G11F_B10F;
+        GLenum type = format == IBLFormat::RGB9E5 ? GL_UNSIGNED_INT_5_9_9_9_REV : GL_UNSIGNED_INT_10F_11F_11F_REV;
+        for (int mip = 0; mip < levels; ++mip) {
+            int mipSize = image->MipWidth(mip);
+            for (unsigned int i = 0; i < 6; ++i)
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, mip, internalFormat,
+                    mipSize, mipSize, 0, GL_RGB, type, &packed[image->LevelOffset(mip, i) / 3]);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, mipFilter ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (levels > 1)
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    return id;
+}
 
-    // 3. ʼ֡
-    glGenFramebuffers(1, &m_captureFBO);
-    glGenRenderbuffers(1, &m_captureRBO);
+GLuint IBL::CreateBRDFLUT(int size, const IBLImage* image) {
+    GLuint id;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, size, size, 0, GL_RG, GL_HALF_FLOAT,
+        image ? image->data.data() : nullptr);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return id;
+}
 
-    // 4. HDRתͼ
-    Shader equirectShader("shaders/cubemap.vert", "shaders/equirectangular_to_cubemap.frag");
-    equirectShader.use();
-    equirectShader.setInt("equirectangularMap", 0);
-    equirectShader.setMat4("projection", captureProjection);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, hdrTexture);
+void IBL::UploadFromCache(const IBLCacheData& cache) {
+    // 环境贴图只缓存了mip0，其余级别重新生成；紧凑格式不能用glGenerateMipmap，在CPU上生成
+    if (m_Format == IBLFormat::RGB16F) {
+        m_envCubemap = CreateCubemap(cache.env.width, 1, true, &cache.env);
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    }
+    else {
+        IBLImage env = IBLFormats::BuildMips(cache.env);
+        m_envCubemap = CreateCubemap(env.width, env.mips, true, &env, m_Format, &cache.envBC6H);
+    }
+    if (!m_Params.shIrradiance)
+        m_irradianceMap = CreateCubemap(cache.irradiance.width, 1, false, &cache.irradiance, m_Format);
+    m_prefilterMap = CreateCubemap(cache.prefilter.width, cache.prefilter.mips, true, &cache.prefilter,
+        m_Format, &cache.prefilterBC6H);
+    m_brdfLUT = CreateBRDFLUT(cache.brdf.width, &cache.brdf);
+    m_SH = cache.sh;
+}
 
-    glBindFramebuffer(GL_FRAMEBUFFER, m_captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, m_captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
+void IBL::ReadBack(IBLCacheData& cache) const {
+    auto readCubemap = [](GLuint id, int size, int levels, IBLImage& image) {
+        image.Allocate(size, size, 6, levels, 3);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, id);
+        for (int mip = 0; mip < levels; ++mip)
+            for (unsigned int i = 0; i < 6; ++i)
+                glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, mip, GL_RGB, GL_HALF_FLOAT,
+                    &image.data[image.LevelOffset(mip, i)]);
+    };
 
-    glViewport(0, 0, 512, 512);
-    for (unsigned int i = 0; i < 6; ++i) {
-        equirectShader.setMat4("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-            GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, m_envCubemap, 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        RenderCube();
-    }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    readCubemap(m_envCubemap, m_Params.envSize, 1, cache.env);
+    if (m_irradianceMap)
+        readCubemap(m_irradianceMap, m_Params.irradianceSize, 1, cache.irradiance);
+    readCubemap(m_prefilterMap, m_Params.prefilterSize, m_Params.prefilterMips, cache.prefilter);
+    cache.brdf.Allocate(m_Params.brdfSize, m_Params.brdfSize, 1, 1, 2);
+    glBindTexture(GL_TEXTURE_2D, m_brdfLUT);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RG, GL_HALF_FLOAT, cache.brdf.data.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    cache.sh = m_SH;
+}
 
-    // 5. mipmap
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_envCubemap);
+// 等待GPU完成后计时，得到各阶段的实际耗时
+static double FinishStage(std::chrono::steady_clock::time_point& start) {
+    glFinish();
+    auto now = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(now - start).count();
+    start = now;
+    return ms;
+}
+
+bool IBL::Bake(const std::string& hdrPath) {
+    auto stageStart = std::chrono::steady_clock::now();
+
+    // 1. 按扫描线分块解码HDR，直接重采样到立方体贴图各面并累加漫反射球谐
+    //    不再创建整张等距柱状图的浮点数组和2D纹理，峰值内存只有一个分块和目标面
+    IBLImage envFaces;
+    if (!HDRStream::LoadCubemap(hdrPath, m_Params.envSize, envFaces, m_SH))
+        return false;
+
+    // 2. 上传环境立方体贴图并生成mipmap
+    m_envCubemap = CreateCubemap(envFaces.width, 1, true, &envFaces);
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-    glDeleteTextures(1, &hdrTexture);
+    m_Timings.env = FinishStage(stageStart);
 
-    // ԤIBLͼ
-    PrecomputeIrradianceMap();
+    // 预计算IBL贴图
+    if (!m_Params.shIrradiance) {
+        PrecomputeIrradianceMap();
+        m_Timings.irradiance = FinishStage(stageStart);
+    }
     PrecomputePrefilterMap();
+    m_Timings.prefilter = FinishStage(stageStart);
     PrecomputeBRDFLUT();
+    m_Timings.brdf = FinishStage(stageStart);
+
+    return true;
 }
 
 IBL::~IBL() {
+    ResidencyManager& residency = ResidencyManager::Get();
+    residency.UntrackTexture(m_envCubemap);
+    residency.UntrackTexture(m_irradianceMap);
+    residency.UntrackTexture(m_prefilterMap);
+    residency.UntrackTexture(m_brdfLUT);
     glDeleteTextures(1, &m_envCubemap);
     glDeleteTextures(1, &m_irradianceMap);
     glDeleteTextures(1, &m_prefilterMap);
     glDeleteTextures(1, &m_brdfLUT);
     glDeleteFramebuffers(1, &m_captureFBO);
     glDeleteRenderbuffers(1, &m_captureRBO);
+    if (m_Dynamic) {
+        residency.UntrackTexture(m_prefilterBack);
+        residency.UntrackTexture(m_irradianceBack);
+        glDeleteTextures(1, &m_prefilterBack);
+        glDeleteTextures(1, &m_irradianceBack);
+        glDeleteBuffers(1, &m_SHReadback);
+        if (!m_StepQueries.empty())
+            glDeleteQueries((GLsizei)m_StepQueries.size(), m_StepQueries.data());
+    }
+}
+
+// ================== 动态探针 ==================
+// 一轮更新的步骤：0-5 渲染场景的6个面；6 生成环境mip并计算漫反射；7.. 每级预滤波mip一步，最后一步交换前后台
+int IBL::CaptureStepCount() const {
+    return 6 + 1 + m_Params.prefilterMips;
+}
+
+bool IBL::UpdateCapture() {
+    if (!m_Dynamic || !m_CaptureScene) return false;
+
+    // 收集已完成的GPU计时（不等待），平滑更新各步骤的耗时估计
+    int steps = CaptureStepCount();
+    for (int step = 0; step < steps; ++step) {
+        if (!m_StepQueryPending[step]) continue;
+        GLint available = 0;
+        glGetQueryObjectiv(m_StepQueries[step], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(m_StepQueries[step], GL_QUERY_RESULT, &ns);
+        float ms = (float)(ns / 1.0e6);
+        m_StepCostMs[step] = m_StepCostMs[step] > 0.0f ? m_StepCostMs[step] * 0.75f + ms * 0.25f : ms;
+        m_StepQueryPending[step] = false;
+    }
+
+    GLint previousFBO = 0, previousViewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFBO);
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+    // 按估计耗时在预算内执行尽量多的步骤，每帧至少一步；未测量过的步骤按整个预算计
+    bool completed = false;
+    float spent = 0.0f;
+    for (int ran = 0; ran < steps; ++ran) {
+        int step = m_CaptureStep;
+        float cost = m_StepCostMs[step] > 0.0f ? m_StepCostMs[step] : m_CaptureBudgetMs;
+        if (ran > 0 && spent + cost > m_CaptureBudgetMs) break;
+
+        bool timed = !m_StepQueryPending[step];
+        if (timed) glBeginQuery(GL_TIME_ELAPSED, m_StepQueries[step]);
+        RunCaptureStep(step);
+        if (timed) {
+            glEndQuery(GL_TIME_ELAPSED);
+            m_StepQueryPending[step] = true;
+        }
+        spent += cost;
+        if (++m_CaptureStep == steps) {
+            m_CaptureStep = 0;
+            completed = true;
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFBO);
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    return completed;
+}
+
+void IBL::RunCaptureStep(int step) {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_captureFBO);
+
+    if (step < 6) {
+        // 从探针位置渲染场景的一个面
+        int size = m_Params.envSize;
+        glm::mat4 view = captureViews[step] * glm::translate(glm::mat4(1.0f), -m_CapturePosition);
+        glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.05f, 100.0f);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+            GL_TEXTURE_CUBE_MAP_POSITIVE_X + step, m_envCubemap, 0);
+        glViewport(0, 0, size, size);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        m_CaptureScene(view, projection, m_CapturePosition);
+        return;
+    }
+
+    if (step == 6) {
+        glBindTexture(GL_TEXTURE_CUBE_MAP, m_envCubemap);
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+        if (m_SHReadback) {
+            // 异步读回到PBO，几帧后的最后一步再映射，避免同步等待GPU
+            int size = std::max(1, m_Params.envSize >> m_SHReadbackMip);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, m_SHReadback);
+            for (unsigned int i = 0; i < 6; ++i)
+                glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, m_SHReadbackMip, GL_RGB, GL_FLOAT,
+                    (void*)((size_t)i * size * size * 3 * sizeof(float)));
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+        else {
+            ConvolveIrradiance(*m_IrradianceShader, m_irradianceBack);
+        }
+        return;
+    }
+
+    int mip = step - 7;
+    PrefilterMip(*m_PrefilterShader, m_prefilterBack, mip);
+    if (mip + 1 < m_Params.prefilterMips) return;
+
+    // 一轮完成：交换前后台
+    std::swap(m_prefilterMap, m_prefilterBack);
+    if (m_irradianceBack)
+        std::swap(m_irradianceMap, m_irradianceBack);
+    if (m_SHReadback) {
+        int size = std::max(1, m_Params.envSize >> m_SHReadbackMip);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_SHReadback);
+        const float* faces = static_cast<const float*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+        if (faces) {
+            m_SH = SphericalHarmonics::ProjectCubemap(faces, size);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    ++m_CaptureCycles;
+}
+
+bool IBL::SupportsBC6H() {
+    static int supported = -1;
+    if (supported < 0) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        supported = 0;
+        for (GLint i = 0; i < count && !supported; ++i) {
+            const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            supported = name && std::strcmp(name, "GL_ARB_texture_compression_bptc") == 0;
+        }
+    }
+    return supported == 1;
+}
+
+// ================== 质量档位报告 ==================
+void IBL::ReportQuality(const std::string& hdrPath) {
+    // 关闭球谐以覆盖辐照度卷积阶段；不读写缓存，保证每个档位都真实烘焙
+    const IBLQuality tiers[] = { IBLQuality::Reference, IBLQuality::Default, IBLQuality::Fast };
+    IBLCacheData results[3];
+    StageTimings timings[3];
+    for (int i = 0; i < 3; ++i) {
+        IBL ibl(hdrPath, false, tiers[i], IBLFormat::RGB16F, false);
+        ibl.ReadBack(results[i]);
+        timings[i] = ibl.m_Timings;
+    }
+
+    std::cout << "IBL quality report: " << hdrPath << " (error = relative RMS vs reference)" << std::endl;
+    for (int i = 0; i < 3; ++i) {
+        const IBLCacheData& test = results[i];
+        const IBLCacheData& reference = results[0];
+        std::cout << "  " << IBLBakeParams::QualityName(tiers[i])
+            << "  env " << timings[i].env << " ms / " << IBLBaker::RelativeError(test.env, reference.env) * 100.0 << "%"
+            << "  irradiance " << timings[i].irradiance << " ms / " << IBLBaker::RelativeError(test.irradiance, reference.irradiance) * 100.0 << "%"
+            << "  prefilter " << timings[i].prefilter << " ms / " << IBLBaker::RelativeError(test.prefilter, reference.prefilter) * 100.0 << "%"
+            << "  brdf " << timings[i].brdf << " ms / " << IBLBaker::RelativeError(test.brdf, reference.brdf) * 100.0 << "%"
+            << std::endl;
+    }
+
+    // 存储格式：以Default档位的产物为源，报告各格式的显存与误差（相对半精度源数据）
+    const IBLCacheData& data = results[1];
+    IBLImage env = IBLFormats::BuildMips(data.env);
+    const IBLFormat formats[] = { IBLFormat::RGB16F, IBLFormat::R11G11B10F, IBLFormat::RGB9E5, IBLFormat::BC6H };
+    std::cout << "IBL storage formats (default tier, error = relative RMS vs RGB16F):" << std::endl;
+    for (IBLFormat format : formats) {
+        size_t bytes = (size_t)((env.data.size() + data.irradiance.data.size() + data.prefilter.data.size()) / 3 *
+            IBLFormats::BytesPerTexel(format));
+        std::cout << "  " << IBLFormats::Name(format) << "  " << bytes / (1024.0 * 1024.0) << " MB"
+            << "  env " << IBLFormats::FormatError(env, format) * 100.0 << "%"
+            << "  irradiance " << IBLFormats::FormatError(data.irradiance, format) * 100.0 << "%"
+            << "  prefilter " << IBLFormats::FormatError(data.prefilter, format) * 100.0 << "%" << std::endl;
+    }
 }
 
 void IBL::BindIrradianceMap(GLenum textureUnit) const {
@@ -158,119 +613,128 @@ void IBL::BindBRDFLUT(GLenum textureUnit) const {
     glBindTexture(GL_TEXTURE_2D, m_brdfLUT);
 }
 
-// ================== IBLԤ ==================
+void IBL::ApplySH(const Shader& shader) const {
+    for (int i = 0; i < 9; ++i)
+        shader.setVec3("shCoefficients[" + std::to_string(i) + "]", m_SH.c[i]);
+}
+
+// ================== IBL预计算核心 ==================
 void IBL::PrecomputeIrradianceMap() {
-    // նͼ
-    glGenTextures(1, &m_irradianceMap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_irradianceMap);
-    for (unsigned int i = 0; i < 6; ++i) {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F,
-            32, 32, 0, GL_RGB, GL_FLOAT, nullptr);
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // 创建辐照度贴图
+    int size = m_Params.irradianceSize;
+    m_irradianceMap = CreateCubemap(size, 1, false, nullptr);
 
-    // ֡
+    // 配置帧缓冲
     glBindFramebuffer(GL_FRAMEBUFFER, m_captureFBO);
     glBindRenderbuffer(GL_RENDERBUFFER, m_captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 32, 32);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
 
-    // ն
-    Shader irradianceShader("shaders/cubemap.vert", "shaders/irradiance_convolution.frag");
-    irradianceShader.use();
-    irradianceShader.setInt("environmentMap", 0);
-    irradianceShader.setMat4("projection", captureProjection);
+    // 卷积计算辐照度
+    std::unique_ptr<Shader> irradianceShader = MakeIrradianceShader();
+    ConvolveIrradiance(*irradianceShader, m_irradianceMap);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+std::unique_ptr<Shader> IBL::MakeIrradianceShader() const {
+    auto shader = std::make_unique<Shader>("shaders/cubemap.vert", "shaders/irradiance_convolution.frag");
+    shader->use();
+    shader->setInt("environmentMap", 0);
+    shader->setMat4("projection", captureProjection);
+    shader->setFloat("sampleDelta", m_Params.irradianceDelta);
+    // 源mip：一个源纹素约覆盖 (PI/2)/envSize 弧度，与采样步长匹配
+    float sourceLod = m_Params.mipFiltered
+        ? std::max(0.0f, std::log2(m_Params.irradianceDelta * m_Params.envSize * 2.0f / 3.14159265f)) : 0.0f;
+    shader->setFloat("sourceLod", sourceLod);
+    return shader;
+}
+
+// 调用前须绑定m_captureFBO，深度缓冲不小于辐照度贴图
+void IBL::ConvolveIrradiance(const Shader& shader, GLuint target) {
+    int size = m_Params.irradianceSize;
+    shader.use();
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_CUBE_MAP, m_envCubemap);
-
-    glViewport(0, 0, 32, 32);
+    glViewport(0, 0, size, size);
     for (unsigned int i = 0; i < 6; ++i) {
-        irradianceShader.setMat4("view", captureViews[i]);
+        shader.setMat4("view", captureViews[i]);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-            GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, m_irradianceMap, 0);
+            GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, target, 0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         RenderCube();
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void IBL::PrecomputePrefilterMap() {
-    // Ԥ˲ͼ
-    glGenTextures(1, &m_prefilterMap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_prefilterMap);
-    for (unsigned int i = 0; i < 6; ++i) {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F,
-            128, 128, 0, GL_RGB, GL_FLOAT, nullptr);
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-
-    // Ԥ˲
-    Shader prefilterShader("shaders/cubemap.vert", "shaders/prefilter.frag");
-    prefilterShader.use();
-    prefilterShader.setInt("environmentMap", 0);
-    prefilterShader.setMat4("projection", captureProjection);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_envCubemap);
+    // 创建预滤波贴图（只分配实际渲染的mip级别）
+    unsigned int maxMipLevels = m_Params.prefilterMips;
+    m_prefilterMap = CreateCubemap(m_Params.prefilterSize, maxMipLevels, true, nullptr);
 
+    // 预滤波计算
+    std::unique_ptr<Shader> prefilterShader = MakePrefilterShader();
     glBindFramebuffer(GL_FRAMEBUFFER, m_captureFBO);
-    unsigned int maxMipLevels = 5;
     for (unsigned int mip = 0; mip < maxMipLevels; ++mip) {
-        unsigned int mipWidth = 128 * std::pow(0.5, mip);
-        unsigned int mipHeight = 128 * std::pow(0.5, mip);
+        unsigned int mipSize = std::max(1, m_Params.prefilterSize >> mip);
         glBindRenderbuffer(GL_RENDERBUFFER, m_captureRBO);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
-        glViewport(0, 0, mipWidth, mipHeight);
-
-        float roughness = (float)mip / (float)(maxMipLevels - 1);
-        prefilterShader.setFloat("roughness", roughness);
-        for (unsigned int i = 0; i < 6; ++i) {
-            prefilterShader.setMat4("view", captureViews[i]);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, m_prefilterMap, mip);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            RenderCube();
-        }
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipSize, mipSize);
+        PrefilterMip(*prefilterShader, m_prefilterMap, mip);
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+std::unique_ptr<Shader> IBL::MakePrefilterShader() const {
+    auto shader = std::make_unique<Shader>("shaders/cubemap.vert", "shaders/prefilter.frag");
+    shader->use();
+    shader->setInt("environmentMap", 0);
+    shader->setMat4("projection", captureProjection);
+    shader->setInt("sampleCount", m_Params.prefilterSamples);
+    shader->setFloat("envResolution", (float)m_Params.envSize);
+    shader->setBool("mipFiltered", m_Params.mipFiltered);
+    return shader;
+}
+
+// 渲染预滤波贴图的一级mip（6个面）；调用前须绑定m_captureFBO，深度缓冲不小于该mip
+void IBL::PrefilterMip(const Shader& shader, GLuint target, unsigned int mip) {
+    unsigned int mipSize = std::max(1, m_Params.prefilterSize >> mip);
+    shader.use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_envCubemap);
+    glViewport(0, 0, mipSize, mipSize);
+
+    float roughness = m_Params.prefilterMips > 1 ? (float)mip / (float)(m_Params.prefilterMips - 1) : 0.0f;
+    shader.setFloat("roughness", roughness);
+    shader.setFloat("totalWeight", PrefilterTotalWeight(roughness, m_Params.prefilterSamples));
+    for (unsigned int i = 0; i < 6; ++i) {
+        shader.setMat4("view", captureViews[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+            GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, target, mip);
+        DrawSampleBatches(shader, m_Params.prefilterSamples, [this]() { RenderCube(); });
+    }
+}
+
 void IBL::PrecomputeBRDFLUT() {
-    // BRDF
-    glGenTextures(1, &m_brdfLUT);
-    glBindTexture(GL_TEXTURE_2D, m_brdfLUT);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, 512, 512, 0, GL_RG, GL_FLOAT, 0);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // 创建BRDF查找纹理
+    int size = m_Params.brdfSize;
+    m_brdfLUT = CreateBRDFLUT(size, nullptr);
 
-    // ֡
+    // 配置帧缓冲
     glBindFramebuffer(GL_FRAMEBUFFER, m_captureFBO);
     glBindRenderbuffer(GL_RENDERBUFFER, m_captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_brdfLUT, 0);
 
-    // BRDF
-    glViewport(0, 0, 512, 512);
+    // 计算BRDF积分
+    glViewport(0, 0, size, size);
     Shader brdfShader("shaders/brdf.vert", "shaders/brdf.frag");
     brdfShader.use();
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    RenderQuad();
+    brdfShader.setInt("sampleCount", m_Params.brdfSamples);
+    DrawSampleBatches(brdfShader, m_Params.brdfSamples, [this]() { RenderQuad(); });
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-// ================== Ⱦ ==================
+// ================== 渲染辅助方法 ==================
 void IBL::RenderCube() {
-    // ʼVAO״εʱִУ
+    // 初始化立方体VAO（首次调用时执行）
     if (cubeVAO == 0) {
         glGenVertexArrays(1, &cubeVAO);
         glGenBuffers(1, &cubeVBO);
@@ -289,7 +753,7 @@ void IBL::RenderCube() {
         glBindVertexArray(0);
     }
 
-    // Ⱦ
+    // 渲染立方体
     glBindVertexArray(cubeVAO);
     glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
@@ -298,10 +762,10 @@ void IBL::RenderCube() {
 void IBL::RenderQuad() {
     static unsigned int quadVAO = 0, quadVBO;
 
-    // ʼıVAO״εʱִУ
+    // 初始化四边形VAO（首次调用时执行）
     if (quadVAO == 0) {
         float quadVertices[] = {
-            // λ       // UV
+            // 位置       // UV
             -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
             -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
              1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
@@ -322,7 +786,7 @@ void IBL::RenderQuad() {
         glBindVertexArray(0);
     }
 
-    // Ⱦı
+    // 渲染四边形
     glBindVertexArray(quadVAO);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
     glBindVertexArray(0);
@@ -1,39 +1,129 @@
 #pragma once
 #include <glad/glad.h>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <glm/glm.hpp>
 #include "Shader.h"
+#include "IBLCache.h"
+#include "IBLFormats.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 class IBL {
 public:
-    IBL(const std::string& hdrPath);
+    // useSH：漫反射环境光使用L2球谐系数（pbr.frag的SH_IRRADIANCE变体），不再生成辐照度贴图
+    // quality：烘焙质量档位（分辨率、mip数、样本数）；useCache为false时总是重新烘焙且不写缓存
+    // format：运行时立方体贴图的存储格式（缓存始终为半精度，BRDF查找表固定RG16F）
+    IBL(const std::string& hdrPath, bool useSH = true, IBLQuality quality = IBLQuality::Default,
+        IBLFormat format = IBLFormat::RGB16F, bool useCache = true);
+    // 由已加载的缓存数据直接创建（探针异步加载使用，不烘焙、不访问HDR文件）
+    IBL(const IBLCacheData& cache, const IBLBakeParams& params, IBLFormat format);
+    // 动态探针：不读取HDR，从探针位置渲染场景到captureSize的立方体贴图，UpdateCapture按帧分片更新
+    IBL(int captureSize, bool useSH, IBLQuality quality);
     ~IBL();
 
+    // 烘焙失败时为false
+    bool IsValid() const { return m_prefilterMap != 0; }
+    // 全部IBL纹理的显存占用
+    size_t GetResidentBytes() const { return m_ResidentBytes; }
+
     void BindIrradianceMap(GLenum textureUnit) const;
     void BindPrefilterMap(GLenum textureUnit) const;
     void BindBRDFLUT(GLenum textureUnit) const;
+    // 上传球谐系数到shCoefficients[9]
+    void ApplySH(const Shader& shader) const;
+    bool UsesSH() const { return m_Params.shIrradiance; }
+    const SH9Color& GetSH() const { return m_SH; }
+    // pbr.frag的maxReflectionLod
+    float GetMaxReflectionLod() const { return (float)(m_Params.prefilterMips - 1); }
+
+    // ================== 动态探针 ==================
+    // 渲染场景的回调：调用时已绑定捕获帧缓冲和视口，不得修改帧缓冲绑定
+    using SceneRenderer = std::function<void(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position)>;
+    void SetCaptureScene(SceneRenderer renderer) { m_CaptureScene = std::move(renderer); }
+    void SetCapturePosition(const glm::vec3& position) { m_CapturePosition = position; }
+    // 每帧的GPU时间预算（毫秒），按各步骤实测耗时决定本帧执行几步，至少一步
+    void SetCaptureBudget(float ms) { m_CaptureBudgetMs = ms; }
+    // 执行本帧的更新步骤（一个面、一次mip生成或一级预滤波mip），完成一轮并交换结果时返回true
+    bool UpdateCapture();
+    bool IsDynamic() const { return m_Dynamic; }
+    bool HasCapture() const { return m_CaptureCycles > 0; }
+
+    // 驱动是否支持BPTC（BC6H）压缩纹理
+    static bool SupportsBC6H();
+    // 质量档位对应的烘焙参数（含着色器哈希），与构造函数计算缓存键的方式相同
+    static IBLBakeParams MakeParams(bool useSH, IBLQuality quality);
+    // 不支持的存储格式回退到R11G11B10F
+    static IBLFormat ResolveFormat(IBLFormat format);
+
+    // 依次用三个质量档位烘焙同一HDR，输出各阶段耗时及相对Reference档位的误差（开发时使用）
+    static void ReportQuality(const std::string& hdrPath);
 
 private:
-    GLuint m_envCubemap;      // ͼ
-    GLuint m_irradianceMap;    // նͼ
-    GLuint m_prefilterMap;     // 淴Ԥ˲ͼ
-    GLuint m_brdfLUT;          // BRDF
-    GLuint m_captureFBO;       // ֡
-    GLuint m_captureRBO;       // Ⱦ
-
-    // ʹvector洢ͼԭᵼ³ʼ⣩
+    GLuint m_envCubemap = 0;      // 环境立方体贴图
+    GLuint m_irradianceMap = 0;    // 漫反射辐照度贴图
+    GLuint m_prefilterMap = 0;     // 镜面反射预滤波贴图
+    GLuint m_brdfLUT = 0;          // BRDF查找纹理
+    GLuint m_captureFBO = 0;       // 帧缓冲对象
+    GLuint m_captureRBO = 0;       // 渲染缓冲对象
+    IBLBakeParams m_Params;        // 烘焙分辨率等参数（参与缓存键）
+    IBLFormat m_Format = IBLFormat::RGB16F;
+    SH9Color m_SH;                 // 漫反射球谐系数
+    size_t m_ResidentBytes = 0;
+
+    // 各烘焙阶段耗时（毫秒，glFinish同步后计时）
+    struct StageTimings {
+        double env = 0.0, irradiance = 0.0, prefilter = 0.0, brdf = 0.0;
+    };
+    StageTimings m_Timings;
+
+    // 使用vector存储视图矩阵（原数组会导致初始化问题）
     std::vector<glm::mat4> captureViews;
     glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
 
-    // Ⱦ
+    // 动态探针状态
+    bool m_Dynamic = false;
+    SceneRenderer m_CaptureScene;
+    glm::vec3 m_CapturePosition = glm::vec3(0.0f);
+    float m_CaptureBudgetMs = 1.0f;
+    int m_CaptureStep = 0;
+    uint64_t m_CaptureCycles = 0;
+    GLuint m_prefilterBack = 0;    // 正在更新的预滤波贴图，完成后与m_prefilterMap交换
+    GLuint m_irradianceBack = 0;
+    GLuint m_SHReadback = 0;       // 球谐读回PBO
+    int m_SHReadbackMip = 0;
+    std::unique_ptr<Shader> m_PrefilterShader;
+    std::unique_ptr<Shader> m_IrradianceShader;
+    std::vector<GLuint> m_StepQueries;      // 每个步骤一个GL_TIME_ELAPSED查询
+    std::vector<bool> m_StepQueryPending;
+    std::vector<float> m_StepCostMs;        // 各步骤GPU耗时的平滑估计
+    int CaptureStepCount() const;
+    void RunCaptureStep(int step);
+
+    // 辅助渲染方法
+    void InitCaptureViews();
     void RenderCube();
     void RenderQuad();
 
-    // IBLԤ
+    // 磁盘缓存：命中时直接上传，未命中时烘焙后读回保存
+    bool Bake(const std::string& hdrPath);
+    void UploadFromCache(const IBLCacheData& cache);
+    void ReadBack(IBLCacheData& cache) const;
+    void TrackResidency();
+    // format不是RGB16F时image必须非空（紧凑格式只从缓存数据创建）；bc6h为离线压缩的块，可为空
+    static GLuint CreateCubemap(int size, int levels, bool mipFilter, const IBLImage* image,
+        IBLFormat format = IBLFormat::RGB16F, const std::vector<uint8_t>* bc6h = nullptr);
+    static GLuint CreateBRDFLUT(int size, const IBLImage* image);
+
+    // IBL预计算核心流程
     void PrecomputeIrradianceMap();
     void PrecomputePrefilterMap();
     void PrecomputeBRDFLUT();
+    // 烘焙与动态探针共用：固定uniform在创建时设置；渲染前须绑定m_captureFBO
+    std::unique_ptr<Shader> MakeIrradianceShader() const;
+    std::unique_ptr<Shader> MakePrefilterShader() const;
+    void ConvolveIrradiance(const Shader& shader, GLuint target);
+    void PrefilterMip(const Shader& shader, GLuint target, unsigned int mip);
 };
@@ -0,0 +1,573 @@
+#include "IBLBaker.h"
+#include "SphericalHarmonics.h"
+#include "HDRStream.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define IBL_BAKER_SSE 1
+#endif
+
+static const float PI = 3.14159265359f;
+static const int ROWS_PER_TASK = 16;
+
+// 与着色器相同的Hammersley序列
+static float RadicalInverse(uint32_t bits) {
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return float(bits) * 2.3283064365386963e-10f;
+}
+
+static double ElapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ================== FloatCubemap ==================
+void FloatCubemap::Allocate(int faceSize, int mipCount) {
+    size = faceSize;
+    mips = mipCount;
+    data.assign(Offset(mips, 0), 0.0f);
+}
+
+size_t FloatCubemap::Offset(int mip, int face) const {
+    size_t offset = 0;
+    for (int m = 0; m < mip; ++m)
+        offset += (size_t)MipSize(m) * MipSize(m) * 3 * 6;
+    return offset + (size_t)MipSize(mip) * MipSize(mip) * 3 * face;
+}
+
+glm::vec3 FloatCubemap::TexelDirection(int face, int x, int y, int faceSize) {
+    float sc = 2.0f * (x + 0.5f) / faceSize - 1.0f;
+    float tc = 2.0f * (y + 0.5f) / faceSize - 1.0f;
+    glm::vec3 dir;
+    switch (face) {
+    case 0: dir = glm::vec3(1.0f, -tc, -sc); break;    // +X
+    case 1: dir = glm::vec3(-1.0f, -tc, sc); break;    // -X
+    case 2: dir = glm::vec3(sc, 1.0f, tc); break;      // +Y
+    case 3: dir = glm::vec3(sc, -1.0f, -tc); break;    // -Y
+    case 4: dir = glm::vec3(sc, -tc, 1.0f); break;     // +Z
+    default: dir = glm::vec3(-sc, -tc, -1.0f); break;  // -Z
+    }
+    return glm::normalize(dir);
+}
+
+glm::vec3 FloatCubemap::SampleFace(int mip, int face, float s, float t) const {
+    int n = MipSize(mip);
+    float fx = s * n - 0.5f, fy = t * n - 0.5f;
+    int x0 = (int)std::floor(fx), y0 = (int)std::floor(fy);
+    float tx = fx - x0, ty = fy - y0;
+    int x1 = std::min(std::max(x0 + 1, 0), n - 1), y1 = std::min(std::max(y0 + 1, 0), n - 1);
+    x0 = std::min(std::max(x0, 0), n - 1);
+    y0 = std::min(std::max(y0, 0), n - 1);
+
+    const float* p = Face(mip, face);
+    auto texel = [&](int x, int y) { const float* c = p + ((size_t)y * n + x) * 3; return glm::vec3(c[0], c[1], c[2]); };
+    return glm::mix(glm::mix(texel(x0, y0), texel(x1, y0), tx), glm::mix(texel(x0, y1), texel(x1, y1), tx), ty);
+}
+
+glm::vec3 FloatCubemap::Sample(const glm::vec3& dir, float lod) const {
+    // GL规范的面选择：主轴决定面，sc/tc为另外两个分量
+    glm::vec3 a = glm::abs(dir);
+    int face;
+    float sc, tc, ma;
+    if (a.x >= a.y && a.x >= a.z) {
+        face = dir.x > 0.0f ? 0 : 1;
+        sc = dir.x > 0.0f ? -dir.z : dir.z;
+        tc = -dir.y;
+        ma = a.x;
+    }
+    else if (a.y >= a.z) {
+        face = dir.y > 0.0f ? 2 : 3;
+        sc = dir.x;
+        tc = dir.y > 0.0f ? dir.z : -dir.z;
+        ma = a.y;
+    }
+    else {
+        face = dir.z > 0.0f ? 4 : 5;
+        sc = dir.z > 0.0f ? dir.x : -dir.x;
+        tc = -dir.y;
+        ma = a.z;
+    }
+    float s = 0.5f * (sc / ma + 1.0f), t = 0.5f * (tc / ma + 1.0f);
+
+    lod = std::min(std::max(lod, 0.0f), (float)(mips - 1));
+    int mip0 = (int)lod;
+    float frac = lod - mip0;
+    glm::vec3 color = SampleFace(mip0, face, s, t);
+    if (frac > 0.0f && mip0 + 1 < mips)
+        color = glm::mix(color, SampleFace(mip0 + 1, face, s, t), frac);
+    return color;
+}
+
+void FloatCubemap::ToImage(IBLImage& image, int mipCount) const {
+    if (mipCount <= 0 || mipCount > mips) mipCount = mips;
+    image.Allocate(size, size, 6, mipCount, 3);
+    size_t count = image.data.size();
+    for (size_t i = 0; i < count; ++i)
+        image.data[i] = IBLCache::FloatToHalf(data[i]);
+}
+
+void FloatCubemap::FromImage(const IBLImage& image) {
+    Allocate(image.width, image.mips);
+    size_t count = std::min(data.size(), image.data.size());
+    for (size_t i = 0; i < count; ++i)
+        data[i] = IBLCache::HalfToFloat(image.data[i]);
+}
+
+// ================== IBLBaker ==================
+IBLBaker::IBLBaker(const IBLBakeParams& params, const IBLBakeOptions& options)
+    : m_Params(params), m_Options(options) {
+}
+
+void IBLBaker::ParallelFor(int count, const std::function<void(int)>& task) const {
+    unsigned int threadCount = m_Options.threads ? m_Options.threads : std::thread::hardware_concurrency();
+    threadCount = std::max(1u, std::min(threadCount, (unsigned int)count));
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (int i = next++; i < count; i = next++)
+            task(i);
+    };
+    std::vector<std::thread> workers;
+    for (unsigned int t = 1; t < threadCount; ++t)
+        workers.emplace_back(worker);
+    worker();
+    for (std::thread& w : workers)
+        w.join();
+}
+
+bool IBLBaker::BakeFile(const std::string& hdrPath, IBLCacheData& out) {
+    // 与运行时相同的流式解码：直接得到半精度环境贴图mip0和球谐系数
+    auto start = std::chrono::steady_clock::now();
+    if (!HDRStream::LoadCubemap(hdrPath, m_Params.envSize, out.env, out.sh))
+        return false;
+    FloatCubemap env;
+    int levels = 1;
+    while ((out.env.width >> levels) > 0) ++levels;
+    env.Allocate(out.env.width, levels);
+    for (size_t i = 0; i < out.env.data.size(); ++i)
+        env.data[i] = IBLCache::HalfToFloat(out.env.data[i]);
+    GenerateMips(env);
+    m_Stats.env = ElapsedMs(start);
+
+    BakeConvolutions(env, out);
+    return true;
+}
+
+void IBLBaker::BakeEquirect(const float* pixels, int width, int height, int components, IBLCacheData& out) {
+    auto start = std::chrono::steady_clock::now();
+    FloatCubemap env;
+    EquirectToCubemap(pixels, width, height, components, env);
+    GenerateMips(env);
+    env.ToImage(out.env, 1);
+    m_Stats.env = ElapsedMs(start);
+
+    out.sh = SphericalHarmonics::ProjectEquirect(pixels, width, height, components);
+    BakeConvolutions(env, out);
+}
+
+void IBLBaker::BakeConvolutions(const FloatCubemap& env, IBLCacheData& out) {
+    auto start = std::chrono::steady_clock::now();
+    if (m_Params.shIrradiance) {
+        out.irradiance = IBLImage();
+    }
+    else {
+        FloatCubemap irradiance;
+        ConvolveIrradiance(env, irradiance);
+        irradiance.ToImage(out.irradiance);
+    }
+    m_Stats.irradiance = ElapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    FloatCubemap prefilter;
+    PrefilterSpecular(env, prefilter);
+    prefilter.ToImage(out.prefilter);
+    m_Stats.prefilter = ElapsedMs(start);
+
+    m_Stats.brdf = 0.0;
+    if (m_BRDF.data.empty()) {
+        start = std::chrono::steady_clock::now();
+        IntegrateBRDF(m_BRDF);
+        m_Stats.brdf = ElapsedMs(start);
+    }
+    out.brdf = m_BRDF;
+}
+
+void IBLBaker::PrintStats() const {
+    std::cout << "IBLBAKE: environment " << m_Params.envSize << "^2 x6 " << m_Stats.env << " ms, diffuse "
+        << m_Stats.irradiance << " ms, prefilter " << m_Params.prefilterSize << "^2 x" << m_Params.prefilterMips
+        << " mips " << m_Params.prefilterSamples << " spp " << m_Stats.prefilter << " ms";
+    if (m_Stats.brdf > 0.0)
+        std::cout << ", BRDF LUT " << m_Params.brdfSize << "^2 " << m_Stats.brdf << " ms";
+    std::cout << std::endl;
+}
+
+// ================== 等距柱状图 -> 立方体贴图 ==================
+void IBLBaker::EquirectToCubemap(const float* pixels, int width, int height, int components, FloatCubemap& env) const {
+    int size = m_Params.envSize;
+    int levels = 1;
+    while ((size >> levels) > 0) ++levels;
+    env.Allocate(size, levels);
+
+    int bands = (size + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    ParallelFor(6 * bands, [&](int task) {
+        int face = task / bands;
+        int rowStart = (task % bands) * ROWS_PER_TASK;
+        int rowEnd = std::min(rowStart + ROWS_PER_TASK, size);
+        float* dst = env.Face(0, face);
+        for (int y = rowStart; y < rowEnd; ++y) {
+            for (int x = 0; x < size; ++x) {
+                // 与equirectangular_to_cubemap.frag相同的映射，经度方向环绕，纬度方向钳制
+                glm::vec3 dir = FloatCubemap::TexelDirection(face, x, y, size);
+                float u = std::atan2(dir.z, dir.x) / (2.0f * PI) + 0.5f;
+                float v = std::asin(std::min(std::max(dir.y, -1.0f), 1.0f)) / PI + 0.5f;
+                float fx = u * width - 0.5f, fy = v * height - 0.5f;
+                int x0 = (int)std::floor(fx), y0 = (int)std::floor(fy);
+                float tx = fx - x0, ty = fy - y0;
+                int x1 = ((x0 + 1) % width + width) % width;
+                x0 = (x0 % width + width) % width;
+                int y1 = std::min(std::max(y0 + 1, 0), height - 1);
+                y0 = std::min(std::max(y0, 0), height - 1);
+
+                float* out = dst + ((size_t)y * size + x) * 3;
+                for (int c = 0; c < 3; ++c) {
+                    float c00 = pixels[((size_t)y0 * width + x0) * components + c];
+                    float c10 = pixels[((size_t)y0 * width + x1) * components + c];
+                    float c01 = pixels[((size_t)y1 * width + x0) * components + c];
+                    float c11 = pixels[((size_t)y1 * width + x1) * components + c];
+                    out[c] = (c00 + (c10 - c00) * tx) * (1.0f - ty) + (c01 + (c11 - c01) * tx) * ty;
+                }
+            }
+        }
+    });
+}
+
+// 2x2盒式降采样（与glGenerateMipmap等价）
+void IBLBaker::GenerateMips(FloatCubemap& cube) const {
+    for (int mip = 1; mip < cube.mips; ++mip) {
+        int srcSize = cube.MipSize(mip - 1), dstSize = cube.MipSize(mip);
+        ParallelFor(6, [&](int face) {
+            const float* src = cube.Face(mip - 1, face);
+            float* dst = cube.Face(mip, face);
+            for (int y = 0; y < dstSize; ++y) {
+                int sy0 = std::min(2 * y, srcSize - 1), sy1 = std::min(2 * y + 1, srcSize - 1);
+                for (int x = 0; x < dstSize; ++x) {
+                    int sx0 = std::min(2 * x, srcSize - 1), sx1 = std::min(2 * x + 1, srcSize - 1);
+                    for (int c = 0; c < 3; ++c) {
+                        dst[((size_t)y * dstSize + x) * 3 + c] = 0.25f * (
+                            src[((size_t)sy0 * srcSize + sx0) * 3 + c] + src[((size_t)sy0 * srcSize + sx1) * 3 + c] +
+                            src[((size_t)sy1 * srcSize + sx0) * 3 + c] + src[((size_t)sy1 * srcSize + sx1) * 3 + c]);
+                    }
+                }
+            }
+        });
+    }
+}
+
+// ================== 镜面预滤波 ==================
+void IBLBaker::PrefilterSpecular(const FloatCubemap& env, FloatCubemap& prefilter) const {
+    int mipCount = m_Params.prefilterMips;
+    int sampleCount = m_Params.prefilterSamples;
+    prefilter.Allocate(m_Params.prefilterSize, mipCount);
+
+    // 视线V = N时，切线空间内的采样方向、权重和源mip只与粗糙度有关，每级mip预先计算一次
+    struct SampleTable {
+        std::vector<float> x, y, z, weight, lod;
+    };
+    std::vector<SampleTable> tables(mipCount);
+    float saTexel = 4.0f * PI / (6.0f * m_Params.envSize * m_Params.envSize);
+    for (int mip = 0; mip < mipCount; ++mip) {
+        float roughness = mipCount > 1 ? (float)mip / (float)(mipCount - 1) : 0.0f;
+        float a = roughness * roughness;
+        SampleTable& table = tables[mip];
+        for (int i = 0; i < sampleCount; ++i) {
+            float phi = 2.0f * PI * (float)i / (float)sampleCount;
+            float xi = RadicalInverse((uint32_t)i);
+            float cosTheta = std::sqrt((1.0f - xi) / (1.0f + (a * a - 1.0f) * xi));
+            float sinTheta = std::sqrt(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+            glm::vec3 H(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta);
+            glm::vec3 L = 2.0f * H.z * H - glm::vec3(0.0f, 0.0f, 1.0f);
+            if (L.z <= 0.0f) continue;
+
+            // 按PDF估计每个样本覆盖的立体角，选择对应的源mip
+            float denom = H.z * H.z * (a * a - 1.0f) + 1.0f;
+            float D = a * a / std::max(PI * denom * denom, 0.001f);
+            float pdf = D * 0.25f + 0.0001f;
+            float saSample = 1.0f / (sampleCount * pdf + 0.0001f);
+            float lod = (roughness == 0.0f || !m_Params.mipFiltered) ? 0.0f : 0.5f * std::log2(saSample / saTexel);
+
+            table.x.push_back(L.x);
+            table.y.push_back(L.y);
+            table.z.push_back(L.z);
+            table.weight.push_back(L.z);
+            table.lod.push_back(lod);
+        }
+    }
+
+    std::vector<int> taskMip, taskFace, taskRow;
+    for (int mip = 0; mip < mipCount; ++mip) {
+        int n = prefilter.MipSize(mip);
+        for (int face = 0; face < 6; ++face)
+            for (int row = 0; row < n; row += ROWS_PER_TASK) {
+                taskMip.push_back(mip);
+                taskFace.push_back(face);
+                taskRow.push_back(row);
+            }
+    }
+
+    ParallelFor((int)taskMip.size(), [&](int task) {
+        int mip = taskMip[task], face = taskFace[task];
+        int n = prefilter.MipSize(mip);
+        int rowEnd = std::min(taskRow[task] + ROWS_PER_TASK, n);
+        const SampleTable& table = tables[mip];
+        int count = (int)table.x.size();
+        std::vector<float> wx(count), wy(count), wz(count);
+        float* dst = prefilter.Face(mip, face);
+
+        for (int y = taskRow[task]; y < rowEnd; ++y) {
+            for (int x = 0; x < n; ++x) {
+                glm::vec3 N = FloatCubemap::TexelDirection(face, x, y, n);
+                glm::vec3 color(0.0f);
+                if (mip == 0) {
+                    // 粗糙度为0时所有样本都等于N
+                    color = env.Sample(N, 0.0f);
+                }
+                else {
+                    // 与prefilter.frag相同的切线基
+                    glm::vec3 up = std::abs(N.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+                    glm::vec3 T = glm::normalize(glm::cross(up, N));
+                    glm::vec3 B = glm::cross(N, T);
+
+                    // 旋转到世界空间，每次4个样本
+                    int i = 0;
+#ifdef IBL_BAKER_SSE
+                    for (; i + 4 <= count; i += 4) {
+                        __m128 lx = _mm_loadu_ps(&table.x[i]), ly = _mm_loadu_ps(&table.y[i]), lz = _mm_loadu_ps(&table.z[i]);
+                        _mm_storeu_ps(&wx[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(T.x), lx),
+                            _mm_mul_ps(_mm_set1_ps(B.x), ly)), _mm_mul_ps(_mm_set1_ps(N.x), lz)));
+                        _mm_storeu_ps(&wy[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(T.y), lx),
+                            _mm_mul_ps(_mm_set1_ps(B.y), ly)), _mm_mul_ps(_mm_set1_ps(N.y), lz)));
+                        _mm_storeu_ps(&wz[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(T.z), lx),
+                            _mm_mul_ps(_mm_set1_ps(B.z), ly)), _mm_mul_ps(_mm_set1_ps(N.z), lz)));
+                    }
+#endif
+                    for (; i < count; ++i) {
+                        wx[i] = T.x * table.x[i] + B.x * table.y[i] + N.x * table.z[i];
+                        wy[i] = T.y * table.x[i] + B.y * table.y[i] + N.y * table.z[i];
+                        wz[i] = T.z * table.x[i] + B.z * table.y[i] + N.z * table.z[i];
+                    }
+
+                    float totalWeight = 0.0f;
+                    for (i = 0; i < count; ++i) {
+                        color += env.Sample(glm::vec3(wx[i], wy[i], wz[i]), table.lod[i]) * table.weight[i];
+                        totalWeight += table.weight[i];
+                    }
+                    if (totalWeight > 0.0f) color /= totalWeight;
+                }
+                float* out = dst + ((size_t)y * n + x) * 3;
+                out[0] = color.r;
+                out[1] = color.g;
+                out[2] = color.b;
+            }
+        }
+    });
+}
+
+// ================== 漫反射辐照度卷积（关闭球谐时使用） ==================
+void IBLBaker::ConvolveIrradiance(const FloatCubemap& env, FloatCubemap& irradiance) const {
+    int size = m_Params.irradianceSize;
+    irradiance.Allocate(size, 1);
+
+    // 在不超过输出分辨率的环境mip上积分：结果是低频信号，更高分辨率不改变结果
+    int srcMip = 0;
+    while (srcMip + 1 < env.mips && env.MipSize(srcMip) > size) ++srcMip;
+    int n = env.MipSize(srcMip);
+
+    // 源纹素按SoA存放：方向与 颜色*立体角
+    size_t count = (size_t)n * n * 6;
+    std::vector<float> dx(count), dy(count), dz(count), r(count), g(count), b(count);
+    size_t index = 0;
+    for (int face = 0; face < 6; ++face) {
+        const float* src = env.Face(srcMip, face);
+        for (int y = 0; y < n; ++y) {
+            for (int x = 0; x < n; ++x, ++index) {
+                float sc = 2.0f * (x + 0.5f) / n - 1.0f, tc = 2.0f * (y + 0.5f) / n - 1.0f;
+                float solidAngle = (4.0f / (n * n)) / std::pow(1.0f + sc * sc + tc * tc, 1.5f);
+                glm::vec3 dir = FloatCubemap::TexelDirection(face, x, y, n);
+                dx[index] = dir.x; dy[index] = dir.y; dz[index] = dir.z;
+                const float* c = src + ((size_t)y * n + x) * 3;
+                r[index] = c[0] * solidAngle; g[index] = c[1] * solidAngle; b[index] = c[2] * solidAngle;
+            }
+        }
+    }
+
+    ParallelFor(6 * size, [&](int task) {
+        int face = task / size, y = task % size;
+        float* dst = irradiance.Face(0, face) + (size_t)y * size * 3;
+        for (int x = 0; x < size; ++x) {
+            glm::vec3 N = FloatCubemap::TexelDirection(face, x, y, size);
+            float sum[3] = { 0.0f, 0.0f, 0.0f };
+            size_t i = 0;
+#ifdef IBL_BAKER_SSE
+            __m128 accR = _mm_setzero_ps(), accG = _mm_setzero_ps(), accB = _mm_setzero_ps();
+            __m128 nx = _mm_set1_ps(N.x), ny = _mm_set1_ps(N.y), nz = _mm_set1_ps(N.z);
+            for (; i + 4 <= count; i += 4) {
+                __m128 cosine = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, _mm_loadu_ps(&dx[i])),
+                    _mm_mul_ps(ny, _mm_loadu_ps(&dy[i]))), _mm_mul_ps(nz, _mm_loadu_ps(&dz[i])));
+                cosine = _mm_max_ps(cosine, _mm_setzero_ps());
+                accR = _mm_add_ps(accR, _mm_mul_ps(cosine, _mm_loadu_ps(&r[i])));
+                accG = _mm_add_ps(accG, _mm_mul_ps(cosine, _mm_loadu_ps(&g[i])));
+                accB = _mm_add_ps(accB, _mm_mul_ps(cosine, _mm_loadu_ps(&b[i])));
+            }
+            float lanes[4];
+            _mm_storeu_ps(lanes, accR); sum[0] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+            _mm_storeu_ps(lanes, accG); sum[1] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+            _mm_storeu_ps(lanes, accB); sum[2] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+            for (; i < count; ++i) {
+                float cosine = std::max(N.x * dx[i] + N.y * dy[i] + N.z * dz[i], 0.0f);
+                sum[0] += cosine * r[i];
+                sum[1] += cosine * g[i];
+                sum[2] += cosine * b[i];
+            }
+            // 与irradiance_convolution.frag一致，存储 E / PI
+            for (int c = 0; c < 3; ++c)
+                dst[x * 3 + c] = sum[c] / PI;
+        }
+    });
+}
+
+// ================== BRDF积分 ==================
+void IBLBaker::IntegrateBRDF(IBLImage& lut) const {
+    int size = m_Params.brdfSize;
+    int sampleCount = m_Params.brdfSamples;
+    lut.Allocate(size, size, 1, 1, 2);
+
+    // 与粗糙度无关的部分预先计算：Hammersley的第二维与 sin(phi)
+    std::vector<float> xi(sampleCount), sinPhi(sampleCount);
+    for (int i = 0; i < sampleCount; ++i) {
+        xi[i] = RadicalInverse((uint32_t)i);
+        sinPhi[i] = std::sin(2.0f * PI * (float)i / (float)sampleCount);
+    }
+
+    ParallelFor(size, [&](int y) {
+        float roughness = (y + 0.5f) / size;
+        float a = roughness * roughness;
+        float k = roughness * roughness / 2.0f;
+        for (int x = 0; x < size; ++x) {
+            float NdotV = (x + 0.5f) / size;
+            float Vx = std::sqrt(1.0f - NdotV * NdotV), Vz = NdotV;
+            float G1V = NdotV / (NdotV * (1.0f - k) + k);
+            float A = 0.0f, B = 0.0f;
+            int i = 0;
+#ifdef IBL_BAKER_SSE
+            // N = +Z时brdf.frag的切线基为 T = -Y, B = +X，半程向量的世界x分量为 sin(phi)sin(theta)
+            __m128 accA = _mm_setzero_ps(), accB = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+            for (; i + 4 <= sampleCount; i += 4) {
+                __m128 vxi = _mm_loadu_ps(&xi[i]);
+                __m128 cosTheta = _mm_sqrt_ps(_mm_div_ps(_mm_sub_ps(one, vxi),
+                    _mm_add_ps(one, _mm_mul_ps(_mm_set1_ps(a * a - 1.0f), vxi))));
+                __m128 sinTheta = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(cosTheta, cosTheta)), zero));
+                __m128 hx = _mm_mul_ps(_mm_loadu_ps(&sinPhi[i]), sinTheta);
+                __m128 dotVH = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(Vx), hx), _mm_mul_ps(_mm_set1_ps(Vz), cosTheta));
+                __m128 NdotL = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(2.0f), dotVH), cosTheta), _mm_set1_ps(Vz));
+                __m128 mask = _mm_cmpgt_ps(NdotL, zero);
+                NdotL = _mm_max_ps(NdotL, zero);
+                __m128 VdotH = _mm_max_ps(dotVH, zero);
+
+                __m128 G1L = _mm_div_ps(NdotL, _mm_add_ps(_mm_mul_ps(NdotL, _mm_set1_ps(1.0f - k)), _mm_set1_ps(k)));
+                __m128 GVis = _mm_div_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(G1V), G1L), VdotH),
+                    _mm_mul_ps(cosTheta, _mm_set1_ps(NdotV)));
+                __m128 f = _mm_sub_ps(one, VdotH);
+                __m128 f2 = _mm_mul_ps(f, f);
+                __m128 Fc = _mm_mul_ps(_mm_mul_ps(f2, f2), f);
+                GVis = _mm_and_ps(mask, GVis);
+                accA = _mm_add_ps(accA, _mm_mul_ps(_mm_sub_ps(one, Fc), GVis));
+                accB = _mm_add_ps(accB, _mm_mul_ps(Fc, GVis));
+            }
+            float lanes[4];
+            _mm_storeu_ps(lanes, accA); A = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+            _mm_storeu_ps(lanes, accB); B = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+            for (; i < sampleCount; ++i) {
+                float cosTheta = std::sqrt((1.0f - xi[i]) / (1.0f + (a * a - 1.0f) * xi[i]));
+                float sinTheta = std::sqrt(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+                float dotVH = Vx * sinPhi[i] * sinTheta + Vz * cosTheta;
+                float NdotL = 2.0f * dotVH * cosTheta - Vz;
+                if (NdotL <= 0.0f) continue;
+                float VdotH = std::max(dotVH, 0.0f);
+                float G1L = NdotL / (NdotL * (1.0f - k) + k);
+                float GVis = G1V * G1L * VdotH / (cosTheta * NdotV);
+                float Fc = std::pow(1.0f - VdotH, 5.0f);
+                A += (1.0f - Fc) * GVis;
+                B += Fc * GVis;
+            }
+            uint16_t* out = &lut.data[((size_t)y * size + x) * 2];
+            out[0] = IBLCache::FloatToHalf(A / sampleCount);
+            out[1] = IBLCache::FloatToHalf(B / sampleCount);
+        }
+    });
+}
+
+// ================== 误差评估 ==================
+double IBLBaker::RelativeError(const IBLImage& test, const IBLImage& reference) {
+    if (test.data.empty() || reference.data.empty() || test.channels != reference.channels)
+        return -1.0;
+
+    double errorSum = 0.0, referenceSum = 0.0;
+    if (test.faces == 6 && reference.faces == 6 && test.channels == 3) {
+        FloatCubemap testCube, referenceCube;
+        testCube.FromImage(test);
+        referenceCube.FromImage(reference);
+        for (int mip = 0; mip < testCube.mips; ++mip) {
+            // 相同粗糙度：roughness = mip / (mips - 1)
+            float referenceLod = testCube.mips > 1 ? (float)mip / (testCube.mips - 1) * (referenceCube.mips - 1) : 0.0f;
+            int n = testCube.MipSize(mip);
+            for (int face = 0; face < 6; ++face) {
+                const float* p = testCube.Face(mip, face);
+                for (int y = 0; y < n; ++y)
+                    for (int x = 0; x < n; ++x) {
+                        glm::vec3 ref = referenceCube.Sample(FloatCubemap::TexelDirection(face, x, y, n), referenceLod);
+                        const float* c = p + ((size_t)y * n + x) * 3;
+                        glm::vec3 diff = glm::vec3(c[0], c[1], c[2]) - ref;
+                        errorSum += glm::dot(diff, diff);
+                        referenceSum += glm::dot(ref, ref);
+                    }
+            }
+        }
+    }
+    else if (test.faces == 1 && reference.faces == 1) {
+        int channels = test.channels;
+        auto fetch = [&](int x, int y, int c) {
+            return IBLCache::HalfToFloat(reference.data[((size_t)y * reference.width + x) * channels + c]);
+        };
+        for (int y = 0; y < test.height; ++y)
+            for (int x = 0; x < test.width; ++x) {
+                float fx = (x + 0.5f) / test.width * reference.width - 0.5f;
+                float fy = (y + 0.5f) / test.height * reference.height - 0.5f;
+                int x0 = std::min(std::max((int)std::floor(fx), 0), reference.width - 1);
+                int y0 = std::min(std::max((int)std::floor(fy), 0), reference.height - 1);
+                int x1 = std::min(x0 + 1, reference.width - 1), y1 = std::min(y0 + 1, reference.height - 1);
+                float tx = std::min(std::max(fx - x0, 0.0f), 1.0f), ty = std::min(std::max(fy - y0, 0.0f), 1.0f);
+                for (int c = 0; c < channels; ++c) {
+                    float ref = (fetch(x0, y0, c) * (1.0f - tx) + fetch(x1, y0, c) * tx) * (1.0f - ty) +
+                        (fetch(x0, y1, c) * (1.0f - tx) + fetch(x1, y1, c) * tx) * ty;
+                    float diff = IBLCache::HalfToFloat(test.data[((size_t)y * test.width + x) * channels + c]) - ref;
+                    errorSum += diff * diff;
+                    referenceSum += ref * ref;
+                }
+            }
+    }
+    else {
+        return -1.0;
+    }
+    return referenceSum > 0.0 ? std::sqrt(errorSum / referenceSum) : 0.0;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "IBLCache.h"
+
+// IBL烘焙的CPU实现（不需要GL上下文），产物与IBL类的GPU烘焙一致，直接写成运行时缓存格式
+// 流程：等距柱状图->立方体贴图、环境贴图mip、GGX重要性采样预滤波（按PDF选择源mip）、
+//       分割求和BRDF查找表、漫反射球谐/辐照度卷积
+// 所有阶段按 (mip, 面, 行块) 切分任务在线程池上并行，内层采样循环使用SSE
+// 样本数等质量参数在IBLBakeParams中（参与缓存键），这里只有不影响结果的执行选项
+struct IBLBakeOptions {
+    unsigned int threads = 0;       // 0 = 硬件线程数
+};
+
+// 最近一次烘焙各阶段耗时（毫秒），由调用方按需输出；BRDF只在首次烘焙时计算，之后为0
+struct IBLBakeStats {
+    double env = 0.0, irradiance = 0.0, prefilter = 0.0, brdf = 0.0;
+};
+
+// 浮点立方体贴图（RGB），布局与IBLImage相同：[mip][face][y][x][channel]
+struct FloatCubemap {
+    int size = 0, mips = 1;
+    std::vector<float> data;
+
+    void Allocate(int faceSize, int mipCount);
+    int MipSize(int mip) const { return size >> mip > 0 ? size >> mip : 1; }
+    float* Face(int mip, int face) { return data.data() + Offset(mip, face); }
+    const float* Face(int mip, int face) const { return data.data() + Offset(mip, face); }
+    size_t Offset(int mip, int face) const;
+
+    // 与GL立方体贴图相同的面选择与双线性过滤（边缘钳制），lod在mip间线性插值
+    glm::vec3 Sample(const glm::vec3& dir, float lod) const;
+    glm::vec3 SampleFace(int mip, int face, float s, float t) const;
+
+    // 面上纹素中心对应的方向（GL约定）
+    static glm::vec3 TexelDirection(int face, int x, int y, int faceSize);
+    // 与半精度缓存图像互相转换，mipCount <= 0 时输出全部mip
+    void ToImage(IBLImage& image, int mipCount = 0) const;
+    void FromImage(const IBLImage& image);
+};
+
+class IBLBaker {
+public:
+    IBLBaker(const IBLBakeParams& params, const IBLBakeOptions& options = IBLBakeOptions());
+
+    // 流式解码HDR（与运行时相同）并烘焙全部产物；BakeEquirect用于已在内存中的图像
+    bool BakeFile(const std::string& hdrPath, IBLCacheData& out);
+    void BakeEquirect(const float* pixels, int width, int height, int components, IBLCacheData& out);
+
+    // 各阶段（公开以便单独计时/对比）
+    void EquirectToCubemap(const float* pixels, int width, int height, int components, FloatCubemap& env) const;
+    void GenerateMips(FloatCubemap& cube) const;
+    void PrefilterSpecular(const FloatCubemap& env, FloatCubemap& prefilter) const;
+    void ConvolveIrradiance(const FloatCubemap& env, FloatCubemap& irradiance) const;
+    void IntegrateBRDF(IBLImage& lut) const;
+
+    // 相对RMS误差 sqrt(sum((a-b)^2) / sum(b^2))，用于质量档位报告
+    // 分辨率不同时在test的纹素中心对reference双线性采样；预滤波贴图按相同粗糙度对应mip
+    static double RelativeError(const IBLImage& test, const IBLImage& reference);
+
+    const IBLBakeStats& GetStats() const { return m_Stats; }
+    void PrintStats() const;
+
+private:
+    // 环境贴图（含mip）之后的漫反射、预滤波与BRDF阶段
+    void BakeConvolutions(const FloatCubemap& env, IBLCacheData& out);
+    // 在线程池上执行count个任务
+    void ParallelFor(int count, const std::function<void(int)>& task) const;
+
+    IBLBakeParams m_Params;
+    IBLBakeOptions m_Options;
+    IBLImage m_BRDF;                // BRDF查找表与环境无关，批量烘焙时只计算一次
+    IBLBakeStats m_Stats;
+};
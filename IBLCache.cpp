@@ -0,0 +1,261 @@
+#include "IBLCache.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// 缓存文件格式
+static const char CACHE_MAGIC[4] = { 'I', 'B', 'L', 'C' };
+static const uint32_t CACHE_VERSION = 4;
+
+size_t IBLImage::LevelOffset(int mip, int face) const {
+    size_t offset = 0;
+    for (int m = 0; m < mip; ++m)
+        offset += FaceSize(m) * faces;
+    return offset + FaceSize(mip) * face;
+}
+
+void IBLImage::Allocate(int w, int h, int faceCount, int mipCount, int channelCount) {
+    width = w;
+    height = h;
+    faces = faceCount;
+    mips = mipCount;
+    channels = channelCount;
+    data.assign(LevelOffset(mips, 0), 0);
+}
+
+// ================== 质量档位 ==================
+IBLBakeParams IBLBakeParams::ForQuality(IBLQuality quality) {
+    IBLBakeParams params;
+    switch (quality) {
+    case IBLQuality::Fast:
+        params.envSize = 256;
+        params.irradianceSize = 16;
+        params.prefilterSize = 64;
+        params.brdfSize = 128;
+        params.prefilterSamples = 64;
+        params.brdfSamples = 128;
+        params.irradianceDelta = 0.1f;
+        break;
+    case IBLQuality::Reference:
+        params.envSize = 1024;
+        params.irradianceSize = 64;
+        params.prefilterSize = 256;
+        params.prefilterMips = 6;
+        params.prefilterSamples = 8192;
+        params.brdfSamples = 4096;
+        params.irradianceDelta = 0.0125f;
+        params.mipFiltered = false;
+        break;
+    default:
+        break;
+    }
+    return params;
+}
+
+const char* IBLBakeParams::QualityName(IBLQuality quality) {
+    switch (quality) {
+    case IBLQuality::Fast: return "fast";
+    case IBLQuality::Reference: return "reference";
+    default: return "default";
+    }
+}
+
+// ================== 哈希 ==================
+uint64_t IBLCache::HashBytes(const void* data, size_t size, uint64_t seed) {
+    const uint64_t prime = 1099511628211ull;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < size; ++i)
+        hash = (hash ^ bytes[i]) * prime;
+    return hash;
+}
+
+bool IBLCache::HashFile(const std::string& path, uint64_t& hash) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    hash = 14695981039346656037ull;
+    std::vector<char> buffer(1 << 20);
+    while (file) {
+        file.read(buffer.data(), buffer.size());
+        hash = HashBytes(buffer.data(), (size_t)file.gcount(), hash);
+    }
+    return true;
+}
+
+uint64_t IBLCache::MakeKey(uint64_t contentHash, const IBLBakeParams& params) {
+    int32_t fields[10] = { params.envSize, params.irradianceSize, params.prefilterSize,
+        params.prefilterMips, params.brdfSize, params.prefilterSamples, params.brdfSamples,
+        params.mipFiltered ? 1 : 0, params.shIrradiance ? 1 : 0, 0 };
+    std::memcpy(&fields[9], &params.irradianceDelta, sizeof(float));
+    uint64_t key = HashBytes(fields, sizeof(fields), contentHash);
+    return HashBytes(&params.shaderHash, sizeof(params.shaderHash), key);
+}
+
+uint64_t IBLCache::HashBakeShaders(const std::string& shaderDir) {
+    const char* files[] = {
+        "cubemap.vert", "equirectangular_to_cubemap.frag",
+        "irradiance_convolution.frag", "prefilter.frag",
+        "brdf.vert", "brdf.frag"
+    };
+    uint64_t hash = 0;
+    for (const char* file : files) {
+        uint64_t fileHash = 0;
+        HashFile(shaderDir + "/" + file, fileHash);
+        hash = HashBytes(&fileHash, sizeof(fileHash), hash);
+    }
+    return hash;
+}
+
+// ================== 半精度浮点 ==================
+uint16_t IBLCache::FloatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, 4);
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    uint32_t exponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (exponent == 0xFF)                          // Inf / NaN
+        return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+    int halfExponent = (int)exponent - 127 + 15;
+    if (halfExponent >= 31)                        // 溢出 -> Inf
+        return sign | 0x7C00;
+    if (halfExponent <= 0) {                       // 非规格化数
+        if (halfExponent < -10) return sign;
+        mantissa |= 0x800000;
+        int shift = 14 - halfExponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) ++half;
+        return sign | (uint16_t)half;
+    }
+    // 规格化数，最近偶数舍入（进位可能溢出到指数，结果仍正确）
+    uint32_t half = ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) ++half;
+    return sign | (uint16_t)half;
+}
+
+float IBLCache::HalfToFloat(uint16_t value) {
+    uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+    uint32_t bits;
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        }
+        else {                                     // 非规格化数转为规格化float
+            exponent = 127 - 15 + 1;
+            while (!(mantissa & 0x400)) { mantissa <<= 1; --exponent; }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+        }
+    }
+    else if (exponent == 31) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+    float result;
+    std::memcpy(&result, &bits, 4);
+    return result;
+}
+
+// ================== 读写 ==================
+static void WriteImage(std::ofstream& file, const IBLImage& image) {
+    int32_t header[5] = { image.width, image.height, image.faces, image.mips, image.channels };
+    uint64_t count = image.data.size();
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(image.data.data()), count * sizeof(uint16_t));
+}
+
+static void WriteBlob(std::ofstream& file, const std::vector<uint8_t>& blob) {
+    uint64_t size = blob.size();
+    file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    file.write(reinterpret_cast<const char*>(blob.data()), size);
+}
+
+static bool ReadBlob(std::ifstream& file, std::vector<uint8_t>& blob) {
+    uint64_t size = 0;
+    file.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (!file || size > (1ull << 30)) return false;
+    blob.resize((size_t)size);
+    file.read(reinterpret_cast<char*>(blob.data()), size);
+    return (bool)file;
+}
+
+static bool ReadImage(std::ifstream& file, IBLImage& image) {
+    int32_t header[5];
+    uint64_t count = 0;
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!file) return false;
+    // 空图像（未烘焙的产物）
+    if (header[0] == 0 && header[1] == 0 && count == 0) {
+        image = IBLImage();
+        return true;
+    }
+    if (header[0] <= 0 || header[0] > 16384 || header[1] <= 0 || header[1] > 16384 ||
+        (header[2] != 1 && header[2] != 6) || header[3] < 1 || header[3] > 15 ||
+        header[4] < 1 || header[4] > 4)
+        return false;
+
+    image.Allocate(header[0], header[1], header[2], header[3], header[4]);
+    if (image.data.size() != count) return false;
+    file.read(reinterpret_cast<char*>(image.data.data()), count * sizeof(uint16_t));
+    return (bool)file;
+}
+
+bool IBLCache::Load(const std::string& path, uint64_t key, IBLCacheData& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t fileKey = 0;
+    file.read(magic, 4);
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&fileKey), sizeof(fileKey));
+    if (!file || std::memcmp(magic, CACHE_MAGIC, 4) != 0 || version != CACHE_VERSION)
+        return false;
+    if (fileKey != key) {
+        std::cout << "IBL_CACHE: stale cache (source or bake parameters changed): " << path << std::endl;
+        return false;
+    }
+
+    if (!ReadImage(file, out.env) || !ReadImage(file, out.irradiance) ||
+        !ReadImage(file, out.prefilter) || !ReadImage(file, out.brdf) ||
+        !file.read(reinterpret_cast<char*>(out.sh.c), sizeof(out.sh.c)) ||
+        !ReadBlob(file, out.envBC6H) || !ReadBlob(file, out.prefilterBC6H)) {
+        std::cout << "ERROR::IBL_CACHE::Corrupt cache: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool IBLCache::Save(const std::string& path, uint64_t key, const IBLCacheData& data) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cout << "WARNING::IBL_CACHE::Cannot write cache: " << path << std::endl;
+        return false;
+    }
+    file.write(CACHE_MAGIC, 4);
+    file.write(reinterpret_cast<const char*>(&CACHE_VERSION), sizeof(CACHE_VERSION));
+    file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+    WriteImage(file, data.env);
+    WriteImage(file, data.irradiance);
+    WriteImage(file, data.prefilter);
+    WriteImage(file, data.brdf);
+    file.write(reinterpret_cast<const char*>(data.sh.c), sizeof(data.sh.c));
+    WriteBlob(file, data.envBC6H);
+    WriteBlob(file, data.prefilterBC6H);
+    return (bool)file;
+}
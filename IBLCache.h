@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "SphericalHarmonics.h"
+
+// IBL烘焙结果的磁盘缓存（不依赖GL，烘焙工具和运行时共用）
+// 键 = HDR文件内容哈希 + 烘焙参数；任一变化都会重新烘焙
+
+// 烘焙质量档位：
+//   Fast      低分辨率，预滤波按样本PDF选择源mip，样本数比Default少一个数量级
+//   Default   原有的分辨率与样本数
+//   Reference 高分辨率、大量样本且全部从源mip0采样，作为误差报告的基准
+enum class IBLQuality { Fast, Default, Reference };
+
+// 烘焙参数
+struct IBLBakeParams {
+    int envSize = 512;
+    int irradianceSize = 32;
+    int prefilterSize = 128;
+    int prefilterMips = 5;
+    int brdfSize = 512;
+    int prefilterSamples = 1024;
+    int brdfSamples = 1024;
+    float irradianceDelta = 0.025f;   // 辐照度卷积的球面步长（弧度）
+    bool mipFiltered = true;          // 按样本覆盖的立体角选择源mip（filtered importance sampling）
+    bool shIrradiance = true;   // 漫反射用球谐系数代替卷积辐照度贴图（不再烘焙irradiance）
+    uint64_t shaderHash = 0;    // 烘焙着色器源码的哈希，修改着色器后缓存自动失效
+
+    static IBLBakeParams ForQuality(IBLQuality quality);
+    static const char* QualityName(IBLQuality quality);
+};
+
+// 一张纹理的全部mip，立方体贴图6个面连续存放：[mip][face][y][x][channel]
+// 像素为半精度浮点（与GL_RGB16F/GL_RG16F的读回格式一致）
+struct IBLImage {
+    int width = 0, height = 0;
+    int faces = 1, mips = 1, channels = 3;
+    std::vector<uint16_t> data;
+
+    int MipWidth(int mip) const { return width >> mip > 0 ? width >> mip : 1; }
+    int MipHeight(int mip) const { return height >> mip > 0 ? height >> mip : 1; }
+    size_t FaceSize(int mip) const { return (size_t)MipWidth(mip) * MipHeight(mip) * channels; }
+    size_t LevelOffset(int mip, int face) const;
+    void Allocate(int w, int h, int faceCount, int mipCount, int channelCount);
+};
+
+struct IBLCacheData {
+    IBLImage env;          // 环境立方体贴图（只存mip0，加载后重新生成mip）
+    IBLImage irradiance;   // shIrradiance时为空
+    IBLImage prefilter;
+    IBLImage brdf;
+    SH9Color sh;           // 漫反射球谐系数
+
+    // 可选的离线BC6H压缩结果（iblbake --bc6h），[mip][face]连续的16字节块；env含完整mip链
+    std::vector<uint8_t> envBC6H;
+    std::vector<uint8_t> prefilterBC6H;
+};
+
+class IBLCache {
+public:
+    static std::string CachePath(const std::string& hdrPath) { return hdrPath + ".iblcache"; }
+
+    // 文件内容哈希（64位FNV-1a，按8字节分块）
+    static bool HashFile(const std::string& path, uint64_t& hash);
+    static uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+    static uint64_t MakeKey(uint64_t contentHash, const IBLBakeParams& params);
+    // 烘焙着色器源码的哈希（写入IBLBakeParams::shaderHash），离线烘焙工具需传入同一份着色器目录
+    static uint64_t HashBakeShaders(const std::string& shaderDir = "shaders");
+
+    // 半精度浮点转换（与GL_HALF_FLOAT位布局一致）
+    static uint16_t FloatToHalf(float value);
+    static float HalfToFloat(uint16_t value);
+
+    static bool Load(const std::string& path, uint64_t key, IBLCacheData& out);
+    static bool Save(const std::string& path, uint64_t key, const IBLCacheData& data);
+};
@@ -0,0 +1,396 @@
+#include "IBLFormats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+const char* IBLFormats::Name(IBLFormat format) {
+    switch (format) {
+    case IBLFormat::R11G11B10F: return "R11G11B10F";
+    case IBLFormat::RGB9E5: return "RGB9E5";
+    case IBLFormat::BC6H: return "BC6H";
+    default: return "RGB16F";
+    }
+}
+
+float IBLFormats::BytesPerTexel(IBLFormat format) {
+    switch (format) {
+    case IBLFormat::R11G11B10F:
+    case IBLFormat::RGB9E5: return 4.0f;
+    case IBLFormat::BC6H: return 1.0f;
+    default: return 8.0f;
+    }
+}
+
+// ================== R11G11B10F ==================
+// 无符号小浮点：与半精度指数相同（5位、偏置15），尾数截短为 mantissaBits 位
+static uint32_t ToSmallFloat(float value, int mantissaBits) {
+    if (!(value > 0.0f)) return 0;                 // 负数与NaN
+    uint32_t half = IBLCache::FloatToHalf(value);
+    if (half > 0x7BFF) half = 0x7BFF;              // 钳制到最大有限值
+    int shift = 10 - mantissaBits;
+    uint32_t result = (half + (1u << (shift - 1))) >> shift;
+    uint32_t maxFinite = (30u << mantissaBits) | ((1u << mantissaBits) - 1);
+    return std::min(result, maxFinite);
+}
+
+static float FromSmallFloat(uint32_t bits, int mantissaBits) {
+    return IBLCache::HalfToFloat((uint16_t)(bits << (10 - mantissaBits)));
+}
+
+uint32_t IBLFormats::PackR11G11B10F(float r, float g, float b) {
+    return ToSmallFloat(r, 6) | (ToSmallFloat(g, 6) << 11) | (ToSmallFloat(b, 5) << 22);
+}
+
+void IBLFormats::UnpackR11G11B10F(uint32_t packed, float rgb[3]) {
+    rgb[0] = FromSmallFloat(packed & 0x7FF, 6);
+    rgb[1] = FromSmallFloat((packed >> 11) & 0x7FF, 6);
+    rgb[2] = FromSmallFloat((packed >> 22) & 0x3FF, 5);
+}
+
+// ================== RGB9E5 ==================
+// 按EXT_texture_shared_exponent规范：N=9, B=15, Emax=31
+static const int RGB9E5_MANTISSA = 9;
+static const int RGB9E5_BIAS = 15;
+static const float RGB9E5_MAX = 65408.0f;    // (2^9-1)/2^9 * 2^16
+
+uint32_t IBLFormats::PackRGB9E5(float r, float g, float b) {
+    auto clampChannel = [](float v) { return (v > 0.0f) ? std::min(v, RGB9E5_MAX) : 0.0f; };
+    float rc = clampChannel(r), gc = clampChannel(g), bc = clampChannel(b);
+    float maxc = std::max(rc, std::max(gc, bc));
+    if (maxc <= 0.0f) return 0;
+
+    int exponent;
+    std::frexp(maxc, &exponent);                   // maxc = m * 2^exponent, m∈[0.5,1)
+    int sharedExp = std::max(-RGB9E5_BIAS - 1, exponent - 1) + 1 + RGB9E5_BIAS;
+    float scale = std::ldexp(1.0f, sharedExp - RGB9E5_BIAS - RGB9E5_MANTISSA);
+    if ((int)std::floor(maxc / scale + 0.5f) == (1 << RGB9E5_MANTISSA)) {
+        ++sharedExp;
+        scale *= 2.0f;
+    }
+    uint32_t rm = (uint32_t)std::floor(rc / scale + 0.5f);
+    uint32_t gm = (uint32_t)std::floor(gc / scale + 0.5f);
+    uint32_t bm = (uint32_t)std::floor(bc / scale + 0.5f);
+    return rm | (gm << 9) | (bm << 18) | ((uint32_t)sharedExp << 27);
+}
+
+void IBLFormats::UnpackRGB9E5(uint32_t packed, float rgb[3]) {
+    int exponent = (int)(packed >> 27);
+    float scale = std::ldexp(1.0f, exponent - RGB9E5_BIAS - RGB9E5_MANTISSA);
+    rgb[0] = (packed & 0x1FF) * scale;
+    rgb[1] = ((packed >> 9) & 0x1FF) * scale;
+    rgb[2] = ((packed >> 18) & 0x1FF) * scale;
+}
+
+// ================== BC6H（mode 11） ==================
+// 单区域、10位端点、4位索引：5位模式 + 6x10位端点 + 63位索引 = 128位
+static const int BC6H_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// 解码器的反量化：10位端点 -> 16位中间值
+static int Unquantize10(int x) {
+    if (x == 0) return 0;
+    if (x == 1023) return 0xFFFF;
+    return (x << 6) + 32;
+}
+
+// 插值后的中间值 -> 半精度位（无符号格式乘31/64）
+static uint16_t FinishUnquantize(int value) {
+    return (uint16_t)((value * 31) >> 6);
+}
+
+static int Quantize10(float value) {
+    int x = (int)std::floor((value - 32.0f) / 64.0f + 0.5f);
+    return std::min(std::max(x, 0), 1023);
+}
+
+// 用给定端点为每个纹素选择最优索引，返回半精度位空间的平方误差
+static double AssignIndices(const int q0[3], const int q1[3], const uint16_t texels[16][3], int indices[16]) {
+    uint16_t palette[16][3];
+    int e0[3], e1[3];
+    for (int c = 0; c < 3; ++c) {
+        e0[c] = Unquantize10(q0[c]);
+        e1[c] = Unquantize10(q1[c]);
+    }
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 3; ++c)
+            palette[i][c] = FinishUnquantize((e0[c] * (64 - BC6H_WEIGHTS[i]) + e1[c] * BC6H_WEIGHTS[i] + 32) >> 6);
+
+    double total = 0.0;
+    for (int t = 0; t < 16; ++t) {
+        double best = 1e30;
+        for (int i = 0; i < 16; ++i) {
+            double error = 0.0;
+            for (int c = 0; c < 3; ++c) {
+                double d = (double)palette[i][c] - texels[t][c];
+                error += d * d;
+            }
+            if (error < best) {
+                best = error;
+                indices[t] = i;
+            }
+        }
+        total += best;
+    }
+    return total;
+}
+
+struct BitWriter {
+    uint8_t* data;
+    int position = 0;
+    void Write(uint32_t value, int bits) {
+        for (int i = 0; i < bits; ++i, ++position)
+            if ((value >> i) & 1u)
+                data[position >> 3] |= (uint8_t)(1u << (position & 7));
+    }
+};
+
+struct BitReader {
+    const uint8_t* data;
+    int position = 0;
+    uint32_t Read(int bits) {
+        uint32_t value = 0;
+        for (int i = 0; i < bits; ++i, ++position)
+            value |= (uint32_t)((data[position >> 3] >> (position & 7)) & 1u) << i;
+        return value;
+    }
+};
+
+void IBLFormats::EncodeBC6HBlock(const uint16_t texels[16][3], uint8_t block[16]) {
+    // 无符号BC6H不能表示负数和超过最大有限值的数
+    uint16_t source[16][3];
+    float target[16][3];     // 与端点同一空间的目标值：half * 64 / 31
+    for (int t = 0; t < 16; ++t)
+        for (int c = 0; c < 3; ++c) {
+            uint16_t h = texels[t][c];
+            if (h & 0x8000) h = 0;
+            if (h > 0x7BFF) h = 0x7BFF;
+            source[t][c] = h;
+            target[t][c] = h * (64.0f / 31.0f);
+        }
+
+    // 主轴方向上的包围范围作为初始端点
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int t = 0; t < 16; ++t)
+        for (int c = 0; c < 3; ++c)
+            mean[c] += target[t][c] / 16.0f;
+    float cov[3][3] = {};
+    for (int t = 0; t < 16; ++t)
+        for (int a = 0; a < 3; ++a)
+            for (int b = 0; b < 3; ++b)
+                cov[a][b] += (target[t][a] - mean[a]) * (target[t][b] - mean[b]);
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[3];
+        for (int a = 0; a < 3; ++a)
+            next[a] = cov[a][0] * axis[0] + cov[a][1] * axis[1] + cov[a][2] * axis[2];
+        float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+        if (length < 1e-6f) break;
+        for (int a = 0; a < 3; ++a) axis[a] = next[a] / length;
+    }
+    float minProj = 1e30f, maxProj = -1e30f;
+    for (int t = 0; t < 16; ++t) {
+        float p = (target[t][0] - mean[0]) * axis[0] + (target[t][1] - mean[1]) * axis[1] + (target[t][2] - mean[2]) * axis[2];
+        minProj = std::min(minProj, p);
+        maxProj = std::max(maxProj, p);
+    }
+
+    int q0[3], q1[3], indices[16];
+    for (int c = 0; c < 3; ++c) {
+        q0[c] = Quantize10(mean[c] + axis[c] * minProj);
+        q1[c] = Quantize10(mean[c] + axis[c] * maxProj);
+    }
+    double bestError = AssignIndices(q0, q1, source, indices);
+
+    // 固定索引后按最小二乘重新拟合端点
+    for (int iteration = 0; iteration < 2; ++iteration) {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f, at[3] = {}, bt[3] = {};
+        for (int t = 0; t < 16; ++t) {
+            float w = BC6H_WEIGHTS[indices[t]] / 64.0f;
+            aa += (1.0f - w) * (1.0f - w);
+            ab += (1.0f - w) * w;
+            bb += w * w;
+            for (int c = 0; c < 3; ++c) {
+                at[c] += (1.0f - w) * target[t][c];
+                bt[c] += w * target[t][c];
+            }
+        }
+        float det = aa * bb - ab * ab;
+        if (std::abs(det) < 1e-6f) break;
+
+        int r0[3], r1[3], refitIndices[16];
+        for (int c = 0; c < 3; ++c) {
+            r0[c] = Quantize10((at[c] * bb - bt[c] * ab) / det);
+            r1[c] = Quantize10((bt[c] * aa - at[c] * ab) / det);
+        }
+        double error = AssignIndices(r0, r1, source, refitIndices);
+        if (error >= bestError) break;
+        bestError = error;
+        std::memcpy(q0, r0, sizeof(q0));
+        std::memcpy(q1, r1, sizeof(q1));
+        std::memcpy(indices, refitIndices, sizeof(indices));
+    }
+
+    // 锚点（纹素0）索引的最高位隐含为0，否则交换端点
+    if (indices[0] >= 8) {
+        for (int c = 0; c < 3; ++c) std::swap(q0[c], q1[c]);
+        for (int t = 0; t < 16; ++t) indices[t] = 15 - indices[t];
+    }
+
+    std::memset(block, 0, 16);
+    BitWriter writer{ block };
+    writer.Write(0x03, 5);
+    for (int c = 0; c < 3; ++c) writer.Write((uint32_t)q0[c], 10);
+    for (int c = 0; c < 3; ++c) writer.Write((uint32_t)q1[c], 10);
+    writer.Write((uint32_t)indices[0], 3);
+    for (int t = 1; t < 16; ++t) writer.Write((uint32_t)indices[t], 4);
+}
+
+void IBLFormats::DecodeBC6HBlock(const uint8_t block[16], uint16_t texels[16][3]) {
+    BitReader reader{ block };
+    if (reader.Read(5) != 0x03) {
+        // 只解码本编码器产生的mode 11
+        std::memset(texels, 0, sizeof(uint16_t) * 16 * 3);
+        return;
+    }
+    int e0[3], e1[3];
+    for (int c = 0; c < 3; ++c) e0[c] = Unquantize10((int)reader.Read(10));
+    for (int c = 0; c < 3; ++c) e1[c] = Unquantize10((int)reader.Read(10));
+    for (int t = 0; t < 16; ++t) {
+        int w = BC6H_WEIGHTS[reader.Read(t == 0 ? 3 : 4)];
+        for (int c = 0; c < 3; ++c)
+            texels[t][c] = FinishUnquantize((e0[c] * (64 - w) + e1[c] * w + 32) >> 6);
+    }
+}
+
+// ================== 整张图像 ==================
+std::vector<uint32_t> IBLFormats::PackImage(const IBLImage& image, IBLFormat format) {
+    size_t count = image.data.size() / 3;
+    std::vector<uint32_t> packed(count);
+    for (size_t i = 0; i < count; ++i) {
+        float r = IBLCache::HalfToFloat(image.data[i * 3]);
+        float g = IBLCache::HalfToFloat(image.data[i * 3 + 1]);
+        float b = IBLCache::HalfToFloat(image.data[i * 3 + 2]);
+        packed[i] = format == IBLFormat::RGB9E5 ? PackRGB9E5(r, g, b) : PackR11G11B10F(r, g, b);
+    }
+    return packed;
+}
+
+size_t IBLFormats::BC6HOffset(const IBLImage& image, int mip, int face) {
+    size_t offset = 0;
+    for (int m = 0; m < mip; ++m)
+        offset += BC6HLevelSize(image.MipWidth(m), image.MipHeight(m)) * image.faces;
+    return offset + BC6HLevelSize(image.MipWidth(mip), image.MipHeight(mip)) * face;
+}
+
+std::vector<uint8_t> IBLFormats::EncodeBC6H(const IBLImage& image) {
+    std::vector<uint8_t> blocks(BC6HOffset(image, image.mips, 0));
+    if (image.channels != 3) return blocks;
+
+    // 每个(mip, face)一个任务
+    auto encodeLevel = [&](int mip, int face) {
+        int w = image.MipWidth(mip), h = image.MipHeight(mip);
+        const uint16_t* src = &image.data[image.LevelOffset(mip, face)];
+        uint8_t* dst = &blocks[BC6HOffset(image, mip, face)];
+        for (int by = 0; by < (h + 3) / 4; ++by)
+            for (int bx = 0; bx < (w + 3) / 4; ++bx) {
+                // 不足4x4的小mip复制边缘纹素
+                uint16_t texels[16][3];
+                for (int t = 0; t < 16; ++t) {
+                    int x = std::min(bx * 4 + (t & 3), w - 1), y = std::min(by * 4 + (t >> 2), h - 1);
+                    for (int c = 0; c < 3; ++c)
+                        texels[t][c] = src[((size_t)y * w + x) * 3 + c];
+                }
+                EncodeBC6HBlock(texels, dst);
+                dst += 16;
+            }
+    };
+
+    std::vector<std::thread> workers;
+    for (int face = 0; face < image.faces; ++face)
+        workers.emplace_back([&, face]() {
+            for (int mip = 0; mip < image.mips; ++mip)
+                encodeLevel(mip, face);
+        });
+    for (std::thread& worker : workers)
+        worker.join();
+    return blocks;
+}
+
+IBLImage IBLFormats::BuildMips(const IBLImage& image) {
+    int levels = 1;
+    while ((std::max(image.width, image.height) >> levels) > 0) ++levels;
+    IBLImage result;
+    result.Allocate(image.width, image.height, image.faces, levels, image.channels);
+    std::copy(image.data.begin(), image.data.begin() + image.LevelOffset(1, 0), result.data.begin());
+
+    int channels = image.channels;
+    for (int mip = 1; mip < levels; ++mip) {
+        int sw = result.MipWidth(mip - 1), sh = result.MipHeight(mip - 1);
+        int dw = result.MipWidth(mip), dh = result.MipHeight(mip);
+        for (int face = 0; face < image.faces; ++face) {
+            const uint16_t* src = &result.data[result.LevelOffset(mip - 1, face)];
+            uint16_t* dst = &result.data[result.LevelOffset(mip, face)];
+            for (int y = 0; y < dh; ++y)
+                for (int x = 0; x < dw; ++x) {
+                    int x0 = std::min(2 * x, sw - 1), x1 = std::min(2 * x + 1, sw - 1);
+                    int y0 = std::min(2 * y, sh - 1), y1 = std::min(2 * y + 1, sh - 1);
+                    for (int c = 0; c < channels; ++c) {
+                        float sum = IBLCache::HalfToFloat(src[((size_t)y0 * sw + x0) * channels + c]) +
+                            IBLCache::HalfToFloat(src[((size_t)y0 * sw + x1) * channels + c]) +
+                            IBLCache::HalfToFloat(src[((size_t)y1 * sw + x0) * channels + c]) +
+                            IBLCache::HalfToFloat(src[((size_t)y1 * sw + x1) * channels + c]);
+                        dst[((size_t)y * dw + x) * channels + c] = IBLCache::FloatToHalf(sum * 0.25f);
+                    }
+                }
+        }
+    }
+    return result;
+}
+
+double IBLFormats::FormatError(const IBLImage& image, IBLFormat format) {
+    if (format == IBLFormat::RGB16F || image.data.empty() || image.channels != 3) return 0.0;
+
+    double errorSum = 0.0, referenceSum = 0.0;
+    auto accumulate = [&](uint16_t original, float stored) {
+        float reference = IBLCache::HalfToFloat(original);
+        double d = (double)stored - reference;
+        errorSum += d * d;
+        referenceSum += (double)reference * reference;
+    };
+
+    if (format == IBLFormat::BC6H) {
+        std::vector<uint8_t> blocks = EncodeBC6H(image);
+        for (int mip = 0; mip < image.mips; ++mip) {
+            int w = image.MipWidth(mip), h = image.MipHeight(mip);
+            for (int face = 0; face < image.faces; ++face) {
+                const uint16_t* src = &image.data[image.LevelOffset(mip, face)];
+                const uint8_t* block = &blocks[BC6HOffset(image, mip, face)];
+                for (int by = 0; by < (h + 3) / 4; ++by)
+                    for (int bx = 0; bx < (w + 3) / 4; ++bx, block += 16) {
+                        uint16_t decoded[16][3];
+                        DecodeBC6HBlock(block, decoded);
+                        for (int t = 0; t < 16; ++t) {
+                            int x = bx * 4 + (t & 3), y = by * 4 + (t >> 2);
+                            if (x >= w || y >= h) continue;
+                            for (int c = 0; c < 3; ++c)
+                                accumulate(src[((size_t)y * w + x) * 3 + c], IBLCache::HalfToFloat(decoded[t][c]));
+                        }
+                    }
+            }
+        }
+    }
+    else {
+        size_t count = image.data.size() / 3;
+        for (size_t i = 0; i < count; ++i) {
+            float rgb[3];
+            float r = IBLCache::HalfToFloat(image.data[i * 3]);
+            float g = IBLCache::HalfToFloat(image.data[i * 3 + 1]);
+            float b = IBLCache::HalfToFloat(image.data[i * 3 + 2]);
+            if (format == IBLFormat::RGB9E5) UnpackRGB9E5(PackRGB9E5(r, g, b), rgb);
+            else UnpackR11G11B10F(PackR11G11B10F(r, g, b), rgb);
+            for (int c = 0; c < 3; ++c)
+                accumulate(image.data[i * 3 + c], rgb[c]);
+        }
+    }
+    return referenceSum > 0.0 ? std::sqrt(errorSum / referenceSum) : 0.0;
+}
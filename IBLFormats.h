@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "IBLCache.h"
+
+// IBL立方体贴图的存储格式（不依赖GL，烘焙工具和运行时共用）
+//   RGB16F      6字节/纹素（驱动通常按8字节分配），烘焙和缓存使用的原始格式
+//   R11G11B10F  4字节/纹素，无符号浮点，5位指数，6/6/5位尾数
+//   RGB9E5      4字节/纹素，三通道共享5位指数，9位尾数
+//   BC6H        1字节/纹素，无符号BC6H（只使用单区域10位端点的mode 11）
+enum class IBLFormat { RGB16F, R11G11B10F, RGB9E5, BC6H };
+
+class IBLFormats {
+public:
+    static const char* Name(IBLFormat format);
+    // 显存估算用的每纹素字节数
+    static float BytesPerTexel(IBLFormat format);
+
+    // 单个纹素打包/解包（与GL_UNSIGNED_INT_10F_11F_11F_REV、GL_UNSIGNED_INT_5_9_9_9_REV位布局一致）
+    static uint32_t PackR11G11B10F(float r, float g, float b);
+    static void UnpackR11G11B10F(uint32_t packed, float rgb[3]);
+    static uint32_t PackRGB9E5(float r, float g, float b);
+    static void UnpackRGB9E5(uint32_t packed, float rgb[3]);
+
+    // BC6H：16个纹素（行优先4x4）的半精度RGB -> 16字节块
+    static void EncodeBC6HBlock(const uint16_t texels[16][3], uint8_t block[16]);
+    static void DecodeBC6HBlock(const uint8_t block[16], uint16_t texels[16][3]);
+
+    // 整张图像：R11G11B10F/RGB9E5 打包为 [mip][face] 连续的uint32；BC6H 为 [mip][face] 连续的块
+    static std::vector<uint32_t> PackImage(const IBLImage& image, IBLFormat format);
+    static std::vector<uint8_t> EncodeBC6H(const IBLImage& image);
+    static size_t BC6HLevelSize(int width, int height) { return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 16; }
+    static size_t BC6HOffset(const IBLImage& image, int mip, int face);
+
+    // 由mip0生成完整mip链（2x2盒式滤波），压缩格式无法用glGenerateMipmap
+    static IBLImage BuildMips(const IBLImage& image);
+
+    // 以该格式存储后的相对RMS误差（相对于半精度源数据）
+    static double FormatError(const IBLImage& image, IBLFormat format);
+};
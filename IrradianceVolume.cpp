@@ -0,0 +1,346 @@
+#include "IrradianceVolume.h"
+#include "ResidencyManager.h"
+#include "SceneBVH.h"
+#include "SceneManager.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace {
+    const float PI = 3.14159265359f;
+    const float SH_Y0 = 0.282095f;
+    const float SH_Y1 = 0.488603f;
+
+    // 均匀分布在球面上的方向（Fibonacci格点）
+    std::vector<glm::vec3> FibonacciDirections(int count) {
+        std::vector<glm::vec3> dirs(count);
+        const float goldenAngle = PI * (3.0f - std::sqrt(5.0f));
+        for (int i = 0; i < count; ++i) {
+            float y = 1.0f - (i + 0.5f) * 2.0f / count;
+            float r = std::sqrt(std::max(0.0f, 1.0f - y * y));
+            float phi = goldenAngle * i;
+            dirs[i] = glm::vec3(std::cos(phi) * r, y, std::sin(phi) * r);
+        }
+        return dirs;
+    }
+}
+
+IrradianceVolume::IrradianceVolume(const AABB& bounds, const glm::ivec3& resolution, int workerThreads)
+    : m_Bounds(bounds), m_Resolution(glm::max(resolution, glm::ivec3(2))), m_Running(true) {
+    m_CellSize = (m_Bounds.max - m_Bounds.min) / glm::vec3(m_Resolution - 1);
+    m_ThreadCount = workerThreads > 0 ? (unsigned int)workerThreads : std::thread::hardware_concurrency();
+    m_ThreadCount = std::max(1u, m_ThreadCount);
+    m_Probes.resize((size_t)m_Resolution.x * m_Resolution.y * m_Resolution.z, ProbeSH());
+
+    // 三线性过滤、边缘钳制，探针位于纹素中心
+    glGenTextures(3, m_Textures);
+    for (GLuint texture : m_Textures) {
+        glBindTexture(GL_TEXTURE_3D, texture);
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, m_Resolution.x, m_Resolution.y, m_Resolution.z, 0,
+            GL_RGBA, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        ResidencyManager::Get().TrackTexture(texture,
+            (size_t)m_Resolution.x * m_Resolution.y * m_Resolution.z * 8, "IrradianceVolume");
+    }
+    glBindTexture(GL_TEXTURE_3D, 0);
+
+    MarkAllDirty();
+    m_Worker = std::thread(&IrradianceVolume::WorkerLoop, this);
+}
+
+IrradianceVolume::~IrradianceVolume() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Running = false;
+    }
+    m_Cond.notify_all();
+    if (m_Worker.joinable()) m_Worker.join();
+}
+
+// ================== 失效区域 ==================
+void IrradianceVolume::MarkDirty(const glm::ivec3& minProbe, const glm::ivec3& maxProbe) {
+    if (!m_HasDirty) {
+        m_DirtyMin = minProbe;
+        m_DirtyMax = maxProbe;
+        m_HasDirty = true;
+        return;
+    }
+    m_DirtyMin = glm::min(m_DirtyMin, minProbe);
+    m_DirtyMax = glm::max(m_DirtyMax, maxProbe);
+}
+
+void IrradianceVolume::MarkAllDirty() {
+    MarkDirty(glm::ivec3(0), m_Resolution - 1);
+}
+
+void IrradianceVolume::SetSky(const SH9Color& sky) {
+    for (int i = 0; i < 9; ++i) {
+        if (glm::any(glm::greaterThan(glm::abs(sky.c[i] - m_Sky.c[i]), glm::vec3(1e-4f)))) {
+            m_Sky = sky;
+            MarkAllDirty();
+            return;
+        }
+    }
+}
+
+void IrradianceVolume::SetSun(const glm::vec3& direction, const glm::vec3& color) {
+    glm::vec3 dir = glm::normalize(direction);
+    if (glm::dot(dir, m_SunDirection) > 0.9999f && glm::all(glm::lessThan(glm::abs(color - m_SunColor), glm::vec3(1e-3f))))
+        return;
+    m_SunDirection = dir;
+    m_SunColor = color;
+    MarkAllDirty();
+}
+
+void IrradianceVolume::Invalidate(const std::vector<AABB>& changedBounds) {
+    glm::vec3 padding = m_CellSize * regionPadding;
+    for (const AABB& box : changedBounds) {
+        if (!box.IsValid()) continue;
+        glm::vec3 lo = (box.min - padding - m_Bounds.min) / m_CellSize;
+        glm::vec3 hi = (box.max + padding - m_Bounds.min) / m_CellSize;
+        glm::ivec3 minProbe = glm::max(glm::ivec3(glm::ceil(lo)), glm::ivec3(0));
+        glm::ivec3 maxProbe = glm::min(glm::ivec3(glm::floor(hi)), m_Resolution - 1);
+        if (glm::all(glm::lessThanEqual(minProbe, maxProbe)))
+            MarkDirty(minProbe, maxProbe);
+    }
+}
+
+// ================== 主线程 ==================
+void IrradianceVolume::Update(const SceneManager& scene) {
+    std::unique_ptr<BakeJob> done;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        done = std::move(m_Completed);
+    }
+    if (done) {
+        m_Busy = false;
+        m_Probes = std::move(done->result);
+        Upload(m_Probes, done->regionMin, done->regionMax);
+        glm::ivec3 size = done->regionMax - done->regionMin + 1;
+        m_ProbesBaked = size.x * size.y * size.z;
+        m_InvalidProbes = done->invalidProbes;
+        m_LastBakeMs = done->bakeMs;
+        m_LastTriangles = (int)(done->triangles.size() / 3);
+        ++m_BakesCompleted;
+        m_Ready = true;
+    }
+
+    // 后台空闲时提交累积的失效区域（烘焙期间发生的变化合并到下一次）
+    if (!m_HasDirty || m_Busy) return;
+    std::unique_ptr<BakeJob> job(new BakeJob());
+    scene.CollectStaticTriangles(job->triangles);
+    job->sky = m_Sky;
+    job->sunDirection = m_SunDirection;
+    job->sunColor = m_SunColor;
+    job->regionMin = m_DirtyMin;
+    job->regionMax = m_DirtyMax;
+    job->result = m_Probes;
+    m_HasDirty = false;
+    m_Busy = true;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Request = std::move(job);
+    }
+    m_Cond.notify_one();
+}
+
+void IrradianceVolume::Upload(const std::vector<ProbeSH>& grid, const glm::ivec3& minProbe, const glm::ivec3& maxProbe) {
+    glm::ivec3 size = maxProbe - minProbe + 1;
+    std::vector<float> data[3];
+    for (int channel = 0; channel < 3; ++channel)
+        data[channel].reserve((size_t)size.x * size.y * size.z * 4);
+    for (int z = minProbe.z; z <= maxProbe.z; ++z)
+        for (int y = minProbe.y; y <= maxProbe.y; ++y)
+            for (int x = minProbe.x; x <= maxProbe.x; ++x) {
+                const ProbeSH& sh = grid[ProbeIndex(x, y, z)];
+                for (int channel = 0; channel < 3; ++channel)
+                    for (int i = 0; i < 4; ++i)
+                        data[channel].push_back(sh.c[i][channel]);
+            }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (int channel = 0; channel < 3; ++channel) {
+        glBindTexture(GL_TEXTURE_3D, m_Textures[channel]);
+        glTexSubImage3D(GL_TEXTURE_3D, 0, minProbe.x, minProbe.y, minProbe.z, size.x, size.y, size.z,
+            GL_RGBA, GL_FLOAT, data[channel].data());
+    }
+    glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void IrradianceVolume::Apply(const Shader& shader) const {
+    const GLuint units[3] = { VOLUME_UNIT_R, VOLUME_UNIT_G, VOLUME_UNIT_B };
+    const char* names[3] = { "irradianceVolumeR", "irradianceVolumeG", "irradianceVolumeB" };
+    for (int channel = 0; channel < 3; ++channel) {
+        glActiveTexture(GL_TEXTURE0 + units[channel]);
+        glBindTexture(GL_TEXTURE_3D, m_Textures[channel]);
+        shader.setInt(names[channel], units[channel]);
+        ResidencyManager::Get().TouchTexture(m_Textures[channel]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    shader.setBool("irradianceVolumeEnabled", m_Ready);
+    shader.setVec3("volumeMin", m_Bounds.min);
+    shader.setVec3("volumeMax", m_Bounds.max);
+    shader.setVec3("volumeResolution", glm::vec3(m_Resolution));
+}
+
+void IrradianceVolume::PrintStats() const {
+    std::cout << "IRRADIANCE VOLUME: " << m_Resolution.x << "x" << m_Resolution.y << "x" << m_Resolution.z
+        << " probes, " << m_BakesCompleted << " bakes, last " << m_ProbesBaked << " probes / "
+        << m_LastTriangles << " triangles in " << m_LastBakeMs << " ms, " << m_InvalidProbes << " invalid"
+        << (m_Busy ? " (baking)" : "") << std::endl;
+}
+
+void IrradianceVolume::Cleanup() {
+    for (GLuint texture : m_Textures)
+        ResidencyManager::Get().UntrackTexture(texture);
+    glDeleteTextures(3, m_Textures);
+    for (GLuint& texture : m_Textures)
+        texture = 0;
+}
+
+// ================== 后台烘焙 ==================
+void IrradianceVolume::WorkerLoop() {
+    while (true) {
+        std::unique_ptr<BakeJob> job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Cond.wait(lock, [this] { return !m_Running || m_Request; });
+            if (!m_Running) return;
+            job = std::move(m_Request);
+        }
+        auto start = std::chrono::steady_clock::now();
+        Bake(*job);
+        if (!m_Running) return;
+        job->bakeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Completed = std::move(job);
+    }
+}
+
+void IrradianceVolume::ParallelFor(int count, const std::function<void(int)>& task) const {
+    unsigned int threadCount = std::max(1u, std::min(m_ThreadCount, (unsigned int)count));
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (int i = next++; i < count && m_Running; i = next++)
+            task(i);
+    };
+    std::vector<std::thread> workers;
+    for (unsigned int t = 1; t < threadCount; ++t)
+        workers.emplace_back(worker);
+    worker();
+    for (std::thread& w : workers)
+        w.join();
+}
+
+glm::vec3 IrradianceVolume::SampleIrradiance(const std::vector<ProbeSH>& grid, const glm::vec3& p,
+    const glm::vec3& n) const {
+    glm::vec3 local = glm::clamp((p - m_Bounds.min) / m_CellSize, glm::vec3(0.0f), glm::vec3(m_Resolution - 1));
+    glm::ivec3 base = glm::min(glm::ivec3(local), m_Resolution - 2);
+    glm::vec3 f = local - glm::vec3(base);
+    glm::vec3 basis(SH_Y1 * n.y, SH_Y1 * n.z, SH_Y1 * n.x);
+
+    glm::vec3 result(0.0f);
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::ivec3 offset(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+        float w = (offset.x ? f.x : 1.0f - f.x) * (offset.y ? f.y : 1.0f - f.y) * (offset.z ? f.z : 1.0f - f.z);
+        if (w <= 0.0f) continue;
+        const ProbeSH& sh = grid[ProbeIndex(base.x + offset.x, base.y + offset.y, base.z + offset.z)];
+        result += w * (sh.c[0] * SH_Y0 + sh.c[1] * basis.x + sh.c[2] * basis.y + sh.c[3] * basis.z);
+    }
+    return glm::max(result, glm::vec3(0.0f));
+}
+
+void IrradianceVolume::Bake(BakeJob& job) {
+    SceneBVH bvh;
+    bvh.Build(job.triangles);
+    const int rayCount = std::max(16, raysPerProbe);
+    const std::vector<glm::vec3> dirs = FibonacciDirections(rayCount);
+    const glm::vec3 toSun = -job.sunDirection;
+    const float rayBias = 1e-3f * glm::length(m_CellSize);
+
+    glm::ivec3 size = job.regionMax - job.regionMin + 1;
+    int regionCount = size.x * size.y * size.z;
+    auto regionProbe = [&](int i) {
+        return job.regionMin + glm::ivec3(i % size.x, (i / size.x) % size.y, i / (size.x * size.y));
+    };
+    std::vector<unsigned char> invalid(regionCount, 0);
+
+    // 每遍用上一遍的网格计算击中点的间接光，第一遍沿用已烘焙的结果（首次烘焙为0）
+    std::vector<ProbeSH> grid;
+    grid.swap(job.result);
+    for (int pass = 0; pass <= std::max(0, bounces) && m_Running; ++pass) {
+        std::vector<ProbeSH> next = grid;
+        ParallelFor(regionCount, [&](int i) {
+            glm::ivec3 probe = regionProbe(i);
+            glm::vec3 origin = ProbePosition(probe.x, probe.y, probe.z);
+            glm::vec3 sum[4] = {};
+            int backfaces = 0;
+            for (const glm::vec3& dir : dirs) {
+                glm::vec3 radiance;
+                RayHit hit;
+                if (bvh.Intersect(origin, dir, FLT_MAX, hit)) {
+                    if (hit.backface) {
+                        ++backfaces;
+                        continue;
+                    }
+                    glm::vec3 normal = bvh.GetNormal(hit.triangle);
+                    glm::vec3 p = origin + dir * hit.t + normal * rayBias;
+                    // 朗伯表面：出射辐射度 = 反照率 / PI * 辐照度，网格中存放的已经是辐照度 / PI
+                    glm::vec3 light = SampleIrradiance(grid, p, normal);
+                    float NdotL = glm::dot(normal, toSun);
+                    if (NdotL > 0.0f && !bvh.Occluded(p, toSun, FLT_MAX))
+                        light += job.sunColor * (NdotL / PI);
+                    radiance = albedo * light;
+                }
+                else {
+                    radiance = SphericalHarmonics::EvaluateRadiance(job.sky, dir);
+                }
+                sum[0] += radiance * SH_Y0;
+                sum[1] += radiance * (SH_Y1 * dir.y);
+                sum[2] += radiance * (SH_Y1 * dir.z);
+                sum[3] += radiance * (SH_Y1 * dir.x);
+            }
+            // 蒙特卡洛投影（每条光线的立体角为4PI / N），再乘以余弦卷积因子/PI（1, 2/3）
+            float weight = 4.0f * PI / rayCount;
+            ProbeSH& sh = next[ProbeIndex(probe.x, probe.y, probe.z)];
+            sh.c[0] = sum[0] * weight;
+            for (int k = 1; k < 4; ++k)
+                sh.c[k] = sum[k] * (weight * 2.0f / 3.0f);
+            invalid[i] = backfaces > backfaceThreshold * rayCount;
+        });
+
+        // 几何内部的探针用相邻的有效探针平均，避免漏光（区域外的探针视为有效）
+        job.invalidProbes = 0;
+        for (int i = 0; i < regionCount; ++i) {
+            if (!invalid[i]) continue;
+            ++job.invalidProbes;
+            glm::ivec3 probe = regionProbe(i);
+            ProbeSH average = ProbeSH();
+            int count = 0;
+            for (int dz = -1; dz <= 1; ++dz)
+                for (int dy = -1; dy <= 1; ++dy)
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        glm::ivec3 q = probe + glm::ivec3(dx, dy, dz);
+                        if (glm::any(glm::lessThan(q, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(q, m_Resolution)))
+                            continue;
+                        glm::ivec3 r = q - job.regionMin;
+                        bool inRegion = glm::all(glm::greaterThanEqual(r, glm::ivec3(0))) && glm::all(glm::lessThan(r, size));
+                        if (inRegion && invalid[(r.z * size.y + r.y) * size.x + r.x]) continue;
+                        const ProbeSH& src = next[ProbeIndex(q.x, q.y, q.z)];
+                        for (int k = 0; k < 4; ++k)
+                            average.c[k] += src.c[k];
+                        ++count;
+                    }
+            ProbeSH& dst = next[ProbeIndex(probe.x, probe.y, probe.z)];
+            for (int k = 0; k < 4; ++k)
+                dst.c[k] = count > 0 ? average.c[k] / (float)count : glm::vec3(0.0f);
+        }
+        grid.swap(next);
+    }
+    job.result.swap(grid);
+}
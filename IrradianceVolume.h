@@ -0,0 +1,117 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Frustum.h"
+#include "Shader.h"
+#include "SphericalHarmonics.h"
+
+class SceneManager;
+
+// 辐照度体积：场景包围盒内的规则网格光照探针，存放L1球谐（每个颜色通道4个系数）
+//   烘焙：CPU工作线程对静态几何建BVH，每个探针沿raysPerProbe个Fibonacci方向发射光线并投影到球谐，
+//         击中点的出射辐射度 = 反照率 * (平行光直接光照（阴影光线） + 上一遍体积的辐照度)，未击中取天空球谐，
+//         重复bounces遍得到多次反弹；背面击中比例超过backfaceThreshold的探针视为在几何内部，用相邻有效探针填充
+//   存储：R/G/B三张RGBA16F三维纹理，纹素为(c0, c1, c2, c3)，已乘以余弦卷积因子并除以PI（与IBL辐照度相同的量）
+//   着色器：irradiance_volume.glsl按片段位置（沿法线偏移半个格子）三线性采样后求值，体积边缘一个格子内过渡到探针/环境光
+//   更新：静态投射体变化（ShadowCasterList::invalidated）只重新烘焙其附近的探针，平行光变化时整体重新烘焙；
+//         烘焙在后台线程异步进行，主线程在Update中上传完成的区域
+//   只烘焙平行光和天空光，点光源/聚光灯是动态的，仍由分簇光源逐片段计算
+class IrradianceVolume {
+public:
+    static const GLuint VOLUME_UNIT_R = 19;     // 分簇光源纹理缓冲占用到18
+    static const GLuint VOLUME_UNIT_G = 20;
+    static const GLuint VOLUME_UNIT_B = 21;
+
+    int raysPerProbe = 256;
+    int bounces = 2;                    // 间接光反弹次数（0为只有直接光照和天空光）
+    glm::vec3 albedo = glm::vec3(0.5f); // 烘焙用的统一表面反照率
+    float backfaceThreshold = 0.25f;
+    float regionPadding = 2.0f;         // 几何变化时向外扩展重新烘焙的格子数
+
+    // resolution为每个轴上的探针数（至少为2），探针位于bounds的格点上；workerThreads < 0时按CPU核数
+    IrradianceVolume(const AABB& bounds, const glm::ivec3& resolution, int workerThreads = -1);
+    ~IrradianceVolume();
+
+    // 天空光（通常为全局探针的球谐）和平行光；参数变化时整体重新烘焙
+    void SetSky(const SH9Color& sky);
+    void SetSun(const glm::vec3& direction, const glm::vec3& color);
+    // 静态几何变化的世界包围盒：与之相邻的探针重新烘焙
+    void Invalidate(const std::vector<AABB>& changedBounds);
+
+    // 主线程每帧调用：有失效区域且后台空闲时收集静态三角形并提交烘焙，上传已完成的区域
+    void Update(const SceneManager& scene);
+    // 绑定三张体积纹理并设置体积参数（第一次烘焙完成前irradianceVolumeEnabled = false）
+    void Apply(const Shader& shader) const;
+
+    bool IsReady() const { return m_Ready; }
+    void PrintStats() const;
+    void Cleanup();
+
+private:
+    // L1球谐，c[0]为常数项，c[1..3]按y, z, x（与SphericalHarmonics的基函数顺序相同）
+    struct ProbeSH {
+        glm::vec3 c[4] = {};
+    };
+
+    // 后台烘焙任务：三角形、光照和需要重新烘焙的探针范围（含端点）
+    struct BakeJob {
+        std::vector<glm::vec3> triangles;
+        SH9Color sky;
+        glm::vec3 sunDirection;
+        glm::vec3 sunColor;
+        glm::ivec3 regionMin, regionMax;
+        std::vector<ProbeSH> result;    // 完整网格（提交时为当前结果）
+        int invalidProbes = 0;
+        float bakeMs = 0.0f;
+    };
+
+    AABB m_Bounds;
+    glm::ivec3 m_Resolution;
+    glm::vec3 m_CellSize;
+    unsigned int m_ThreadCount;
+    GLuint m_Textures[3] = {};
+
+    // 主线程状态
+    SH9Color m_Sky;
+    glm::vec3 m_SunDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+    glm::vec3 m_SunColor = glm::vec3(0.0f);
+    bool m_HasDirty = false;
+    glm::ivec3 m_DirtyMin, m_DirtyMax;
+    bool m_Ready = false;
+    int m_BakesCompleted = 0;
+    int m_ProbesBaked = 0;
+    int m_InvalidProbes = 0;
+    float m_LastBakeMs = 0.0f;
+    int m_LastTriangles = 0;
+
+    // 已烘焙的网格（后台线程读，主线程在任务完成后替换）
+    std::vector<ProbeSH> m_Probes;
+
+    std::thread m_Worker;
+    std::mutex m_Mutex;
+    std::condition_variable m_Cond;
+    std::unique_ptr<BakeJob> m_Request;
+    std::unique_ptr<BakeJob> m_Completed;
+    std::atomic<bool> m_Running;
+    bool m_Busy = false;
+
+    int ProbeIndex(int x, int y, int z) const { return (z * m_Resolution.y + y) * m_Resolution.x + x; }
+    glm::vec3 ProbePosition(int x, int y, int z) const { return m_Bounds.min + glm::vec3(x, y, z) * m_CellSize; }
+    void MarkDirty(const glm::ivec3& minProbe, const glm::ivec3& maxProbe);
+    void MarkAllDirty();
+
+    void WorkerLoop();
+    // job.result为提交时的完整网格，烘焙后替换为新结果
+    void Bake(BakeJob& job);
+    void ParallelFor(int count, const std::function<void(int)>& task) const;
+    // 三线性插值上一遍网格在p处沿n方向的辐照度（/PI）
+    glm::vec3 SampleIrradiance(const std::vector<ProbeSH>& grid, const glm::vec3& p, const glm::vec3& n) const;
+    void Upload(const std::vector<ProbeSH>& grid, const glm::ivec3& minProbe, const glm::ivec3& maxProbe);
+};
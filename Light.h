@@ -1,6 +1,8 @@
 // Light.h
 #pragma once
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
 
 struct PointLight {
     glm::vec3 position;
@@ -25,3 +27,11 @@ struct SpotLight {
     float quadratic;
 };
 
+// 衰减 1/(constant + linear*d + quadratic*d^2) 使亮度降到 1/256 的距离，之外的光照忽略不计
+inline float AttenuationRange(float constant, float linear, float quadratic, const glm::vec3& color) {
+    float intensity = std::max(color.r, std::max(color.g, color.b));
+    float target = 256.0f * intensity - constant;
+    if (target <= 0.0f) return 0.0f;
+    if (quadratic <= 0.0f) return linear > 0.0f ? target / linear : 0.0f;
+    return (-linear + std::sqrt(linear * linear + 4.0f * quadratic * target)) / (2.0f * quadratic);
+}
@@ -0,0 +1,704 @@
+#include "Lightmapper.h"
+#include "IBLCache.h"
+#include "ResidencyManager.h"
+#include "SceneBVH.h"
+#include "SceneManager.h"
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+    const float PI = 3.14159265359f;
+    const char CACHE_MAGIC[4] = { 'L', 'M', 'A', 'P' };
+    const uint32_t CACHE_VERSION = 2;
+
+    // 主轴投影平面上的二维坐标
+    glm::vec2 Project(const glm::vec3& p, int axis) {
+        return glm::vec2(p[(axis + 1) % 3], p[(axis + 2) % 3]);
+    }
+
+    float Edge(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c) {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+
+    // 每个纹素独立的随机序列（xorshift32，种子经过整数哈希）
+    struct Random {
+        uint32_t state;
+        explicit Random(uint32_t seed) {
+            seed = (seed ^ 61u) ^ (seed >> 16);
+            seed *= 9u;
+            seed ^= seed >> 4;
+            seed *= 0x27d4eb2du;
+            seed ^= seed >> 15;
+            state = seed ? seed : 1u;
+        }
+        float Next() {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return (state >> 8) * (1.0f / 16777216.0f);
+        }
+    };
+
+    // 以n为轴的余弦分布方向
+    glm::vec3 CosineSample(const glm::vec3& n, Random& random) {
+        float u1 = random.Next(), u2 = random.Next();
+        float r = std::sqrt(u1);
+        float phi = 2.0f * PI * u2;
+        glm::vec3 tangent = glm::normalize(glm::cross(std::abs(n.x) > 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f), n));
+        glm::vec3 bitangent = glm::cross(n, tangent);
+        return tangent * (r * std::cos(phi)) + bitangent * (r * std::sin(phi)) + n * std::sqrt(std::max(0.0f, 1.0f - u1));
+    }
+}
+
+Lightmapper::Lightmapper(const std::string& cachePath, int workerThreads)
+    : m_CachePath(cachePath), m_Running(true) {
+    m_ThreadCount = workerThreads > 0 ? (unsigned int)workerThreads : std::thread::hardware_concurrency();
+    m_ThreadCount = std::max(1u, m_ThreadCount);
+    m_Worker = std::thread(&Lightmapper::WorkerLoop, this);
+}
+
+Lightmapper::~Lightmapper() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Running = false;
+    }
+    m_Cond.notify_all();
+    if (m_Worker.joinable()) m_Worker.join();
+}
+
+// ================== 输入 ==================
+void Lightmapper::AddNode(const SceneNode::Ptr& node) {
+    if (!node) return;
+    if (!node->IsStatic())
+        std::cerr << "ERROR::LIGHTMAPPER: node is not static, its lightmap will not follow movement" << std::endl;
+    m_Nodes.push_back(node);
+    m_Charts.clear();
+    m_Dirty = true;
+}
+
+void Lightmapper::AddPointLight(const PointLight& light) {
+    m_PointLights.push_back(light);
+    m_Dirty = true;
+    m_QuietTime = 0.0f;
+}
+
+void Lightmapper::SetSun(const glm::vec3& direction, const glm::vec3& color) {
+    glm::vec3 dir = glm::normalize(direction);
+    if (glm::dot(dir, m_SunDirection) > 0.9999f && glm::all(glm::lessThan(glm::abs(color - m_SunColor), glm::vec3(1e-3f))))
+        return;
+    m_SunDirection = dir;
+    m_SunColor = color;
+    m_Dirty = true;
+    m_QuietTime = 0.0f;
+}
+
+void Lightmapper::SetSky(const SH9Color& sky) {
+    for (int i = 0; i < 9; ++i) {
+        if (glm::any(glm::greaterThan(glm::abs(sky.c[i] - m_Sky.c[i]), glm::vec3(1e-4f)))) {
+            m_Sky = sky;
+            m_Dirty = true;
+            m_QuietTime = 0.0f;
+            return;
+        }
+    }
+}
+
+void Lightmapper::Invalidate(const std::vector<AABB>& changedBounds) {
+    for (const AABB& box : changedBounds) {
+        if (!box.IsValid()) continue;
+        m_Dirty = true;
+        m_QuietTime = 0.0f;
+        return;
+    }
+}
+
+// ================== 第二套UV ==================
+bool Lightmapper::ChartsValid() const {
+    if (m_Charts.empty()) return false;
+    for (size_t i = 0; i < m_ChartedNodes.size(); ++i) {
+        if (m_ChartedNodes[i]->GetWorldTransform() != m_ChartTransforms[i]) return false;
+        for (Mesh* mesh : m_ChartedNodes[i]->GetAllMeshes())
+            if (!mesh->HasLightmapUVs()) return false;
+    }
+    return true;
+}
+
+bool Lightmapper::GenerateCharts() {
+    struct Chart {
+        int axis = 0;
+        glm::vec2 min = glm::vec2(FLT_MAX), max = glm::vec2(-FLT_MAX);
+        glm::ivec2 size, offset;
+    };
+    struct MeshCharts {
+        Mesh* mesh;
+        glm::mat4 world;
+        glm::mat3 normalMatrix;
+        std::vector<unsigned int> indices;
+        std::vector<int> triangleChart;
+    };
+    std::vector<Chart> charts;
+    std::vector<MeshCharts> meshes;
+    std::vector<SceneNode::Ptr> charted;
+    std::unordered_set<const Mesh*> seen;
+
+    for (const SceneNode::Ptr& node : m_Nodes) {
+        std::vector<Mesh*> nodeMeshes = node->GetAllMeshes();
+        // 共享模型的网格只能有一套第二UV
+        bool shared = false;
+        for (Mesh* mesh : nodeMeshes)
+            shared = shared || seen.count(mesh) > 0;
+        if (shared) {
+            std::cerr << "ERROR::LIGHTMAPPER: node shares meshes with another lightmapped node, skipped" << std::endl;
+            continue;
+        }
+        if (nodeMeshes.empty()) continue;
+        charted.push_back(node);
+        glm::mat4 world = node->GetWorldTransform();
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(world)));
+
+        for (Mesh* mesh : nodeMeshes) {
+            seen.insert(mesh);
+            MeshCharts mc;
+            mc.mesh = mesh;
+            mc.world = world;
+            mc.normalMatrix = normalMatrix;
+            const std::vector<Vertex>& vertices = mesh->GetVertices();
+            mc.indices = mesh->GetIndices();
+            if (mc.indices.empty())
+                for (unsigned int i = 0; i < (unsigned int)vertices.size(); ++i)
+                    mc.indices.push_back(i);
+            int triangleCount = (int)(mc.indices.size() / 3);
+
+            // 按几何法线（朝向与顶点法线一致）的主轴分为6类
+            std::vector<int> triangleClass(triangleCount);
+            for (int t = 0; t < triangleCount; ++t) {
+                const Vertex& a = vertices[mc.indices[t * 3]];
+                const Vertex& b = vertices[mc.indices[t * 3 + 1]];
+                const Vertex& c = vertices[mc.indices[t * 3 + 2]];
+                glm::vec3 p0 = glm::vec3(world * glm::vec4(a.Position, 1.0f));
+                glm::vec3 p1 = glm::vec3(world * glm::vec4(b.Position, 1.0f));
+                glm::vec3 p2 = glm::vec3(world * glm::vec4(c.Position, 1.0f));
+                glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+                if (glm::dot(n, normalMatrix * (a.Normal + b.Normal + c.Normal)) < 0.0f)
+                    n = -n;
+                glm::vec3 absN = glm::abs(n);
+                int axis = absN.x >= absN.y && absN.x >= absN.z ? 0 : (absN.y >= absN.z ? 1 : 2);
+                triangleClass[t] = axis * 2 + (n[axis] < 0.0f ? 1 : 0);
+            }
+
+            // 共享顶点且同类的三角形合并（并查集）
+            std::vector<int> parent(triangleCount);
+            for (int t = 0; t < triangleCount; ++t)
+                parent[t] = t;
+            auto find = [&](int t) {
+                while (parent[t] != t) {
+                    parent[t] = parent[parent[t]];
+                    t = parent[t];
+                }
+                return t;
+            };
+            std::vector<int> owner(vertices.size() * 6, -1);
+            for (int t = 0; t < triangleCount; ++t) {
+                for (int k = 0; k < 3; ++k) {
+                    int& first = owner[(size_t)mc.indices[t * 3 + k] * 6 + triangleClass[t]];
+                    if (first < 0) first = t;
+                    else parent[find(t)] = find(first);
+                }
+            }
+
+            std::unordered_map<int, int> rootChart;
+            mc.triangleChart.resize(triangleCount);
+            for (int t = 0; t < triangleCount; ++t) {
+                int root = find(t);
+                auto it = rootChart.find(root);
+                if (it == rootChart.end()) {
+                    it = rootChart.emplace(root, (int)charts.size()).first;
+                    charts.push_back(Chart());
+                    charts.back().axis = triangleClass[t] / 2;
+                }
+                Chart& chart = charts[it->second];
+                mc.triangleChart[t] = it->second;
+                for (int k = 0; k < 3; ++k) {
+                    glm::vec2 uv = Project(glm::vec3(world * glm::vec4(vertices[mc.indices[t * 3 + k]].Position, 1.0f)), chart.axis);
+                    chart.min = glm::min(chart.min, uv);
+                    chart.max = glm::max(chart.max, uv);
+                }
+            }
+            meshes.push_back(std::move(mc));
+        }
+    }
+    if (charts.empty()) return false;
+
+    // 按高度从高到低逐行装箱，放不下时降低纹素密度
+    std::vector<int> order(charts.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = (int)i;
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return charts[a].max.y - charts[a].min.y > charts[b].max.y - charts[b].min.y;
+    });
+    float scale = texelsPerUnit;
+    bool packed = false;
+    for (int attempt = 0; attempt < 20 && !packed; ++attempt) {
+        if (attempt > 0) scale *= 0.8f;
+        int x = 0, y = 0, rowHeight = 0;
+        packed = true;
+        for (int i : order) {
+            Chart& chart = charts[i];
+            chart.size = glm::ivec2(glm::ceil((chart.max - chart.min) * scale)) + 1 + 2 * padding;
+            if (x + chart.size.x > atlasSize) {
+                x = 0;
+                y += rowHeight;
+                rowHeight = 0;
+            }
+            if (chart.size.x > atlasSize || y + chart.size.y > atlasSize) {
+                packed = false;
+                break;
+            }
+            chart.offset = glm::ivec2(x, y);
+            x += chart.size.x;
+            rowHeight = std::max(rowHeight, chart.size.y);
+        }
+    }
+    if (!packed) {
+        std::cerr << "ERROR::LIGHTMAPPER: " << charts.size() << " charts do not fit into a "
+            << atlasSize << "x" << atlasSize << " atlas" << std::endl;
+        return false;
+    }
+
+    // 每个图表拆分一份顶点，图表内的顶点落在纹素中心的连续坐标上
+    m_Charts.clear();
+    for (MeshCharts& mc : meshes) {
+        const std::vector<Vertex>& vertices = mc.mesh->GetVertices();
+        std::vector<Vertex> newVertices;
+        std::vector<unsigned int> newIndices;
+        std::vector<glm::vec2> lightmapUVs;
+        std::vector<glm::vec2> texelCoords;
+        std::unordered_map<uint64_t, unsigned int> remap;
+        newIndices.reserve(mc.indices.size());
+        for (size_t i = 0; i < mc.indices.size(); ++i) {
+            unsigned int v = mc.indices[i];
+            int chartIndex = mc.triangleChart[i / 3];
+            uint64_t key = ((uint64_t)v << 32) | (uint32_t)chartIndex;
+            auto it = remap.find(key);
+            if (it == remap.end()) {
+                const Chart& chart = charts[chartIndex];
+                glm::vec2 local = Project(glm::vec3(mc.world * glm::vec4(vertices[v].Position, 1.0f)), chart.axis) - chart.min;
+                glm::vec2 texel = glm::vec2(chart.offset + padding) + 0.5f + local * scale;
+                it = remap.emplace(key, (unsigned int)newVertices.size()).first;
+                newVertices.push_back(vertices[v]);
+                texelCoords.push_back(texel);
+                lightmapUVs.push_back(texel / (float)atlasSize);
+            }
+            newIndices.push_back(it->second);
+        }
+        for (size_t t = 0; t + 2 < newIndices.size(); t += 3) {
+            LightmapTriangle tri;
+            for (int k = 0; k < 3; ++k) {
+                const Vertex& vertex = newVertices[newIndices[t + k]];
+                tri.uv[k] = texelCoords[newIndices[t + k]];
+                tri.position[k] = glm::vec3(mc.world * glm::vec4(vertex.Position, 1.0f));
+                tri.normal[k] = glm::normalize(mc.normalMatrix * vertex.Normal);
+            }
+            m_Charts.push_back(tri);
+        }
+        mc.mesh->SetLightmapGeometry(newVertices, newIndices, lightmapUVs);
+    }
+    m_ChartedNodes = charted;
+    m_ChartTransforms.clear();
+    for (const SceneNode::Ptr& node : charted)
+        m_ChartTransforms.push_back(node->GetWorldTransform());
+    m_ChartScale = scale;
+    m_ChartCount = (int)charts.size();
+    return true;
+}
+
+// ================== 主线程 ==================
+void Lightmapper::Update(const SceneManager& scene, float deltaTime) {
+    std::unique_ptr<BakeJob> done;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        done = std::move(m_Completed);
+    }
+    if (done) {
+        m_Busy = false;
+        Upload(*done);
+        m_LastFromCache = false;
+        m_LastBakeMs = done->bakeMs;
+        ++m_Bakes;
+    }
+
+    // 模型重新加载后网格丢失第二套UV
+    if (!m_Dirty && m_Texture && !ChartsValid())
+        m_Dirty = true;
+    if (!m_Dirty || m_Busy || m_Nodes.empty()) return;
+
+    // 等待静态几何稳定（启动时的模型流送、连续编辑），节点的模型全部驻留后才烘焙
+    m_QuietTime += deltaTime;
+    if (m_QuietTime < bakeDelay) return;
+    for (const SceneNode::Ptr& node : m_Nodes)
+        if (node->IsModelPending()) return;
+
+    m_Dirty = false;
+    if (!ChartsValid() && !GenerateCharts()) return;
+
+    std::unique_ptr<BakeJob> job(new BakeJob());
+    job->width = atlasSize;
+    job->height = atlasSize;
+    job->texelSize = 1.0f / m_ChartScale;
+    scene.CollectStaticTriangles(job->triangles);
+    job->lightmapTriangles = m_Charts;
+    job->pointLights = m_PointLights;
+    job->sunDirection = m_SunDirection;
+    job->sunColor = m_SunColor;
+    job->sky = m_Sky;
+    job->key = ComputeKey(*job);
+
+    // 输入没有变化（如启动时的失效）时沿用当前结果
+    if (m_Texture && job->key == m_TextureKey) {
+        for (const SceneNode::Ptr& node : m_ChartedNodes)
+            node->GetMaterial().lightmap = m_Texture;
+        return;
+    }
+    if (LoadCache(job->key, *job)) {
+        Upload(*job);
+        m_LastFromCache = true;
+        return;
+    }
+
+    m_Busy = true;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Request = std::move(job);
+    }
+    m_Cond.notify_one();
+}
+
+uint64_t Lightmapper::ComputeKey(const BakeJob& job) const {
+    uint64_t hash = IBLCache::HashBytes(job.triangles.data(), job.triangles.size() * sizeof(glm::vec3));
+    hash = IBLCache::HashBytes(job.lightmapTriangles.data(), job.lightmapTriangles.size() * sizeof(LightmapTriangle), hash);
+    hash = IBLCache::HashBytes(job.pointLights.data(), job.pointLights.size() * sizeof(PointLight), hash);
+    hash = IBLCache::HashBytes(&job.sunDirection, sizeof(job.sunDirection), hash);
+    hash = IBLCache::HashBytes(&job.sunColor, sizeof(job.sunColor), hash);
+    hash = IBLCache::HashBytes(job.sky.c, sizeof(job.sky.c), hash);
+    const float params[] = {
+        (float)job.width, (float)job.height, job.texelSize, (float)padding, (float)samplesPerTexel,
+        (float)maxBounces, albedo.r, albedo.g, albedo.b, backfaceThreshold, (float)CACHE_VERSION
+    };
+    return IBLCache::HashBytes(params, sizeof(params), hash);
+}
+
+void Lightmapper::Upload(const BakeJob& job) {
+    if (m_Texture) ResidencyManager::Get().UntrackTexture(m_Texture);
+    else glGenTextures(1, &m_Texture);
+    glBindTexture(GL_TEXTURE_2D, m_Texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB9_E5, job.width, job.height, 0, GL_RGB, GL_UNSIGNED_INT_5_9_9_9_REV,
+        job.texels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    ResidencyManager::Get().TrackTexture(m_Texture, (size_t)job.width * job.height * 4, "Lightmap");
+
+    m_TextureKey = job.key;
+    m_TextureWidth = job.width;
+    m_TextureHeight = job.height;
+    m_LastValidTexels = job.validTexels;
+    for (const SceneNode::Ptr& node : m_ChartedNodes)
+        node->GetMaterial().lightmap = m_Texture;
+}
+
+void Lightmapper::PrintStats() const {
+    std::cout << "LIGHTMAPPER: " << m_ChartedNodes.size() << " nodes, " << m_ChartCount << " charts, "
+        << m_TextureWidth << "x" << m_TextureHeight << " at " << m_ChartScale << " texels/unit, "
+        << m_Bakes << " bakes, last " << (m_LastFromCache ? "loaded from cache" : std::to_string(m_LastBakeMs) + " ms")
+        << ", " << m_LastValidTexels << " valid texels" << (m_Busy ? " (baking)" : "") << std::endl;
+}
+
+void Lightmapper::Cleanup() {
+    for (const SceneNode::Ptr& node : m_ChartedNodes)
+        node->GetMaterial().lightmap = 0;
+    if (m_Texture) {
+        ResidencyManager::Get().UntrackTexture(m_Texture);
+        glDeleteTextures(1, &m_Texture);
+        m_Texture = 0;
+    }
+}
+
+// ================== 磁盘缓存 ==================
+bool Lightmapper::LoadCache(uint64_t key, BakeJob& job) const {
+    std::ifstream file(m_CachePath, std::ios::binary);
+    if (!file) return false;
+
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t fileKey = 0;
+    int32_t size[2] = {};
+    int32_t validTexels = 0;
+    file.read(magic, 4);
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&fileKey), sizeof(fileKey));
+    file.read(reinterpret_cast<char*>(size), sizeof(size));
+    file.read(reinterpret_cast<char*>(&validTexels), sizeof(validTexels));
+    if (!file || std::memcmp(magic, CACHE_MAGIC, 4) != 0 || version != CACHE_VERSION)
+        return false;
+    if (fileKey != key || size[0] != job.width || size[1] != job.height) {
+        std::cout << "LIGHTMAPPER: stale cache (scene or lights changed): " << m_CachePath << std::endl;
+        return false;
+    }
+    job.texels.resize((size_t)job.width * job.height);
+    if (!file.read(reinterpret_cast<char*>(job.texels.data()), job.texels.size() * sizeof(uint32_t))) {
+        std::cout << "ERROR::LIGHTMAPPER::Corrupt cache: " << m_CachePath << std::endl;
+        job.texels.clear();
+        return false;
+    }
+    job.validTexels = validTexels;
+    return true;
+}
+
+bool Lightmapper::SaveCache(const BakeJob& job) const {
+    std::ofstream file(m_CachePath, std::ios::binary);
+    if (!file) {
+        std::cout << "WARNING::LIGHTMAPPER::Cannot write cache: " << m_CachePath << std::endl;
+        return false;
+    }
+    int32_t size[2] = { job.width, job.height };
+    int32_t validTexels = job.validTexels;
+    file.write(CACHE_MAGIC, 4);
+    file.write(reinterpret_cast<const char*>(&CACHE_VERSION), sizeof(CACHE_VERSION));
+    file.write(reinterpret_cast<const char*>(&job.key), sizeof(job.key));
+    file.write(reinterpret_cast<const char*>(size), sizeof(size));
+    file.write(reinterpret_cast<const char*>(&validTexels), sizeof(validTexels));
+    file.write(reinterpret_cast<const char*>(job.texels.data()), job.texels.size() * sizeof(uint32_t));
+    return (bool)file;
+}
+
+// 共享指数格式（EXT_texture_shared_exponent）：9位尾数 x3，5位指数，偏移15
+uint32_t Lightmapper::PackRGB9E5(const glm::vec3& rgb) {
+    const int MANTISSA_BITS = 9;
+    const int EXP_BIAS = 15;
+    const float MAX_VALUE = 65408.0f;   // (511 / 512) * 2^16
+    glm::vec3 c = glm::clamp(rgb, glm::vec3(0.0f), glm::vec3(MAX_VALUE));
+    float maxChannel = std::max(c.r, std::max(c.g, c.b));
+    if (maxChannel <= 0.0f) return 0;
+
+    int exponent = std::max(-EXP_BIAS - 1, (int)std::floor(std::log2(maxChannel))) + 1 + EXP_BIAS;
+    float denom = std::exp2((float)(exponent - EXP_BIAS - MANTISSA_BITS));
+    if ((int)std::floor(maxChannel / denom + 0.5f) == (1 << MANTISSA_BITS)) {
+        denom *= 2.0f;
+        ++exponent;
+    }
+    uint32_t r = (uint32_t)std::min(511.0f, std::floor(c.r / denom + 0.5f));
+    uint32_t g = (uint32_t)std::min(511.0f, std::floor(c.g / denom + 0.5f));
+    uint32_t b = (uint32_t)std::min(511.0f, std::floor(c.b / denom + 0.5f));
+    return r | (g << 9) | (b << 18) | ((uint32_t)exponent << 27);
+}
+
+// ================== 后台烘焙 ==================
+void Lightmapper::WorkerLoop() {
+    while (true) {
+        std::unique_ptr<BakeJob> job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Cond.wait(lock, [this] { return !m_Running || m_Request; });
+            if (!m_Running) return;
+            job = std::move(m_Request);
+        }
+        auto start = std::chrono::steady_clock::now();
+        Bake(*job);
+        if (!m_Running) return;
+        job->bakeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        SaveCache(*job);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Completed = std::move(job);
+    }
+}
+
+void Lightmapper::ParallelFor(int count, const std::function<void(int)>& task) const {
+    unsigned int threadCount = std::max(1u, std::min(m_ThreadCount, (unsigned int)count));
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (int i = next++; i < count && m_Running; i = next++)
+            task(i);
+    };
+    std::vector<std::thread> workers;
+    for (unsigned int t = 1; t < threadCount; ++t)
+        workers.emplace_back(worker);
+    worker();
+    for (std::thread& w : workers)
+        w.join();
+}
+
+void Lightmapper::Bake(BakeJob& job) const {
+    SceneBVH bvh;
+    bvh.Build(job.triangles);
+    const int width = job.width, height = job.height;
+    const size_t texelCount = (size_t)width * height;
+    const glm::vec3 toSun = -job.sunDirection;
+    const glm::vec3 extent = bvh.GetBounds().IsValid() ? bvh.GetBounds().max - bvh.GetBounds().min : glm::vec3(1.0f);
+    const float rayBias = std::max(1e-4f, 1e-3f * glm::length(extent));
+    const int sampleCount = std::max(1, samplesPerTexel);
+
+    // 光栅化：纹素中心落在三角形内（含边上）时记录世界位置和插值法线
+    std::vector<glm::vec3> positions(texelCount), normals(texelCount);
+    std::vector<unsigned char> valid(texelCount, 0);
+    for (const LightmapTriangle& tri : job.lightmapTriangles) {
+        float area = Edge(tri.uv[0], tri.uv[1], tri.uv[2]);
+        if (std::abs(area) < 1e-8f) continue;
+        glm::vec2 lo = glm::min(tri.uv[0], glm::min(tri.uv[1], tri.uv[2]));
+        glm::vec2 hi = glm::max(tri.uv[0], glm::max(tri.uv[1], tri.uv[2]));
+        int x0 = std::max(0, (int)std::floor(lo.x - 0.5f)), x1 = std::min(width - 1, (int)std::ceil(hi.x - 0.5f));
+        int y0 = std::max(0, (int)std::floor(lo.y - 0.5f)), y1 = std::min(height - 1, (int)std::ceil(hi.y - 0.5f));
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x) {
+                glm::vec2 center(x + 0.5f, y + 0.5f);
+                float b0 = Edge(tri.uv[1], tri.uv[2], center) / area;
+                float b1 = Edge(tri.uv[2], tri.uv[0], center) / area;
+                float b2 = 1.0f - b0 - b1;
+                if (b0 < -1e-3f || b1 < -1e-3f || b2 < -1e-3f) continue;
+                size_t i = (size_t)y * width + x;
+                positions[i] = b0 * tri.position[0] + b1 * tri.position[1] + b2 * tri.position[2];
+                normals[i] = glm::normalize(b0 * tri.normal[0] + b1 * tri.normal[1] + b2 * tri.normal[2]);
+                valid[i] = 1;
+            }
+    }
+
+    // 点p（法线n）处的直接辐照度：平行光和静态点光源，阴影光线判断可见性
+    auto directLight = [&](const glm::vec3& p, const glm::vec3& n) {
+        glm::vec3 origin = p + n * rayBias;
+        glm::vec3 result(0.0f);
+        float NdotL = glm::dot(n, toSun);
+        if (NdotL > 0.0f && !bvh.Occluded(origin, toSun, FLT_MAX))
+            result += job.sunColor * NdotL;
+        for (const PointLight& light : job.pointLights) {
+            glm::vec3 toLight = light.position - p;
+            float distance = glm::length(toLight);
+            if (distance <= 0.0f || distance > AttenuationRange(light.constant, light.linear, light.quadratic, light.diffuse))
+                continue;
+            glm::vec3 l = toLight / distance;
+            NdotL = glm::dot(n, l);
+            if (NdotL <= 0.0f || bvh.Occluded(origin, l, distance - rayBias)) continue;
+            result += light.diffuse * NdotL / (light.constant + light.linear * distance + light.quadratic * distance * distance);
+        }
+        return result;
+    };
+
+    // 路径追踪：直接光照不含噪声单独保存，间接光 = PI * 出射辐射度的余弦加权平均
+    std::vector<glm::vec3> direct(texelCount, glm::vec3(0.0f)), indirect(texelCount, glm::vec3(0.0f));
+    ParallelFor(height, [&](int y) {
+        for (int x = 0; x < width; ++x) {
+            size_t i = (size_t)y * width + x;
+            if (!valid[i]) continue;
+            const glm::vec3 p = positions[i], n = normals[i];
+            direct[i] = directLight(p, n);
+
+            Random random((uint32_t)i);
+            glm::vec3 sum(0.0f);
+            int backfaces = 0;
+            for (int s = 0; s < sampleCount; ++s) {
+                glm::vec3 origin = p + n * rayBias;
+                glm::vec3 dir = CosineSample(n, random);
+                glm::vec3 throughput(1.0f);
+                for (int bounce = 0; bounce < std::max(1, maxBounces); ++bounce) {
+                    RayHit hit;
+                    if (!bvh.Intersect(origin, dir, FLT_MAX, hit)) {
+                        // 天空项与SphericalHarmonics::Evaluate、IBL辐照度贴图一致，结果为 辐照度 / PI（着色器直接乘以反照率）
+                        sum += throughput * SphericalHarmonics::EvaluateRadiance(job.sky, dir) / PI;
+                        break;
+                    }
+                    if (hit.backface) {
+                        if (bounce == 0) ++backfaces;
+                        break;
+                    }
+                    glm::vec3 hitNormal = bvh.GetNormal(hit.triangle);
+                    glm::vec3 hitPos = origin + dir * hit.t;
+                    // 朗伯表面：出射辐射度 = 反照率 / PI * 直接辐照度
+                    sum += throughput * albedo * directLight(hitPos, hitNormal) / PI;
+                    throughput *= albedo;
+                    origin = hitPos + hitNormal * rayBias;
+                    dir = CosineSample(hitNormal, random);
+                }
+            }
+            indirect[i] = sum * (PI / sampleCount);
+            // 纹素在几何内部（背面击中过多）时丢弃，由相邻纹素扩展填充
+            if (backfaces > backfaceThreshold * sampleCount)
+                valid[i] = 0;
+        }
+    });
+    if (!m_Running) return;
+
+    // à-trous降噪（只处理间接光）：5x5 B3样条核，按法线和世界位置的差异加权，不跨图表和几何边缘
+    const float kernel[3] = { 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+    std::vector<glm::vec3> filtered(texelCount);
+    for (int step = 1; step <= 4 && m_Running; step *= 2) {
+        float sigma = 2.0f * step * job.texelSize;
+        ParallelFor(height, [&](int y) {
+            for (int x = 0; x < width; ++x) {
+                size_t i = (size_t)y * width + x;
+                if (!valid[i]) continue;
+                glm::vec3 sum(0.0f);
+                float weightSum = 0.0f;
+                for (int dy = -2; dy <= 2; ++dy)
+                    for (int dx = -2; dx <= 2; ++dx) {
+                        int qx = x + dx * step, qy = y + dy * step;
+                        if (qx < 0 || qy < 0 || qx >= width || qy >= height) continue;
+                        size_t q = (size_t)qy * width + qx;
+                        if (!valid[q]) continue;
+                        glm::vec3 dp = positions[q] - positions[i];
+                        float w = kernel[std::abs(dx)] * kernel[std::abs(dy)]
+                            * std::pow(std::max(0.0f, glm::dot(normals[i], normals[q])), 32.0f)
+                            * std::exp(-glm::dot(dp, dp) / (2.0f * sigma * sigma));
+                        sum += indirect[q] * w;
+                        weightSum += w;
+                    }
+                filtered[i] = weightSum > 0.0f ? sum / weightSum : indirect[i];
+            }
+        });
+        indirect.swap(filtered);
+    }
+
+    std::vector<glm::vec3> result(texelCount, glm::vec3(0.0f));
+    job.validTexels = 0;
+    for (size_t i = 0; i < texelCount; ++i) {
+        if (!valid[i]) continue;
+        result[i] = direct[i] + indirect[i];
+        ++job.validTexels;
+    }
+
+    // 有效纹素向外扩展，填充图表间隔和几何内部的纹素
+    for (int iteration = 0; iteration < 2 * padding; ++iteration) {
+        std::vector<unsigned char> nextValid = valid;
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x) {
+                size_t i = (size_t)y * width + x;
+                if (valid[i]) continue;
+                glm::vec3 sum(0.0f);
+                int count = 0;
+                for (int dy = -1; dy <= 1; ++dy)
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        int qx = x + dx, qy = y + dy;
+                        if (qx < 0 || qy < 0 || qx >= width || qy >= height) continue;
+                        size_t q = (size_t)qy * width + qx;
+                        if (!valid[q]) continue;
+                        sum += result[q];
+                        ++count;
+                    }
+                if (count == 0) continue;
+                result[i] = sum / (float)count;
+                nextValid[i] = 1;
+            }
+        valid.swap(nextValid);
+    }
+
+    job.texels.resize(texelCount);
+    for (size_t i = 0; i < texelCount; ++i)
+        job.texels[i] = PackRGB9E5(result[i]);
+}
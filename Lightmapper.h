@@ -0,0 +1,130 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Light.h"
+#include "SceneNode.h"
+#include "SphericalHarmonics.h"
+
+class SceneManager;
+
+// 静态节点的CPU光照贴图烘焙
+//   UV：三角形按几何法线的主轴方向（±X/±Y/±Z）分类，共享顶点且同类的三角形组成一个图表，沿主轴平面投影；
+//       图表按高度排序后逐行（shelf）装入一张图集，放不下时降低纹素密度重试；接缝处拆分顶点，第二套UV写入网格（location = 4）
+//   烘焙：后台线程把三角形光栅化到纹素（世界位置和插值法线），按行分配到全部核心路径追踪：
+//         平行光和静态点光源用阴影光线直接计算（硬阴影，不做降噪），间接光按余弦分布采样，
+//         每次反弹做直接光照采样，未击中取天空球谐；求交使用SceneBVH（SSE 4叉BVH）
+//   降噪：只对间接光做按法线/位置加权的à-trous滤波（步长1, 2, 4），再把有效纹素向外扩展padding圈，双线性过滤不会采到空白
+//   存储：RGB9E5（4字节/纹素）纹理，连同输入的哈希写入磁盘缓存，场景和光照不变时启动直接加载
+//   使用：烘焙完成后设置节点材质的lightmap，SceneManager::RenderScene用LIGHTMAPPED变体绘制这些节点，
+//         片段只做一次漫反射纹理和一次光照贴图采样，不再计算阴影和遍历动态光源（聚光灯等动态光源不影响这些表面）
+//   数值与Phong漫反射相同的约定：纹素 = 平行光/点光源颜色 * NdotL * 可见性 + 间接辐照度，不除以PI
+class Lightmapper {
+public:
+    static const GLuint LIGHTMAP_UNIT = 22;     // 辐照度体积占用到21
+
+    int atlasSize = 1024;
+    float texelsPerUnit = 16.0f;    // 世界空间纹素密度（图集放不下时自动降低）
+    int padding = 2;                // 图表之间的间隔（纹素）
+    int samplesPerTexel = 128;      // 间接光的采样数
+    int maxBounces = 3;
+    glm::vec3 albedo = glm::vec3(0.5f);     // 烘焙用的统一表面反照率（与IrradianceVolume相同）
+    float backfaceThreshold = 0.25f;        // 背面击中比例超过该值的纹素视为在几何内部，由相邻纹素填充
+    float bakeDelay = 2.0f;                 // 静态几何变化（含启动时的流送）后等待这么多秒没有新的变化再烘焙
+
+    // cachePath为磁盘缓存文件；workerThreads < 0时按CPU核数
+    explicit Lightmapper(const std::string& cachePath, int workerThreads = -1);
+    ~Lightmapper();
+
+    // 登记使用光照贴图的节点（应为静态节点，懒加载的模型驻留后才会烘焙）
+    void AddNode(const SceneNode::Ptr& node);
+    // 静态光源：烘焙进光照贴图
+    void AddPointLight(const PointLight& light);
+    void SetSun(const glm::vec3& direction, const glm::vec3& color);
+    void SetSky(const SH9Color& sky);
+    // 静态几何变化的世界包围盒：光照贴图过期，bakeDelay后重新烘焙（期间沿用旧结果）
+    void Invalidate(const std::vector<AABB>& changedBounds);
+
+    // 主线程每帧调用：需要烘焙且节点都已驻留时生成UV并提交（命中磁盘缓存时直接加载），完成后上传并设置材质
+    void Update(const SceneManager& scene, float deltaTime);
+    bool IsBaked() const { return m_Texture != 0; }
+    void PrintStats() const;
+    void Cleanup();
+
+private:
+    // 光栅化用的三角形：图集纹素坐标、世界位置和世界法线
+    struct LightmapTriangle {
+        glm::vec2 uv[3];
+        glm::vec3 position[3];
+        glm::vec3 normal[3];
+    };
+
+    struct BakeJob {
+        uint64_t key = 0;
+        int width = 0, height = 0;
+        float texelSize = 0.0f;                     // 一个纹素的世界尺寸（降噪的位置权重）
+        std::vector<glm::vec3> triangles;           // 全部静态几何（求交）
+        std::vector<LightmapTriangle> lightmapTriangles;
+        std::vector<PointLight> pointLights;
+        glm::vec3 sunDirection, sunColor;
+        SH9Color sky;
+        std::vector<uint32_t> texels;               // 结果（RGB9E5）
+        int validTexels = 0;
+        float bakeMs = 0.0f;
+    };
+
+    std::string m_CachePath;
+    unsigned int m_ThreadCount;
+    std::vector<SceneNode::Ptr> m_Nodes;
+    std::vector<PointLight> m_PointLights;
+    glm::vec3 m_SunDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+    glm::vec3 m_SunColor = glm::vec3(0.0f);
+    SH9Color m_Sky;
+
+    // 主线程状态
+    bool m_Dirty = true;
+    float m_QuietTime = 0.0f;           // 距上次失效的时间
+    std::vector<SceneNode::Ptr> m_ChartedNodes;    // 已生成第二套UV的节点（与其他节点共享网格的节点不参与）
+    std::vector<glm::mat4> m_ChartTransforms;      // 生成时的世界变换（m_Charts中为世界坐标）
+    std::vector<LightmapTriangle> m_Charts;    // 当前UV对应的光栅化输入
+    float m_ChartScale = 0.0f;          // 实际使用的纹素密度
+    int m_ChartCount = 0;
+    GLuint m_Texture = 0;
+    uint64_t m_TextureKey = 0;          // 当前纹理对应的输入哈希
+    int m_TextureWidth = 0, m_TextureHeight = 0;
+    int m_Bakes = 0;
+    bool m_LastFromCache = false;
+    float m_LastBakeMs = 0.0f;
+    int m_LastValidTexels = 0;
+
+    std::thread m_Worker;
+    std::mutex m_Mutex;
+    std::condition_variable m_Cond;
+    std::unique_ptr<BakeJob> m_Request;
+    std::unique_ptr<BakeJob> m_Completed;
+    std::atomic<bool> m_Running;
+    bool m_Busy = false;
+
+    // 为全部节点生成第二套UV并重新上传网格，失败（图表过多）时返回false
+    bool GenerateCharts();
+    // 已有UV仍然有效（没有新节点，节点没有移动，模型也没有重新加载）
+    bool ChartsValid() const;
+    uint64_t ComputeKey(const BakeJob& job) const;
+    void Upload(const BakeJob& job);
+
+    void WorkerLoop();
+    void Bake(BakeJob& job) const;
+    void ParallelFor(int count, const std::function<void(int)>& task) const;
+
+    static uint32_t PackRGB9E5(const glm::vec3& rgb);
+    bool LoadCache(uint64_t key, BakeJob& job) const;
+    bool SaveCache(const BakeJob& job) const;
+};
@@ -4,28 +4,34 @@
 #include <glm/detail/type_vec.hpp>
 
 struct Material {
-    // ͳphong
+    // 传统phong参数
     float shininess = 32.0f;
-    // 
+    // 公共参数
     float opacity = 1.0f;
+    // 透明度测试（镂空）：漫反射alpha低于alphaCutoff的片段丢弃；深度绘制时单独分组
+    bool alphaTest = false;
+    float alphaCutoff = 0.5f;
 
-    // PBRʲ
+    // PBR材质参数
     float metallic = 0.5f;
     float roughness = 0.5f;
     float ao = 1.0f;
-    float velvetRoughness = 0.85f;  // ޴ֲڶ
-    float velvetMetallic = 0.05f;   // ޽
+    float velvetRoughness = 0.85f;  // 天鹅绒粗糙度
+    float velvetMetallic = 0.05f;   // 天鹅绒金属度
 
-    // ͱʶ
+    // 材质类型标识
     enum Type { PHONG, PBR } type = PHONG;
 
-    // ֧
+    // 烘焙光照贴图（Lightmapper，RGB9E5），非0时节点用着色器的LIGHTMAPPED变体绘制，不再遍历动态光源
+    unsigned int lightmap = 0;
+
+    // 材质遮罩支持
     bool useMaterialMask = false;
-    // ޲
-    glm::vec3 velvetColor = glm::vec3(0.8f, 0.1f, 0.1f); // Ĭɫë
-    float velvetStrength = 0.7f;               // ëǿϵ
-    bool useVelvet = false;                     // Ч
-    //ﲻ֪ǷҪʹȲɾ
-    // ͱ
+    // 天鹅绒参数
+    glm::vec3 velvetColor = glm::vec3(0.8f, 0.1f, 0.1f); // 默认深红色绒毛
+    float velvetStrength = 0.7f;               // 绒毛强度系数
+    bool useVelvet = false;                     // 启用天鹅绒特效
+    //这里不知道是否要使用先不删除
+    // 纹理类型标记
     bool isPBR = false;
 };
\ No newline at end of file
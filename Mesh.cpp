@@ -1,52 +1,159 @@
 #include "Mesh.h"
 #include "Material.h"
+#include "ResidencyManager.h"
+#include "TextureStreamer.h"
+#include "TexturePacker.h"
+#include "BindlessTextures.h"
+#include <cmath>
+#include <algorithm>
 
 Mesh::Mesh(const std::vector<Vertex>& vertices,
     const std::vector<unsigned int>& indices,
     const std::vector<Texture>& textures)
     : vertices(vertices), indices(indices), textures(textures)
 {
-    setupMesh();  // ˽гʼ
+    setupMesh();  // 调用私有初始化函数
+    computeUVDensity();
 }
 
+// 导入时预计算：sqrt(UV面积 / 模型空间面积)
+void Mesh::computeUVDensity() {
+    double worldArea = 0.0, uvArea = 0.0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const Vertex& a = vertices[indices[i]];
+        const Vertex& b = vertices[indices[i + 1]];
+        const Vertex& c = vertices[indices[i + 2]];
+        worldArea += 0.5 * glm::length(glm::cross(b.Position - a.Position, c.Position - a.Position));
+        glm::vec2 e1 = b.TexCoords - a.TexCoords, e2 = c.TexCoords - a.TexCoords;
+        uvArea += 0.5 * std::abs(e1.x * e2.y - e1.y * e2.x);
+    }
+    m_UVDensity = (worldArea > 0.0 && uvArea > 0.0) ? (float)std::sqrt(uvArea / worldArea) : 0.0f;
+}
+
+// 位置之外的顶点属性，在VBO后段交错存放
+struct VertexAttributes {
+    glm::vec3 Normal;
+    glm::vec2 TexCoords;
+    glm::vec3 Tangent;
+};
+
 void Mesh::setupMesh() {
     glGenVertexArrays(1, &VAO);
+    glGenVertexArrays(1, &depthVAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
 
+    // 拆分为位置流和属性流：深度绘制只读取前者
+    std::vector<glm::vec3> positions(vertices.size());
+    std::vector<VertexAttributes> attributes(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        positions[i] = vertices[i].Position;
+        attributes[i] = { vertices[i].Normal, vertices[i].TexCoords, vertices[i].Tangent };
+    }
+    size_t positionBytes = positions.size() * sizeof(glm::vec3);
+    size_t attributeBytes = attributes.size() * sizeof(VertexAttributes);
+    size_t lightmapBytes = HasLightmapUVs() ? lightmapUVs.size() * sizeof(glm::vec2) : 0;
+
     glBindVertexArray(VAO);
 
-    // 
+    // 顶点数据
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, positionBytes + attributeBytes + lightmapBytes, nullptr, GL_STATIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, positionBytes, positions.data());
+    glBufferSubData(GL_ARRAY_BUFFER, positionBytes, attributeBytes, attributes.data());
+    if (lightmapBytes)
+        glBufferSubData(GL_ARRAY_BUFFER, positionBytes + attributeBytes, lightmapBytes, lightmapUVs.data());
 
-    // 
+    // 索引数据
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
 
-    // ָ
-    // λ
+    // 顶点属性指针
+    // 位置属性
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
-    // 
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    // 法线属性
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-    // 
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(VertexAttributes),
+        (void*)(positionBytes + offsetof(VertexAttributes, Normal)));
+    // 纹理坐标属性
     glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-    // ԣlocation=3
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VertexAttributes),
+        (void*)(positionBytes + offsetof(VertexAttributes, TexCoords)));
+    // 新增：切线属性（location=3）
     glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(VertexAttributes),
+        (void*)(positionBytes + offsetof(VertexAttributes, Tangent)));
+    // 光照贴图UV（location=4，只有LIGHTMAPPED变体读取）
+    if (lightmapBytes) {
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)(positionBytes + attributeBytes));
+    }
+
+    // 深度VAO：同一VBO/EBO，只启用位置
+    glBindVertexArray(depthVAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
     glBindVertexArray(0);
+
+    m_ResidencyHandle = ResidencyManager::Get().TrackGeometry(VAO, VBO, EBO,
+        positionBytes + attributeBytes + lightmapBytes + indices.size() * sizeof(unsigned int), "Mesh", depthVAO);
 }
 
-// 4. ޸Draw²ϵͳ
-void Mesh::Draw(Shader& shader, const Material& material) const {
-    // 1.  - ߼
+// 4. 修改Draw方法适配新材质系统
+void Mesh::Draw(Shader& shader, const Material& material) {
+    ResidencyManager& residency = ResidencyManager::Get();
+    EnsureResident();
+
+    // 1. 绑定纹理 - 简化逻辑
     bool hasDiffuse = false;
     bool hasSpecular = false;
+    bool diffusePacked = false;
+    bool specularPacked = false;
+    // BINDLESS变体的着色器只需要句柄表下标，不占用纹理单元
+    bool bindless = BindlessTextures::Get().Apply(shader);
+    if (bindless) {
+        // 没有句柄的纹理走下面的绑定路径，着色器按下标-1选择采样器
+        shader.setInt("diffuseIndex", -1);
+        shader.setInt("specularIndex", -1);
+    }
 
     for (unsigned int i = 0; i < textures.size(); i++) {
+        residency.TouchTexture(textures[i].id);
+
+        bool isDiffuse = textures[i].type == "texture_diffuse";
+        bool isSpecular = textures[i].type == "texture_specular";
+        int handleIndex = bindless ? BindlessTextures::Get().GetIndex(textures[i].id) : -1;
+        if (handleIndex >= 0 && (isDiffuse || isSpecular)) {
+            std::string prefix = isDiffuse ? "diffuse" : "specular";
+            shader.setInt(prefix + "Index", handleIndex);
+            shader.setFloat(prefix + "Layer", (float)std::max(textures[i].layer, 0));
+            shader.setVec4(prefix + "Rect", textures[i].uvRect);
+            (isDiffuse ? hasDiffuse : hasSpecular) = true;
+            (isDiffuse ? diffusePacked : specularPacked) = textures[i].layer >= 0;
+            if (textures[i].layer < 0)
+                TextureStreamer::Get().Request(textures[i].id, m_UVDensity);
+            continue;
+        }
+
+        // 打包的纹理：固定单元上的数组纹理 + 每次绘制的层号/UV变换
+        if (textures[i].layer >= 0) {
+            if (textures[i].type == "texture_diffuse") {
+                TexturePacker::BindArray(TexturePacker::DIFFUSE_ARRAY_UNIT, textures[i].id);
+                shader.setFloat("diffuseLayer", (float)textures[i].layer);
+                shader.setVec4("diffuseRect", textures[i].uvRect);
+                hasDiffuse = diffusePacked = true;
+            }
+            else if (textures[i].type == "texture_specular") {
+                TexturePacker::BindArray(TexturePacker::SPECULAR_ARRAY_UNIT, textures[i].id);
+                shader.setFloat("specularLayer", (float)textures[i].layer);
+                shader.setVec4("specularRect", textures[i].uvRect);
+                hasSpecular = specularPacked = true;
+            }
+            continue;
+        }
+
         glActiveTexture(GL_TEXTURE0 + i);
 
         if (textures[i].type == "texture_diffuse") {
@@ -59,37 +166,133 @@ void Mesh::Draw(Shader& shader, const Material& material) const {
         }
 
         glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        TextureStreamer::Get().Request(textures[i].id, m_UVDensity);
     }
 
-    // 2. òʲ
+    // 2. 设置材质参数
     shader.setFloat("material.shininess", material.shininess);
 
-    // 3. ״̬ؼ޸
+    // 3. 标记纹理存在状态（关键修复）
     shader.setBool("hasDiffuseTexture", hasDiffuse);
     shader.setBool("hasSpecularTexture", hasSpecular);
+    shader.setBool("diffusePacked", diffusePacked);
+    shader.setBool("specularPacked", specularPacked);
+    shader.setInt("diffuseArray", TexturePacker::DIFFUSE_ARRAY_UNIT);
+    shader.setInt("specularArray", TexturePacker::SPECULAR_ARRAY_UNIT);
+
+    // 4. 绘制网格
+    glBindVertexArray(VAO);
+    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+}
+
+void Mesh::DrawDepth() {
+    EnsureResident();
+    glBindVertexArray(depthVAO);
+    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+}
+
+void Mesh::DrawDepthAlphaTested(Shader& shader, const Material& material) {
+    ResidencyManager& residency = ResidencyManager::Get();
+    EnsureResident();
+
+    // 两个采样器类型不同，必须指向不同的单元
+    shader.setInt("alphaMap", 0);
+    shader.setInt("alphaArray", TexturePacker::DIFFUSE_ARRAY_UNIT);
+    bool hasAlpha = false;
+    for (const auto& texture : textures) {
+        if (texture.type != "texture_diffuse") continue;
+        residency.TouchTexture(texture.id);
+        if (texture.layer >= 0) {
+            TexturePacker::BindArray(TexturePacker::DIFFUSE_ARRAY_UNIT, texture.id);
+            shader.setFloat("alphaLayer", (float)texture.layer);
+            shader.setVec4("alphaRect", texture.uvRect);
+        }
+        else {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, texture.id);
+        }
+        shader.setBool("alphaPacked", texture.layer >= 0);
+        hasAlpha = true;
+        break;
+    }
+    // 没有漫反射纹理时按不透明处理
+    shader.setFloat("alphaCutoff", hasAlpha ? material.alphaCutoff : -1.0f);
 
-    // 4. 
     glBindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
 }
 
 void Mesh::SetupMesh(const std::vector<float>& vertices, const std::vector<unsigned int>& indices) {
-    // 1. ת
+    // 1. 转换顶点数据
     std::vector<Vertex> vertexStructs;
     for (size_t i = 0; i < vertices.size(); i += 11) {
         Vertex v;
         v.Position = glm::vec3(vertices[i], vertices[i + 1], vertices[i + 2]);
         v.Normal = glm::vec3(vertices[i + 3], vertices[i + 4], vertices[i + 5]);
         v.TexCoords = glm::vec2(vertices[i + 6], vertices[i + 7]);
-        v.Tangent = glm::vec3(vertices[i + 8], vertices[i + 9], vertices[i + 10]); // 
+        v.Tangent = glm::vec3(vertices[i + 8], vertices[i + 9], vertices[i + 10]); // 添加切线
         vertexStructs.push_back(v);
     }
 
-    // 2. 
+    // 2. 设置网格数据
     this->vertices = vertexStructs;
     this->indices = indices;
+    this->lightmapUVs.clear();
+
+    // 3. 调用已有的setupMesh()初始化OpenGL对象
+    setupMesh();
+    computeUVDensity();
+}
+
+void Mesh::SetLightmapGeometry(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+    const std::vector<glm::vec2>& lightmapUVs) {
+    Release();
+    this->vertices = vertices;
+    this->indices = indices;
+    this->lightmapUVs = lightmapUVs;
+    setupMesh();
+    computeUVDensity();
+}
+
+void Mesh::ReplaceTexture(unsigned int oldId, unsigned int newId, int oldLayer) {
+    for (auto& tex : textures) {
+        if (tex.id != oldId || tex.layer != oldLayer) continue;
+        tex.id = newId;
+        tex.layer = -1;
+        tex.uvRect = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+    }
+}
+
+void Mesh::PackTexture(unsigned int oldId, const Texture& packed) {
+    for (auto& tex : textures) {
+        if (tex.id != oldId || tex.layer >= 0) continue;
+        tex.id = packed.id;
+        tex.layer = packed.layer;
+        tex.uvRect = packed.uvRect;
+    }
+}
+
+void Mesh::Release() {
+    // 已被驱逐时GL对象已由ResidencyManager删除，名字可能已分配给其他网格，不能再删除
+    ResidencyManager& residency = ResidencyManager::Get();
+    if (residency.IsGeometryResident(m_ResidencyHandle)) {
+        residency.UntrackGeometry(m_ResidencyHandle);
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteVertexArrays(1, &depthVAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+    }
+    m_ResidencyHandle = 0;
+    VAO = VBO = EBO = depthVAO = 0;
+}
 
-    // 3. еsetupMesh()ʼOpenGL
+void Mesh::EnsureResident() {
+    if (ResidencyManager::Get().TouchGeometry(m_ResidencyHandle)) return;
+    // 被驱逐：旧名字作废，从CPU副本重新上传
+    m_ResidencyHandle = 0;
+    VAO = VBO = EBO = depthVAO = 0;
     setupMesh();
-}
\ No newline at end of file
+}
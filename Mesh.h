@@ -2,6 +2,7 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <vector>
+#include <cstdint>
 #include "Shader.h"
 #include "Material.h"
 
@@ -9,32 +10,64 @@ struct Vertex {
     glm::vec3 Position;
     glm::vec3 Normal;
     glm::vec2 TexCoords;
-    glm::vec3 Tangent; // 
+    glm::vec3 Tangent; // 添加切线属性
 };
 
 struct Texture {
     unsigned int id;
     std::string type;
     std::string path;
+    // 打包进数组/图集时：id为GL_TEXTURE_2D_ARRAY，layer为层号，uvRect为(缩放, 偏移)
+    int layer = -1;
+    glm::vec4 uvRect = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
 };
 
 class Mesh {
 public:
-    // 캯㡢
+    // 构造函数参数包含顶点、索引和纹理
     Mesh(const std::vector<Vertex>& vertices,
         const std::vector<unsigned int>& indices,
         const std::vector<Texture>& textures);
 
-    // ޸SetupMesh
+    // 修复SetupMesh声明
     void SetupMesh(const std::vector<float>& vertices, const std::vector<unsigned int>& indices);
-    void Draw(Shader& shader, const Material& material) const;
+    // 几何被显存预算驱逐后，下次绘制时重新上传
+    void Draw(Shader& shader, const Material& material);
+    // 只写深度：只读位置流，不设置任何材质/纹理状态（model等由调用方设置）
+    void DrawDepth();
+    // 透明度测试的深度绘制：只绑定漫反射纹理（alphaMap，打包时为alphaArray）
+    void DrawDepthAlphaTested(Shader& shader, const Material& material);
     const std::vector<Texture>& GetTextures() const { return textures; }
+    const std::vector<Vertex>& GetVertices() const { return vertices; }
+    const std::vector<unsigned int>& GetIndices() const { return indices; }
+    // 每单位模型空间长度覆盖的UV范围，用于纹理mip流送
+    float GetUVDensity() const { return m_UVDensity; }
+
+    // 光照贴图UV（location = 4）：图表在接缝处拆分顶点，因此连同新的顶点/索引一起替换并重新上传
+    void SetLightmapGeometry(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+        const std::vector<glm::vec2>& lightmapUVs);
+    bool HasLightmapUVs() const { return !lightmapUVs.empty() && lightmapUVs.size() == vertices.size(); }
+
+    // 热重载时替换纹理对象
+    void ReplaceTexture(unsigned int oldId, unsigned int newId, int oldLayer = -1);
+    // 导入时打包：把二维纹理换成数组纹理中的一层
+    void PackTexture(unsigned int oldId, const Texture& packed);
+    // 释放GPU缓冲（Mesh按值拷贝，不能放在析构函数里）
+    void Release();
 
 private:
+    // VBO前段为紧凑的位置流（12字节/顶点），后段为法线/UV/切线交错，有光照贴图UV时再接一段；depthVAO只引用位置流
     unsigned int VAO, VBO, EBO;
+    unsigned int depthVAO = 0;
+    uint32_t m_ResidencyHandle = 0;
+    float m_UVDensity = 0.0f;
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     std::vector<Texture> textures;
+    std::vector<glm::vec2> lightmapUVs;
 
     void setupMesh();
+    // 绘制前调用：几何被显存预算驱逐后重新上传
+    void EnsureResident();
+    void computeUVDensity();
 };
@@ -0,0 +1,333 @@
+#include "MeshCodec.h"
+#include <cstring>
+#include <algorithm>
+
+static_assert(sizeof(Vertex) == 44, "MeshCodec假定Vertex为11个紧凑float");
+
+// ================== 通用工具 ==================
+static inline uint32_t ZigZag(uint32_t delta) {
+    return (delta << 1) ^ (uint32_t)((int32_t)delta >> 31);
+}
+
+static inline uint32_t UnZigZag(uint32_t v) {
+    return (v >> 1) ^ (0u - (v & 1u));
+}
+
+static void WriteVarint(std::vector<uint8_t>& out, uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+static bool ReadVarint(const uint8_t*& p, const uint8_t* end, uint32_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (p >= end) return false;
+        uint8_t b = *p++;
+        v |= (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// 字节平面模式
+enum PlaneMode : uint8_t { PLANE_ZERO = 0, PLANE_RAW = 1, PLANE_SPARSE = 2 };
+
+// ================== 顶点流 ==================
+void MeshCodec::EncodeVertices(const std::vector<Vertex>& vertices, std::vector<uint8_t>& out, bool compress) {
+    out.clear();
+    out.push_back(compress ? 1 : 0);
+
+    const uint32_t* src = reinterpret_cast<const uint32_t*>(vertices.data());
+    uint32_t prev[CHANNELS] = {};
+    uint32_t deltas[BLOCK_SIZE];
+    uint8_t plane[BLOCK_SIZE];
+
+    for (size_t base = 0; base < vertices.size(); base += BLOCK_SIZE) {
+        size_t n = std::min(BLOCK_SIZE, vertices.size() - base);
+
+        for (size_t ch = 0; ch < CHANNELS; ++ch) {
+            // 同一通道相邻顶点的位模式差分，接近的float差值很小
+            for (size_t i = 0; i < n; ++i) {
+                uint32_t cur = src[(base + i) * CHANNELS + ch];
+                deltas[i] = ZigZag(cur - prev[ch]);
+                prev[ch] = cur;
+            }
+
+            for (unsigned int p = 0; p < 4; ++p) {
+                size_t nonZero = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    plane[i] = (uint8_t)(deltas[i] >> (8 * p));
+                    nonZero += plane[i] != 0;
+                }
+
+                size_t maskBytes = (n + 7) / 8;
+                if (compress && nonZero == 0) {
+                    out.push_back(PLANE_ZERO);
+                }
+                else if (compress && maskBytes + nonZero < n) {
+                    // 稀疏平面：位掩码 + 非零字节
+                    out.push_back(PLANE_SPARSE);
+                    size_t maskPos = out.size();
+                    out.resize(out.size() + maskBytes, 0);
+                    for (size_t i = 0; i < n; ++i) {
+                        if (plane[i]) {
+                            out[maskPos + i / 8] |= (uint8_t)(1u << (i & 7));
+                            out.push_back(plane[i]);
+                        }
+                    }
+                }
+                else {
+                    out.push_back(PLANE_RAW);
+                    out.insert(out.end(), plane, plane + n);
+                }
+            }
+        }
+    }
+}
+
+bool MeshCodec::DecodeVertices(const uint8_t* data, size_t size, size_t vertexCount, std::vector<Vertex>& out) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    if (p >= end) return false;
+    ++p; // 压缩标志只影响编码端，解码按平面模式处理
+
+    out.resize(vertexCount);
+    uint32_t* dst = reinterpret_cast<uint32_t*>(out.data());
+    uint32_t prev[CHANNELS] = {};
+    uint32_t deltas[BLOCK_SIZE];
+
+    for (size_t base = 0; base < vertexCount; base += BLOCK_SIZE) {
+        size_t n = std::min(BLOCK_SIZE, vertexCount - base);
+
+        for (size_t ch = 0; ch < CHANNELS; ++ch) {
+            std::memset(deltas, 0, n * sizeof(uint32_t));
+
+            for (unsigned int pl = 0; pl < 4; ++pl) {
+                if (p >= end) return false;
+                uint8_t mode = *p++;
+                unsigned int shift = 8 * pl;
+
+                if (mode == PLANE_RAW) {
+                    if ((size_t)(end - p) < n) return false;
+                    for (size_t i = 0; i < n; ++i)
+                        deltas[i] |= (uint32_t)p[i] << shift;
+                    p += n;
+                }
+                else if (mode == PLANE_SPARSE) {
+                    size_t maskBytes = (n + 7) / 8;
+                    if ((size_t)(end - p) < maskBytes) return false;
+                    const uint8_t* mask = p;
+                    p += maskBytes;
+                    for (size_t m = 0; m < maskBytes; ++m) {
+                        uint8_t bits = mask[m];
+                        if (!bits) continue;  // 大部分掩码字节为0，整字节跳过
+                        for (size_t i = m * 8; bits; ++i, bits >>= 1) {
+                            if (bits & 1) {
+                                if (p >= end) return false;
+                                deltas[i] |= (uint32_t)(*p++) << shift;
+                            }
+                        }
+                    }
+                }
+                else if (mode != PLANE_ZERO) {
+                    return false;
+                }
+            }
+
+            // 前缀和还原
+            uint32_t v = prev[ch];
+            for (size_t i = 0; i < n; ++i) {
+                v += UnZigZag(deltas[i]);
+                dst[(base + i) * CHANNELS + ch] = v;
+            }
+            prev[ch] = v;
+        }
+    }
+    return p == end;
+}
+
+// ================== 索引流 ==================
+// 编码字节含义：
+//   0..239   命中边FIFO：edge(0..7) * 30 + rotation(0..2) * 10 + third(0..9)
+//            third: 0 = 下一个新顶点, 1..8 = 顶点FIFO位置, 9 = 显式varint
+//   0xF0..F7 未命中：低3位表示a/b/c是否为“下一个新顶点”，其余显式varint
+namespace {
+    struct IndexCoderState {
+        unsigned int edges[8][2] = {};
+        unsigned int edgeHead = 0;
+        unsigned int verts[8] = {};
+        unsigned int vertHead = 0;
+        unsigned int next = 0;  // 首次出现顺序下的下一个新顶点
+        unsigned int last = 0;  // 上一个显式编码的顶点
+
+        void PushEdge(unsigned int a, unsigned int b) {
+            edgeHead = (edgeHead + 7) & 7;
+            edges[edgeHead][0] = a;
+            edges[edgeHead][1] = b;
+        }
+        void PushVertex(unsigned int v) {
+            vertHead = (vertHead + 7) & 7;
+            verts[vertHead] = v;
+        }
+        // 相邻三角形以相反方向共享边，因此记录反向边
+        void PushTriangle(unsigned int a, unsigned int b, unsigned int c) {
+            PushEdge(b, a);
+            PushEdge(c, b);
+            PushEdge(a, c);
+        }
+        const unsigned int* Edge(unsigned int i) const { return edges[(edgeHead + i) & 7]; }
+        unsigned int Vert(unsigned int i) const { return verts[(vertHead + i) & 7]; }
+    };
+
+    inline void Rotate(unsigned int tri[3], unsigned int rot, unsigned int out[3]) {
+        out[0] = tri[rot % 3];
+        out[1] = tri[(rot + 1) % 3];
+        out[2] = tri[(rot + 2) % 3];
+    }
+}
+
+void MeshCodec::EncodeIndices(const std::vector<unsigned int>& indices, std::vector<uint8_t>& out) {
+    out.clear();
+    IndexCoderState s;
+
+    // 先写定长的码字流，再写varint附加流，解码时两个指针并行读取
+    std::vector<uint8_t> codes;
+    std::vector<uint8_t> extra;
+    codes.reserve(indices.size() / 3);
+
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        unsigned int tri[3] = { indices[t], indices[t + 1], indices[t + 2] };
+
+        int edgeHit = -1;
+        unsigned int rotation = 0;
+        for (unsigned int e = 0; e < EDGE_FIFO && edgeHit < 0; ++e) {
+            const unsigned int* edge = s.Edge(e);
+            for (unsigned int r = 0; r < 3; ++r) {
+                unsigned int rt[3];
+                Rotate(tri, r, rt);
+                if (rt[0] == edge[0] && rt[1] == edge[1]) {
+                    edgeHit = (int)e;
+                    rotation = r;
+                    break;
+                }
+            }
+        }
+
+        if (edgeHit >= 0) {
+            unsigned int rt[3];
+            Rotate(tri, rotation, rt);
+            unsigned int c = rt[2];
+
+            unsigned int third = 9;
+            if (c == s.next) {
+                third = 0;
+                s.next++;
+            }
+            else {
+                for (unsigned int v = 0; v < VERTEX_FIFO; ++v) {
+                    if (s.Vert(v) == c) { third = 1 + v; break; }
+                }
+            }
+            if (third == 9) {
+                WriteVarint(extra, ZigZag(c - s.last));
+                s.last = c;
+            }
+            codes.push_back((uint8_t)(edgeHit * 30 + rotation * 10 + third));
+            s.PushVertex(c);
+        }
+        else {
+            uint8_t code = 0xF0;
+            for (unsigned int k = 0; k < 3; ++k) {
+                if (tri[k] == s.next) {
+                    code |= (uint8_t)(1u << k);
+                    s.next++;
+                }
+                else {
+                    WriteVarint(extra, ZigZag(tri[k] - s.last));
+                    s.last = tri[k];
+                }
+                s.PushVertex(tri[k]);
+            }
+            codes.push_back(code);
+        }
+        s.PushTriangle(tri[0], tri[1], tri[2]);
+    }
+
+    WriteVarint(out, (uint32_t)codes.size());
+    out.insert(out.end(), codes.begin(), codes.end());
+    out.insert(out.end(), extra.begin(), extra.end());
+}
+
+bool MeshCodec::DecodeIndices(const uint8_t* data, size_t size, size_t indexCount, size_t vertexCount,
+    std::vector<unsigned int>& out) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    uint32_t triCount;
+    if (!ReadVarint(p, end, triCount) || (size_t)triCount * 3 != indexCount) return false;
+    if ((size_t)(end - p) < triCount) return false;
+
+    const uint8_t* codes = p;
+    const uint8_t* extra = p + triCount;
+    IndexCoderState s;
+    out.resize(indexCount);
+
+    for (uint32_t t = 0; t < triCount; ++t) {
+        uint8_t code = codes[t];
+        unsigned int tri[3];
+
+        if (code < 240) {
+            unsigned int e = code / 30;
+            unsigned int rotation = (code / 10) % 3;
+            unsigned int third = code % 10;
+            const unsigned int* edge = s.Edge(e);
+
+            unsigned int c;
+            if (third == 0) {
+                c = s.next++;
+            }
+            else if (third <= VERTEX_FIFO) {
+                c = s.Vert(third - 1);
+            }
+            else {
+                uint32_t v;
+                if (!ReadVarint(extra, end, v)) return false;
+                c = s.last + UnZigZag(v);
+                s.last = c;
+            }
+            s.PushVertex(c);
+
+            // 反旋转回原始顶点顺序
+            unsigned int rt[3] = { edge[0], edge[1], c };
+            tri[rotation % 3] = rt[0];
+            tri[(rotation + 1) % 3] = rt[1];
+            tri[(rotation + 2) % 3] = rt[2];
+        }
+        else if ((code & 0xF8) == 0xF0) {
+            for (unsigned int k = 0; k < 3; ++k) {
+                if (code & (1u << k)) {
+                    tri[k] = s.next++;
+                }
+                else {
+                    uint32_t v;
+                    if (!ReadVarint(extra, end, v)) return false;
+                    tri[k] = s.last + UnZigZag(v);
+                    s.last = tri[k];
+                }
+                s.PushVertex(tri[k]);
+            }
+        }
+        else {
+            return false;
+        }
+
+        if (tri[0] >= vertexCount || tri[1] >= vertexCount || tri[2] >= vertexCount) return false;
+        s.PushTriangle(tri[0], tri[1], tri[2]);
+        out[t * 3 + 0] = tri[0];
+        out[t * 3 + 1] = tri[1];
+        out[t * 3 + 2] = tri[2];
+    }
+    return extra == end;
+}
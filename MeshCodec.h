@@ -0,0 +1,27 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "Mesh.h"
+
+// 烘焙网格的顶点/索引流编解码（无损）
+// 顶点：按块把每个float通道的位模式做差分+zigzag，再拆成字节平面，可选稀疏平面压缩
+// 索引：边FIFO + 顶点FIFO，利用相邻三角形共享边，通常每个三角形只需1字节
+class MeshCodec {
+public:
+    // 顶点流编码；compress=false时只做差分和字节平面拆分
+    static void EncodeVertices(const std::vector<Vertex>& vertices, std::vector<uint8_t>& out, bool compress = true);
+    static bool DecodeVertices(const uint8_t* data, size_t size, size_t vertexCount, std::vector<Vertex>& out);
+
+    // 索引流编码（三角形列表，索引数必须是3的倍数）
+    static void EncodeIndices(const std::vector<unsigned int>& indices, std::vector<uint8_t>& out);
+    // 解码出的索引不小于vertexCount（文件损坏）时返回false
+    static bool DecodeIndices(const uint8_t* data, size_t size, size_t indexCount, size_t vertexCount,
+        std::vector<unsigned int>& out);
+
+private:
+    static const size_t BLOCK_SIZE = 256;                            // 每块顶点数
+    static const size_t CHANNELS = sizeof(Vertex) / sizeof(uint32_t); // 每顶点的32位通道数（11）
+    static const unsigned int EDGE_FIFO = 8;
+    static const unsigned int VERTEX_FIFO = 8;
+};
@@ -1,12 +1,86 @@
 #include "Model.h"
+#include "MeshCodec.h"
+#include "ResidencyManager.h"
+#include "TextureStreamer.h"
+#include "TexturePacker.h"
+#include "BindlessTextures.h"
 #include <stb_image.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+
+// 烘焙网格文件格式
+static const char COOKED_MAGIC[4] = { 'M', 'D', 'L', 'C' };
+static const uint32_t COOKED_VERSION = 2;
 
 void Model::Draw(Shader& shader, const Material& material) {
     for (unsigned int i = 0; i < meshes.size(); i++)
-        meshes[i].Draw(shader, material); // material
+        meshes[i].Draw(shader, material); // 传递material参数
+}
+
+void Model::DrawDepth() {
+    for (auto& mesh : meshes)
+        mesh.DrawDepth();
+}
+
+void Model::DrawDepthAlphaTested(Shader& shader, const Material& material) {
+    for (auto& mesh : meshes)
+        mesh.DrawDepthAlphaTested(shader, material);
+}
+
+std::vector<std::string> Model::GetTextureFiles() const {
+    std::vector<std::string> files;
+    for (const auto& tex : textures_loaded) {
+        files.push_back(std::filesystem::path(directory + '/' + tex.path).lexically_normal().generic_string());
+    }
+    return files;
+}
+
+bool Model::ReloadTexture(const std::string& file) {
+    for (auto& tex : textures_loaded) {
+        std::string texFile = std::filesystem::path(directory + '/' + tex.path).lexically_normal().generic_string();
+        if (texFile != file) continue;
+
+        // 先解码新纹理，再替换所有网格中的旧ID
+        // 打包过的纹理改为独立的二维纹理，数组本身留到Reload时释放
+        unsigned int newId = TextureFromFile(tex.path.c_str(), directory);
+        for (auto& mesh : meshes)
+            mesh.ReplaceTexture(tex.id, newId, tex.layer);
+        if (tex.layer < 0)
+            ReleaseTexture(tex.id);
+        tex.id = newId;
+        tex.layer = -1;
+        tex.uvRect = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+        return true;
+    }
+    return false;
+}
+
+void Model::Reload() {
+    for (auto& mesh : meshes)
+        mesh.Release();
+    for (auto& tex : textures_loaded) {
+        if (tex.layer < 0)
+            ReleaseTexture(tex.id);
+    }
+    for (unsigned int array : m_TextureArrays)
+        TexturePacker::ReleaseArray(array);
+    meshes.clear();
+    textures_loaded.clear();
+    m_TextureArrays.clear();
+    loadModel(m_Path);
 }
 
 void Model::loadModel(const std::string& path) {
+    directory = path.substr(0, path.find_last_of('/'));
+
+    // 优先读取烘焙缓存（DecodeCooked检查是否比源文件新）
+    if (loadCooked(path))
+        return;
+
     Assimp::Importer import;
     const aiScene* scene = import.ReadFile(path,
         aiProcess_Triangulate |
@@ -17,17 +91,279 @@ void Model::loadModel(const std::string& path) {
         std::cout << "ERROR::ASSIMP::" << import.GetErrorString() << std::endl;
         return;
     }
-    directory = path.substr(0, path.find_last_of('/'));
     processNode(scene->mRootNode, scene);
+    packTextures(std::vector<TextureData>());
+    computeBounds();
+    saveCooked(CookedPath(path));
+}
+
+Model::Model(ModelData& data) : m_Path(data.path) {
+    directory = m_Path.substr(0, m_Path.find_last_of('/'));
+    upload(data);
+}
+
+bool Model::loadCooked(const std::string& path) {
+    ModelData data;
+    if (!DecodeCooked(path, data))
+        return false;
+    upload(data);
+    return true;
+}
+
+// 按路径去重上传纹理，再用解码好的顶点/索引创建网格
+void Model::upload(ModelData& data) {
+    for (const auto& texData : data.textures) {
+        Texture texture;
+        texture.id = UploadTexture(texData);
+        texture.path = texData.path;
+        textures_loaded.push_back(texture);
+    }
+    for (auto& meshData : data.meshes) {
+        std::vector<Texture> textures;
+        for (const auto& ref : meshData.textures) {
+            for (const auto& loaded : textures_loaded) {
+                if (loaded.path != ref.second) continue;
+                Texture texture = loaded;
+                texture.type = ref.first;
+                textures.push_back(texture);
+                break;
+            }
+        }
+        meshes.push_back(Mesh(meshData.vertices, meshData.indices, textures));
+    }
+    packTextures(data.textures);
+    m_Bounds = data.bounds;
+}
+
+// 导入时把可打包的纹理合并进数组/图集；decoded里没有的纹理先用stbi_info判断尺寸再解码
+void Model::packTextures(const std::vector<TextureData>& decoded) {
+    std::vector<TextureData> sources(textures_loaded.size());
+    std::vector<TexturePacker::Input> inputs(textures_loaded.size());
+    for (size_t i = 0; i < textures_loaded.size(); ++i) {
+        const Texture& tex = textures_loaded[i];
+        for (const auto& data : decoded) {
+            if (data.path == tex.path) { sources[i] = data; break; }
+        }
+        if (!sources[i].pixels) {
+            std::string file = directory + '/' + tex.path;
+            int width, height, components;
+            if (!stbi_info(file.c_str(), &width, &height, &components) ||
+                !TexturePacker::IsPackable(width, height) || !DecodeTexture(file, sources[i]))
+                continue;
+        }
+        if (!TexturePacker::IsPackable(sources[i].width, sources[i].height)) continue;
+        inputs[i].pixels = sources[i].pixels.get();
+        inputs[i].width = sources[i].width;
+        inputs[i].height = sources[i].height;
+        inputs[i].components = sources[i].components;
+    }
+
+    std::vector<TexturePacker::Location> locations = TexturePacker::Pack(inputs, m_TextureArrays);
+    for (size_t i = 0; i < textures_loaded.size(); ++i) {
+        if (locations[i].layer < 0) continue;
+        Texture& tex = textures_loaded[i];
+        Texture packed = tex;
+        packed.id = locations[i].array;
+        packed.layer = locations[i].layer;
+        packed.uvRect = locations[i].rect;
+        for (auto& mesh : meshes)
+            mesh.PackTexture(tex.id, packed);
+
+        ReleaseTexture(tex.id);
+        tex = packed;
+    }
+}
+
+void Model::computeBounds() {
+    m_Bounds = AABB();
+    for (const auto& mesh : meshes)
+        for (const auto& v : mesh.GetVertices())
+            m_Bounds.Expand(v.Position);
+}
+
+static bool ReadCookedHeader(std::ifstream& file, uint32_t& meshCount, AABB& bounds) {
+    char magic[4];
+    uint32_t version = 0;
+    file.read(magic, 4);
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&meshCount), sizeof(meshCount));
+    file.read(reinterpret_cast<char*>(&bounds.min[0]), sizeof(float) * 3);
+    file.read(reinterpret_cast<char*>(&bounds.max[0]), sizeof(float) * 3);
+    return file && std::memcmp(magic, COOKED_MAGIC, 4) == 0 && version == COOKED_VERSION;
+}
+
+bool Model::IsCookedFresh(const std::string& path) {
+    std::error_code ec;
+    auto cookedTime = std::filesystem::last_write_time(CookedPath(path), ec);
+    if (ec) return false;
+
+    // .obj的材质（含纹理路径）在mtllib引用的材质库中，修改材质库也要重新导入
+    std::vector<std::string> sources = { path };
+    std::filesystem::path source(path);
+    std::string extension = source.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if (extension == ".obj") {
+        std::string directory = path.substr(0, path.find_last_of('/'));
+        sources.push_back(std::filesystem::path(source).replace_extension(".mtl").generic_string());
+        // mtllib通常在文件开头，读到第一个顶点为止
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line) && line.compare(0, 2, "v ") != 0) {
+            if (line.compare(0, 7, "mtllib ") != 0) continue;
+            std::istringstream names(line.substr(7));
+            std::string name;
+            while (names >> name)
+                sources.push_back(directory + '/' + name);
+        }
+    }
+    for (const std::string& file : sources) {
+        auto sourceTime = std::filesystem::last_write_time(file, ec);
+        if (ec) continue;   // 没有同名材质库（或只发布了缓存）
+        if (sourceTime > cookedTime) return false;
+    }
+    return true;
+}
+
+bool Model::ReadCookedBounds(const std::string& path, AABB& bounds) {
+    if (!IsCookedFresh(path)) return false;
+    std::ifstream file(CookedPath(path), std::ios::binary);
+    uint32_t meshCount = 0;
+    return file && ReadCookedHeader(file, meshCount, bounds);
+}
+
+bool Model::DecodeCooked(const std::string& path, ModelData& out) {
+    if (!IsCookedFresh(path)) return false;
+    std::string cookedPath = CookedPath(path);
+    std::ifstream file(cookedPath, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    const uint64_t fileSize = (uint64_t)file.tellg();
+    file.seekg(0);
+
+    auto readU32 = [&file]() {
+        uint32_t v = 0;
+        file.read(reinterpret_cast<char*>(&v), sizeof(v));
+        return v;
+    };
+    // 长度字段来自磁盘：超出文件剩余字节的视为损坏，分配前检查，失败时由调用者重新导入
+    auto fits = [&file, fileSize](uint32_t bytes) {
+        return file && (uint64_t)file.tellg() + bytes <= fileSize;
+    };
+    const uint32_t MAX_STRING = 4096;   // 纹理类型和相对路径
+    auto readString = [&file, &readU32, &fits, MAX_STRING](std::string& str) {
+        uint32_t length = readU32();
+        if (!file || length > MAX_STRING || !fits(length)) return false;
+        str.assign(length, '\0');
+        file.read(&str[0], length);
+        return (bool)file;
+    };
+
+    uint32_t meshCount = 0;
+    if (!ReadCookedHeader(file, meshCount, out.bounds))
+        return false;
+    out.path = path;
+    std::string directory = path.substr(0, path.find_last_of('/'));
+
+    std::vector<uint8_t> buffer;
+    for (uint32_t m = 0; m < meshCount && file; m++) {
+        MeshData meshData;
+        uint32_t vertexCount = readU32();
+        uint32_t indexCount = readU32();
+        uint32_t textureCount = readU32();
+
+        bool texturesOk = (bool)file;
+        for (uint32_t t = 0; t < textureCount && texturesOk; t++) {
+            std::string type, texPath;
+            texturesOk = readString(type) && readString(texPath);
+            if (!texturesOk) break;
+            meshData.textures.emplace_back(type, texPath);
+
+            bool known = false;
+            for (const auto& tex : out.textures) known |= tex.path == texPath;
+            if (!known) {
+                TextureData texData;
+                texData.path = texPath;
+                if (!DecodeTexture(directory + '/' + texPath, texData))
+                    std::cout << "Texture failed to load at path: " << texPath << std::endl;
+                out.textures.push_back(texData);
+            }
+        }
+
+        if (!texturesOk) break;
+
+        // 解码顶点/索引流
+        uint32_t vertexBytes = readU32();
+        if (!fits(vertexBytes)) break;
+        buffer.resize(vertexBytes);
+        file.read(reinterpret_cast<char*>(buffer.data()), vertexBytes);
+        if (!file || !MeshCodec::DecodeVertices(buffer.data(), buffer.size(), vertexCount, meshData.vertices))
+            break;
+        uint32_t indexBytes = readU32();
+        if (!fits(indexBytes)) break;
+        buffer.resize(indexBytes);
+        file.read(reinterpret_cast<char*>(buffer.data()), indexBytes);
+        if (!file || !MeshCodec::DecodeIndices(buffer.data(), buffer.size(), indexCount, vertexCount,
+            meshData.indices))
+            break;
+
+        out.meshes.push_back(std::move(meshData));
+    }
+
+    if (out.meshes.size() != meshCount) {
+        std::cout << "ERROR::COOKED_MESH::Corrupt cache: " << cookedPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void Model::saveCooked(const std::string& cookedPath) const {
+    std::ofstream file(cookedPath, std::ios::binary);
+    if (!file) {
+        std::cout << "WARNING::COOKED_MESH::Cannot write cache: " << cookedPath << std::endl;
+        return;
+    }
+
+    auto writeU32 = [&file](uint32_t v) {
+        file.write(reinterpret_cast<const char*>(&v), sizeof(v));
+    };
+    auto writeString = [&file, &writeU32](const std::string& str) {
+        writeU32((uint32_t)str.size());
+        file.write(str.data(), str.size());
+    };
+
+    file.write(COOKED_MAGIC, 4);
+    writeU32(COOKED_VERSION);
+    writeU32((uint32_t)meshes.size());
+    // 包围盒放在文件头，懒加载节点只读头部
+    file.write(reinterpret_cast<const char*>(&m_Bounds.min[0]), sizeof(float) * 3);
+    file.write(reinterpret_cast<const char*>(&m_Bounds.max[0]), sizeof(float) * 3);
+
+    std::vector<uint8_t> buffer;
+    for (const Mesh& mesh : meshes) {
+        writeU32((uint32_t)mesh.GetVertices().size());
+        writeU32((uint32_t)mesh.GetIndices().size());
+        writeU32((uint32_t)mesh.GetTextures().size());
+        for (const Texture& tex : mesh.GetTextures()) {
+            writeString(tex.type);
+            writeString(tex.path);
+        }
+
+        MeshCodec::EncodeVertices(mesh.GetVertices(), buffer);
+        writeU32((uint32_t)buffer.size());
+        file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+
+        MeshCodec::EncodeIndices(mesh.GetIndices(), buffer);
+        writeU32((uint32_t)buffer.size());
+        file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    }
 }
 
 void Model::processNode(aiNode* node, const aiScene* scene) {
-    // ڵ
+    // 处理节点所有网格
     for (unsigned int i = 0; i < node->mNumMeshes; i++) {
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
         meshes.push_back(processMesh(mesh, scene));
     }
-    // ݹ鴦ӽڵ
+    // 递归处理子节点
     for (unsigned int i = 0; i < node->mNumChildren; i++) {
         processNode(node->mChildren[i], scene);
     }
@@ -38,22 +374,22 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene) {
     std::vector<unsigned int> indices;
     std::vector<Texture> textures;
 
-    // 
+    // 处理顶点
     for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
         Vertex vertex;
-        // λ
+        // 位置
         vertex.Position = glm::vec3(
             mesh->mVertices[i].x,
             mesh->mVertices[i].y,
             mesh->mVertices[i].z
         );
-        // 
+        // 法线
         vertex.Normal = glm::vec3(
             mesh->mNormals[i].x,
             mesh->mNormals[i].y,
             mesh->mNormals[i].z
         );
-        // 
+        // 纹理坐标
         if (mesh->mTextureCoords[0]) {
             vertex.TexCoords = glm::vec2(
                 mesh->mTextureCoords[0][i].x,
@@ -63,7 +399,7 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene) {
         else {
             vertex.TexCoords = glm::vec2(0.0f, 0.0f);
         }
-        // ===  ===
+        // === 切线数据 ===
         if (mesh->HasTangentsAndBitangents()) {
             vertex.Tangent = glm::vec3(
                 mesh->mTangents[i].x,
@@ -72,33 +408,33 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene) {
             );
         }
         else {
-            vertex.Tangent = glm::vec3(1.0f, 0.0f, 0.0f); // Ĭֵ
+            vertex.Tangent = glm::vec3(1.0f, 0.0f, 0.0f); // 默认值
         }
         vertices.push_back(vertex);
     }
 
-    // 
+    // 处理索引
     for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
         aiFace face = mesh->mFaces[i];
         for (unsigned int j = 0; j < face.mNumIndices; j++)
             indices.push_back(face.mIndices[j]);
     }
 
-    // 
+    // 处理材质
     if (mesh->mMaterialIndex >= 0) {
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
 
-        // 1. ͼ (PBRΪalbedo)
+        // 1. 漫反射贴图 (PBR中作为albedo)
         std::vector<Texture> diffuseMaps = loadMaterialTextures(material,
             aiTextureType_DIFFUSE, "texture_diffuse");
         textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
 
-        // 2. 淴ͼ
+        // 2. 镜面反射贴图
         std::vector<Texture> specularMaps = loadMaterialTextures(material,
             aiTextureType_SPECULAR, "texture_specular");
         textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
 
-        // 3. PBRרͼ
+        // 3. PBR专用贴图
         std::vector<Texture> metallicMaps = loadMaterialTextures(material,
             aiTextureType_METALNESS, "texture_metallic");
         textures.insert(textures.end(), metallicMaps.begin(), metallicMaps.end());
@@ -124,58 +460,77 @@ std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType
     for (unsigned int i = 0; i < mat->GetTextureCount(type); i++) {
         aiString str;
         mat->GetTexture(type, i, &str);
-        bool skip = false;
-        for (unsigned int j = 0; j < textures_loaded.size(); j++) {
-            if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0) {
-                textures.push_back(textures_loaded[j]);
-                skip = true;
-                break;
-            }
-        }
-        if (!skip) {
-            Texture texture;
-            texture.id = TextureFromFile(str.C_Str(), directory);
+        textures.push_back(loadTexture(str.C_Str(), typeName));
+    }
+    return textures;
+}
+
+Texture Model::loadTexture(const std::string& path, const std::string& typeName) {
+    // 已加载的纹理直接复用
+    for (unsigned int j = 0; j < textures_loaded.size(); j++) {
+        if (textures_loaded[j].path == path) {
+            Texture texture = textures_loaded[j];
             texture.type = typeName;
-            texture.path = str.C_Str();
-            textures.push_back(texture);
-            textures_loaded.push_back(texture);
+            return texture;
         }
     }
-    return textures;
+    Texture texture;
+    texture.id = TextureFromFile(path.c_str(), directory);
+    texture.type = typeName;
+    texture.path = path;
+    textures_loaded.push_back(texture);
+    return texture;
 }
 
 unsigned int Model::TextureFromFile(const char* path, const std::string& directory) {
-    std::string filename = std::string(path);
-    filename = directory + '/' + filename;
+    TextureData data;
+    data.path = path;
+    if (!DecodeTexture(directory + '/' + std::string(path), data))
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+    return UploadTexture(data);
+}
 
+bool Model::DecodeTexture(const std::string& file, TextureData& out) {
+    out.file = file;
+    unsigned char* data = stbi_load(file.c_str(), &out.width, &out.height, &out.components, 0);
+    if (!data) return false;
+    out.pixels = std::shared_ptr<unsigned char>(data, stbi_image_free);
+    return true;
+}
+
+unsigned int Model::UploadTexture(const TextureData& data) {
     unsigned int textureID;
     glGenTextures(1, &textureID);
+    if (!data.pixels) return textureID;
 
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
+    // 只上传粗糙的起始级别，更精细的mip由TextureStreamer按屏幕纹素密度流入
+    // bindless句柄创建后纹理存储不可再修改，此时直接上传完整分辨率且不参与流送
+    bool bindless = BindlessTextures::Get().IsEnabled();
+    int residentMip = bindless ? 0 : TextureStreamer::InitialMip(data.width, data.height);
+    std::vector<unsigned char> pixels;
+    int width, height;
+    TextureStreamer::Downsample(data.pixels.get(), data.width, data.height, data.components, residentMip,
+        pixels, width, height);
+    TextureStreamer::UploadLevel(textureID, pixels.data(), width, height, data.components);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // 分辨率由流送器管理，ResidencyManager只统计占用
+    ResidencyManager::Get().TrackTexture(textureID, ResidencyManager::TextureBytes(width, height,
+        data.components == 3 ? 4 : data.components, true), "Model");
+    if (bindless)
+        BindlessTextures::Get().Register(textureID);
+    else
+        TextureStreamer::Get().Register(textureID, data.file, data.width, data.height, data.components, residentMip);
     return textureID;
 }
+
+void Model::ReleaseTexture(unsigned int id) {
+    ResidencyManager::Get().UntrackTexture(id);
+    TextureStreamer::Get().Unregister(id);
+    BindlessTextures::Get().Unregister(id);
+    glDeleteTextures(1, &id);
+}
@@ -3,25 +3,82 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include "Mesh.h"
+#include "Frustum.h"
 #include "stb_image.h"
 
 #include <iostream>
 #include <vector>
+#include <memory>
+
+// CPU侧模型数据：可在工作线程解码，再由主线程上传
+struct TextureData {
+    std::string path;                       // 相对模型目录
+    std::string file;                       // 实际读取的文件，流送更精细的mip时重新读取
+    int width = 0, height = 0, components = 0;
+    std::shared_ptr<unsigned char> pixels;  // stbi分配
+};
+
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<std::pair<std::string, std::string>> textures; // (类型, 路径)
+};
+
+struct ModelData {
+    std::string path;
+    std::vector<MeshData> meshes;
+    std::vector<TextureData> textures;
+    AABB bounds;
+};
 
 class Model {
 public:
-    Model(const char* path) { loadModel(path); }
+    Model(const char* path) : m_Path(path) { loadModel(path); }
+    // 上传已解码的数据（必须在GL线程调用）
+    Model(ModelData& data);
     void Draw(Shader& shader, const Material& material);
+    void DrawDepth();
+    void DrawDepthAlphaTested(Shader& shader, const Material& material);
     const std::vector<Mesh>& GetMeshes() const { return meshes; }
+    // 光照贴图烘焙为网格生成第二套UV（模型被多个节点共享时各节点的图表会互相覆盖）
+    std::vector<Mesh>& GetMeshes() { return meshes; }
+    const AABB& GetBounds() const { return m_Bounds; }
+
+    // 烘焙缓存访问，不依赖GL，可在工作线程调用
+    static std::string CookedPath(const std::string& path) { return path + ".cooked"; }
+    // 缓存比源模型和它引用的材质库（.mtl）都新时才使用，否则返回false
+    static bool IsCookedFresh(const std::string& path);
+    static bool DecodeCooked(const std::string& path, ModelData& out);
+    static bool ReadCookedBounds(const std::string& path, AABB& bounds);
+
+    // 热重载接口
+    const std::string& GetPath() const { return m_Path; }
+    std::vector<std::string> GetTextureFiles() const;   // 依赖的纹理文件（相对工作目录）
+    bool ReloadTexture(const std::string& file);        // 只重新解码该纹理
+    void Reload();                                      // 源模型变化时重新导入
 
 private:
+    std::string m_Path;
     std::vector<Mesh> meshes;
     std::string directory;
     std::vector<Texture> textures_loaded;
+    std::vector<unsigned int> m_TextureArrays;  // 打包生成的数组纹理
+    AABB m_Bounds;
 
     void loadModel(const std::string& path);
+    void upload(ModelData& data);
+    void computeBounds();
+    void packTextures(const std::vector<TextureData>& decoded);
+    // 烘焙缓存（path + ".cooked"），比源文件和材质库新时跳过Assimp导入；path为源模型路径
+    bool loadCooked(const std::string& path);
+    void saveCooked(const std::string& cookedPath) const;
     void processNode(aiNode* node, const aiScene* scene);
     Mesh processMesh(aiMesh* mesh, const aiScene* scene);
     std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName);
+    Texture loadTexture(const std::string& path, const std::string& typeName);
     unsigned int TextureFromFile(const char* path, const std::string& directory);
+    static bool DecodeTexture(const std::string& file, TextureData& out);
+    static unsigned int UploadTexture(const TextureData& data);
+    // 删除模型自己的二维纹理，并从显存统计/流送/bindless句柄表中注销
+    static void ReleaseTexture(unsigned int id);
 };
@@ -0,0 +1,280 @@
+#include "ProbeManager.h"
+#include "IBLBaker.h"
+#include <algorithm>
+#include <iostream>
+
+ProbeManager::ProbeManager(bool useSH, IBLQuality quality, IBLFormat format)
+    : m_UseSH(useSH), m_Quality(quality), m_Running(true) {
+    // 参数在工作线程中只读，构造时确定
+    m_Params = IBL::MakeParams(useSH, quality);
+    m_Format = IBL::ResolveFormat(format);
+    m_Worker = std::thread(&ProbeManager::WorkerLoop, this);
+}
+
+ProbeManager::~ProbeManager() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Running = false;
+    }
+    m_Cond.notify_all();
+    if (m_Worker.joinable()) m_Worker.join();
+}
+
+int ProbeManager::SetGlobalProbe(const std::string& hdrPath) {
+    if (m_Global >= 0) {
+        // 替换全局探针
+        Probe& probe = *m_Probes[m_Global];
+        probe.hdrPath = hdrPath;
+        probe.ibl.reset();
+    }
+    else {
+        m_Probes.push_back(std::make_unique<Probe>());
+        m_Global = (int)m_Probes.size() - 1;
+        m_Order.push_back(m_Global);
+    }
+
+    // 全局探针是所有对象的兜底，启动时同步加载
+    Probe& probe = *m_Probes[m_Global];
+    probe.global = true;
+    probe.ibl = std::make_unique<IBL>(hdrPath, m_UseSH, m_Quality, m_Format);
+    probe.state = probe.ibl->IsValid() ? ProbeState::Resident : ProbeState::Failed;
+    return m_Global;
+}
+
+int ProbeManager::AddProbe(const std::string& hdrPath, const AABB& bounds, float blendDistance) {
+    auto probe = std::make_unique<Probe>();
+    probe->hdrPath = hdrPath;
+    probe->bounds = bounds;
+    probe->blendDistance = std::max(blendDistance, 0.001f);
+    return InsertProbe(std::move(probe));
+}
+
+int ProbeManager::AddDynamicProbe(const AABB& bounds, float blendDistance, int captureSize,
+    IBL::SceneRenderer renderScene, float budgetMs) {
+    auto probe = std::make_unique<Probe>();
+    probe->bounds = bounds;
+    probe->blendDistance = std::max(blendDistance, 0.001f);
+    probe->dynamic = true;
+    // 动态探针每轮都要重新预滤波，使用Fast档位的样本数
+    probe->ibl = std::make_unique<IBL>(captureSize, m_UseSH, IBLQuality::Fast);
+    probe->ibl->SetCaptureScene(std::move(renderScene));
+    probe->ibl->SetCapturePosition(bounds.Center());
+    probe->ibl->SetCaptureBudget(budgetMs);
+    probe->state = ProbeState::Loading;
+    return InsertProbe(std::move(probe));
+}
+
+int ProbeManager::InsertProbe(std::unique_ptr<Probe> probe) {
+    m_Probes.push_back(std::move(probe));
+    int index = (int)m_Probes.size() - 1;
+
+    // 按体积排序，越小越局部越优先；全局探针总在最后
+    m_Order.push_back(index);
+    std::stable_sort(m_Order.begin(), m_Order.end(), [this](int a, int b) {
+        const Probe& pa = *m_Probes[a];
+        const Probe& pb = *m_Probes[b];
+        if (pa.global != pb.global) return pb.global;
+        if (pa.global) return false;
+        glm::vec3 ea = pa.bounds.max - pa.bounds.min, eb = pb.bounds.max - pb.bounds.min;
+        return ea.x * ea.y * ea.z < eb.x * eb.y * eb.z;
+    });
+    return index;
+}
+
+void ProbeManager::UpdateDynamicProbes() {
+    for (auto& probe : m_Probes) {
+        if (!probe->dynamic) continue;
+        probe->ibl->UpdateCapture();
+        if (probe->ibl->HasCapture())
+            probe->state = ProbeState::Resident;
+    }
+}
+
+float ProbeManager::InfluenceWeight(const Probe& probe, const glm::vec3& position) const {
+    if (probe.global) return 1.0f;
+    // 到最近一个面的距离，在体积外为负
+    glm::vec3 toFace = glm::min(position - probe.bounds.min, probe.bounds.max - position);
+    float inside = std::min(toFace.x, std::min(toFace.y, toFace.z));
+    if (inside <= 0.0f) return 0.0f;
+    return std::min(inside / probe.blendDistance, 1.0f);
+}
+
+void ProbeManager::RequestLoad(int index) {
+    Probe& probe = *m_Probes[index];
+    if (probe.state != ProbeState::Unloaded) return;
+    probe.state = ProbeState::Loading;
+
+    auto job = std::make_unique<LoadJob>();
+    job->probe = index;
+    job->hdrPath = probe.hdrPath;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Requests.push_back(std::move(job));
+    }
+    m_Cond.notify_one();
+}
+
+void ProbeManager::Update(const glm::vec3& cameraPos, unsigned int maxUploads) {
+    ++m_Frame;
+
+    for (unsigned int i = 0; i < maxUploads; ++i) {
+        std::unique_ptr<LoadJob> job;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Completed.empty()) break;
+            job = std::move(m_Completed.front());
+            m_Completed.pop_front();
+        }
+
+        // GL上传只能在主线程进行
+        Probe& probe = *m_Probes[job->probe];
+        if (job->ok)
+            probe.ibl = std::make_unique<IBL>(job->data, m_Params, m_Format);
+        probe.state = probe.ibl && probe.ibl->IsValid() ? ProbeState::Resident : ProbeState::Failed;
+        if (!job->ok)
+            std::cout << "ERROR::PROBES: failed to load " << probe.hdrPath << std::endl;
+        if (probe.state == ProbeState::Failed)
+            probe.ibl.reset();
+        probe.lastUsed = m_Frame;
+    }
+
+    // 预取：相机接近影响体积时提前加载，进入时通常已经驻留
+    for (size_t i = 0; i < m_Probes.size(); ++i) {
+        const Probe& probe = *m_Probes[i];
+        if (probe.global || probe.dynamic || probe.state != ProbeState::Unloaded) continue;
+        glm::vec3 closest = glm::clamp(cameraPos, probe.bounds.min, probe.bounds.max);
+        if (glm::length(cameraPos - closest) <= m_PrefetchDistance)
+            RequestLoad((int)i);
+    }
+
+    EnforceBudget();
+}
+
+void ProbeManager::EnforceBudget() {
+    size_t used = GetResidentBytes();
+    while (used > m_Budget) {
+        // 上一帧仍在使用的探针不驱逐，避免反复加载
+        int victim = -1;
+        for (size_t i = 0; i < m_Probes.size(); ++i) {
+            const Probe& probe = *m_Probes[i];
+            if (probe.global || probe.dynamic || probe.state != ProbeState::Resident || probe.lastUsed + 1 >= m_Frame) continue;
+            if (victim < 0 || probe.lastUsed < m_Probes[victim]->lastUsed)
+                victim = (int)i;
+        }
+        if (victim < 0) break;
+
+        Probe& probe = *m_Probes[victim];
+        used -= probe.ibl->GetResidentBytes();
+        probe.ibl.reset();
+        probe.state = ProbeState::Unloaded;
+    }
+}
+
+ProbeBlend ProbeManager::Select(const glm::vec3& position) {
+    ProbeBlend result;
+    float remaining = 1.0f;
+    for (int index : m_Order) {
+        Probe& probe = *m_Probes[index];
+        float weight = InfluenceWeight(probe, position);
+        if (weight <= 0.0f) continue;
+        if (probe.state != ProbeState::Resident) {
+            // 未驻留：请求加载，权重交给下一个探针
+            RequestLoad(index);
+            continue;
+        }
+        probe.lastUsed = m_Frame;
+
+        if (result.probeA < 0) {
+            result.probeA = index;
+            remaining = 1.0f - weight;
+            if (remaining <= 0.0f) break;
+        }
+        else {
+            result.probeB = index;
+            result.blend = remaining;
+            break;
+        }
+    }
+    return result;
+}
+
+void ProbeManager::Apply(const Shader& shader, const ProbeBlend& blend) const {
+    if (blend.probeA < 0) return;
+    const IBL& a = *m_Probes[blend.probeA]->ibl;
+    const IBL* b = blend.probeB >= 0 ? m_Probes[blend.probeB]->ibl.get() : nullptr;
+    float t = b ? blend.blend : 0.0f;
+
+    if (m_UseSH) {
+        // 球谐投影是线性的，混合系数等价于混合辐照度
+        for (int i = 0; i < 9; ++i) {
+            glm::vec3 c = a.GetSH().c[i];
+            if (b) c = glm::mix(c, b->GetSH().c[i], t);
+            shader.setVec3("shCoefficients[" + std::to_string(i) + "]", c);
+        }
+    }
+    else {
+        a.BindIrradianceMap(GL_TEXTURE10);
+        shader.setInt("irradianceMap", 10);
+        (b ? b : &a)->BindIrradianceMap(GL_TEXTURE14);
+        shader.setInt("irradianceMapB", 14);
+    }
+    a.BindPrefilterMap(GL_TEXTURE11);
+    shader.setInt("prefilterMap", 11);
+    (b ? b : &a)->BindPrefilterMap(GL_TEXTURE13);
+    shader.setInt("prefilterMapB", 13);
+    shader.setFloat("probeBlend", t);
+    shader.setFloat("maxReflectionLod", a.GetMaxReflectionLod());
+    // BRDF查找表与环境无关，所有探针相同
+    a.BindBRDFLUT(GL_TEXTURE12);
+    shader.setInt("brdfLUT", 12);
+}
+
+size_t ProbeManager::GetResidentBytes() const {
+    size_t bytes = 0;
+    for (const auto& probe : m_Probes)
+        if (probe->ibl) bytes += probe->ibl->GetResidentBytes();
+    return bytes;
+}
+
+void ProbeManager::PrintStats() const {
+    int resident = 0, loading = 0;
+    for (const auto& probe : m_Probes) {
+        resident += probe->state == ProbeState::Resident;
+        loading += probe->state == ProbeState::Loading;
+    }
+    std::cout << "PROBES: " << (GetResidentBytes() >> 20) << " / " << (m_Budget >> 20) << " MB"
+        << " | " << m_Probes.size() << " probes (" << resident << " resident, " << loading << " loading)" << std::endl;
+}
+
+void ProbeManager::WorkerLoop() {
+    // 缓存缺失时的CPU烘焙，产物与GPU烘焙一致；保留一个核心给渲染线程，BRDF查找表在多个探针间复用
+    IBLBakeOptions options;
+    unsigned int cores = std::thread::hardware_concurrency();
+    options.threads = cores > 1 ? cores - 1 : 1;
+    IBLBaker baker(m_Params, options);
+    while (true) {
+        std::unique_ptr<LoadJob> job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Cond.wait(lock, [this] { return !m_Running || !m_Requests.empty(); });
+            if (!m_Running) return;
+            job = std::move(m_Requests.front());
+            m_Requests.pop_front();
+        }
+
+        // 与IBL构造函数相同的缓存键；读取和解析在后台完成，主线程只做上传
+        uint64_t contentHash = 0;
+        if (IBLCache::HashFile(job->hdrPath, contentHash)) {
+            std::string cachePath = IBLCache::CachePath(job->hdrPath);
+            uint64_t key = IBLCache::MakeKey(contentHash, m_Params);
+            job->ok = IBLCache::Load(cachePath, key, job->data);
+            if (!job->ok && baker.BakeFile(job->hdrPath, job->data)) {
+                IBLCache::Save(cachePath, key, job->data);
+                job->ok = true;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Completed.push_back(std::move(job));
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Frustum.h"
+#include "IBL.h"
+#include "Shader.h"
+
+// 一个对象使用的环境探针：最多两个，probeB的权重为blend
+struct ProbeBlend {
+    int probeA = -1;
+    int probeB = -1;
+    float blend = 0.0f;
+};
+
+// 环境探针管理：多个烘焙好的IBL环境，每个探针有一个影响体积（AABB）
+//   选择：按体积从小到大（越局部越优先）取第一个覆盖该位置的探针，其边缘过渡区剩余的权重交给下一个，
+//         全局探针覆盖整个场景，总是存在
+//   驻留：探针数据按LRU放在显存预算内，超出时驱逐最久未使用的局部探针（全局探针常驻）
+//   加载：工作线程从IBL磁盘缓存读取数据，主线程按帧上传；缓存缺失时工作线程用IBLBaker在CPU上烘焙并写入缓存
+//   动态探针：从探针位置实时渲染场景，每帧按GPU时间预算推进一部分（见IBL::UpdateCapture）
+class ProbeManager {
+public:
+    ProbeManager(bool useSH, IBLQuality quality, IBLFormat format);
+    ~ProbeManager();
+
+    // 全局探针（无限影响范围，同步加载并常驻），返回探针索引
+    int SetGlobalProbe(const std::string& hdrPath);
+    // 局部探针：bounds内权重为1，向内blendDistance范围内过渡到0；异步加载
+    int AddProbe(const std::string& hdrPath, const AABB& bounds, float blendDistance = 1.0f);
+
+    // 动态探针：从影响体积中心实时捕获场景（IBL动态模式），常驻且不计入驱逐；首轮捕获完成前不参与选择
+    int AddDynamicProbe(const AABB& bounds, float blendDistance, int captureSize,
+        IBL::SceneRenderer renderScene, float budgetMs = 1.0f);
+    IBL* GetProbe(int index) { return m_Probes[index]->ibl.get(); }
+
+    void SetBudget(size_t bytes) { m_Budget = bytes; }
+    // prefetchDistance：相机距影响体积小于该距离时提前加载
+    void SetPrefetchDistance(float distance) { m_PrefetchDistance = distance; }
+
+    // 帧开始调用：上传最多maxUploads个加载完成的探针，预取相机附近的探针，超预算时驱逐
+    void Update(const glm::vec3& cameraPos, unsigned int maxUploads = 1);
+
+    // 为位于position的对象选择探针；未驻留的探针会请求加载，本帧由下一个驻留探针代替
+    ProbeBlend Select(const glm::vec3& position);
+    // 推进动态探针的分片捕获，在本帧主场景绘制之后调用（场景uniform已设置）
+    void UpdateDynamicProbes();
+    // 绑定探针贴图（prefilterMap 11、prefilterMapB 13，irradianceMap 10、irradianceMapB 14，brdfLUT 12）
+    // 并设置probeBlend；球谐变体直接在CPU上混合系数
+    void Apply(const Shader& shader, const ProbeBlend& blend) const;
+
+    size_t GetResidentBytes() const;
+    void PrintStats() const;
+
+private:
+    enum class ProbeState { Unloaded, Loading, Resident, Failed };
+
+    struct Probe {
+        std::string hdrPath;
+        AABB bounds;
+        float blendDistance = 1.0f;
+        bool global = false;
+        bool dynamic = false;
+        ProbeState state = ProbeState::Unloaded;
+        std::unique_ptr<IBL> ibl;
+        uint64_t lastUsed = 0;
+    };
+
+    struct LoadJob {
+        int probe = -1;
+        std::string hdrPath;
+        IBLCacheData data;
+        bool ok = false;
+    };
+
+    bool m_UseSH;
+    IBLQuality m_Quality;
+    IBLFormat m_Format;
+    IBLBakeParams m_Params;
+    std::vector<std::unique_ptr<Probe>> m_Probes;
+    std::vector<int> m_Order;       // 按影响体积从小到大，全局探针在最后
+    int m_Global = -1;
+    uint64_t m_Frame = 1;
+    size_t m_Budget = 64u * 1024u * 1024u;
+    float m_PrefetchDistance = 4.0f;
+
+    std::thread m_Worker;
+    std::atomic<bool> m_Running;
+    std::mutex m_Mutex;
+    std::condition_variable m_Cond;
+    std::deque<std::unique_ptr<LoadJob>> m_Requests;
+    std::deque<std::unique_ptr<LoadJob>> m_Completed;
+
+    // 影响权重：体积内部为1，边缘blendDistance内线性过渡，体积外为0
+    float InfluenceWeight(const Probe& probe, const glm::vec3& position) const;
+    int InsertProbe(std::unique_ptr<Probe> probe);
+    void RequestLoad(int index);
+    void EnforceBudget();
+    void WorkerLoop();
+};
@@ -0,0 +1,108 @@
+#include "ResidencyManager.h"
+#include <algorithm>
+#include <iostream>
+
+ResidencyManager& ResidencyManager::Get() {
+    static ResidencyManager instance;
+    return instance;
+}
+
+size_t ResidencyManager::TextureBytes(int width, int height, int bytesPerTexel, bool mipmapped) {
+    size_t bytes = (size_t)width * height * bytesPerTexel;
+    return mipmapped ? bytes * 4 / 3 : bytes;
+}
+
+// ================== 登记/使用 ==================
+void ResidencyManager::TrackTexture(GLuint id, size_t bytes, const char* owner) {
+    UntrackTexture(id);
+    TextureEntry& entry = m_Textures[id];
+    entry.bytes = bytes;
+    entry.lastUsed = m_Frame;
+    entry.owner = owner;
+    m_Used += bytes;
+}
+
+void ResidencyManager::UntrackTexture(GLuint id) {
+    auto it = m_Textures.find(id);
+    if (it == m_Textures.end()) return;
+    m_Used -= it->second.bytes;
+    m_Textures.erase(it);
+}
+
+void ResidencyManager::TouchTexture(GLuint id) {
+    auto it = m_Textures.find(id);
+    if (it == m_Textures.end()) return;
+    it->second.lastUsed = m_Frame;
+}
+
+void ResidencyManager::ResizeTexture(GLuint id, size_t bytes) {
+    auto it = m_Textures.find(id);
+    if (it == m_Textures.end()) return;
+    m_Used = m_Used - it->second.bytes + bytes;
+    it->second.bytes = bytes;
+}
+
+uint32_t ResidencyManager::TrackGeometry(GLuint vao, GLuint vbo, GLuint ebo, size_t bytes, const char* owner, GLuint depthVao) {
+    uint32_t handle = m_NextHandle++;
+    GeometryEntry& entry = m_Geometry[handle];
+    entry.vao = vao;
+    entry.vbo = vbo;
+    entry.ebo = ebo;
+    entry.depthVao = depthVao;
+    entry.bytes = bytes;
+    entry.lastUsed = m_Frame;
+    entry.owner = owner;
+    m_Used += bytes;
+    return handle;
+}
+
+void ResidencyManager::UntrackGeometry(uint32_t handle) {
+    auto it = m_Geometry.find(handle);
+    if (it == m_Geometry.end()) return;
+    m_Used -= it->second.bytes;
+    m_Geometry.erase(it);
+}
+
+bool ResidencyManager::TouchGeometry(uint32_t handle) {
+    auto it = m_Geometry.find(handle);
+    if (it == m_Geometry.end()) return false;
+    it->second.lastUsed = m_Frame;
+    return true;
+}
+
+// ================== 帧处理 ==================
+void ResidencyManager::BeginFrame() {
+    m_Frame++;
+}
+
+void ResidencyManager::EnforceBudget() {
+    if (m_Used <= m_Budget) return;
+
+    // 纹理不在这里驱逐（见TextureStreamer的mip偏移），只按LRU删除本帧未使用的几何
+    std::vector<std::pair<uint64_t, uint32_t>> candidates;
+    for (const auto& g : m_Geometry) {
+        if (g.second.lastUsed < m_Frame)
+            candidates.push_back({ g.second.lastUsed, g.first });
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (const auto& c : candidates) {
+        if (m_Used <= m_Budget) break;
+        GeometryEntry& entry = m_Geometry[c.second];
+        glDeleteVertexArrays(1, &entry.vao);
+        if (entry.depthVao) glDeleteVertexArrays(1, &entry.depthVao);
+        glDeleteBuffers(1, &entry.vbo);
+        glDeleteBuffers(1, &entry.ebo);
+        UntrackGeometry(c.second);
+    }
+}
+
+void ResidencyManager::PrintStats() const {
+    size_t textureBytes = 0, geometryBytes = 0;
+    for (const auto& t : m_Textures) textureBytes += t.second.bytes;
+    for (const auto& g : m_Geometry) geometryBytes += g.second.bytes;
+
+    std::cout << "RESIDENCY: " << (m_Used >> 20) << " / " << (m_Budget >> 20) << " MB"
+        << " | textures " << m_Textures.size() << " (" << (textureBytes >> 20) << " MB)"
+        << " | geometry " << m_Geometry.size() << " (" << (geometryBytes >> 20) << " MB)" << std::endl;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 显存预算管理：统计Model/Mesh/IBL/ShadowMapper创建的纹理和缓冲，
+// 绘制路径记录每个资源最近使用的帧，超出预算时按LRU驱逐
+//   纹理：只统计占用，不驱逐；Model纹理的分辨率由TextureStreamer管理，超预算时由它整体提高mip偏移
+//   几何：删除VAO/VBO/EBO并注销句柄，Mesh保留CPU副本；Mesh每次使用前用句柄检查，
+//         已被驱逐时丢弃旧的GL名字（可能已被其他对象复用）并重新上传
+class ResidencyManager {
+public:
+    static ResidencyManager& Get();
+
+    void SetBudget(size_t bytes) { m_Budget = bytes; }
+    size_t GetBudget() const { return m_Budget; }
+    size_t GetUsedBytes() const { return m_Used; }
+
+    // 纹理按GL名字登记
+    void TrackTexture(GLuint id, size_t bytes, const char* owner);
+    void UntrackTexture(GLuint id);
+    void TouchTexture(GLuint id);
+    // 纹理存储被外部重新定义（如mip流送）后更新占用
+    void ResizeTexture(GLuint id, size_t bytes);
+
+    // 几何按句柄登记（GL名字会被复用，句柄不会）；depthVao为共享同一缓冲的只含位置的VAO，驱逐时一并删除
+    uint32_t TrackGeometry(GLuint vao, GLuint vbo, GLuint ebo, size_t bytes, const char* owner, GLuint depthVao = 0);
+    void UntrackGeometry(uint32_t handle);
+    bool TouchGeometry(uint32_t handle);   // 返回false表示已被驱逐，需要重新上传
+    bool IsGeometryResident(uint32_t handle) const { return m_Geometry.count(handle) > 0; }
+
+    // 帧开始：推进帧号
+    void BeginFrame();
+    // 帧结束：超预算时驱逐本帧未使用的几何
+    void EnforceBudget();
+    void PrintStats() const;
+
+    // 纹理字节估算（含完整mip链）
+    static size_t TextureBytes(int width, int height, int bytesPerTexel, bool mipmapped);
+
+private:
+    ResidencyManager() = default;
+
+    struct TextureEntry {
+        size_t bytes = 0;
+        uint64_t lastUsed = 0;
+        const char* owner = "";
+    };
+    struct GeometryEntry {
+        GLuint vao = 0, vbo = 0, ebo = 0;
+        GLuint depthVao = 0;
+        size_t bytes = 0;
+        uint64_t lastUsed = 0;
+        const char* owner = "";
+    };
+
+    std::unordered_map<GLuint, TextureEntry> m_Textures;
+    std::unordered_map<uint32_t, GeometryEntry> m_Geometry;
+    uint32_t m_NextHandle = 1;
+    uint64_t m_Frame = 1;
+    size_t m_Used = 0;
+    size_t m_Budget = 512u * 1024u * 1024u;
+};
@@ -0,0 +1,352 @@
+#include "SceneBVH.h"
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define BVH_USE_SSE 1
+#endif
+
+// ================== 构建 ==================
+namespace {
+    struct BuildTriangle {
+        AABB bounds;
+        glm::vec3 centroid;
+        int index;
+    };
+
+    // 构建用的二叉节点：count > 0为叶子（first为首个三角形），否则first为左子节点，右子节点紧随其后
+    struct BinaryNode {
+        AABB bounds;
+        int first;
+        int count;
+    };
+
+    float SurfaceArea(const AABB& box) {
+        if (!box.IsValid()) return 0.0f;
+        glm::vec3 d = box.max - box.min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+}
+
+void SceneBVH::Build(const std::vector<glm::vec3>& vertices) {
+    m_Nodes.clear();
+    m_V0.clear();
+    m_E1.clear();
+    m_E2.clear();
+    m_TriangleIds.clear();
+    m_Normals.clear();
+    m_Bounds = AABB();
+
+    int triangleCount = (int)(vertices.size() / 3);
+    if (triangleCount == 0) return;
+
+    std::vector<BuildTriangle> tris(triangleCount);
+    m_Normals.resize(triangleCount);
+    for (int i = 0; i < triangleCount; ++i) {
+        const glm::vec3& a = vertices[i * 3];
+        const glm::vec3& b = vertices[i * 3 + 1];
+        const glm::vec3& c = vertices[i * 3 + 2];
+        tris[i].bounds.Expand(a);
+        tris[i].bounds.Expand(b);
+        tris[i].bounds.Expand(c);
+        tris[i].centroid = (a + b + c) / 3.0f;
+        tris[i].index = i;
+        glm::vec3 n = glm::cross(b - a, c - a);
+        float len = glm::length(n);
+        m_Normals[i] = len > 0.0f ? n / len : glm::vec3(0.0f, 1.0f, 0.0f);
+        m_Bounds.Expand(tris[i].bounds);
+    }
+
+    // 显式栈自顶向下划分，避免深层递归
+    struct Task { int node, begin, end; };
+    std::vector<BinaryNode> nodes;
+    nodes.reserve(triangleCount * 2);
+    nodes.push_back(BinaryNode());
+    std::vector<Task> stack;
+    stack.push_back({ 0, 0, triangleCount });
+
+    while (!stack.empty()) {
+        Task task = stack.back();
+        stack.pop_back();
+
+        AABB bounds, centroidBounds;
+        for (int i = task.begin; i < task.end; ++i) {
+            bounds.Expand(tris[i].bounds);
+            centroidBounds.Expand(tris[i].centroid);
+        }
+        nodes[task.node].bounds = bounds;
+
+        int count = task.end - task.begin;
+        int bestAxis = -1, bestSplit = 0;
+        float bestCost = (float)count;   // 不划分的代价（相对节点面积，求交代价为1）
+        if (count > MAX_LEAF_SIZE) {
+            float parentArea = SurfaceArea(bounds);
+            for (int axis = 0; axis < 3; ++axis) {
+                float lo = centroidBounds.min[axis], hi = centroidBounds.max[axis];
+                if (hi - lo <= 1e-6f) continue;
+                float scale = BIN_COUNT / (hi - lo);
+
+                AABB binBounds[BIN_COUNT];
+                int binCount[BIN_COUNT] = {};
+                for (int i = task.begin; i < task.end; ++i) {
+                    int b = std::min(BIN_COUNT - 1, (int)((tris[i].centroid[axis] - lo) * scale));
+                    binBounds[b].Expand(tris[i].bounds);
+                    ++binCount[b];
+                }
+
+                // 从右向左累计右侧的面积和数量，再从左向右扫描各分割面
+                float rightArea[BIN_COUNT];
+                int rightCount[BIN_COUNT];
+                AABB acc;
+                int n = 0;
+                for (int b = BIN_COUNT - 1; b > 0; --b) {
+                    acc.Expand(binBounds[b]);
+                    n += binCount[b];
+                    rightArea[b] = SurfaceArea(acc);
+                    rightCount[b] = n;
+                }
+                acc = AABB();
+                n = 0;
+                for (int b = 0; b < BIN_COUNT - 1; ++b) {
+                    acc.Expand(binBounds[b]);
+                    n += binCount[b];
+                    if (n == 0 || rightCount[b + 1] == 0) continue;
+                    float cost = 0.125f + (SurfaceArea(acc) * n + rightArea[b + 1] * rightCount[b + 1]) / parentArea;
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = b;
+                    }
+                }
+            }
+        }
+
+        if (bestAxis < 0) {
+            // 叶子；超过MAX_LEAF_SIZE只发生在质心重合、无法划分时
+            nodes[task.node].first = task.begin;
+            nodes[task.node].count = count;
+            continue;
+        }
+
+        float lo = centroidBounds.min[bestAxis];
+        float scale = BIN_COUNT / (centroidBounds.max[bestAxis] - lo);
+        auto middle = std::partition(tris.begin() + task.begin, tris.begin() + task.end,
+            [&](const BuildTriangle& t) {
+                return std::min(BIN_COUNT - 1, (int)((t.centroid[bestAxis] - lo) * scale)) <= bestSplit;
+            });
+        int mid = (int)(middle - tris.begin());
+
+        int left = (int)nodes.size();
+        nodes.push_back(BinaryNode());
+        nodes.push_back(BinaryNode());
+        nodes[task.node].first = left;
+        nodes[task.node].count = 0;
+        stack.push_back({ left, task.begin, mid });
+        stack.push_back({ left + 1, mid, task.end });
+    }
+
+    m_V0.resize(triangleCount);
+    m_E1.resize(triangleCount);
+    m_E2.resize(triangleCount);
+    m_TriangleIds.resize(triangleCount);
+    for (int i = 0; i < triangleCount; ++i) {
+        int src = tris[i].index;
+        m_V0[i] = vertices[src * 3];
+        m_E1[i] = vertices[src * 3 + 1] - m_V0[i];
+        m_E2[i] = vertices[src * 3 + 2] - m_V0[i];
+        m_TriangleIds[i] = src;
+    }
+
+    // 折叠为4叉树：每个节点从二叉子节点开始，反复展开表面积最大的内部节点直到凑满4个
+    m_Nodes.reserve(nodes.size() / 2 + 1);
+    struct CollapseTask { int node4, binary; };
+    std::vector<CollapseTask> pending;
+    m_Nodes.push_back(Node());
+    pending.push_back({ 0, 0 });
+    while (!pending.empty()) {
+        CollapseTask task = pending.back();
+        pending.pop_back();
+
+        int slots[4];
+        int slotCount = 0;
+        const BinaryNode& source = nodes[task.binary];
+        if (source.count > 0) {
+            slots[slotCount++] = task.binary;   // 根节点就是叶子
+        }
+        else {
+            slots[slotCount++] = source.first;
+            slots[slotCount++] = source.first + 1;
+        }
+        while (slotCount < 4) {
+            int expand = -1;
+            float bestArea = -1.0f;
+            for (int i = 0; i < slotCount; ++i) {
+                const BinaryNode& candidate = nodes[slots[i]];
+                if (candidate.count > 0) continue;
+                float area = SurfaceArea(candidate.bounds);
+                if (area > bestArea) {
+                    bestArea = area;
+                    expand = i;
+                }
+            }
+            if (expand < 0) break;
+            int first = nodes[slots[expand]].first;
+            slots[expand] = first;
+            slots[slotCount++] = first + 1;
+        }
+
+        Node node;
+        node.validMask = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (i >= slotCount) {
+                node.minX[i] = node.minY[i] = node.minZ[i] = FLT_MAX;
+                node.maxX[i] = node.maxY[i] = node.maxZ[i] = -FLT_MAX;
+                node.child[i] = -1;
+                node.count[i] = -1;
+                continue;
+            }
+            const BinaryNode& child = nodes[slots[i]];
+            node.minX[i] = child.bounds.min.x;
+            node.minY[i] = child.bounds.min.y;
+            node.minZ[i] = child.bounds.min.z;
+            node.maxX[i] = child.bounds.max.x;
+            node.maxY[i] = child.bounds.max.y;
+            node.maxZ[i] = child.bounds.max.z;
+            node.validMask |= 1 << i;
+            if (child.count > 0) {
+                node.child[i] = child.first;
+                node.count[i] = child.count;
+            }
+            else {
+                node.child[i] = (int)m_Nodes.size();
+                node.count[i] = 0;
+                m_Nodes.push_back(Node());
+                pending.push_back({ node.child[i], slots[i] });
+            }
+        }
+        m_Nodes[task.node4] = node;
+    }
+}
+
+// ================== 遍历 ==================
+namespace {
+    const int STACK_SIZE = 128;
+
+    // Moller-Trumbore，双面；返回false表示未命中或不比tMax更近
+    inline bool IntersectTriangle(const glm::vec3& v0, const glm::vec3& e1, const glm::vec3& e2,
+        const glm::vec3& origin, const glm::vec3& dir, float tMax, float& t, float& u, float& v, float& det) {
+        glm::vec3 p = glm::cross(dir, e2);
+        det = glm::dot(e1, p);
+        if (std::abs(det) < 1e-12f) return false;
+        float invDet = 1.0f / det;
+        glm::vec3 s = origin - v0;
+        u = glm::dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f) return false;
+        glm::vec3 q = glm::cross(s, e1);
+        v = glm::dot(dir, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f) return false;
+        t = glm::dot(e2, q) * invDet;
+        return t > 0.0f && t < tMax;
+    }
+}
+
+template <bool AnyHit>
+bool SceneBVH::Traverse(const glm::vec3& origin, const glm::vec3& dir, float tMax, RayHit* hit) const {
+    if (m_Nodes.empty()) return false;
+    // 分量为0时取很大的倒数，slab测试仍然正确
+    glm::vec3 invDir;
+    for (int i = 0; i < 3; ++i)
+        invDir[i] = std::abs(dir[i]) > 1e-12f ? 1.0f / dir[i] : (dir[i] >= 0.0f ? 1e12f : -1e12f);
+
+#ifdef BVH_USE_SSE
+    const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+    const __m128 ix = _mm_set1_ps(invDir.x), iy = _mm_set1_ps(invDir.y), iz = _mm_set1_ps(invDir.z);
+    const __m128 zero = _mm_setzero_ps();
+#endif
+
+    bool found = false;
+    // 栈中保存(节点下标, 进入距离)，出栈时距离已超过当前最近交点的直接跳过
+    int stackNode[STACK_SIZE];
+    float stackDist[STACK_SIZE];
+    int sp = 0;
+    stackNode[sp] = 0;
+    stackDist[sp++] = 0.0f;
+
+    while (sp > 0) {
+        --sp;
+        if (stackDist[sp] >= tMax) continue;
+        const Node& node = m_Nodes[stackNode[sp]];
+
+        // 4个子包围盒的slab测试
+        alignas(16) float enter[4];
+        int hitMask;
+#ifdef BVH_USE_SSE
+        __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minX), ox), ix);
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxX), ox), ix);
+        __m128 tNear = _mm_min_ps(t0, t1), tFar = _mm_max_ps(t0, t1);
+        t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minY), oy), iy);
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxY), oy), iy);
+        tNear = _mm_max_ps(tNear, _mm_min_ps(t0, t1));
+        tFar = _mm_min_ps(tFar, _mm_max_ps(t0, t1));
+        t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minZ), oz), iz);
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxZ), oz), iz);
+        tNear = _mm_max_ps(_mm_max_ps(tNear, _mm_min_ps(t0, t1)), zero);
+        tFar = _mm_min_ps(_mm_min_ps(tFar, _mm_max_ps(t0, t1)), _mm_set1_ps(tMax));
+        hitMask = _mm_movemask_ps(_mm_cmple_ps(tNear, tFar)) & node.validMask;
+        _mm_store_ps(enter, tNear);
+#else
+        hitMask = 0;
+        for (int i = 0; i < 4; ++i) {
+            float tx0 = (node.minX[i] - origin.x) * invDir.x, tx1 = (node.maxX[i] - origin.x) * invDir.x;
+            float ty0 = (node.minY[i] - origin.y) * invDir.y, ty1 = (node.maxY[i] - origin.y) * invDir.y;
+            float tz0 = (node.minZ[i] - origin.z) * invDir.z, tz1 = (node.maxZ[i] - origin.z) * invDir.z;
+            float tNear = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::max(std::min(tz0, tz1), 0.0f));
+            float tFar = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::min(std::max(tz0, tz1), tMax));
+            enter[i] = tNear;
+            if (tNear <= tFar) hitMask |= 1 << i;
+        }
+        hitMask &= node.validMask;
+#endif
+        if (!hitMask) continue;
+
+        // 先处理命中的叶子，内部节点按进入距离由远到近入栈（最近的先出栈）
+        int inner[4];
+        int innerCount = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (!(hitMask & (1 << i))) continue;
+            if (node.count[i] == 0) {
+                inner[innerCount++] = i;
+                continue;
+            }
+            for (int tri = node.child[i]; tri < node.child[i] + node.count[i]; ++tri) {
+                float t, u, v, det;
+                if (!IntersectTriangle(m_V0[tri], m_E1[tri], m_E2[tri], origin, dir, tMax, t, u, v, det))
+                    continue;
+                if (AnyHit) return true;
+                tMax = t;
+                found = true;
+                hit->t = t;
+                hit->triangle = m_TriangleIds[tri];
+                hit->u = u;
+                hit->v = v;
+                hit->backface = det < 0.0f;
+            }
+        }
+        for (int a = 1; a < innerCount; ++a)
+            for (int b = a; b > 0 && enter[inner[b]] > enter[inner[b - 1]]; --b)
+                std::swap(inner[b], inner[b - 1]);
+        for (int k = 0; k < innerCount && sp < STACK_SIZE; ++k) {
+            stackNode[sp] = node.child[inner[k]];
+            stackDist[sp++] = enter[inner[k]];
+        }
+    }
+    return found;
+}
+
+bool SceneBVH::Intersect(const glm::vec3& origin, const glm::vec3& dir, float tMax, RayHit& hit) const {
+    return Traverse<false>(origin, dir, tMax, &hit);
+}
+
+bool SceneBVH::Occluded(const glm::vec3& origin, const glm::vec3& dir, float tMax) const {
+    return Traverse<true>(origin, dir, tMax, nullptr);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include "Frustum.h"
+
+// CPU光线求交的包围体层次（不依赖GL，烘焙工作线程只读共享）
+//   构建：按质心分箱的SAH（BIN_COUNT个桶）建二叉树，叶子最多MAX_LEAF_SIZE个三角形，
+//         再把二叉树折叠为4叉树（每次展开表面积最大的内部子节点），子节点包围盒按SoA存放
+//   遍历：栈式，SSE一次测试一个节点的4个子包围盒，命中的子节点按进入距离由近到远访问；
+//         Intersect求最近交点，Occluded找到任意交点即返回
+//   三角形按叶子顺序重排，RayHit::triangle为构建时传入的原始下标
+struct RayHit {
+    float t = 0.0f;
+    int triangle = -1;
+    float u = 0.0f, v = 0.0f;   // 重心坐标：p = v0 + u * (v1 - v0) + v * (v2 - v0)
+    bool backface = false;      // 从绕序的背面击中（光线与几何法线同向）
+};
+
+class SceneBVH {
+public:
+    static const int BIN_COUNT = 12;
+    static const int MAX_LEAF_SIZE = 4;
+
+    // vertices为世界空间顶点，每3个一个三角形
+    void Build(const std::vector<glm::vec3>& vertices);
+    bool Empty() const { return m_Nodes.empty(); }
+    int GetNodeCount() const { return (int)m_Nodes.size(); }
+    int GetTriangleCount() const { return (int)m_TriangleIds.size(); }
+    const AABB& GetBounds() const { return m_Bounds; }
+
+    // dir不要求单位长度，t以dir为单位
+    bool Intersect(const glm::vec3& origin, const glm::vec3& dir, float tMax, RayHit& hit) const;
+    bool Occluded(const glm::vec3& origin, const glm::vec3& dir, float tMax) const;
+    // 原始下标三角形的几何法线（按顶点绕序，单位长度）
+    glm::vec3 GetNormal(int triangle) const { return m_Normals[triangle]; }
+
+private:
+    // 4叉节点：第i个子节点 count[i] > 0为叶子（child[i]为首个三角形），0为内部节点（child[i]为节点下标），
+    // -1为空槽；空槽的包围盒为空，validMask中对应位为0
+    struct Node {
+        float minX[4], minY[4], minZ[4];
+        float maxX[4], maxY[4], maxZ[4];
+        int child[4];
+        int count[4];
+        int validMask;
+    };
+
+    std::vector<Node> m_Nodes;
+    std::vector<glm::vec3> m_V0, m_E1, m_E2;    // 叶子顺序的三角形（顶点 + 两条边）
+    std::vector<int> m_TriangleIds;             // 叶子顺序 -> 原始下标
+    std::vector<glm::vec3> m_Normals;           // 原始下标
+    AABB m_Bounds;
+
+    template <bool AnyHit>
+    bool Traverse(const glm::vec3& origin, const glm::vec3& dir, float tMax, RayHit* hit) const;
+};
@@ -6,8 +6,25 @@ SceneManager::SceneManager() {
     m_RootNode = std::make_shared<SceneNode>("Root");
 }
 
-void SceneManager::RenderScene(Shader& shader) {
-    m_RootNode->Draw(shader);
+void SceneManager::RenderScene(Shader& shader, const glm::mat4& projection, const glm::mat4& view, float brightness) {
+    m_LightmappedNodes.clear();
+    m_RootNode->Draw(shader, glm::mat4(1.0f), &m_LightmappedNodes);
+    if (m_LightmappedNodes.empty()) return;
+
+    // 编译失败时退回动态光照绘制
+    Shader* lightmapShader = GetVariant(shader, "LIGHTMAPPED", m_LightmappedVariants);
+    if (!lightmapShader) {
+        for (SceneNode* node : m_LightmappedNodes)
+            node->DrawLightmapped(shader);
+        return;
+    }
+    lightmapShader->use();
+    lightmapShader->setMat4("projection", projection);
+    lightmapShader->setMat4("view", view);
+    lightmapShader->setFloat("brightness", brightness);
+    for (SceneNode* node : m_LightmappedNodes)
+        node->DrawLightmapped(*lightmapShader);
+    shader.use();
 }
 
 SceneNode::Ptr SceneManager::CreateNode(const std::string& name) {
@@ -16,19 +33,141 @@ SceneNode::Ptr SceneManager::CreateNode(const std::string& name) {
     return node;
 }
 
-SceneNode::Ptr SceneManager::CreateModelNode(const std::string& name, const std::string& modelPath) {
+SceneNode::Ptr SceneManager::CreateModelNode(const std::string& name, const std::string& modelPath, bool lazy) {
     auto node = CreateNode(name);
+
+    // 已有烘焙缓存时只登记包围盒，否则退回同步导入（同时生成缓存）
+    AABB bounds;
+    if (lazy && Model::ReadCookedBounds(modelPath, bounds)) {
+        node->SetLazyModel(modelPath, bounds);
+        return node;
+    }
+
     auto model = std::make_shared<Model>(modelPath.c_str());
     node->AttachModel(model);
+    if (m_OnModelLoaded) m_OnModelLoaded(model.get());
     return node;
 }
-SceneNode& SceneManager::CreatePrimitiveNode(const std::string& name, PrimitiveType type) {
+
+void SceneManager::UpdateStreaming(const glm::vec3& cameraPos, const glm::mat4& viewProjection) {
+    Frustum frustum = Frustum::FromMatrix(viewProjection);
+    UpdateStreamingNode(m_RootNode, glm::mat4(1.0f), cameraPos, frustum);
+    m_Streamer.Update();
+}
+
+void SceneManager::UpdateStreamingNode(const SceneNode::Ptr& node, const glm::mat4& parentTransform,
+    const glm::vec3& cameraPos, const Frustum& frustum) {
+    node->UpdateTransform(parentTransform);
+
+    if (node->IsModelPending() && !node->IsLoadRequested()) {
+        AABB worldBounds = node->GetWorldBounds();
+        if (frustum.Intersects(worldBounds) || worldBounds.Distance(cameraPos) < prefetchRadius) {
+            node->MarkLoadRequested();
+            std::weak_ptr<SceneNode> weakNode = node;
+            m_Streamer.RequestModel(node->GetLazyPath(), [this, weakNode](std::shared_ptr<Model> model) {
+                auto target = weakNode.lock();
+                if (!target) return;
+                target->AttachModel(model);
+                if (m_OnModelLoaded) m_OnModelLoaded(model.get());
+            });
+        }
+    }
+
+    for (const auto& child : node->GetChildren())
+        UpdateStreamingNode(child, node->GetWorldTransform(), cameraPos, frustum);
+}
+
+void SceneManager::CollectShadowCasters(ShadowCasterList& casters) {
+    m_DepthStats = SceneNode::DepthStats();
+    casters.bounds.clear();
+    casters.invalidated.clear();
+    casters.dynamicBounds.clear();
+    CollectShadowCastersNode(m_RootNode, casters);
+}
+
+void SceneManager::CollectShadowCastersNode(const SceneNode::Ptr& node, ShadowCasterList& casters) {
+    node->UpdateShadowCache(casters.invalidated);
+    if (node->HasGeometry()) {
+        AABB worldBounds = node->GetWorldBounds();
+        if (worldBounds.IsValid()) {
+            casters.bounds.push_back(worldBounds);
+            if (!node->IsStatic())
+                casters.dynamicBounds.push_back(worldBounds);
+        }
+    }
+    for (const auto& child : node->GetChildren())
+        CollectShadowCastersNode(child, casters);
+}
+
+void SceneManager::CollectStaticTriangles(std::vector<glm::vec3>& out) const {
+    out.clear();
+    CollectStaticTrianglesNode(m_RootNode, out);
+}
+
+void SceneManager::CollectStaticTrianglesNode(const SceneNode::Ptr& node, std::vector<glm::vec3>& out) const {
+    if (node->IsStatic() && !node->IsModelPending())
+        node->AppendWorldTriangles(out);
+    for (const auto& child : node->GetChildren())
+        CollectStaticTrianglesNode(child, out);
+}
+
+void SceneManager::RenderShadowCasters(Shader& shader, const glm::mat4& lightSpace, bool staticCasters) {
+    m_AlphaTestedCasters.clear();
+    m_RootNode->DrawShadowCasters(shader, Frustum::FromMatrix(lightSpace), staticCasters,
+        m_AlphaTestedCasters, m_DepthStats);
+    if (m_AlphaTestedCasters.empty()) return;
+
+    // 编译失败时退回不透明绘制
+    Shader* alphaShader = GetVariant(shader, "ALPHA_TEST", m_AlphaTestVariants);
+    Shader& target = alphaShader ? *alphaShader : shader;
+    target.use();
+    target.setMat4("lightSpaceMatrix", lightSpace);
+    for (const auto& caster : m_AlphaTestedCasters)
+        caster.node->DrawDepthAlphaTested(target);
+    shader.use();
+}
+
+void SceneManager::RenderShadowCastersLayered(Shader& shader, const glm::mat4 faceMatrices[6]) {
+    Frustum faces[6];
+    for (int f = 0; f < 6; ++f)
+        faces[f] = Frustum::FromMatrix(faceMatrices[f]);
+    m_AlphaTestedCasters.clear();
+    m_RootNode->DrawShadowCastersLayered(shader, faces, m_AlphaTestedCasters, m_DepthStats);
+    if (m_AlphaTestedCasters.empty()) return;
+
+    Shader* alphaShader = GetVariant(shader, "ALPHA_TEST", m_AlphaTestVariants);
+    Shader& target = alphaShader ? *alphaShader : shader;
+    target.use();
+    for (int f = 0; f < 6; ++f)
+        target.setMat4("faceMatrices[" + std::to_string(f) + "]", faceMatrices[f]);
+    for (const auto& caster : m_AlphaTestedCasters) {
+        target.setInt("faceMask", caster.faceMask);
+        caster.node->DrawDepthAlphaTested(target);
+    }
+    shader.use();
+}
+
+Shader* SceneManager::GetVariant(const Shader& shader, const char* define, VariantMap& variants) {
+    ShaderVariant& variant = variants[&shader];
+    if (variant.sourceProgram != shader.ID || !variant.shader) {
+        std::vector<std::string> defines = shader.GetDefines();
+        defines.push_back(define);
+        const std::string& geometryPath = shader.GetGeometryPath();
+        if (variant.shader && variant.shader->isCompiledSuccessfully())
+            glDeleteProgram(variant.shader->ID);
+        variant.shader = std::make_unique<Shader>(shader.GetVertexPath().c_str(), shader.GetFragmentPath().c_str(),
+            defines, geometryPath.empty() ? nullptr : geometryPath.c_str());
+        variant.sourceProgram = shader.ID;
+    }
+    return variant.shader->isCompiledSuccessfully() ? variant.shader.get() : nullptr;
+}
+SceneNode::Ptr SceneManager::CreatePrimitiveNode(const std::string& name, PrimitiveType type) {
     auto node = std::make_shared<SceneNode>(name);
-    nodes.push_back(node); // ӵڵб
-    m_RootNode->AddChild(node); // ӵ
+    nodes.push_back(node); // 添加到节点列表
+    m_RootNode->AddChild(node); // 添加到场景树
 
     if (type == PrimitiveType::PLANE) {
-        // ݣλáߡ꣩
+        // 顶点数据（位置、法线、纹理坐标）
         std::vector<Vertex> planeVertices = {
             {glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.0f, 0.0f)},
             {glm::vec3(1.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(1.0f, 0.0f)},
@@ -43,28 +182,28 @@ SceneNode& SceneManager::CreatePrimitiveNode(const std::string& name, PrimitiveT
         
 
         std::vector<unsigned int> planeIndices = { 0, 1, 2, 0, 2, 3 };
-        //std::vector<Texture> planeTextures; // бͨҪ
+        //std::vector<Texture> planeTextures; // 空纹理列表（基础几何体通常不需要纹理）
 
-        // ʹ캯
+        // 创建网格对象（使用三参数构造函数）
         Mesh planeMesh(planeVertices, planeIndices, planeTextures);
         node->AddMesh(planeMesh);
 
     }
 
-    return *node; // 
+    return node;
 }
 
-// ɴ
+// 生成纯白纹理
 unsigned int SceneManager::GenerateWhiteTexture() {
     unsigned int textureID;
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_2D, textureID);
 
-    // 1x1 ɫ
+    // 1x1 纯白色像素
     unsigned char data[] = { 255, 255, 255, 255 };
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
 
-    // 
+    // 设置纹理参数
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
@@ -1,24 +1,76 @@
 #pragma once
 #include "SceneNode.h"
+#include "AssetStreamer.h"
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+// 本帧的阴影投射体
+struct ShadowCasterList {
+    std::vector<AABB> bounds;       // 全部投射体的世界包围盒（级联拟合）
+    std::vector<AABB> invalidated;  // 变换或几何发生变化的静态投射体（旧位置与新位置）
+    std::vector<AABB> dynamicBounds; // 非静态投射体，为空时无需逐帧绘制
+};
 
 class SceneManager {
 public:
     SceneManager();
-    // ö
+    // 几何体类型枚举
     enum class PrimitiveType { PLANE };
-    // 
+    // 场景操作
     SceneNode::Ptr GetRoot() const { return m_RootNode; }
-    // ƽɷ
-    SceneNode& CreatePrimitiveNode(const std::string& name, PrimitiveType type);
+    // 平面生成方法
+    SceneNode::Ptr CreatePrimitiveNode(const std::string& name, PrimitiveType type);
     unsigned int GenerateWhiteTexture();
-    void RenderScene(Shader& shader);
+    // 有光照贴图的节点随后用着色器的LIGHTMAPPED变体绘制（首次使用时编译），只采样光照贴图，不遍历动态光源；
+    // 变体是独立的程序，调用方传入本帧的相机矩阵和亮度（shader本身由调用方设置）
+    void RenderScene(Shader& shader, const glm::mat4& projection, const glm::mat4& view, float brightness);
 
-    // ݴ
+    // 快捷创建方法
     SceneNode::Ptr CreateNode(const std::string& name);
-    SceneNode::Ptr CreateModelNode(const std::string& name, const std::string& modelPath);
+    // lazy=true时只读取烘焙文件头的包围盒，首次可见或进入预取半径时再流送
+    SceneNode::Ptr CreateModelNode(const std::string& name, const std::string& modelPath, bool lazy = false);
+
+    // 每帧调用：更新变换、触发懒加载请求并上传已完成的模型
+    void UpdateStreaming(const glm::vec3& cameraPos, const glm::mat4& viewProjection);
+    // 收集阴影投射体并消耗节点的变化标记，变换需已在本帧更新（UpdateStreaming之后调用）
+    void CollectShadowCasters(ShadowCasterList& casters);
+    // 全部静态、已驻留节点的世界空间三角形（懒加载尚未驻留的节点跳过，驻留后由invalidated通知重新收集）
+    void CollectStaticTriangles(std::vector<glm::vec3>& out) const;
+    // 深度绘制静态或非静态投射体：按lightSpace的视锥剔除，不透明节点只读位置流，
+    // 透明度测试的节点随后用着色器的ALPHA_TEST变体绘制（首次使用时编译）
+    void RenderShadowCasters(Shader& shader, const glm::mat4& lightSpace, bool staticCasters);
+    // 点光源单遍深度绘制：faceMatrices为六个面的矩阵，逐节点剔除后用faceMask告知几何着色器
+    void RenderShadowCastersLayered(Shader& shader, const glm::mat4 faceMatrices[6]);
+    // 本帧（自上次CollectShadowCasters起）的深度绘制统计
+    const SceneNode::DepthStats& GetDepthStats() const { return m_DepthStats; }
+    void SetModelLoadedCallback(std::function<void(Model*)> callback) { m_OnModelLoaded = callback; }
+    float prefetchRadius = 8.0f;   // 相机预取半径
 
     std::vector<std::shared_ptr<SceneNode>> nodes;
 private:
     SceneNode::Ptr m_RootNode;
+    AssetStreamer m_Streamer;
+    std::function<void(Model*)> m_OnModelLoaded;
+
+    // 着色器变体（源着色器的宏 + 一个额外的宏），源程序重新编译（热重载）后重建
+    struct ShaderVariant {
+        unsigned int sourceProgram = 0;
+        std::unique_ptr<Shader> shader;
+    };
+    using VariantMap = std::unordered_map<const Shader*, ShaderVariant>;
+    VariantMap m_AlphaTestVariants;     // 深度着色器的ALPHA_TEST变体
+    VariantMap m_LightmappedVariants;   // 场景着色器的LIGHTMAPPED变体
+    std::vector<SceneNode::DepthCaster> m_AlphaTestedCasters;
+    std::vector<SceneNode*> m_LightmappedNodes;
+    SceneNode::DepthStats m_DepthStats;
+
+    // 编译失败时返回nullptr
+    Shader* GetVariant(const Shader& shader, const char* define, VariantMap& variants);
+
+    void UpdateStreamingNode(const SceneNode::Ptr& node, const glm::mat4& parentTransform,
+        const glm::vec3& cameraPos, const Frustum& frustum);
+    void CollectShadowCastersNode(const SceneNode::Ptr& node, ShadowCasterList& casters);
+    void CollectStaticTrianglesNode(const SceneNode::Ptr& node, std::vector<glm::vec3>& out) const;
 };
 
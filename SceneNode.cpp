@@ -1,12 +1,18 @@
 #include "SceneNode.h"
+#include "TextureStreamer.h"
+#include "Lightmapper.h"
+#include "ResidencyManager.h"
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
 
 SceneNode::SceneNode(const std::string& name)
     : m_Name(name),
     m_Position(0.0f),
     m_Rotation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f)),
-    m_Scale(1.0f) {
+    m_Scale(1.0f),
+    m_LocalTransform(1.0f),
+    m_WorldTransform(1.0f) {
 }
 
 void SceneNode::AddChild(Ptr child) {
@@ -32,10 +38,71 @@ void SceneNode::SetScale(const glm::vec3& scale) {
 
 void SceneNode::AttachModel(std::shared_ptr<Model> model) {
     m_Model = model;
+    if (model) m_LocalBounds = model->GetBounds();
+    m_ShadowDirty = true;
+}
+
+void SceneNode::SetLazyModel(const std::string& path, const AABB& bounds) {
+    m_LazyPath = path;
+    m_LocalBounds = bounds;
+    m_LoadRequested = false;
 }
 
 void SceneNode::AddMesh(const Mesh& mesh) {
     m_Meshes.push_back(mesh);
+    // 代码生成的网格同样需要包围盒（阴影级联拟合、视锥剔除）
+    for (const auto& v : mesh.GetVertices())
+        m_LocalBounds.Expand(v.Position);
+    m_ShadowDirty = true;
+}
+
+void SceneNode::SetStatic(bool isStatic) {
+    if (m_Static == isStatic) return;
+    m_Static = isStatic;
+    m_ShadowDirty = true;
+}
+
+void SceneNode::UpdateShadowCache(std::vector<AABB>& invalidated) {
+    if (!m_ShadowDirty) return;
+    m_ShadowDirty = false;
+    // 旧位置的阴影需要从缓存中擦除，新位置需要补画
+    if (m_ShadowBounds.IsValid())
+        invalidated.push_back(m_ShadowBounds);
+    m_ShadowBounds = m_Static && HasGeometry() ? GetWorldBounds() : AABB();
+    if (m_ShadowBounds.IsValid())
+        invalidated.push_back(m_ShadowBounds);
+}
+
+void SceneNode::AppendWorldTriangles(std::vector<glm::vec3>& out) const {
+    // 绕序与顶点法线不一致的三角形（如地面平面）交换顶点，使几何法线朝向表面外侧，烘焙时据此判断背面
+    glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(m_WorldTransform)));
+    auto appendTriangle = [&](const Vertex& a, const Vertex& b, const Vertex& c) {
+        glm::vec3 p0 = glm::vec3(m_WorldTransform * glm::vec4(a.Position, 1.0f));
+        glm::vec3 p1 = glm::vec3(m_WorldTransform * glm::vec4(b.Position, 1.0f));
+        glm::vec3 p2 = glm::vec3(m_WorldTransform * glm::vec4(c.Position, 1.0f));
+        glm::vec3 shadingNormal = normalMatrix * (a.Normal + b.Normal + c.Normal);
+        if (glm::dot(glm::cross(p1 - p0, p2 - p0), shadingNormal) < 0.0f)
+            std::swap(p1, p2);
+        out.push_back(p0);
+        out.push_back(p1);
+        out.push_back(p2);
+    };
+    auto appendMesh = [&](const Mesh& mesh) {
+        const std::vector<Vertex>& vertices = mesh.GetVertices();
+        const std::vector<unsigned int>& indices = mesh.GetIndices();
+        if (indices.empty()) {
+            for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+                appendTriangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+            return;
+        }
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+            appendTriangle(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]]);
+    };
+    for (const Mesh& mesh : m_Meshes)
+        appendMesh(mesh);
+    if (m_Model)
+        for (const Mesh& mesh : m_Model->GetMeshes())
+            appendMesh(mesh);
 }
 
 void SceneNode::UpdateTransform(const glm::mat4& parentTransform) {
@@ -44,18 +111,37 @@ void SceneNode::UpdateTransform(const glm::mat4& parentTransform) {
     glm::mat4 scale = glm::scale(glm::mat4(1.0f), m_Scale);
 
     m_LocalTransform = translation * rotation * scale;
-    m_WorldTransform = parentTransform * m_LocalTransform;
+    glm::mat4 worldTransform = parentTransform * m_LocalTransform;
+    if (worldTransform != m_WorldTransform) {
+        m_WorldTransform = worldTransform;
+        m_ShadowDirty = true;
+    }
+}
+
+void SceneNode::SetStreamingContext() const {
+    glm::vec3 cameraPos = TextureStreamer::Get().GetCameraPos();
+    AABB bounds = GetWorldBounds();
+    float distance = bounds.IsValid() ? bounds.Distance(cameraPos)
+        : glm::length(glm::vec3(m_WorldTransform[3]) - cameraPos);
+    float scale = glm::max(glm::length(glm::vec3(m_WorldTransform[0])),
+        glm::max(glm::length(glm::vec3(m_WorldTransform[1])), glm::length(glm::vec3(m_WorldTransform[2]))));
+    TextureStreamer::Get().SetDrawContext(distance, scale);
 }
 
-void SceneNode::Draw(Shader& shader, const glm::mat4& parentTransform) {
-    // 1. µǰڵ任
+void SceneNode::Draw(Shader& shader, const glm::mat4& parentTransform, std::vector<SceneNode*>* lightmapped) {
+    // 1. 更新当前节点变换
     UpdateTransform(parentTransform);
 
-    // 2. òʲɫ
+    // 2. 设置材质参数到着色器
     shader.setFloat("material.shininess", m_Material.shininess);
 
-    // 3. Ƶǰڵ
-    if (m_Model) {
+    // 3. 绘制当前节点
+    if (m_Model || !m_Meshes.empty())
+        SetStreamingContext();
+    if (lightmapped && IsLightmapped()) {
+        lightmapped->push_back(this);
+    }
+    else if (m_Model) {
         shader.setMat4("model", m_WorldTransform);
         m_Model->Draw(shader, m_Material);
     }
@@ -65,14 +151,175 @@ void SceneNode::Draw(Shader& shader, const glm::mat4& parentTransform) {
             mesh.Draw(shader, m_Material);
         }
     }
+    else if (IsModelPending()) {
+        DrawProxy(shader);
+    }
 
-    // 4. ݹӽڵ
+    // 4. 递归绘制子节点
     for (auto& child : m_Children) {
-        child->Draw(shader, m_WorldTransform);
+        child->Draw(shader, m_WorldTransform, lightmapped);
     }
 }
 
-// Աʷ
+bool SceneNode::IsLightmapped() const {
+    if (m_Material.lightmap == 0) return false;
+    if (!m_Model && m_Meshes.empty()) return false;
+    for (const Mesh& mesh : m_Meshes)
+        if (!mesh.HasLightmapUVs()) return false;
+    if (m_Model)
+        for (const Mesh& mesh : m_Model->GetMeshes())
+            if (!mesh.HasLightmapUVs()) return false;
+    return true;
+}
+
+void SceneNode::DrawLightmapped(Shader& shader) {
+    glActiveTexture(GL_TEXTURE0 + Lightmapper::LIGHTMAP_UNIT);
+    glBindTexture(GL_TEXTURE_2D, m_Material.lightmap);
+    glActiveTexture(GL_TEXTURE0);
+    ResidencyManager::Get().TouchTexture(m_Material.lightmap);
+    shader.setInt("lightmap", Lightmapper::LIGHTMAP_UNIT);
+    shader.setFloat("material.shininess", m_Material.shininess);
+    shader.setMat4("model", m_WorldTransform);
+    SetStreamingContext();
+    if (m_Model)
+        m_Model->Draw(shader, m_Material);
+    else
+        for (auto& mesh : m_Meshes)
+            mesh.Draw(shader, m_Material);
+}
+
+std::vector<Mesh*> SceneNode::GetAllMeshes() {
+    std::vector<Mesh*> meshes;
+    for (Mesh& mesh : m_Meshes)
+        meshes.push_back(&mesh);
+    if (m_Model)
+        for (Mesh& mesh : m_Model->GetMeshes())
+            meshes.push_back(&mesh);
+    return meshes;
+}
+
+void SceneNode::DrawShadowCasters(Shader& shader, const Frustum& frustum, bool staticCasters,
+    std::vector<DepthCaster>& alphaTested, DepthStats& stats) {
+    if (m_Static == staticCasters && HasGeometry()) {
+        AABB worldBounds = GetWorldBounds();
+        if (worldBounds.IsValid() && !frustum.Intersects(worldBounds)) {
+            ++stats.culled;
+        }
+        else if (m_Material.alphaTest && !IsModelPending()) {
+            alphaTested.push_back({ this, 0 });
+            ++stats.alphaTested;
+        }
+        else {
+            DrawDepthGeometry(shader);
+            ++stats.drawn;
+        }
+    }
+
+    for (auto& child : m_Children)
+        child->DrawShadowCasters(shader, frustum, staticCasters, alphaTested, stats);
+}
+
+void SceneNode::DrawShadowCastersLayered(Shader& shader, const Frustum faces[6],
+    std::vector<DepthCaster>& alphaTested, DepthStats& stats) {
+    if (HasGeometry()) {
+        AABB worldBounds = GetWorldBounds();
+        int mask = 0;
+        if (!worldBounds.IsValid()) {
+            mask = 0x3F;    // 没有包围盒时不剔除
+        }
+        else {
+            for (int f = 0; f < 6; ++f)
+                if (faces[f].Intersects(worldBounds)) mask |= 1 << f;
+        }
+        if (!mask) {
+            ++stats.culled;
+        }
+        else if (m_Material.alphaTest && !IsModelPending()) {
+            alphaTested.push_back({ this, mask });
+            ++stats.alphaTested;
+        }
+        else {
+            shader.setInt("faceMask", mask);
+            DrawDepthGeometry(shader);
+            ++stats.drawn;
+        }
+    }
+
+    for (auto& child : m_Children)
+        child->DrawShadowCastersLayered(shader, faces, alphaTested, stats);
+}
+
+void SceneNode::DrawDepthGeometry(Shader& shader) {
+    if (m_Model) {
+        shader.setMat4("model", m_WorldTransform);
+        m_Model->DrawDepth();
+    }
+    else if (!m_Meshes.empty()) {
+        shader.setMat4("model", m_WorldTransform);
+        for (auto& mesh : m_Meshes)
+            mesh.DrawDepth();
+    }
+    else if (IsModelPending()) {
+        shader.setMat4("model", ProxyTransform());
+        ProxyCube().DrawDepth();
+    }
+}
+
+void SceneNode::DrawDepthAlphaTested(Shader& shader) {
+    shader.setMat4("model", m_WorldTransform);
+    if (m_Model) {
+        m_Model->DrawDepthAlphaTested(shader, m_Material);
+    }
+    else {
+        for (auto& mesh : m_Meshes)
+            mesh.DrawDepthAlphaTested(shader, m_Material);
+    }
+}
+
+static std::unique_ptr<Mesh> s_ProxyCube;
+
+Mesh& SceneNode::ProxyCube() {
+    if (!s_ProxyCube) {
+        std::vector<Vertex> vertices;
+        for (int i = 0; i < 8; ++i) {
+            Vertex v;
+            v.Position = glm::vec3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+            v.Normal = glm::normalize(v.Position);
+            v.TexCoords = glm::vec2(0.0f);
+            v.Tangent = glm::vec3(1.0f, 0.0f, 0.0f);
+            vertices.push_back(v);
+        }
+        std::vector<unsigned int> indices = {
+            0, 2, 1, 1, 2, 3,   4, 5, 6, 5, 7, 6,
+            0, 1, 4, 1, 5, 4,   2, 6, 3, 3, 6, 7,
+            0, 4, 2, 2, 4, 6,   1, 3, 5, 3, 7, 5
+        };
+        s_ProxyCube.reset(new Mesh(vertices, indices, std::vector<Texture>()));
+    }
+    return *s_ProxyCube;
+}
+
+void SceneNode::ReleaseProxy() {
+    if (!s_ProxyCube) return;
+    s_ProxyCube->Release();
+    s_ProxyCube.reset();
+}
+
+glm::mat4 SceneNode::ProxyTransform() const {
+    return m_WorldTransform *
+        glm::translate(glm::mat4(1.0f), m_LocalBounds.Center()) *
+        glm::scale(glm::mat4(1.0f), m_LocalBounds.Extent());
+}
+
+void SceneNode::DrawProxy(Shader& shader) {
+    shader.setMat4("model", ProxyTransform());
+    shader.setBool("useColorOnly", true);
+    shader.setVec3("diffuseColor", glm::vec3(0.35f));
+    ProxyCube().Draw(shader, m_Material);
+    shader.setBool("useColorOnly", false);
+}
+
+// 成员访问方法
 Material& SceneNode::GetMaterial() {
     return m_Material;
 }
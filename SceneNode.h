@@ -3,34 +3,87 @@
 #include <memory>
 #include <glm/glm.hpp>
 #include "Model.h"
-// Ԫ֧ͷļ 
+#include "Frustum.h"
+// 添加四元数支持头文件 
 #include <glm/gtc/quaternion.hpp>  
 #include "Material.h"
 class SceneNode {
 public:
     using Ptr = std::shared_ptr<SceneNode>;
 
+    // 深度绘制中延后处理的透明度测试节点（faceMask只用于分层绘制）
+    struct DepthCaster {
+        SceneNode* node = nullptr;
+        int faceMask = 0;
+    };
+    // 深度绘制统计
+    struct DepthStats {
+        int drawn = 0;          // 走位置流的节点
+        int culled = 0;         // 被光源视锥剔除的节点
+        int alphaTested = 0;    // 分到透明度测试组的节点
+    };
+
     SceneNode(const std::string& name);
 
-    // 任
+    // 变换方法
     void SetPosition(const glm::vec3& position);
     void SetRotation(float angle, const glm::vec3& axis);
     void SetScale(const glm::vec3& scale);
 
-    // ڵϵ
+    // 节点关系
     void AddChild(Ptr child);
     void RemoveChild(Ptr child);
 
-    // Ⱦ
+    // 渲染组件
     void AttachModel(std::shared_ptr<Model> model);
     void AddMesh(const Mesh& mesh);
 
-    // Ⱦ
+    // 懒加载：先只登记包围盒和烘焙资源路径，驻留前绘制低精度代理
+    void SetLazyModel(const std::string& path, const AABB& bounds);
+    bool IsModelPending() const { return !m_LazyPath.empty() && !m_Model; }
+    // 已向流送器提交加载请求（SetLazyModel时清除）
+    bool IsLoadRequested() const { return m_LoadRequested; }
+    void MarkLoadRequested() { m_LoadRequested = true; }
+    // 释放共享的代理立方体网格（程序退出、GL上下文销毁前调用）
+    static void ReleaseProxy();
+
+    // 阴影缓存：静态节点（默认）只渲染进缓存的静态阴影，运动的节点应设为非静态，每帧绘制在缓存之上
+    void SetStatic(bool isStatic);
+    bool IsStatic() const { return m_Static; }
+    bool HasGeometry() const { return m_Model || !m_Meshes.empty() || IsModelPending(); }
+    // 世界变换或几何自上次调用以来发生变化时，把缓存中登记的旧包围盒和新包围盒加入invalidated
+    void UpdateShadowCache(std::vector<AABB>& invalidated);
+    // 把本节点（不含子节点）已驻留几何的世界空间三角形追加到out，每3个顶点一个三角形，绕序按顶点法线朝外；CPU烘焙求交用
+    void AppendWorldTriangles(std::vector<glm::vec3>& out) const;
+
+    // 渲染方法
     void UpdateTransform(const glm::mat4& parentTransform);
-    void Draw(Shader& shader, const glm::mat4& parentTransform = glm::mat4(1.0f));
+    // lightmapped不为空时，已烘焙光照贴图的节点不在这里绘制，而是加入列表，由调用方用LIGHTMAPPED变体绘制
+    void Draw(Shader& shader, const glm::mat4& parentTransform = glm::mat4(1.0f),
+        std::vector<SceneNode*>* lightmapped = nullptr);
+    // 光照贴图绘制：绑定材质的光照贴图后绘制本节点（不含子节点），使用本帧已更新的世界变换
+    void DrawLightmapped(Shader& shader);
+    // 材质有光照贴图且全部网格都有光照贴图UV（模型热重载后UV丢失，退回动态光照）
+    bool IsLightmapped() const;
+    // 深度绘制：只绘制IsStatic() == staticCasters且与光源视锥相交的节点，使用本帧已更新的世界变换
+    // 不设置任何材质状态，只读位置流；透明度测试的节点放入alphaTested，由调用方用对应变体绘制
+    void DrawShadowCasters(Shader& shader, const Frustum& frustum, bool staticCasters,
+        std::vector<DepthCaster>& alphaTested, DepthStats& stats);
+    // 分层深度绘制（全部投射体）：按世界包围盒与各面视锥的相交结果设置faceMask，与所有面都不相交的节点跳过
+    void DrawShadowCastersLayered(Shader& shader, const Frustum faces[6],
+        std::vector<DepthCaster>& alphaTested, DepthStats& stats);
+    // 透明度测试的深度绘制（绑定漫反射纹理做alpha裁剪）
+    void DrawDepthAlphaTested(Shader& shader);
 
-    // ʷ
+    // 访问方法
     Material& GetMaterial();
+    std::shared_ptr<Model> GetModel() const { return m_Model; }
+    const std::string& GetName() const { return m_Name; }
+    const std::string& GetLazyPath() const { return m_LazyPath; }
+    const std::vector<Ptr>& GetChildren() const { return m_Children; }
+    // 本节点的全部网格（自有网格和模型网格，懒加载未驻留时为空）
+    std::vector<Mesh*> GetAllMeshes();
+    AABB GetWorldBounds() const { return m_LocalBounds.Transform(m_WorldTransform); }
     glm::mat4 GetWorldTransform() const;
     glm::mat4 GetLocalTransform() const;
 
@@ -46,4 +99,20 @@ private:
     std::shared_ptr<Model> m_Model;
     std::vector<Mesh> m_Meshes;
     Material m_Material;
+
+    std::string m_LazyPath;
+    bool m_LoadRequested = false;
+    AABB m_LocalBounds;
+
+    bool m_Static = true;
+    bool m_ShadowDirty = true;
+    AABB m_ShadowBounds;    // 已渲染进静态阴影缓存的世界包围盒
+
+    void DrawProxy(Shader& shader);
+    // 代理立方体（[-1,1]），所有待加载节点共享，首次使用时创建
+    static Mesh& ProxyCube();
+    // 纹理流送需要本节点到相机的距离和世界缩放
+    void SetStreamingContext() const;
+    glm::mat4 ProxyTransform() const;
+    void DrawDepthGeometry(Shader& shader);
 };
@@ -1,22 +1,28 @@
 #include "Shader.h"
 #include<iostream>
+#include <algorithm>
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath) {
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& defines,
+    const char* geometryPath)
+    : m_VertexPath(vertexPath), m_FragmentPath(fragmentPath), m_GeometryPath(geometryPath ? geometryPath : ""),
+    m_Defines(defines) {
 
-    // ʼ״̬־
+    // 初始化状态标志
+    ID = 0;
     m_CompileSuccess = true;
 
-    // 1. ȡļ
-    std::string vertexCode, fragmentCode;
-    std::ifstream vShaderFile, fShaderFile;
+    // 1. 读取文件内容
+    std::string vertexCode, fragmentCode, geometryCode;
+    std::ifstream vShaderFile, fShaderFile, gShaderFile;
 
 
-    // ȷifstream׳쳣
+    // 确保ifstream对象能抛出异常
     vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    gShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
 
     try {
-        // ļ  ȡ  ر
+        // 打开文件 → 读取 → 关闭
         vShaderFile.open(vertexPath);
         std::stringstream vShaderStream;
         vShaderStream << vShaderFile.rdbuf();
@@ -28,28 +34,47 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
         fShaderStream << fShaderFile.rdbuf();
         fragmentCode = fShaderStream.str();
         fShaderFile.close();
+
+        if (geometryPath) {
+            gShaderFile.open(geometryPath);
+            std::stringstream gShaderStream;
+            gShaderStream << gShaderFile.rdbuf();
+            geometryCode = gShaderStream.str();
+            gShaderFile.close();
+        }
     }
     catch (...) {
         std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
-        m_CompileSuccess = false;  // ʧ
-        return;  // ֱӷأ
+        m_CompileSuccess = false;  // 标记失败
+        return;  // 直接返回，避免后续操作
     }
 
+    // 展开#include（各阶段分别去重）
+    std::vector<std::string> vertexFiles, fragmentFiles, geometryFiles;
+    vertexCode = ResolveIncludes(vertexCode, m_VertexPath, 0, vertexFiles);
+    fragmentCode = ResolveIncludes(fragmentCode, m_FragmentPath, 0, fragmentFiles);
+    if (geometryPath)
+        geometryCode = ResolveIncludes(geometryCode, m_GeometryPath, 0, geometryFiles);
+    if (!m_CompileSuccess) return;
+
+    vertexCode = InjectDefines(vertexCode, defines);
+    fragmentCode = InjectDefines(fragmentCode, defines);
+    geometryCode = InjectDefines(geometryCode, defines);
     const char* vShaderCode = vertexCode.c_str();
     const char* fShaderCode = fragmentCode.c_str();
 
-    // 2. ɫ
+    // 2. 编译着色器
 
 
-    // ɫ
+    // 顶点着色器
     unsigned int vertex = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(vertex, 1, &vShaderCode, NULL);
     glCompileShader(vertex);
-    if (!checkCompileErrors(vertex, "VERTEX")) {  // ޸ļ麯ֵ
+    if (!checkCompileErrors(vertex, "VERTEX")) {  // 修改检查函数返回值
         m_CompileSuccess = false;
-        glDeleteShader(vertex);  // Դ
+        glDeleteShader(vertex);  // 立即清理资源
     }
-    // Ƭɫ
+    // 片段着色器
     unsigned int  fragment = glCreateShader(GL_FRAGMENT_SHADER);
     glShaderSource(fragment, 1, &fShaderCode, NULL);
     glCompileShader(fragment);
@@ -57,28 +82,142 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
         m_CompileSuccess = false;
         glDeleteShader(fragment);
     }
-    // һɫʧǰ
+    // 几何着色器（可选）
+    unsigned int geometry = 0;
+    if (geometryPath) {
+        const char* gShaderCode = geometryCode.c_str();
+        geometry = glCreateShader(GL_GEOMETRY_SHADER);
+        glShaderSource(geometry, 1, &gShaderCode, NULL);
+        glCompileShader(geometry);
+        if (!checkCompileErrors(geometry, "GEOMETRY")) {
+            m_CompileSuccess = false;
+            glDeleteShader(geometry);
+            geometry = 0;
+        }
+    }
+    // 如果任一着色器失败则提前返回
     if (!m_CompileSuccess) return;
 
-    // 3. ɫ
+    // 3. 链接着色器程序
     ID = glCreateProgram();
     glAttachShader(ID, vertex);
     glAttachShader(ID, fragment);
+    if (geometry) glAttachShader(ID, geometry);
     glLinkProgram(ID);
     if (!checkCompileErrors(ID, "PROGRAM")) {
         m_CompileSuccess = false;
-        glDeleteProgram(ID);  // ʧܵĳ
+        glDeleteProgram(ID);  // 清理失败的程序
     }
 
-    // 4. Դ
+    // 4. 清理资源
     glDeleteShader(vertex);
     glDeleteShader(fragment);
+    if (geometry) glDeleteShader(geometry);
+}
+
+// 逐行查找#include，被包含文件前后插入#line，编译错误的行号指向原文件
+std::string Shader::ResolveIncludes(const std::string& code, const std::string& path, int sourceIndex,
+    std::vector<std::string>& stageFiles) {
+    std::string dir;
+    size_t slash = path.find_last_of("/\\");
+    if (slash != std::string::npos) dir = path.substr(0, slash + 1);
+
+    std::istringstream in(code);
+    std::string result, line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+            result += line + "\n";
+            continue;
+        }
+
+        size_t open = line.find('"', start + 8);
+        size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+        if (close == std::string::npos) {
+            std::cerr << "ERROR::SHADER::BAD_INCLUDE: " << path << "(" << lineNumber << ")" << std::endl;
+            m_CompileSuccess = false;
+            result += "\n";
+            continue;
+        }
+        std::string file = dir + line.substr(open + 1, close - open - 1);
+        // 同一阶段已经展开过
+        if (std::find(stageFiles.begin(), stageFiles.end(), file) != stageFiles.end()) {
+            result += "\n";
+            continue;
+        }
+        stageFiles.push_back(file);
+
+        std::ifstream includeFile(file);
+        if (!includeFile.is_open()) {
+            std::cerr << "ERROR::SHADER::INCLUDE_NOT_FOUND: " << file << " (" << path << ")" << std::endl;
+            m_CompileSuccess = false;
+            result += "\n";
+            continue;
+        }
+        std::stringstream includeStream;
+        includeStream << includeFile.rdbuf();
+
+        auto known = std::find(m_Includes.begin(), m_Includes.end(), file);
+        int index = (int)(known - m_Includes.begin()) + 1;
+        if (known == m_Includes.end()) m_Includes.push_back(file);
+
+        result += "#line 1 " + std::to_string(index) + "\n";
+        result += ResolveIncludes(includeStream.str(), file, index, stageFiles);
+        result += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceIndex) + "\n";
+    }
+    return result;
+}
+
+// #version必须是第一条语句，宏插在它的下一行
+// "GLSL_VERSION n"不作为宏，而是把#version的版本号改为n（保留profile），供需要更高GLSL版本的变体使用
+std::string Shader::InjectDefines(const std::string& code, const std::vector<std::string>& defines) {
+    if (defines.empty()) return code;
+    const std::string versionPrefix = "GLSL_VERSION ";
+    std::string block;
+    std::string versionOverride;
+    for (const auto& define : defines) {
+        if (define.compare(0, versionPrefix.size(), versionPrefix) == 0)
+            versionOverride = define.substr(versionPrefix.size());
+        else
+            block += "#define " + define + "\n";
+    }
+
+    size_t version = code.find("#version");
+    if (version == std::string::npos) return block + code;
+    size_t lineEnd = code.find('\n', version);
+    if (lineEnd == std::string::npos) return code + "\n" + block;
+    std::string versionLine = code.substr(version, lineEnd - version);
+    if (!versionOverride.empty()) {
+        // "#version 330 core" -> "#version 400 core"
+        std::istringstream tokens(versionLine);
+        std::string directive, number, profile;
+        tokens >> directive >> number >> profile;
+        versionLine = "#version " + versionOverride + (profile.empty() ? "" : " " + profile);
+    }
+    return code.substr(0, version) + versionLine + "\n" + block + code.substr(lineEnd + 1);
 }
 
 void Shader::use() const {
     glUseProgram(ID);
 }
 
+bool Shader::Reload() {
+    Shader fresh(m_VertexPath.c_str(), m_FragmentPath.c_str(), m_Defines,
+        m_GeometryPath.empty() ? nullptr : m_GeometryPath.c_str());
+    if (!fresh.isCompiledSuccessfully()) {
+        std::cerr << "SHADER_RELOAD_FAILED: keeping previous program for "
+            << m_FragmentPath << std::endl;
+        return false;
+    }
+    if (m_CompileSuccess) glDeleteProgram(ID);
+    ID = fresh.ID;
+    m_Includes = fresh.m_Includes;
+    m_CompileSuccess = true;
+    return true;
+}
+
 void Shader::setFloat(const std::string& name, float value) const {
     glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
 }
@@ -92,7 +231,7 @@ void Shader::setVec3(const std::string& name, float x, float y, float z) const {
 }
 
 
-//// glm汾
+//// glm向量版本
 //void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
 //    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
 //}
@@ -105,8 +244,10 @@ bool Shader::checkCompileErrors(unsigned int shader, const std::string& type) {
         glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
         if (!success) {
             glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-            std::cerr << "SHADER_COMPILATION_ERROR: " << type << "\n" // std::
+            std::cerr << "SHADER_COMPILATION_ERROR: " << type << "\n" // 添加std::
                 << infoLog << std::endl;
+            for (size_t i = 0; i < m_Includes.size(); ++i)
+                std::cerr << "  source " << i + 1 << ": " << m_Includes[i] << std::endl;
             return false;
         }
     }
@@ -114,7 +255,7 @@ bool Shader::checkCompileErrors(unsigned int shader, const std::string& type) {
         glGetProgramiv(shader, GL_LINK_STATUS, &success);
         if (!success) {
             glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-            std::cerr << "PROGRAM_LINKING_ERROR\n" << infoLog << std::endl; // std::
+            std::cerr << "PROGRAM_LINKING_ERROR\n" << infoLog << std::endl; // 添加std::
             return false;
         }
     }
@@ -4,27 +4,41 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <vector>
 
 class Shader {
 public:
-    unsigned int ID; // ɫID
+    unsigned int ID; // 着色器程序ID
 
-    // 캯ܶ/Ƭɫļ·
-    Shader(const char* vertexPath, const char* fragmentPath);
+    // 构造函数：接受顶点/片段着色器文件路径
+    // defines为着色器变体的宏（"NAME"或"NAME VALUE"），插入到#version之后
+    // geometryPath可选，宏同样插入几何着色器
+    // 源文件中的 #include "文件" 按所在文件的目录展开，同一阶段中每个文件只展开一次（与#ifdef无关）
+    Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& defines = {},
+        const char* geometryPath = nullptr);
 
-    // ɫ
+    // 激活着色器程序
     void use() const;
 
-    // uniformߺ
+    // 热重载：重新编译源文件，成功后替换程序对象，失败则保留旧程序
+    bool Reload();
+    const std::string& GetVertexPath() const { return m_VertexPath; }
+    const std::string& GetFragmentPath() const { return m_FragmentPath; }
+    const std::string& GetGeometryPath() const { return m_GeometryPath; }   // 没有几何着色器时为空
+    const std::vector<std::string>& GetDefines() const { return m_Defines; }
+    // 展开的被包含文件；编译错误中的源字符串编号N对应第N - 1项（0为主文件）
+    const std::vector<std::string>& GetIncludes() const { return m_Includes; }
+
+    // uniform工具函数
     void setFloat(const std::string& name, float value) const;
     void setMat4(const std::string& name, const glm::mat4& mat) const;
 
     void setVec3(const std::string& name, float x, float y, float z) const;
-    //void setVec3(const std::string& name, const glm::vec3& value) const; // glm֧
+    //void setVec3(const std::string& name, const glm::vec3& value) const; // glm向量支持
     void setVec3(const std::string& name, const glm::vec3& value) const {
         glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
     }
-    // ĳ÷ã
+    // 补充的常用方法（后续开发可用）
     void setInt(const std::string& name, int value) const {
         glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
     }
@@ -33,15 +47,32 @@ public:
         glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
     }
 
+    void setVec2(const std::string& name, const glm::vec2& value) const {
+        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    }
+
+    void setVec4(const std::string& name, const glm::vec4& value) const {
+        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    }
+
     void setMat3(const std::string& name, const glm::mat3& mat) const {
         glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
     }
     bool isCompiledSuccessfully() const { return m_CompileSuccess; }
-    // ɫ/Ӵ
+    // 检查着色器编译/链接错误
     bool checkCompileErrors(unsigned int shader, const std::string& type);
     
 private:
 
 
-    bool m_CompileSuccess = false; // ״̬־
+    bool m_CompileSuccess = false; // 状态标志
+    std::string m_VertexPath;
+    std::string m_FragmentPath;
+    std::string m_GeometryPath;
+    std::vector<std::string> m_Defines;
+    std::vector<std::string> m_Includes;
+
+    std::string ResolveIncludes(const std::string& code, const std::string& path, int sourceIndex,
+        std::vector<std::string>& stageFiles);
+    static std::string InjectDefines(const std::string& code, const std::vector<std::string>& defines);
 };
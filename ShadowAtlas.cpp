@@ -0,0 +1,449 @@
+#include "ShadowAtlas.h"
+#include "ResidencyManager.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// 立方体各面的观察方向与上方向（与IBL捕获相同）
+static const glm::vec3 FACE_DIRECTIONS[6] = {
+    glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+    glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+    glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+};
+static const glm::vec3 FACE_UPS[6] = {
+    glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+    glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+    glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+};
+
+static const float SHADOW_NEAR = 0.1f;
+
+// 聚光灯tile的视场：外锥角再留出一点余量，锥体边缘的PCF采样不会落到tile外
+static float SpotFov(float cosOuter) {
+    return std::min(2.0f * std::acos(cosOuter) + glm::radians(4.0f), glm::radians(170.0f));
+}
+
+ShadowAtlas::ShadowAtlas(int atlasSize)
+    : m_AtlasSize((atlasSize > MAX_TILE_SIZE ? atlasSize / MAX_TILE_SIZE : 1) * MAX_TILE_SIZE) {
+    // 创建帧缓冲
+    glGenFramebuffers(1, &atlasFBO);
+
+    // 16位深度足够覆盖局部光源的范围
+    glGenTextures(1, &atlasTexture);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT16,
+        m_AtlasSize, m_AtlasSize, 0,
+        GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+
+    // 深度比较模式 + 线性过滤（硬件PCF），着色器把采样限制在tile内
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, atlasFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, atlasTexture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR::SHADOWATLAS: Framebuffer not complete!" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // tile表
+    for (int i = 0; i < MAX_TILES; ++i) {
+        m_Tiles[i].matrix = glm::mat4(1.0f);
+        m_Tiles[i].rect = glm::vec4(0.0f);
+        m_Tiles[i].params = glm::vec4(0.0f);
+    }
+    glGenBuffers(1, &tileUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, tileUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(m_Tiles), m_Tiles, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // 整张图集按最大tile划分为顶层空闲块
+    int blocks = m_AtlasSize / MAX_TILE_SIZE;
+    for (int y = blocks - 1; y >= 0; --y)
+        for (int x = blocks - 1; x >= 0; --x)
+            m_FreeBlocks[0].push_back(glm::ivec2(x * MAX_TILE_SIZE, y * MAX_TILE_SIZE));
+
+    ResidencyManager::Get().TrackTexture(atlasTexture,
+        ResidencyManager::TextureBytes(m_AtlasSize, m_AtlasSize, 2, false), "ShadowAtlas");
+}
+
+// ================== 光源 ==================
+int ShadowAtlas::AddLight(ShadowLightType type) {
+    ShadowLight light;
+    light.type = type;
+    m_Lights.push_back(light);
+    return (int)m_Lights.size() - 1;
+}
+
+int ShadowAtlas::AddSpotLight() {
+    return AddLight(ShadowLightType::Spot);
+}
+
+int ShadowAtlas::AddPointLight() {
+    return AddLight(ShadowLightType::Point);
+}
+
+void ShadowAtlas::SetSpotLight(int id, const SpotLight& light) {
+    ShadowLight& shadow = m_Lights[id];
+    glm::vec3 direction = glm::normalize(light.direction);
+    float range = std::min(AttenuationRange(light.constant, light.linear, light.quadratic, light.diffuse), maxRange);
+    if (shadow.position != light.position || shadow.direction != direction ||
+        shadow.cosOuter != light.outerCutOff || shadow.range != range)
+        shadow.dirty = true;
+    shadow.position = light.position;
+    shadow.direction = direction;
+    shadow.cosOuter = light.outerCutOff;
+    shadow.range = range;
+    shadow.intensity = std::max(light.diffuse.r, std::max(light.diffuse.g, light.diffuse.b));
+}
+
+void ShadowAtlas::SetPointLight(int id, const PointLight& light) {
+    ShadowLight& shadow = m_Lights[id];
+    float range = std::min(AttenuationRange(light.constant, light.linear, light.quadratic, light.diffuse), maxRange);
+    if (shadow.position != light.position || shadow.range != range)
+        shadow.dirty = true;
+    shadow.position = light.position;
+    shadow.range = range;
+    shadow.intensity = std::max(light.diffuse.r, std::max(light.diffuse.g, light.diffuse.b));
+}
+
+// ================== 分配 ==================
+int ShadowAtlas::DesiredTileSize(const ShadowLight& light, float coveragePixels) const {
+    // 点光源每个面只覆盖90度，边长取一半
+    float pixels = coveragePixels * resolutionScale * (light.type == ShadowLightType::Point ? 0.5f : 1.0f);
+    float level = std::log2(std::max(pixels, 1.0f));
+    // 滞后：与当前大小相差不到0.75级时保持不变，避免在边界处反复重新分配
+    if (light.tileSize > 0 && std::abs(level - std::log2((float)light.tileSize)) < 0.75f)
+        return light.tileSize;
+    int size = 1 << (int)std::lround(level);
+    if (size < MIN_TILE_SIZE) size = MIN_TILE_SIZE;
+    if (size > MAX_TILE_SIZE) size = MAX_TILE_SIZE;
+    return size;
+}
+
+bool ShadowAtlas::AllocateBlock(int level, glm::ivec2& pos) {
+    if (!m_FreeBlocks[level].empty()) {
+        pos = m_FreeBlocks[level].back();
+        m_FreeBlocks[level].pop_back();
+        return true;
+    }
+    if (level == 0) return false;
+
+    // 拆分上一级的块，剩余三块放回空闲表
+    glm::ivec2 parent;
+    if (!AllocateBlock(level - 1, parent)) return false;
+    int size = MAX_TILE_SIZE >> level;
+    m_FreeBlocks[level].push_back(parent + glm::ivec2(size, size));
+    m_FreeBlocks[level].push_back(parent + glm::ivec2(0, size));
+    m_FreeBlocks[level].push_back(parent + glm::ivec2(size, 0));
+    pos = parent;
+    return true;
+}
+
+void ShadowAtlas::FreeBlock(int level, const glm::ivec2& pos) {
+    std::vector<glm::ivec2>& blocks = m_FreeBlocks[level];
+    if (level > 0) {
+        // 四个兄弟块都空闲时合并回上一级
+        int size = MAX_TILE_SIZE >> level;
+        glm::ivec2 parent = (pos / (2 * size)) * (2 * size);
+        int found[3];
+        int count = 0;
+        for (int i = 0; i < 4; ++i) {
+            glm::ivec2 sibling = parent + glm::ivec2((i & 1) * size, (i >> 1) * size);
+            if (sibling == pos) continue;
+            auto it = std::find(blocks.begin(), blocks.end(), sibling);
+            if (it == blocks.end()) break;
+            found[count++] = (int)(it - blocks.begin());
+        }
+        if (count == 3) {
+            std::sort(found, found + 3);
+            for (int i = 2; i >= 0; --i)
+                blocks.erase(blocks.begin() + found[i]);
+            FreeBlock(level - 1, parent);
+            return;
+        }
+    }
+    blocks.push_back(pos);
+}
+
+bool ShadowAtlas::Allocate(ShadowLight& light, int tileSize) {
+    int faces = FaceCount(light);
+    int slot = -1;
+    for (int s = 0; s + faces <= MAX_TILES && slot < 0; ++s) {
+        bool free = true;
+        for (int f = 0; f < faces; ++f)
+            free = free && !m_SlotUsed[s + f];
+        if (free) slot = s;
+    }
+    if (slot < 0) return false;
+
+    int level = (int)std::lround(std::log2((float)(MAX_TILE_SIZE / tileSize)));
+    for (int f = 0; f < faces; ++f) {
+        if (!AllocateBlock(level, light.tiles[f])) {
+            for (int j = 0; j < f; ++j)
+                FreeBlock(level, light.tiles[j]);
+            return false;
+        }
+    }
+    for (int f = 0; f < faces; ++f)
+        m_SlotUsed[slot + f] = true;
+    light.firstSlot = slot;
+    light.tileSize = tileSize;
+    light.dirty = true;
+    light.rendered = false;
+    return true;
+}
+
+void ShadowAtlas::Release(ShadowLight& light) {
+    if (light.tileSize == 0) return;
+    int level = (int)std::lround(std::log2((float)(MAX_TILE_SIZE / light.tileSize)));
+    for (int f = 0; f < FaceCount(light); ++f) {
+        FreeBlock(level, light.tiles[f]);
+        m_SlotUsed[light.firstSlot + f] = false;
+    }
+    light.tileSize = 0;
+    light.firstSlot = -1;
+    light.rendered = false;
+    ++m_FreeEpoch;
+}
+
+void ShadowAtlas::Update(const glm::vec3& cameraPos, const glm::mat4& viewProjection, float fovY, int screenHeight,
+    const std::vector<AABB>& changedBounds, const std::vector<AABB>& dynamicBounds) {
+    ++m_Frame;
+    Frustum frustum = Frustum::FromMatrix(viewProjection);
+    float tanHalf = std::tan(fovY * 0.5f);
+
+    // 1. 重要性：光照范围在屏幕上的覆盖比例 * 亮度，不在视锥内的光源为0（保留已有tile，但不更新）
+    std::vector<float> coverage(m_Lights.size(), 0.0f);
+    std::vector<int> order;
+    for (size_t i = 0; i < m_Lights.size(); ++i) {
+        ShadowLight& light = m_Lights[i];
+        AABB bounds;
+        bounds.Expand(light.position - glm::vec3(light.range));
+        bounds.Expand(light.position + glm::vec3(light.range));
+        float distance = glm::length(cameraPos - light.position);
+        coverage[i] = distance <= light.range ? 1.0f : std::min(light.range / (distance * tanHalf), 1.0f);
+        bool visible = light.range > 0.0f && frustum.Intersects(bounds);
+        light.importance = visible ? coverage[i] * light.intensity : 0.0f;
+        order.push_back((int)i);
+
+        // 范围内有投射体变化时重绘
+        if (light.tileSize > 0 && !light.dirty) {
+            for (const AABB& box : changedBounds)
+                if (box.Intersects(bounds)) { light.dirty = true; break; }
+            for (const AABB& box : dynamicBounds)
+                if (!light.dirty && box.Intersects(bounds)) { light.dirty = true; break; }
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        return m_Lights[a].importance > m_Lights[b].importance;
+    });
+
+    // 2. 按重要性分配tile，放不下时降级，仍放不下时挤掉最不重要的光源
+    for (int id : order) {
+        ShadowLight& light = m_Lights[id];
+        if (light.importance <= 0.0f) continue;
+        int desired = DesiredTileSize(light, coverage[id] * (float)screenHeight);
+        if (light.tileSize == desired) continue;
+        if (light.tileSize > 0 && desired > light.tileSize) {
+            // 已有较小的tile：请求变化或之后释放过空间时才尝试更大的分配；成功后再释放原tile，失败时保持原tile（不重绘）
+            if (desired != light.requestedSize || light.allocEpoch != m_FreeEpoch) {
+                ShadowLight larger = light;
+                bool allocated = false;
+                for (int size = desired; size > light.tileSize && !allocated; size /= 2)
+                    allocated = Allocate(larger, size);
+                if (allocated) {
+                    Release(light);
+                    light = larger;
+                }
+                light.requestedSize = desired;
+                light.allocEpoch = m_FreeEpoch;
+            }
+            continue;
+        }
+        Release(light);
+
+        for (;;) {
+            bool allocated = false;
+            for (int size = desired; size >= MIN_TILE_SIZE && !allocated; size /= 2)
+                allocated = Allocate(light, size);
+            if (allocated) break;
+
+            int victim = -1;
+            for (auto it = order.rbegin(); it != order.rend(); ++it) {
+                const ShadowLight& other = m_Lights[*it];
+                if (*it != id && other.tileSize > 0 && other.importance < light.importance) {
+                    victim = *it;
+                    break;
+                }
+            }
+            if (victim < 0) break;
+            Release(m_Lights[victim]);
+        }
+        light.requestedSize = desired;
+        light.allocEpoch = m_FreeEpoch;
+    }
+}
+
+// ================== 渲染 ==================
+glm::mat4 ShadowAtlas::FaceMatrix(const ShadowLight& light, int face) const {
+    float farPlane = std::max(light.range, SHADOW_NEAR * 2.0f);
+    if (light.type == ShadowLightType::Point) {
+        glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, SHADOW_NEAR, farPlane);
+        return projection * glm::lookAt(light.position, light.position + FACE_DIRECTIONS[face], FACE_UPS[face]);
+    }
+    glm::vec3 up = std::abs(light.direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::mat4 projection = glm::perspective(SpotFov(light.cosOuter), 1.0f, SHADOW_NEAR, farPlane);
+    return projection * glm::lookAt(light.position, light.position + light.direction, up);
+}
+
+bool ShadowAtlas::LayeredAvailable() {
+    if (!m_LayeredChecked) {
+        m_LayeredChecked = true;
+        bool viewportArray = GLAD_GL_VERSION_4_1 != 0;
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+        for (GLint i = 0; i < extensionCount && !viewportArray; ++i) {
+            const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (name && std::strcmp(name, "GL_ARB_viewport_array") == 0) viewportArray = true;
+        }
+        if (viewportArray && glViewportIndexedf && glScissorIndexed) {
+            auto shader = std::make_unique<Shader>("shaders/depth.vert", "shaders/depth.frag",
+                std::vector<std::string>{ "LAYERED" }, "shaders/depth_cube.geom");
+            if (shader->isCompiledSuccessfully())
+                m_LayeredShader = std::move(shader);
+        }
+        if (!m_LayeredShader)
+            std::cout << "SHADOWATLAS: viewport arrays unavailable, point lights render one face per pass" << std::endl;
+    }
+    return m_LayeredShader != nullptr;
+}
+
+void ShadowAtlas::Render(Shader& depthShader, const std::function<void(Shader&, const glm::mat4&)>& drawScene,
+    const std::function<void(Shader&, const glm::mat4*)>& drawLayered) {
+    // 待更新的光源按 重要性 * 等待帧数 排序
+    std::vector<int> pending;
+    for (size_t i = 0; i < m_Lights.size(); ++i) {
+        const ShadowLight& light = m_Lights[i];
+        if (light.tileSize > 0 && light.importance > 0.0f && (light.dirty || !light.rendered))
+            pending.push_back((int)i);
+    }
+    m_TilesRendered = 0;
+    m_ScenePasses = 0;
+    if (pending.empty()) return;
+    std::sort(pending.begin(), pending.end(), [this](int a, int b) {
+        const ShadowLight& la = m_Lights[a];
+        const ShadowLight& lb = m_Lights[b];
+        return la.importance * (float)(m_Frame - la.lastRendered) > lb.importance * (float)(m_Frame - lb.lastRendered);
+    });
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLint previousFBO = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFBO);
+
+    bool layeredAvailable = layeredPointLights && drawLayered && LayeredAvailable();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, atlasFBO);
+    glEnable(GL_SCISSOR_TEST);
+    float invAtlas = 1.0f / (float)m_AtlasSize;
+    for (int id : pending) {
+        ShadowLight& light = m_Lights[id];
+        int faces = FaceCount(light);
+        // 至少更新一个光源，其余在预算内尽量多更新
+        if (m_TilesRendered > 0 && m_TilesRendered + faces > maxTileUpdates) continue;
+
+        bool layered = layeredAvailable && light.type == ShadowLightType::Point;
+        Shader& shader = layered ? *m_LayeredShader : depthShader;
+        shader.use();
+        glm::mat4 faceMatrices[6];
+        float tanHalf = light.type == ShadowLightType::Point ? 1.0f : std::tan(SpotFov(light.cosOuter) * 0.5f);
+        for (int f = 0; f < faces; ++f) {
+            glm::ivec2 pos = light.tiles[f];
+            glViewport(pos.x, pos.y, light.tileSize, light.tileSize);
+            glScissor(pos.x, pos.y, light.tileSize, light.tileSize);
+            glClear(GL_DEPTH_BUFFER_BIT);
+
+            TileData& tile = m_Tiles[light.firstSlot + f];
+            tile.matrix = FaceMatrix(light, f);
+            tile.rect = glm::vec4(light.tileSize * invAtlas, light.tileSize * invAtlas, pos.x * invAtlas, pos.y * invAtlas);
+            tile.params = glm::vec4(2.0f * tanHalf / (float)light.tileSize, 0.0f, 0.0f, 0.0f);
+            if (layered) {
+                faceMatrices[f] = tile.matrix;
+                shader.setMat4("faceMatrices[" + std::to_string(f) + "]", tile.matrix);
+            }
+            else {
+                shader.setMat4("lightSpaceMatrix", tile.matrix);
+                drawScene(shader, tile.matrix);
+                ++m_ScenePasses;
+            }
+        }
+        if (layered) {
+            // 面i使用视口/裁剪矩形i；之后的glViewport/glScissor会重新设置全部视口
+            for (int f = 0; f < faces; ++f) {
+                glm::ivec2 pos = light.tiles[f];
+                glViewportIndexedf(f, (float)pos.x, (float)pos.y, (float)light.tileSize, (float)light.tileSize);
+                glScissorIndexed(f, pos.x, pos.y, light.tileSize, light.tileSize);
+            }
+            drawLayered(shader, faceMatrices);
+            ++m_ScenePasses;
+        }
+        light.dirty = false;
+        light.rendered = true;
+        light.lastRendered = m_Frame;
+        m_TilesRendered += faces;
+    }
+    glDisable(GL_SCISSOR_TEST);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, tileUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(m_Tiles), m_Tiles);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFBO);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void ShadowAtlas::Apply(const Shader& shader) const {
+    glActiveTexture(GL_TEXTURE0 + ATLAS_UNIT);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    shader.setInt("shadowAtlas", ATLAS_UNIT);
+    GLuint block = glGetUniformBlockIndex(shader.ID, "ShadowTiles");
+    if (block != GL_INVALID_INDEX)
+        glUniformBlockBinding(shader.ID, block, UBO_BINDING);
+    glBindBufferBase(GL_UNIFORM_BUFFER, UBO_BINDING, tileUBO);
+}
+
+int ShadowAtlas::GetShadowTile(int id) const {
+    const ShadowLight& light = m_Lights[id];
+    return light.tileSize > 0 && light.rendered ? light.firstSlot : -1;
+}
+
+void ShadowAtlas::PrintStats() const {
+    int shadowed = 0;
+    size_t texels = 0;
+    for (const auto& light : m_Lights) {
+        if (light.tileSize == 0) continue;
+        ++shadowed;
+        texels += (size_t)FaceCount(light) * light.tileSize * light.tileSize;
+    }
+    std::cout << "SHADOW ATLAS: " << shadowed << " / " << m_Lights.size() << " lights shadowed | "
+        << (int)(100.0 * texels / ((double)m_AtlasSize * m_AtlasSize)) << "% of " << m_AtlasSize << "^2 used | "
+        << m_TilesRendered << " tiles redrawn in " << m_ScenePasses << " scene passes last frame"
+        << (m_LayeredShader ? " (layered point lights)" : "") << std::endl;
+}
+
+void ShadowAtlas::Cleanup() {
+    ResidencyManager::Get().UntrackTexture(atlasTexture);
+    glDeleteFramebuffers(1, &atlasFBO);
+    glDeleteTextures(1, &atlasTexture);
+    glDeleteBuffers(1, &tileUBO);
+    m_LayeredShader.reset();
+}
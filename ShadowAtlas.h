@@ -0,0 +1,117 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "Frustum.h"
+#include "Light.h"
+#include "Shader.h"
+
+enum class ShadowLightType { Spot, Point };
+
+// 点光源/聚光灯阴影图集：所有局部光源共享一张深度纹理，按光源动态分配正方形tile
+//   分配：四叉树伙伴分配器，tile边长MIN_TILE_SIZE..MAX_TILE_SIZE（2的幂），
+//         由光源在屏幕上的覆盖大小决定，重要性（覆盖 * 亮度）高的光源优先，空间不足时逐级降级或挤掉最不重要的光源
+//   聚光灯一个透视tile，点光源六个90度tile（立方体各面，面序与GL_TEXTURE_CUBE_MAP_POSITIVE_X起相同）
+//   更新：光源移动、tile重新分配、范围内有投射体变化时才重绘，每帧最多重绘maxTileUpdates个tile，
+//         按 重要性 * 等待帧数 排序，避免低优先级光源一直得不到更新
+//   单遍点光源：支持视口数组（GL 4.1 / ARB_viewport_array）时，六个面的tile设为视口0..5，
+//         几何着色器按gl_ViewportIndex把三角形发往各面，每个点光源只遍历一次场景；否则逐面绘制
+//   着色器：tile的矩阵和图集矩形放在ShadowTiles块（UBO），光源的shadowTile为首个tile下标，-1为无阴影
+class ShadowAtlas {
+public:
+    static const int MAX_TILES = 64;
+    static const int MAX_TILE_SIZE = 1024;
+    static const int MIN_TILE_SIZE = 64;
+    static const GLuint ATLAS_UNIT = 15;
+    static const GLuint UBO_BINDING = 1;    // 0为BindlessTextures的句柄表
+
+    GLuint atlasFBO = 0;
+    GLuint atlasTexture = 0;
+    GLuint tileUBO = 0;
+
+    int maxTileUpdates = 12;        // 每帧最多重绘的tile数（点光源一次6个）
+    float resolutionScale = 1.0f;   // 屏幕覆盖像素 -> tile边长
+    float maxRange = 25.0f;         // 阴影远平面上限
+    bool layeredPointLights = true; // 点光源六个面单遍渲染（不支持时自动退回逐面绘制）
+
+    // atlasSize为MAX_TILE_SIZE的整数倍；16位深度，4096^2 = 32MB
+    explicit ShadowAtlas(int atlasSize = 4096);
+
+    // 登记投射阴影的光源，返回光源编号；每帧用Set*更新光源参数
+    int AddSpotLight();
+    int AddPointLight();
+    void SetSpotLight(int id, const SpotLight& light);
+    void SetPointLight(int id, const PointLight& light);
+
+    // 每帧：计算光源重要性并分配tile；changedBounds为变化的静态投射体，dynamicBounds为每帧运动的投射体
+    void Update(const glm::vec3& cameraPos, const glm::mat4& viewProjection, float fovY, int screenHeight,
+        const std::vector<AABB>& changedBounds, const std::vector<AABB>& dynamicBounds);
+    // 按预算重绘tile；drawScene用传入的深度着色器绘制全部投射体（已设置lightSpaceMatrix，第二个参数为同一矩阵）
+    // drawLayered：点光源单遍绘制全部投射体，参数为分层着色器和六个面的矩阵（已设置faceMatrices，用于逐节点剔除）
+    void Render(Shader& depthShader, const std::function<void(Shader&, const glm::mat4&)>& drawScene,
+        const std::function<void(Shader&, const glm::mat4*)>& drawLayered = nullptr);
+    // 绑定图集（shadowAtlas）和ShadowTiles块
+    void Apply(const Shader& shader) const;
+    // 光源的首个tile下标，尚未渲染或没有分配时为-1
+    int GetShadowTile(int id) const;
+
+    void PrintStats() const;
+    void Cleanup();
+
+private:
+    static const int LEVELS = 5;    // 1024, 512, 256, 128, 64
+
+    struct ShadowLight {
+        ShadowLightType type = ShadowLightType::Spot;
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+        float cosOuter = 0.0f;
+        float range = 0.0f;
+        float intensity = 0.0f;
+
+        float importance = 0.0f;
+        int tileSize = 0;               // 每个面的边长，0为没有分配
+        int requestedSize = 0;          // 上次分配时请求的边长，空间不足时大于tileSize
+        uint64_t allocEpoch = 0;        // 上次分配后的m_FreeEpoch
+        glm::ivec2 tiles[6];            // 图集中的像素位置
+        int firstSlot = -1;             // ShadowTiles中的下标
+        bool dirty = true;              // 需要重绘
+        bool rendered = false;          // 当前分配的tile已经渲染过
+        uint64_t lastRendered = 0;
+    };
+
+    // std140：每个tile一个矩阵、一个图集矩形（缩放xy、偏移zw）、一组参数
+    struct TileData {
+        glm::mat4 matrix;
+        glm::vec4 rect;
+        glm::vec4 params;   // x: 单位距离上一个纹素的世界尺寸（法线偏移用）
+    };
+
+    int m_AtlasSize;
+    std::vector<ShadowLight> m_Lights;
+    std::vector<glm::ivec2> m_FreeBlocks[LEVELS];
+    bool m_SlotUsed[MAX_TILES] = {};
+    TileData m_Tiles[MAX_TILES];
+    uint64_t m_Frame = 0;
+    uint64_t m_FreeEpoch = 0;   // 每次释放tile时递增，空闲空间没有变化时不重试更大的分配
+    int m_TilesRendered = 0;    // 上一帧重绘的tile数
+    int m_ScenePasses = 0;      // 上一帧遍历场景的次数
+
+    // 分层渲染（depth.vert LAYERED + depth_cube.geom），首次使用时创建
+    std::unique_ptr<Shader> m_LayeredShader;
+    bool m_LayeredChecked = false;
+
+    int AddLight(ShadowLightType type);
+    int FaceCount(const ShadowLight& light) const { return light.type == ShadowLightType::Point ? 6 : 1; }
+    int DesiredTileSize(const ShadowLight& light, float coveragePixels) const;
+    bool Allocate(ShadowLight& light, int tileSize);
+    void Release(ShadowLight& light);
+    bool AllocateBlock(int level, glm::ivec2& pos);
+    void FreeBlock(int level, const glm::ivec2& pos);
+    glm::mat4 FaceMatrix(const ShadowLight& light, int face) const;
+    // 视口数组可用且分层着色器编译成功
+    bool LayeredAvailable();
+};
@@ -0,0 +1,397 @@
+#include "ShadowMapper.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// EXT_texture_filter_anisotropic（glad未生成）
+#ifndef GL_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_TEXTURE_MAX_ANISOTROPY_EXT 0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
+#endif
+
+// 深度纹理数组及其帧缓冲，实际阴影与静态缓存格式相同（拷贝用glBlitFramebuffer）
+static void CreateDepthArray(GLsizei width, GLsizei height, GLsizei layers, GLuint& texture, GLuint& fbo) {
+    // 创建帧缓冲
+    glGenFramebuffers(1, &fbo);
+
+    // 创建深度纹理数组，每层一个级联
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24,
+        width, height, layers, 0,
+        GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+
+    // 深度比较模式 + 线性过滤：着色器中每次采样即为硬件2x2 PCF
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+
+    // 绑定帧缓冲（先挂第0层检查完整性，渲染时逐层切换）
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+
+    // 检查帧缓冲完整性
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR::SHADOWMAPPER: Framebuffer not complete!" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+ShadowMapper::ShadowMapper() {
+    // 检查OpenGL上下文
+    if (!gladLoadGL()) {
+        std::cerr << "ERROR::SHADOWMAPPER: GLAD not initialized!" << std::endl;
+        return;
+    }
+
+    CreateDepthArray(SHADOW_WIDTH, SHADOW_HEIGHT, CASCADE_COUNT, depthMap, depthMapFBO);
+    for (int i = 0; i < CASCADE_COUNT; ++i)
+        m_LightSpace[i] = glm::mat4(1.0f);
+
+    ResidencyManager::Get().TrackTexture(depthMap,
+        ResidencyManager::TextureBytes(SHADOW_WIDTH, SHADOW_HEIGHT, 4, false) * CASCADE_COUNT, "ShadowMapper");
+}
+
+void ShadowMapper::CreateStaticCache() {
+    CreateDepthArray(SHADOW_WIDTH, SHADOW_HEIGHT, CASCADE_COUNT, staticDepthMap, staticDepthMapFBO);
+    ResidencyManager::Get().TrackTexture(staticDepthMap,
+        ResidencyManager::TextureBytes(SHADOW_WIDTH, SHADOW_HEIGHT, 4, false) * CASCADE_COUNT, "ShadowMapper static cache");
+}
+
+void ShadowMapper::CreateMoments() {
+    // 矩数组：RGBA16F，三线性过滤 + 各向异性
+    int levels = 1;
+    while ((SHADOW_WIDTH >> levels) > 0) ++levels;
+    glGenTextures(1, &momentsMap);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, momentsMap);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA16F, SHADOW_WIDTH, SHADOW_HEIGHT, CASCADE_COUNT, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (name && (std::strcmp(name, "GL_EXT_texture_filter_anisotropic") == 0 ||
+            std::strcmp(name, "GL_ARB_texture_filter_anisotropic") == 0)) {
+            float maxAnisotropy = 1.0f;
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+            glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_ANISOTROPY_EXT, std::min(maxAnisotropy, 8.0f));
+            break;
+        }
+    }
+
+    // 水平模糊的中间结果
+    glGenTextures(1, &m_BlurTexture);
+    glBindTexture(GL_TEXTURE_2D, m_BlurTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenFramebuffers(1, &m_MomentsFBO);
+    glGenVertexArrays(1, &m_EmptyVAO);
+    m_MomentsShader = std::make_unique<Shader>("shaders/fullscreen.vert", "shaders/evsm_blur.frag",
+        std::vector<std::string>{ "FROM_DEPTH" });
+    m_BlurShader = std::make_unique<Shader>("shaders/fullscreen.vert", "shaders/evsm_blur.frag");
+    m_MomentsValid = false;
+
+    ResidencyManager::Get().TrackTexture(momentsMap,
+        ResidencyManager::TextureBytes(SHADOW_WIDTH, SHADOW_HEIGHT, 8, true) * CASCADE_COUNT, "ShadowMapper EVSM");
+    ResidencyManager::Get().TrackTexture(m_BlurTexture,
+        ResidencyManager::TextureBytes(SHADOW_WIDTH, SHADOW_HEIGHT, 8, false), "ShadowMapper EVSM blur");
+}
+
+void ShadowMapper::UpdateCascades(const glm::mat4& view, float fovY, float aspect, float nearPlane, float farPlane,
+    const glm::vec3& lightDir, const std::vector<AABB>& casters) {
+    float n = nearPlane;
+    float f = std::min(farPlane, shadowDistance);
+    float tanY = std::tan(fovY * 0.5f);
+    float tanX = tanY * aspect;
+    glm::mat4 invView = glm::inverse(view);
+
+    // 光源视图只含旋转（原点处朝向光照方向），平移全部放进正交投影，便于按纹素对齐
+    glm::vec3 dir = glm::normalize(lightDir);
+    glm::vec3 up = std::abs(dir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), dir, up);
+    // 光照方向变化时所有级联重新拟合
+    bool lightChanged = dir != m_LightDir;
+    m_LightDir = dir;
+    m_LightView = lightView;
+
+    // 投射体包围盒转换到光源空间，各级共用
+    std::vector<AABB> lightCasters;
+    lightCasters.reserve(casters.size());
+    for (const AABB& box : casters)
+        if (box.IsValid()) lightCasters.push_back(box.Transform(lightView));
+
+    float prevSplit = n;
+    for (int i = 0; i < CASCADE_COUNT; ++i) {
+        // 对数划分与均匀划分的混合
+        float p = (float)(i + 1) / CASCADE_COUNT;
+        float logSplit = n * std::pow(f / n, p);
+        float uniformSplit = n + (f - n) * p;
+        float split = splitLambda * logSplit + (1.0f - splitLambda) * uniformSplit;
+
+        // 子视锥8个角点（视空间），外接球与相机朝向无关，旋转相机时投影大小不变
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        for (int c = 0; c < 8; ++c) {
+            float depth = (c & 4) ? split : prevSplit;
+            corners[c] = glm::vec3(((c & 1) ? 1.0f : -1.0f) * tanX * depth,
+                ((c & 2) ? 1.0f : -1.0f) * tanY * depth, -depth);
+            center += corners[c];
+        }
+        center /= 8.0f;
+        float radius = 0.0f;
+        for (int c = 0; c < 8; ++c)
+            radius = std::max(radius, glm::length(corners[c] - center));
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        // 深度范围：光源空间朝向光源为+z，外接球之外向光源方向扩展到覆盖XY范围内的投射体
+        glm::vec3 centerLS = glm::vec3(lightView * invView * glm::vec4(center, 1.0f));
+        float zNear = centerLS.z + radius, zFar = centerLS.z - radius;
+        for (const AABB& box : lightCasters) {
+            if (box.max.x < centerLS.x - radius || box.min.x > centerLS.x + radius ||
+                box.max.y < centerLS.y - radius || box.min.y > centerLS.y + radius ||
+                box.max.z < zFar)
+                continue;
+            zNear = std::max(zNear, box.max.z);
+        }
+
+        // 新范围仍在上次的余量内时沿用上次的投影，静态缓存保持有效
+        CascadeFit& fit = m_Fit[i];
+        float margin = cacheStatic ? radius * cachePadding : 0.0f;
+        bool reuse = fit.valid && !lightChanged && fit.radius == radius &&
+            std::abs(centerLS.x - fit.center.x) <= fit.extent - radius &&
+            std::abs(centerLS.y - fit.center.y) <= fit.extent - radius &&
+            zNear <= fit.zNear && zFar >= fit.zFar;
+        if (!reuse) {
+            // 中心按纹素对齐：重新拟合时阴影贴图只整纹素移动
+            fit.radius = radius;
+            fit.extent = radius + margin;
+            float texel = 2.0f * fit.extent / (float)SHADOW_WIDTH;
+            fit.center.x = std::floor(centerLS.x / texel) * texel;
+            fit.center.y = std::floor(centerLS.y / texel) * texel;
+            fit.zNear = zNear + margin;
+            fit.zFar = zFar - margin;
+            fit.valid = true;
+            m_StaticValid[i] = false;
+        }
+
+        glm::mat4 lightProjection = glm::ortho(fit.center.x - fit.extent, fit.center.x + fit.extent,
+            fit.center.y - fit.extent, fit.center.y + fit.extent, -fit.zNear, -fit.zFar);
+        m_LightSpace[i] = lightProjection * lightView;
+        m_Splits[i] = split;
+        // 一个纹素在[0,1]深度中的跨度，着色器再按表面倾斜放大
+        m_Bias[i] = 1.5f * (2.0f * fit.extent / (float)SHADOW_WIDTH) / (fit.zNear - fit.zFar);
+        prevSplit = split;
+    }
+}
+
+void ShadowMapper::InvalidateStatic(const std::vector<AABB>& changedBounds) {
+    for (const AABB& bounds : changedBounds) {
+        if (!bounds.IsValid()) continue;
+        AABB box = bounds.Transform(m_LightView);
+        for (int i = 0; i < CASCADE_COUNT; ++i) {
+            const CascadeFit& fit = m_Fit[i];
+            if (!fit.valid || !m_StaticValid[i]) continue;
+            if (box.max.x < fit.center.x - fit.extent || box.min.x > fit.center.x + fit.extent ||
+                box.max.y < fit.center.y - fit.extent || box.min.y > fit.center.y + fit.extent ||
+                box.max.z < fit.zFar)
+                continue;
+            m_StaticValid[i] = false;
+        }
+    }
+}
+
+void ShadowMapper::RenderCascades(Shader& depthShader, const std::function<void(Shader&, const glm::mat4&)>& drawStatic,
+    const std::function<void(Shader&, const glm::mat4&)>& drawDynamic) {
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLint previousFBO = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFBO);
+
+    if (cacheStatic && !staticDepthMap)
+        CreateStaticCache();
+
+    glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+    depthShader.use();
+    for (int i = 0; i < CASCADE_COUNT; ++i) {
+        depthShader.setMat4("lightSpaceMatrix", m_LightSpace[i]);
+
+        if (!cacheStatic) {
+            glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthMap, 0, i);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            drawStatic(depthShader, m_LightSpace[i]);
+            if (drawDynamic) drawDynamic(depthShader, m_LightSpace[i]);
+            m_LiveIsCopy[i] = false;
+            m_LayerChanged[i] = true;
+            continue;
+        }
+
+        // 1. 静态缓存失效时重绘
+        if (!m_StaticValid[i]) {
+            glBindFramebuffer(GL_FRAMEBUFFER, staticDepthMapFBO);
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, staticDepthMap, 0, i);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            drawStatic(depthShader, m_LightSpace[i]);
+            m_StaticValid[i] = true;
+            m_LiveIsCopy[i] = false;
+            ++m_StaticRedraws;
+        }
+
+        // 2. 实际阴影层与缓存不同（上一帧画过动态投射体或缓存刚更新）时拷贝
+        if (!m_LiveIsCopy[i]) {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, staticDepthMapFBO);
+            glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, staticDepthMap, 0, i);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, depthMapFBO);
+            glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthMap, 0, i);
+            glBlitFramebuffer(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT, 0, 0, SHADOW_WIDTH, SHADOW_HEIGHT,
+                GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            m_LiveIsCopy[i] = true;
+            m_LayerChanged[i] = true;
+        }
+
+        // 3. 动态投射体与缓存的深度合并
+        if (drawDynamic) {
+            glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthMap, 0, i);
+            drawDynamic(depthShader, m_LightSpace[i]);
+            m_LiveIsCopy[i] = false;
+            m_LayerChanged[i] = true;
+        }
+    }
+
+    if (filter == ShadowFilter::EVSM)
+        UpdateMoments();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFBO);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void ShadowMapper::UpdateMoments() {
+    if (!momentsMap) CreateMoments();
+    bool changed = !m_MomentsValid;
+    for (int i = 0; i < CASCADE_COUNT; ++i)
+        changed = changed || m_LayerChanged[i];
+    if (!changed) return;
+
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    glDisable(GL_DEPTH_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_MomentsFBO);
+    glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+    glBindVertexArray(m_EmptyVAO);
+
+    // 读取原始深度时临时关闭比较模式
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthMap);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_BlurTexture);
+
+    glm::vec2 texel(1.0f / SHADOW_WIDTH, 1.0f / SHADOW_HEIGHT);
+    for (int i = 0; i < CASCADE_COUNT; ++i) {
+        if (m_MomentsValid && !m_LayerChanged[i]) continue;
+
+        // 1. 深度 -> 矩 + 水平模糊
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_BlurTexture, 0);
+        m_MomentsShader->use();
+        m_MomentsShader->setInt("depthMap", 0);
+        m_MomentsShader->setFloat("layer", (float)i);
+        m_MomentsShader->setVec2("exponents", evsmExponents);
+        m_MomentsShader->setVec2("direction", glm::vec2(texel.x, 0.0f));
+        m_MomentsShader->setInt("radius", evsmBlurRadius);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        // 2. 竖直模糊，写入矩数组的对应层
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, momentsMap, 0, i);
+        m_BlurShader->use();
+        m_BlurShader->setInt("source", 1);
+        m_BlurShader->setVec2("direction", glm::vec2(0.0f, texel.y));
+        m_BlurShader->setInt("radius", evsmBlurRadius);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        m_LayerChanged[i] = false;
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, momentsMap);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    glBindVertexArray(0);
+    if (depthTest) glEnable(GL_DEPTH_TEST);
+    m_MomentsValid = true;
+}
+
+const char* ShadowMapper::FilterName(ShadowFilter filter) {
+    switch (filter) {
+    case ShadowFilter::Hard: return "Hard (1 tap)";
+    case ShadowFilter::PCF3x3: return "PCF 3x3";
+    case ShadowFilter::PCF5x5: return "PCF 5x5";
+    case ShadowFilter::EVSM: return "EVSM";
+    }
+    return "Unknown";
+}
+
+void ShadowMapper::Apply(const Shader& shader) const {
+    glActiveTexture(GL_TEXTURE0 + CASCADE_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthMap);
+    shader.setInt("shadowMap", CASCADE_UNIT);
+    shader.setInt("cascadeCount", CASCADE_COUNT);
+    // 矩数组尚未生成时退回PCF 5x5；采样器总是指向自己的单元，避免与其他类型的采样器共用单元0
+    bool evsm = filter == ShadowFilter::EVSM && momentsMap;
+    shader.setInt("shadowFilter", evsm ? (int)ShadowFilter::EVSM : (int)(filter == ShadowFilter::EVSM ? ShadowFilter::PCF5x5 : filter));
+    shader.setInt("shadowMoments", MOMENTS_UNIT);
+    if (evsm) {
+        glActiveTexture(GL_TEXTURE0 + MOMENTS_UNIT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, momentsMap);
+        shader.setVec2("evsmExponents", evsmExponents);
+        shader.setFloat("evsmBleedReduction", evsmBleedReduction);
+    }
+    for (int i = 0; i < CASCADE_COUNT; ++i) {
+        std::string index = "[" + std::to_string(i) + "]";
+        shader.setMat4("lightSpaceMatrices" + index, m_LightSpace[i]);
+        shader.setFloat("cascadeSplits" + index, m_Splits[i]);
+        shader.setFloat("cascadeBias" + index, m_Bias[i]);
+    }
+}
+
+void ShadowMapper::Cleanup() {
+    ResidencyManager::Get().UntrackTexture(depthMap);
+    glDeleteFramebuffers(1, &depthMapFBO);
+    glDeleteTextures(1, &depthMap);
+    if (momentsMap) {
+        ResidencyManager::Get().UntrackTexture(momentsMap);
+        ResidencyManager::Get().UntrackTexture(m_BlurTexture);
+        glDeleteFramebuffers(1, &m_MomentsFBO);
+        glDeleteTextures(1, &momentsMap);
+        glDeleteTextures(1, &m_BlurTexture);
+        glDeleteVertexArrays(1, &m_EmptyVAO);
+        m_MomentsShader.reset();
+        m_BlurShader.reset();
+    }
+    if (staticDepthMap) {
+        ResidencyManager::Get().UntrackTexture(staticDepthMap);
+        glDeleteFramebuffers(1, &staticDepthMapFBO);
+        glDeleteTextures(1, &staticDepthMap);
+    }
+}
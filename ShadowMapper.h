@@ -1,58 +1,106 @@
 #pragma once
 #include <glad/glad.h>
 #include <glm/glm.hpp>
-#include <iostream> // Ӵ
+#include <functional>
+#include <iostream> // 添加错误输出
+#include <memory>
+#include <vector>
+#include "Frustum.h"
+#include "ResidencyManager.h"
+#include "Shader.h"
+
+// 平行光级联阴影（CSM）：CASCADE_COUNT级深度存放在一个GL_TEXTURE_2D_ARRAY中
+//   划分：对数/线性混合（practical split），splitLambda越大近处级联越细
+//   拟合：每级用相机子视锥的外接球确定正交投影的XY范围（随相机旋转不变），
+//         中心按阴影纹素对齐，相机平移时阴影边缘不闪烁；深度范围向光源方向扩展到覆盖投射体包围盒
+//   选择：shader.frag/pbr.frag按片段的视空间深度与cascadeSplits比较
+//   缓存：静态投射体渲染进单独的深度数组并跨帧保留，每帧拷贝到实际阴影数组后只绘制动态投射体；
+//         级联投影在外接球留有cachePadding余量，相机小范围移动时保持不变，
+//         只有投影变化或有静态投射体在其范围内变化时才重绘该级的静态缓存
+// 阴影过滤方式，着色器中的shadowFilter与之对应
+//   Hard/PCF3x3/PCF5x5：比较采样（硬件2x2 PCF）1/9/25次
+//   EVSM：指数方差阴影，深度转换为矩后做可分离高斯模糊并生成mip，着色器只做一次三线性/各向异性采样，
+//         开销与模糊半径无关；深度层没有变化的级联不重新转换
+enum class ShadowFilter { Hard = 0, PCF3x3, PCF5x5, EVSM };
 
 class ShadowMapper {
 public:
+    static const int CASCADE_COUNT = 4;
+    static const GLuint CASCADE_UNIT = 7;   // 阴影数组绑定的纹理单元（材质纹理从0开始占用）
+    static const GLuint MOMENTS_UNIT = 6;   // EVSM矩数组
+
     GLuint depthMapFBO = 0;
-    GLuint depthMap = 0;
-    const GLuint SHADOW_WIDTH = 2048, SHADOW_HEIGHT = 2048;
-
-    ShadowMapper() {
-        // OpenGL
-        if (!gladLoadGL()) {
-            std::cerr << "ERROR::SHADOWMAPPER: GLAD not initialized!" << std::endl;
-            return;
-        }
-
-        // ֡
-        glGenFramebuffers(1, &depthMapFBO);
-
-        // 
-        glGenTextures(1, &depthMap);
-        glBindTexture(GL_TEXTURE_2D, depthMap);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT,
-            SHADOW_WIDTH, SHADOW_HEIGHT, 0,
-            GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-
-        // ȱȽģʽ
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-        float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-
-        // ֡
-        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
-            GL_TEXTURE_2D, depthMap, 0);
-        glDrawBuffer(GL_NONE);
-        glReadBuffer(GL_NONE);
-
-        // ֡
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-            std::cerr << "ERROR::SHADOWMAPPER: Framebuffer not complete!" << std::endl;
-        }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    }
-
-    void Cleanup() {
-        glDeleteFramebuffers(1, &depthMapFBO);
-        glDeleteTextures(1, &depthMap);
-    }
+    GLuint depthMap = 0;                     // GL_TEXTURE_2D_ARRAY，每层一个级联
+    const GLuint SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024;   // 每级分辨率，4级总量与原2048^2单张相同
+
+    GLuint staticDepthMapFBO = 0;
+    GLuint staticDepthMap = 0;               // 静态投射体的缓存（首次使用时创建）
+
+    float splitLambda = 0.75f;      // 0 = 均匀划分，1 = 对数划分
+    float shadowDistance = 60.0f;   // 阴影覆盖的最远视距
+    bool cacheStatic = true;        // 关闭时每帧重绘全部投射体
+    float cachePadding = 0.2f;      // 级联范围相对外接球半径的余量，越大缓存越稳定、有效分辨率越低
+
+    ShadowFilter filter = ShadowFilter::PCF5x5;
+    int evsmBlurRadius = 3;                 // 模糊半径（纹素），只影响阴影贴图分辨率下的模糊开销
+    glm::vec2 evsmExponents = glm::vec2(5.54f, 5.54f);  // RGBA16F下不溢出的最大指数
+    float evsmBleedReduction = 0.2f;        // 漏光抑制：低于该值的受光比例截断为0
+    GLuint momentsMap = 0;                  // EVSM矩（RGBA16F数组，带mip），首次使用时创建
+
+    ShadowMapper();
+
+    // 每帧：按相机子视锥和投射体包围盒（世界空间）计算各级光源矩阵
+    void UpdateCascades(const glm::mat4& view, float fovY, float aspect, float nearPlane, float farPlane,
+        const glm::vec3& lightDir, const std::vector<AABB>& casters);
+    // 静态投射体变化（世界包围盒）：与之重叠的级联在下次渲染时重绘静态缓存
+    void InvalidateStatic(const std::vector<AABB>& changedBounds);
+    // 逐级渲染深度：drawStatic/drawDynamic用传入的深度着色器绘制静态/动态投射体（已设置lightSpaceMatrix，
+    // 第二个参数为同一矩阵，用于剔除），drawStatic只在缓存失效时调用；没有动态投射体时drawDynamic传空
+    void RenderCascades(Shader& depthShader, const std::function<void(Shader&, const glm::mat4&)>& drawStatic,
+        const std::function<void(Shader&, const glm::mat4&)>& drawDynamic);
+    // 绑定阴影数组（EVSM模式下另外绑定矩数组）并设置lightSpaceMatrices/cascadeSplits/cascadeBias/cascadeCount/shadowFilter
+    void Apply(const Shader& shader) const;
+    static const char* FilterName(ShadowFilter filter);
+
+    const glm::mat4& GetLightSpaceMatrix(int cascade) const { return m_LightSpace[cascade]; }
+    float GetSplit(int cascade) const { return m_Splits[cascade]; }
+    // 累计重绘静态缓存的级联次数
+    int GetStaticRedraws() const { return m_StaticRedraws; }
+
+    void Cleanup();
+
+private:
+    // 光源空间中的级联范围，相机移动不超出余量时沿用
+    struct CascadeFit {
+        glm::vec2 center = glm::vec2(0.0f);
+        float radius = 0.0f;    // 子视锥外接球半径（不含余量）
+        float extent = 0.0f;    // 正交投影半宽（含余量）
+        float zNear = 0.0f, zFar = 0.0f;
+        bool valid = false;
+    };
+
+    CascadeFit m_Fit[CASCADE_COUNT];
+    bool m_StaticValid[CASCADE_COUNT] = {};  // 静态缓存与当前投影一致
+    bool m_LiveIsCopy[CASCADE_COUNT] = {};   // 实际阴影层与静态缓存相同（上一帧没有绘制动态投射体）
+    glm::vec3 m_LightDir = glm::vec3(0.0f);
+    glm::mat4 m_LightView = glm::mat4(1.0f);
+    int m_StaticRedraws = 0;
+    bool m_LayerChanged[CASCADE_COUNT] = {};  // 本帧深度层有变化，需要重新生成EVSM矩
+
+    // EVSM资源
+    GLuint m_MomentsFBO = 0;
+    GLuint m_BlurTexture = 0;               // 水平模糊的中间结果（单层）
+    GLuint m_EmptyVAO = 0;
+    bool m_MomentsValid = false;
+    std::unique_ptr<Shader> m_MomentsShader;   // 深度 -> 矩 + 水平模糊
+    std::unique_ptr<Shader> m_BlurShader;      // 竖直模糊
+
+    glm::mat4 m_LightSpace[CASCADE_COUNT];
+    float m_Splits[CASCADE_COUNT] = {};   // 各级的远端视空间深度
+    float m_Bias[CASCADE_COUNT] = {};     // 各级一个纹素对应的深度增量（NDC [0,1]）
+
+    void CreateStaticCache();
+    void CreateMoments();
+    // 深度层转换为指数矩、可分离模糊并生成mip
+    void UpdateMoments();
 };
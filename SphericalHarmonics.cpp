@@ -0,0 +1,212 @@
+#include "SphericalHarmonics.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define SH_USE_SSE 1
+#endif
+
+static const float PI = 3.14159265359f;
+
+// 实数球谐基函数常数（l=0..2）
+static const float SH_C0 = 0.282095f;
+static const float SH_C1 = 0.488603f;
+static const float SH_C2 = 1.092548f;
+static const float SH_C3 = 0.315392f;
+static const float SH_C4 = 0.546274f;
+
+static void EvaluateBasis(float x, float y, float z, float basis[9]) {
+    basis[0] = SH_C0;
+    basis[1] = SH_C1 * y;
+    basis[2] = SH_C1 * z;
+    basis[3] = SH_C1 * x;
+    basis[4] = SH_C2 * x * y;
+    basis[5] = SH_C2 * y * z;
+    basis[6] = SH_C3 * (3.0f * z * z - 1.0f);
+    basis[7] = SH_C2 * x * z;
+    basis[8] = SH_C4 * (x * x - y * y);
+}
+
+// 余弦卷积（A0=PI, A1=2PI/3, A2=PI/4）再除以PI，与辐照度贴图存储的量一致
+static SH9Color ApplyBandFactors(const double sums[27]) {
+    const float band[9] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+    SH9Color result;
+    for (int i = 0; i < 9; ++i)
+        result.c[i] = glm::vec3(glm::dvec3(sums[i * 3], sums[i * 3 + 1], sums[i * 3 + 2])) * band[i];
+    return result;
+}
+
+// 累加一行像素：同一行纬度相同，y与cos(lat)为常数，只有经度变化
+static void AccumulateRow(const float* row, int width, int components,
+    const float* cosPhi, const float* sinPhi, float y, float cosLat, float sums[9][3]) {
+    int x = 0;
+#ifdef SH_USE_SSE
+    __m128 accR[9], accG[9], accB[9];
+    for (int i = 0; i < 9; ++i)
+        accR[i] = accG[i] = accB[i] = _mm_setzero_ps();
+
+    const __m128 vy = _mm_set1_ps(y);
+    const __m128 vCosLat = _mm_set1_ps(cosLat);
+    for (; x + 4 <= width; x += 4) {
+        __m128 vx = _mm_mul_ps(_mm_loadu_ps(cosPhi + x), vCosLat);
+        __m128 vz = _mm_mul_ps(_mm_loadu_ps(sinPhi + x), vCosLat);
+
+        __m128 basis[9];
+        basis[0] = _mm_set1_ps(SH_C0);
+        basis[1] = _mm_mul_ps(_mm_set1_ps(SH_C1), vy);
+        basis[2] = _mm_mul_ps(_mm_set1_ps(SH_C1), vz);
+        basis[3] = _mm_mul_ps(_mm_set1_ps(SH_C1), vx);
+        basis[4] = _mm_mul_ps(_mm_set1_ps(SH_C2), _mm_mul_ps(vx, vy));
+        basis[5] = _mm_mul_ps(_mm_set1_ps(SH_C2), _mm_mul_ps(vy, vz));
+        basis[6] = _mm_mul_ps(_mm_set1_ps(SH_C3),
+            _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(3.0f), _mm_mul_ps(vz, vz)), _mm_set1_ps(1.0f)));
+        basis[7] = _mm_mul_ps(_mm_set1_ps(SH_C2), _mm_mul_ps(vx, vz));
+        basis[8] = _mm_mul_ps(_mm_set1_ps(SH_C4), _mm_sub_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)));
+
+        const float* p = row + x * components;
+        __m128 r = _mm_set_ps(p[3 * components], p[2 * components], p[components], p[0]);
+        __m128 g = _mm_set_ps(p[3 * components + 1], p[2 * components + 1], p[components + 1], p[1]);
+        __m128 b = _mm_set_ps(p[3 * components + 2], p[2 * components + 2], p[components + 2], p[2]);
+        for (int i = 0; i < 9; ++i) {
+            accR[i] = _mm_add_ps(accR[i], _mm_mul_ps(basis[i], r));
+            accG[i] = _mm_add_ps(accG[i], _mm_mul_ps(basis[i], g));
+            accB[i] = _mm_add_ps(accB[i], _mm_mul_ps(basis[i], b));
+        }
+    }
+
+    // 水平求和4个通道
+    for (int i = 0; i < 9; ++i) {
+        float lanes[4];
+        _mm_storeu_ps(lanes, accR[i]);
+        sums[i][0] += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        _mm_storeu_ps(lanes, accG[i]);
+        sums[i][1] += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        _mm_storeu_ps(lanes, accB[i]);
+        sums[i][2] += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+#endif
+    // 剩余像素（或不支持SSE时的全部像素）
+    for (; x < width; ++x) {
+        float basis[9];
+        EvaluateBasis(cosPhi[x] * cosLat, y, sinPhi[x] * cosLat, basis);
+        const float* p = row + x * components;
+        for (int i = 0; i < 9; ++i) {
+            sums[i][0] += basis[i] * p[0];
+            sums[i][1] += basis[i] * p[1];
+            sums[i][2] += basis[i] * p[2];
+        }
+    }
+}
+
+SH9Color SphericalHarmonics::ProjectEquirect(const float* pixels, int width, int height, int components) {
+    SH9Color result;
+    if (!pixels || width <= 0 || height <= 0 || components < 3) return result;
+
+    // 每个线程一个累加器，投影是线性的，各线程结果直接相加
+    unsigned int threadCount = std::max(1u, std::min(std::thread::hardware_concurrency(), (unsigned int)height));
+    std::vector<SH9Color> partial(threadCount);
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&, t]() {
+            SHProjector projector(width, height);
+            for (int row = (int)t; row < height; row += (int)threadCount)
+                projector.AddRow(pixels + (size_t)row * width * components, row, components);
+            partial[t] = projector.Finish();
+        });
+    }
+    for (std::thread& worker : workers)
+        worker.join();
+
+    for (unsigned int t = 0; t < threadCount; ++t)
+        for (int i = 0; i < 9; ++i)
+            result.c[i] += partial[t].c[i];
+    return result;
+}
+
+SH9Color SphericalHarmonics::ProjectCubemap(const float* faces, int faceSize) {
+    double sums[27] = {};
+    if (!faces || faceSize <= 0) return ApplyBandFactors(sums);
+
+    const float* p = faces;
+    for (int face = 0; face < 6; ++face) {
+        for (int y = 0; y < faceSize; ++y) {
+            for (int x = 0; x < faceSize; ++x, p += 3) {
+                // 方向与FloatCubemap::TexelDirection相同
+                float sc = 2.0f * (x + 0.5f) / faceSize - 1.0f;
+                float tc = 2.0f * (y + 0.5f) / faceSize - 1.0f;
+                glm::vec3 dir;
+                switch (face) {
+                case 0: dir = glm::vec3(1.0f, -tc, -sc); break;
+                case 1: dir = glm::vec3(-1.0f, -tc, sc); break;
+                case 2: dir = glm::vec3(sc, 1.0f, tc); break;
+                case 3: dir = glm::vec3(sc, -1.0f, -tc); break;
+                case 4: dir = glm::vec3(sc, -tc, 1.0f); break;
+                default: dir = glm::vec3(-sc, -tc, -1.0f); break;
+                }
+                // 纹素立体角 = (2/N)^2 / (1 + s^2 + t^2)^(3/2)
+                float lengthSq = 1.0f + sc * sc + tc * tc;
+                float weight = 4.0f / ((float)faceSize * faceSize * lengthSq * std::sqrt(lengthSq));
+                dir /= std::sqrt(lengthSq);
+
+                float basis[9];
+                EvaluateBasis(dir.x, dir.y, dir.z, basis);
+                for (int i = 0; i < 9; ++i)
+                    for (int c = 0; c < 3; ++c)
+                        sums[i * 3 + c] += (double)basis[i] * p[c] * weight;
+            }
+        }
+    }
+    return ApplyBandFactors(sums);
+}
+
+glm::vec3 SphericalHarmonics::Evaluate(const SH9Color& sh, const glm::vec3& n) {
+    float basis[9];
+    EvaluateBasis(n.x, n.y, n.z, basis);
+    glm::vec3 result(0.0f);
+    for (int i = 0; i < 9; ++i)
+        result += sh.c[i] * basis[i];
+    return glm::max(result, glm::vec3(0.0f));
+}
+
+glm::vec3 SphericalHarmonics::EvaluateRadiance(const SH9Color& sh, const glm::vec3& dir) {
+    // 除去余弦卷积因子，得到截断到L2的原始辐射度（高频被截断，只适合低频的天空光）
+    const float invBand[9] = { 1.0f, 1.5f, 1.5f, 1.5f, 4.0f, 4.0f, 4.0f, 4.0f, 4.0f };
+    float basis[9];
+    EvaluateBasis(dir.x, dir.y, dir.z, basis);
+    glm::vec3 result(0.0f);
+    for (int i = 0; i < 9; ++i)
+        result += sh.c[i] * (basis[i] * invBand[i]);
+    return glm::max(result, glm::vec3(0.0f));
+}
+
+// ================== 流式投影 ==================
+SHProjector::SHProjector(int width, int height)
+    : m_Width(width), m_Height(height), m_CosPhi(width), m_SinPhi(width) {
+    // 与equirectangular_to_cubemap.frag一致：u = atan(z, x) / 2PI + 0.5, v = asin(y) / PI + 0.5
+    for (int x = 0; x < width; ++x) {
+        float phi = ((x + 0.5f) / width - 0.5f) * 2.0f * PI;
+        m_CosPhi[x] = std::cos(phi);
+        m_SinPhi[x] = std::sin(phi);
+    }
+}
+
+void SHProjector::AddRow(const float* row, int rowIndex, int components) {
+    if (!row || rowIndex < 0 || rowIndex >= m_Height || components < 3) return;
+    float lat = ((rowIndex + 0.5f) / m_Height - 0.5f) * PI;
+    float cosLat = std::cos(lat);
+    // 每个像素的立体角 = cos(lat) * dLat * dPhi
+    float weight = cosLat * (PI / m_Height) * (2.0f * PI / m_Width);
+
+    float sums[9][3] = {};
+    AccumulateRow(row, m_Width, components, m_CosPhi.data(), m_SinPhi.data(), std::sin(lat), cosLat, sums);
+    for (int i = 0; i < 9; ++i)
+        for (int c = 0; c < 3; ++c)
+            m_Sums[i * 3 + c] += (double)sums[i][c] * weight;
+}
+
+SH9Color SHProjector::Finish() const {
+    return ApplyBandFactors(m_Sums);
+}
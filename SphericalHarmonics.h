@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+// 环境光照的L2球谐投影（9个系数，不依赖GL，烘焙工具和运行时共用）
+// 系数已乘以余弦卷积因子并除以PI，着色器中 sum(c[i] * Y[i](N)) 直接等于原辐照度贴图的采样值
+struct SH9Color {
+    glm::vec3 c[9] = {};
+};
+
+class SphericalHarmonics {
+public:
+    // 投影等距柱状HDR图像（像素已按stbi_set_flip_vertically_on_load(true)翻转）
+    // 按行分配到多个线程，每行内用SSE一次处理4个像素
+    static SH9Color ProjectEquirect(const float* pixels, int width, int height, int components);
+
+    // 投影立方体贴图（RGB浮点，[face][y][x][channel]，面顺序与方向约定同GL），按纹素立体角加权
+    // 动态探针用小尺寸mip的读回数据更新漫反射球谐
+    static SH9Color ProjectCubemap(const float* faces, int faceSize);
+
+    // CPU端求值，用于校验和调试
+    static glm::vec3 Evaluate(const SH9Color& sh, const glm::vec3& n);
+    // 沿dir方向的入射辐射度（去掉卷积因子），辐照度体积烘焙时作为未击中几何的光线的天空光
+    static glm::vec3 EvaluateRadiance(const SH9Color& sh, const glm::vec3& dir);
+};
+
+// 流式投影：逐行累加（行号与ProjectEquirect的pixels相同，即翻转后的行号），行顺序任意
+// HDR按扫描线分块解码时使用，不需要整张图像常驻内存
+class SHProjector {
+public:
+    SHProjector(int width, int height);
+    void AddRow(const float* row, int rowIndex, int components);
+    SH9Color Finish() const;
+
+private:
+    int m_Width, m_Height;
+    std::vector<float> m_CosPhi, m_SinPhi;
+    double m_Sums[27] = {};
+};
@@ -0,0 +1,155 @@
+#include "TexturePacker.h"
+#include "ResidencyManager.h"
+#include "BindlessTextures.h"
+#include <algorithm>
+
+static GLenum FormatFromComponents(int components) {
+    if (components == 1) return GL_RED;
+    if (components == 4) return GL_RGBA;
+    return GL_RGB;
+}
+
+static int AlignUp(int value, int alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// 各纹理单元当前绑定的数组纹理
+static GLuint s_BoundArrays[16] = { 0 };
+
+bool TexturePacker::IsPackable(int width, int height) {
+    return std::max(width, height) <= MAX_ARRAY_ENTRY;
+}
+
+std::vector<TexturePacker::Location> TexturePacker::Pack(const std::vector<Input>& inputs, std::vector<GLuint>& arrays) {
+    std::vector<Location> out(inputs.size());
+
+    // 1. 小纹理：按通道数分组，货架法打包进图集页
+    for (int components = 1; components <= 4; ++components) {
+        std::vector<size_t> members;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            const Input& in = inputs[i];
+            if (in.pixels && in.components == components && std::max(in.width, in.height) <= MAX_ATLAS_ENTRY)
+                members.push_back(i);
+        }
+        if (members.size() < 2) continue;
+        std::sort(members.begin(), members.end(),
+            [&inputs](size_t a, size_t b) { return inputs[a].height > inputs[b].height; });
+
+        struct Slot { int page, x, y, cellW, cellH; };
+        std::vector<Slot> slots;
+        int page = 0, x = 0, y = 0, shelfHeight = 0;
+        for (size_t m : members) {
+            int cellW = AlignUp(inputs[m].width + 2 * ATLAS_PADDING, ATLAS_PADDING);
+            int cellH = AlignUp(inputs[m].height + 2 * ATLAS_PADDING, ATLAS_PADDING);
+            if (x + cellW > ATLAS_SIZE) { y += shelfHeight; x = 0; shelfHeight = 0; }
+            if (y + cellH > ATLAS_SIZE) { page++; x = 0; y = 0; shelfHeight = 0; }
+            slots.push_back({ page, x, y, cellW, cellH });
+            x += cellW;
+            shelfHeight = std::max(shelfHeight, cellH);
+        }
+
+        // 整个单元格按平铺方式填充，边框和对齐余量都是纹理自身的内容
+        std::vector<std::vector<unsigned char>> pages(page + 1,
+            std::vector<unsigned char>((size_t)ATLAS_SIZE * ATLAS_SIZE * components, 0));
+        for (size_t k = 0; k < members.size(); ++k) {
+            const Input& in = inputs[members[k]];
+            const Slot& s = slots[k];
+            std::vector<unsigned char>& dst = pages[s.page];
+            for (int py = 0; py < s.cellH; ++py) {
+                int sy = ((py - ATLAS_PADDING) % in.height + in.height) % in.height;
+                for (int px = 0; px < s.cellW; ++px) {
+                    int sx = ((px - ATLAS_PADDING) % in.width + in.width) % in.width;
+                    std::copy_n(in.pixels + ((size_t)sy * in.width + sx) * components, components,
+                        &dst[((size_t)(s.y + py) * ATLAS_SIZE + s.x + px) * components]);
+                }
+            }
+        }
+
+        int maxLevel = 0;
+        while ((2 << maxLevel) <= ATLAS_PADDING) maxLevel++;
+        GLuint id = CreateArray(ATLAS_SIZE, ATLAS_SIZE, page + 1, components, maxLevel, pages);
+        arrays.push_back(id);
+        for (size_t k = 0; k < members.size(); ++k) {
+            const Input& in = inputs[members[k]];
+            const Slot& s = slots[k];
+            Location& loc = out[members[k]];
+            loc.array = id;
+            loc.layer = s.page;
+            loc.rect = glm::vec4((float)in.width, (float)in.height,
+                (float)(s.x + ATLAS_PADDING), (float)(s.y + ATLAS_PADDING)) / (float)ATLAS_SIZE;
+        }
+    }
+
+    // 2. 其余可打包的纹理：同尺寸同通道数的放进同一个数组
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        const Input& in = inputs[i];
+        if (!in.pixels || out[i].layer >= 0 || !IsPackable(in.width, in.height)) continue;
+
+        std::vector<size_t> group;
+        for (size_t j = i; j < inputs.size(); ++j) {
+            const Input& other = inputs[j];
+            if (other.pixels && out[j].layer < 0 && other.width == in.width &&
+                other.height == in.height && other.components == in.components)
+                group.push_back(j);
+        }
+        if (group.size() < 2) continue;
+
+        std::vector<std::vector<unsigned char>> layers;
+        for (size_t j : group)
+            layers.emplace_back(inputs[j].pixels,
+                inputs[j].pixels + (size_t)in.width * in.height * in.components);
+        GLuint id = CreateArray(in.width, in.height, (int)group.size(), in.components, 1000, layers);
+        arrays.push_back(id);
+        for (size_t k = 0; k < group.size(); ++k) {
+            out[group[k]].array = id;
+            out[group[k]].layer = (int)k;
+        }
+    }
+    return out;
+}
+
+GLuint TexturePacker::CreateArray(int width, int height, int layers, int components, int maxLevel,
+    const std::vector<std::vector<unsigned char>>& layerPixels) {
+    GLenum format = FormatFromComponents(components);
+    GLuint id;
+    glGenTextures(1, &id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, format, width, height, layers, 0, format, GL_UNSIGNED_BYTE, nullptr);
+    for (int layer = 0; layer < layers; ++layer)
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, format, GL_UNSIGNED_BYTE,
+            layerPixels[layer].data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // 图集限制mip级数：最粗一级的纹素仍不跨越相邻单元格
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, maxLevel);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    GLint wrap = maxLevel < 1000 ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, wrap);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    ResidencyManager::Get().TrackTexture(id, layers * ResidencyManager::TextureBytes(width, height,
+        components == 3 ? 4 : components, true), "TexturePacker");
+    BindlessTextures::Get().Register(id);
+    return id;
+}
+
+void TexturePacker::BindArray(GLuint unit, GLuint id) {
+    if (unit < 16 && s_BoundArrays[unit] == id) return;
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+    glActiveTexture(GL_TEXTURE0);
+    if (unit < 16) s_BoundArrays[unit] = id;
+}
+
+void TexturePacker::ReleaseArray(GLuint id) {
+    for (GLuint& bound : s_BoundArrays)
+        if (bound == id) bound = 0;
+    ResidencyManager::Get().UntrackTexture(id);
+    BindlessTextures::Get().Unregister(id);
+    glDeleteTextures(1, &id);
+}
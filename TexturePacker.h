@@ -0,0 +1,43 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// 导入时的纹理打包：减少每次绘制的纹理绑定
+//   同尺寸同格式的中等纹理 -> GL_TEXTURE_2D_ARRAY的各层
+//   小纹理 -> 货架法打包进图集页（图集页同样作为数组层），四周按平铺方式填充边框，
+//            打包位置与边框宽度对齐，保证低mip不会串色
+// 绘制时用（层号，UV变换）定位：uv' = fract(uv) * rect.xy + rect.zw
+class TexturePacker {
+public:
+    static const int ATLAS_SIZE = 1024;
+    static const int ATLAS_PADDING = 8;       // 同时决定图集可用的mip级数（log2）
+    static const int MAX_ATLAS_ENTRY = 256;   // 不超过此尺寸的纹理进图集
+    static const int MAX_ARRAY_ENTRY = 1024;  // 更大的纹理留给TextureStreamer逐张流送
+
+    // 数组纹理固定使用的纹理单元（与二维纹理单元错开，避免采样器类型冲突）
+    static const GLuint DIFFUSE_ARRAY_UNIT = 8;
+    static const GLuint SPECULAR_ARRAY_UNIT = 9;
+
+    struct Input {
+        const unsigned char* pixels = nullptr;
+        int width = 0, height = 0, components = 0;
+    };
+    struct Location {
+        GLuint array = 0;
+        int layer = -1;                                  // -1表示未打包
+        glm::vec4 rect = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+    };
+
+    static bool IsPackable(int width, int height);
+    // 打包一组纹理，创建的数组纹理追加到arrays（调用者负责ReleaseArray）
+    static std::vector<Location> Pack(const std::vector<Input>& inputs, std::vector<GLuint>& arrays);
+
+    // 带缓存的数组纹理绑定：同一模型的网格共享数组时跳过重复绑定
+    static void BindArray(GLuint unit, GLuint id);
+    static void ReleaseArray(GLuint id);
+
+private:
+    static GLuint CreateArray(int width, int height, int layers, int components, int maxLevel,
+        const std::vector<std::vector<unsigned char>>& layerPixels);
+};
@@ -0,0 +1,290 @@
+#include "TextureStreamer.h"
+#include "ResidencyManager.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+static GLenum FormatFromComponents(int components) {
+    if (components == 1) return GL_RED;
+    if (components == 4) return GL_RGBA;
+    return GL_RGB;
+}
+
+TextureStreamer& TextureStreamer::Get() {
+    static TextureStreamer instance;
+    return instance;
+}
+
+TextureStreamer::TextureStreamer() : m_Running(true) {
+    m_Worker = std::thread(&TextureStreamer::WorkerLoop, this);
+}
+
+TextureStreamer::~TextureStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Running = false;
+    }
+    m_Cond.notify_all();
+    if (m_Worker.joinable()) m_Worker.join();
+}
+
+// ================== 工具函数 ==================
+int TextureStreamer::MipCount(int width, int height) {
+    int count = 1;
+    while (width > 1 || height > 1) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        count++;
+    }
+    return count;
+}
+
+int TextureStreamer::InitialMip(int width, int height, int initialSize) {
+    int mip = 0;
+    while (std::max(width, height) > initialSize) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        mip++;
+    }
+    return mip;
+}
+
+void TextureStreamer::Downsample(const unsigned char* src, int width, int height, int components, int levels,
+    std::vector<unsigned char>& out, int& outWidth, int& outHeight) {
+    out.assign(src, src + (size_t)width * height * components);
+    std::vector<unsigned char> next;
+    for (int level = 0; level < levels && (width > 1 || height > 1); ++level) {
+        int w = std::max(1, width / 2);
+        int h = std::max(1, height / 2);
+        next.resize((size_t)w * h * components);
+        for (int y = 0; y < h; ++y) {
+            int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+            for (int x = 0; x < w; ++x) {
+                int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+                for (int c = 0; c < components; ++c) {
+                    int sum = out[((size_t)y0 * width + x0) * components + c] +
+                        out[((size_t)y0 * width + x1) * components + c] +
+                        out[((size_t)y1 * width + x0) * components + c] +
+                        out[((size_t)y1 * width + x1) * components + c];
+                    next[((size_t)y * w + x) * components + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+        out.swap(next);
+        width = w;
+        height = h;
+    }
+    outWidth = width;
+    outHeight = height;
+}
+
+void TextureStreamer::UploadLevel(GLuint id, const unsigned char* pixels, int width, int height, int components) {
+    GLenum format = FormatFromComponents(components);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+// ================== 登记/请求 ==================
+void TextureStreamer::Register(GLuint id, const std::string& file, int width, int height, int components, int residentMip) {
+    // 同一名字重新登记（旧纹理已删除）时丢弃旧状态，进行中的加载按序号作废
+    StreamedTexture& tex = m_Textures[id];
+    tex = StreamedTexture();
+    tex.generation = m_NextGeneration++;
+    tex.file = file;
+    tex.width = width;
+    tex.height = height;
+    tex.components = components;
+    tex.mipCount = MipCount(width, height);
+    tex.residentMip = residentMip;
+    tex.requiredMip = residentMip;
+    tex.lastRequest = m_Frame;
+}
+
+void TextureStreamer::Unregister(GLuint id) {
+    m_Textures.erase(id);
+}
+
+void TextureStreamer::SetView(const glm::vec3& cameraPos, float fovY, int viewportHeight) {
+    m_CameraPos = cameraPos;
+    m_ProjScale = viewportHeight / (2.0f * std::tan(fovY * 0.5f));
+}
+
+void TextureStreamer::SetDrawContext(float distance, float worldScale) {
+    m_DrawDistance = std::max(distance, 0.01f);
+    m_DrawScale = std::max(worldScale, 1e-6f);
+}
+
+void TextureStreamer::Request(GLuint id, float uvDensity) {
+    auto it = m_Textures.find(id);
+    if (it == m_Textures.end()) return;
+    StreamedTexture& tex = it->second;
+
+    // 每个屏幕像素覆盖的mip0纹素数：纹理尺寸 * UV/世界单位 / 像素/世界单位
+    int mip = 0;
+    if (uvDensity > 0.0f) {
+        float texelsPerPixel = std::max(tex.width, tex.height) * uvDensity * m_DrawDistance /
+            (m_DrawScale * m_ProjScale);
+        if (texelsPerPixel > 1.0f)
+            mip = (int)std::floor(std::log2(texelsPerPixel));
+    }
+    if (tex.lastRequest != m_Frame) {
+        tex.requiredMip = mip;
+        tex.lastRequest = m_Frame;
+    }
+    else {
+        tex.requiredMip = std::min(tex.requiredMip, mip);
+    }
+}
+
+int TextureStreamer::CoarsestMip(const StreamedTexture& tex) const {
+    return std::min(InitialMip(tex.width, tex.height, m_MinResidentSize), tex.mipCount - 1);
+}
+
+void TextureStreamer::UpdateResidency(GLuint id, const StreamedTexture& tex) {
+    int w = std::max(1, tex.width >> tex.residentMip);
+    int h = std::max(1, tex.height >> tex.residentMip);
+    ResidencyManager::Get().ResizeTexture(id,
+        ResidencyManager::TextureBytes(w, h, tex.components == 3 ? 4 : tex.components, true));
+}
+
+// ================== 帧处理 ==================
+void TextureStreamer::Update(unsigned int maxUploads) {
+    // 显存超预算时整体加粗一级，回落到80%以下再恢复
+    ResidencyManager& residency = ResidencyManager::Get();
+    if (m_Frame % 30 == 0) {
+        if (residency.GetUsedBytes() > residency.GetBudget())
+            m_MipBias = std::min(m_MipBias + 1, 4);
+        else if (m_MipBias > 0 && residency.GetUsedBytes() < residency.GetBudget() / 5 * 4)
+            m_MipBias--;
+    }
+
+    unsigned int uploads = 0;
+
+    // 1. 上传加载线程完成的级别
+    while (uploads < maxUploads) {
+        std::unique_ptr<LoadJob> job;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Completed.empty()) break;
+            job = std::move(m_Completed.front());
+            m_Completed.pop_front();
+        }
+        auto it = m_Textures.find(job->id);
+        // 期间已被卸载，或名字已被新纹理复用
+        if (it == m_Textures.end() || it->second.generation != job->generation) continue;
+        StreamedTexture& tex = it->second;
+        tex.loading = false;
+        if (!job->ok) {
+            tex.failed = true;
+            std::cout << "TEXTURE_STREAMER: failed to reload " << job->file << ", keeping mip " << tex.residentMip << std::endl;
+            continue;
+        }
+        UploadLevel(job->id, job->pixels.data(), job->width, job->height, job->components);
+        tex.residentMip = job->mip;
+        UpdateResidency(job->id, tex);
+        uploads++;
+    }
+
+    // 2. 比较需求与常驻级别
+    for (auto& entry : m_Textures) {
+        StreamedTexture& tex = entry.second;
+        if (tex.loading) continue;
+
+        // 长时间未绘制的纹理退到最粗级别
+        int target = CoarsestMip(tex);
+        if (m_Frame - tex.lastRequest < (uint64_t)m_DropDelay)
+            target = std::min(tex.requiredMip + m_MipBias, CoarsestMip(tex));
+        // 源文件读取失败过：只能保持或丢弃常驻级别
+        if (tex.failed)
+            target = std::max(target, tex.residentMip);
+
+        if (target < tex.residentMip) {
+            tex.coarserFrames = 0;
+            tex.loading = true;
+            auto job = std::make_unique<LoadJob>();
+            job->id = entry.first;
+            job->generation = tex.generation;
+            job->file = tex.file;
+            job->mip = target;
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Requests.push_back(std::move(job));
+            }
+            m_Cond.notify_one();
+        }
+        else if (target > tex.residentMip) {
+            if (++tex.coarserFrames >= m_DropDelay && uploads < maxUploads && DropMips(entry.first, tex, target)) {
+                tex.coarserFrames = 0;
+                uploads++;
+            }
+        }
+        else {
+            tex.coarserFrames = 0;
+        }
+    }
+
+    m_Frame++;
+}
+
+// 从GPU读回较粗的级别，重新定义为第0级（无需再次解码源文件）
+bool TextureStreamer::DropMips(GLuint id, StreamedTexture& tex, int targetMip) {
+    int level = targetMip - tex.residentMip;
+    GLint width = 0, height = 0;
+    glBindTexture(GL_TEXTURE_2D, id);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height);
+    if (width == 0 || height == 0) return false;
+
+    std::vector<unsigned char> pixels((size_t)width * height * tex.components);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, level, FormatFromComponents(tex.components), GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    UploadLevel(id, pixels.data(), width, height, tex.components);
+
+    tex.residentMip = targetMip;
+    UpdateResidency(id, tex);
+    return true;
+}
+
+void TextureStreamer::WorkerLoop() {
+    while (true) {
+        std::unique_ptr<LoadJob> job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Cond.wait(lock, [this] { return !m_Running || !m_Requests.empty(); });
+            if (!m_Running) return;
+            job = std::move(m_Requests.front());
+            m_Requests.pop_front();
+        }
+
+        int width, height, components;
+        unsigned char* data = stbi_load(job->file.c_str(), &width, &height, &components, 0);
+        if (data) {
+            Downsample(data, width, height, components, job->mip, job->pixels, job->width, job->height);
+            job->components = components;
+            job->ok = true;
+            stbi_image_free(data);
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Completed.push_back(std::move(job));
+    }
+}
+
+void TextureStreamer::PrintStats() const {
+    size_t fullTexels = 0, residentTexels = 0;
+    int streaming = 0;
+    for (const auto& entry : m_Textures) {
+        const StreamedTexture& tex = entry.second;
+        fullTexels += (size_t)tex.width * tex.height;
+        residentTexels += (size_t)std::max(1, tex.width >> tex.residentMip) * std::max(1, tex.height >> tex.residentMip);
+        streaming += tex.loading;
+    }
+    std::cout << "TEXTURE_STREAMER: " << m_Textures.size() << " textures, "
+        << (residentTexels >> 10) << "K / " << (fullTexels >> 10) << "K texels resident, "
+        << streaming << " loading, mip bias " << m_MipBias << std::endl;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+// 纹理mip流送：按屏幕空间纹素密度决定每张纹理需要的最精细mip
+//   每次绘制：距离、网格UV密度（导入时预计算）和视口 -> 需要的mip
+//   帧末：需要更精细的mip时交给加载线程解码/降采样，需要更粗的mip时直接从GPU读回丢弃
+// 常驻的最精细级别（residentMip）始终作为GL的第0级，同一个GL名字重新定义存储，
+// 因此网格持有的纹理ID不变，显存只占当前可见分辨率所需
+class TextureStreamer {
+public:
+    static TextureStreamer& Get();
+    ~TextureStreamer();
+
+    // 登记已上传residentMip级别的纹理（file为源图片，供加载线程重新读取）
+    void Register(GLuint id, const std::string& file, int width, int height, int components, int residentMip);
+    void Unregister(GLuint id);
+
+    // 每帧主视图参数：相机位置、竖直视场角（弧度）、视口高度（像素）
+    void SetView(const glm::vec3& cameraPos, float fovY, int viewportHeight);
+    const glm::vec3& GetCameraPos() const { return m_CameraPos; }
+    // 当前绘制对象到相机的距离和世界缩放（SceneNode在绘制模型前设置）
+    void SetDrawContext(float distance, float worldScale);
+    // 绘制时调用：uvDensity为网格每单位长度覆盖的UV范围
+    void Request(GLuint id, float uvDensity);
+
+    // 主线程帧末调用：提交加载、上传完成的mip、丢弃不再需要的mip
+    void Update(unsigned int maxUploads = 2);
+    void PrintStats() const;
+
+    // 导入时首次上传的级别：最大边不超过initialSize
+    static int InitialMip(int width, int height, int initialSize = 256);
+    static int MipCount(int width, int height);
+    // CPU盒式滤波降采样levels次（不依赖GL，可在工作线程调用）
+    static void Downsample(const unsigned char* src, int width, int height, int components, int levels,
+        std::vector<unsigned char>& out, int& outWidth, int& outHeight);
+    // 把一级数据上传为纹理的第0级并生成其余mip
+    static void UploadLevel(GLuint id, const unsigned char* pixels, int width, int height, int components);
+
+private:
+    TextureStreamer();
+
+    struct StreamedTexture {
+        std::string file;
+        int width = 0, height = 0, components = 0;
+        int mipCount = 1;
+        int residentMip = 0;          // 当前GL第0级对应的源mip
+        int requiredMip = 0;          // 本帧所有绘制中最精细的需求
+        int coarserFrames = 0;        // 连续需要更粗mip的帧数（防抖）
+        uint64_t lastRequest = 0;
+        uint64_t generation = 0;      // 登记序号：GL名字被删除后可能复用，加载结果按序号匹配
+        bool loading = false;
+        bool failed = false;          // 重新读取源文件失败，重新登记（热重载）前不再请求更精细的mip
+    };
+    struct LoadJob {
+        GLuint id = 0;
+        uint64_t generation = 0;
+        std::string file;
+        int mip = 0;
+        int width = 0, height = 0, components = 0;
+        std::vector<unsigned char> pixels;
+        bool ok = false;
+    };
+
+    std::unordered_map<GLuint, StreamedTexture> m_Textures;
+    glm::vec3 m_CameraPos = glm::vec3(0.0f);
+    float m_ProjScale = 600.0f;       // 视口高度 / (2 * tan(fovY / 2))
+    float m_DrawDistance = 1.0f;
+    float m_DrawScale = 1.0f;
+    uint64_t m_Frame = 1;
+    uint64_t m_NextGeneration = 1;
+    int m_MipBias = 0;                // 超出显存预算时整体降低分辨率
+    int m_MinResidentSize = 32;       // 最粗不低于此尺寸
+    int m_DropDelay = 60;             // 需要更粗mip持续多少帧后才丢弃
+
+    std::thread m_Worker;
+    std::atomic<bool> m_Running;
+    std::mutex m_Mutex;
+    std::condition_variable m_Cond;
+    std::deque<std::unique_ptr<LoadJob>> m_Requests;
+    std::deque<std::unique_ptr<LoadJob>> m_Completed;
+
+    void WorkerLoop();
+    bool DropMips(GLuint id, StreamedTexture& tex, int targetMip);
+    int CoarsestMip(const StreamedTexture& tex) const;
+    void UpdateResidency(GLuint id, const StreamedTexture& tex);
+};
@@ -4,7 +4,7 @@
 
 Camera::Camera(GLFWwindow* window, glm::vec3 position)
     : m_Window(window), Position(position) {
-} // ʼָ
+} // 初始化窗口指针
 
 glm::mat4 Camera::GetViewMatrix() {
     return glm::lookAt(Position, Position + Front, Up);
@@ -12,7 +12,7 @@ glm::mat4 Camera::GetViewMatrix() {
 
 void Camera::ProcessKeyboard(float deltaTime) {
     float velocity = MovementSpeed * deltaTime;
-    float verticalVelocity = VerticalSpeed * deltaTime; // ֱٶ
+    float verticalVelocity = VerticalSpeed * deltaTime; // 垂直速度
 
     if (glfwGetKey(m_Window, GLFW_KEY_W) == GLFW_PRESS)
         Position += Front * velocity;
@@ -23,7 +23,7 @@ void Camera::ProcessKeyboard(float deltaTime) {
     if (glfwGetKey(m_Window, GLFW_KEY_D) == GLFW_PRESS)
         Position += glm::normalize(glm::cross(Front, Up)) * velocity;
    
-    // QEֱ
+    // QE垂直控制
     if (glfwGetKey(m_Window, GLFW_KEY_E) == GLFW_PRESS)
         Position += glm::vec3(0.0f, 1.0f, 0.0f) * verticalVelocity;
     if (glfwGetKey(m_Window, GLFW_KEY_Q) == GLFW_PRESS)
@@ -35,13 +35,13 @@ void Camera::ProcessMouseMovement(float xoffset, float yoffset) {
     Yaw += xoffset * sensitivity;
     Pitch += yoffset * sensitivity;
 
-    // Ƹ
+    // 限制俯仰角
     if (Pitch > 89.0f)  Pitch = 89.0f;
     if (Pitch < -89.0f) Pitch = -89.0f;
 
     updateVectors();
 }
-// Ŵ
+// 滚轮缩放处理
 void Camera::ProcessMouseScroll(float yoffset) {
     Zoom -= yoffset;
     if (Zoom < 1.0f) Zoom = 1.0f;
@@ -4,23 +4,23 @@
 
 class Camera {
 public:
-    Camera(GLFWwindow* window, glm::vec3 position = glm::vec3(0.0f, 0.0f, 3.0f)); // ޸Ĺ캯
+    Camera(GLFWwindow* window, glm::vec3 position = glm::vec3(0.0f, 0.0f, 3.0f)); // 修改构造函
     void ProcessMouseScroll(float yoffset); 
-    float Zoom = 45.0f;                    // Ų
+    float Zoom = 45.0f;                    // 缩放参数
     glm::mat4 GetViewMatrix();
     void ProcessKeyboard(float deltaTime);
     void ProcessMouseMovement(float xoffset, float yoffset);
 
-    // 
+    // 摄像机参数
     glm::vec3 Position;
     glm::vec3 Front = glm::vec3(0.0f, 0.0f, -1.0f);
     glm::vec3 Up = glm::vec3(0.0f, 1.0f, 0.0f);
     float MovementSpeed = 2.5f;
-    float VerticalSpeed = 3.0f; // ֱٶȿ
+    float VerticalSpeed = 3.0f; // 垂直速度控制
 
 private:
-    GLFWwindow* m_Window; // ָԱ
+    GLFWwindow* m_Window; // 窗口指针成员
     void updateVectors();
-    float Yaw = -90.0f;    // ƫ
-    float Pitch = 0.0f;    // 
+    float Yaw = -90.0f;    // 偏航角
+    float Pitch = 0.0f;    // 俯仰角
 };
\ No newline at end of file
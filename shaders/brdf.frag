@@ -3,6 +3,10 @@ out vec2 FragColor;
 in vec2 TexCoords;
 
 const float PI = 3.14159265359;
+uniform int sampleCount = 1024;      // 由烘焙质量档位决定
+// 样本分批：每次绘制只处理 [sampleStart, sampleEnd)，各批结果加性混合累加
+uniform int sampleStart = 0;
+uniform int sampleEnd = 1024;
 
 float RadicalInverse_VdC(uint bits) {
     bits = (bits << 16u) | (bits >> 16u);
@@ -56,9 +60,9 @@ vec2 IntegrateBRDF(float NdotV, float roughness) {
 
     float A = 0.0;
     float B = 0.0;
-    const uint SAMPLE_COUNT = 1024u;
+    uint SAMPLE_COUNT = uint(sampleCount);
     
-    for(uint i = 0u; i < SAMPLE_COUNT; ++i) {
+    for(uint i = uint(sampleStart); i < uint(sampleEnd); ++i) {
         vec2 Xi = Hammersley(i, SAMPLE_COUNT);
         vec3 H = ImportanceSampleGGX(Xi, vec3(0.0, 0.0, 1.0), roughness);
         vec3 L = normalize(2.0 * dot(V, H) * H - V);
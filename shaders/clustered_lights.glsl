@@ -0,0 +1,75 @@
+// 分簇光源（ClusteredLights）：簇的划分与ClusteredLights.h一致，光源表布局见ClusteredLights::GPULight
+// 由shader.frag、pbr.frag和deferred_lighting.frag包含；ClusterRange按gl_FragCoord选择tile，全屏光照阶段同样适用
+#include "shadows.glsl"
+
+const ivec3 CLUSTER_DIMS = ivec3(16, 9, 24);    // 与ClusteredLights::TILES_X/TILES_Y/SLICES一致
+uniform samplerBuffer clusterLights;             // 每个光源6个纹素，布局见ClusteredLights::GPULight
+uniform usamplerBuffer clusterGrid;              // 每簇(偏移, 数量)
+uniform usamplerBuffer clusterIndices;           // 紧凑的光源下标
+uniform bool clusteredLighting = false;          // false时遍历全部光源（主相机以外的视图，如探针捕获）
+uniform int clusterLightCount = 0;
+uniform vec2 clusterTileSize;                    // 每个tile的像素尺寸
+uniform vec2 clusterDepthParams;                 // 层号 = log(视空间深度) * x + y
+
+struct LocalLight {
+    vec3 position;
+    float range;        // 衰减到1/256的距离，之外不计算
+    vec3 diffuse;
+    int type;           // 0 点光源，1 聚光灯
+    vec3 specular;
+    int shadowTile;     // 阴影图集中的首个tile（点光源6个面），-1为无阴影
+    vec3 ambient;
+    float cosInner;
+    vec3 direction;
+    float cosOuter;
+    vec3 attenuation;   // constant, linear, quadratic
+};
+
+LocalLight FetchLight(int index) {
+    int base = index * 6;
+    vec4 t0 = texelFetch(clusterLights, base);
+    vec4 t1 = texelFetch(clusterLights, base + 1);
+    vec4 t2 = texelFetch(clusterLights, base + 2);
+    vec4 t3 = texelFetch(clusterLights, base + 3);
+    vec4 t4 = texelFetch(clusterLights, base + 4);
+    vec4 t5 = texelFetch(clusterLights, base + 5);
+    LocalLight light;
+    light.position = t0.xyz;
+    light.range = t0.w;
+    light.diffuse = t1.rgb;
+    light.type = int(t1.w);
+    light.specular = t2.rgb;
+    light.shadowTile = int(t2.w);
+    light.ambient = t3.rgb;
+    light.cosInner = t3.w;
+    light.direction = t4.xyz;
+    light.cosOuter = t4.w;
+    light.attenuation = t5.xyz;
+    return light;
+}
+
+// 片段所在簇在下标表中的区间（起点, 数量）；非分簇模式为全部光源
+ivec2 ClusterRange(vec3 worldPos) {
+    if (!clusteredLighting) return ivec2(0, clusterLightCount);
+    float depth = max(-(view * vec4(worldPos, 1.0)).z, 1e-4);
+    int slice = clamp(int(floor(log(depth) * clusterDepthParams.x + clusterDepthParams.y)), 0, CLUSTER_DIMS.z - 1);
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy / clusterTileSize), ivec2(0), CLUSTER_DIMS.xy - 1);
+    return ivec2(texelFetch(clusterGrid, tile.x + CLUSTER_DIMS.x * (tile.y + CLUSTER_DIMS.y * slice)).xy);
+}
+
+int ClusterLightIndex(int i) {
+    return clusteredLighting ? int(texelFetch(clusterIndices, i).r) : i;
+}
+
+// 聚光灯的锥体过渡（点光源为1），L为指向光源的单位向量
+float SpotFactor(LocalLight light, vec3 L) {
+    if (light.type == 0) return 1.0;
+    float theta = dot(L, -light.direction);
+    return clamp((theta - light.cosOuter) / max(light.cosInner - light.cosOuter, 1e-4), 0.0, 1.0);
+}
+
+float LocalShadow(LocalLight light, vec3 fragPos, vec3 normal) {
+    if (light.shadowTile < 0) return 1.0;
+    return light.type == 0 ? PointShadow(light.shadowTile, fragPos, normal, light.position)
+        : AtlasShadow(light.shadowTile, fragPos, normal, light.position);
+}
@@ -0,0 +1,73 @@
+#version 330 core
+// 延迟着色的光照阶段（DeferredRenderer）：全屏三角形，每个像素读取一次G-buffer并按着色模型计算光照
+// 局部光源沿用ClusteredLights的簇（tile为屏幕划分），与前向着色器共用阴影、Phong和PBR函数
+in vec2 TexCoords;
+out vec4 FragColor;
+
+#include "gbuffer.glsl"
+#include "phong_lighting.glsl"
+#include "pbr_lighting.glsl"
+#include "irradiance_volume.glsl"
+
+// ========== G-buffer ==========
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormalMaterial;
+uniform sampler2D gEmission;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;     // 由深度重建世界坐标
+uniform vec3 viewPos;
+
+// ========== 光源（与shader.frag/pbr.frag相同的uniform） ==========
+uniform DirLight dirLight;              // Phong平行光，方向同时用于PBR
+uniform vec3 dirLightColor = vec3(0.0); // PBR平行光辐射度
+uniform float brightness;
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    // 背景保留清屏颜色
+    if (depth >= 1.0) discard;
+
+    vec4 albedoModel = texelFetch(gAlbedo, pixel, 0);
+    vec4 normalMaterial = texelFetch(gNormalMaterial, pixel, 0);
+    vec3 emission = texelFetch(gEmission, pixel, 0).rgb;
+    int model = DecodeShadingModel(albedoModel.a);
+    if (model == SHADING_UNLIT) {
+        FragColor = vec4(emission, 1.0);
+        return;
+    }
+
+    vec4 world = inverseViewProjection * vec4(vec3(TexCoords, depth) * 2.0 - 1.0, 1.0);
+    vec3 worldPos = world.xyz / world.w;
+    vec3 N = DecodeNormal(normalMaterial.xy);
+    vec3 V = normalize(viewPos - worldPos);
+    vec3 albedo = albedoModel.rgb;
+    ivec2 cluster = ClusterRange(worldPos);
+
+    if (model == SHADING_PHONG) {
+        float shininess = normalMaterial.z * 256.0;
+        vec3 specularColor = vec3(normalMaterial.w);
+        float shadow = 1.0 - DirectionalShadow(worldPos, N, normalize(-dirLight.direction));
+        DirLight sun = dirLight;
+        sun.ambient = VolumeAmbient(dirLight.ambient, worldPos, N);
+        vec3 result = CalcDirLight(sun, N, V, shadow, albedo, specularColor, shininess);
+        for (int i = cluster.x; i < cluster.x + cluster.y; ++i)
+            result += CalcLocalLight(FetchLight(ClusterLightIndex(i)), N, worldPos, V, albedo, specularColor, shininess);
+        FragColor = vec4(emission + result * brightness, 1.0);
+        return;
+    }
+
+    // PBR：emission中已有IBL环境光和天鹅绒项
+    float roughness = normalMaterial.z;
+    float metallic = normalMaterial.w;
+    vec3 F0 = mix(vec3(0.04), albedo, metallic);
+    vec3 Lo = vec3(0.0);
+    for (int i = cluster.x; i < cluster.x + cluster.y; ++i)
+        Lo += CalcLocalLightPBR(FetchLight(ClusterLightIndex(i)), N, V, worldPos, albedo, roughness, metallic, F0);
+    Lo += CalcDirLightPBR(dirLight.direction, dirLightColor, N, V, worldPos, albedo, roughness, metallic, F0);
+
+    vec3 color = emission + Lo;
+    color = color / (color + vec3(1.0));  // 色调映射
+    color = pow(color, vec3(1.0/2.2));    // Gamma校正
+    FragColor = vec4(color, 1.0);
+}
@@ -1,2 +1,29 @@
 #version 330 core
+#ifdef ALPHA_TEST
+// 透明度测试变体：漫反射alpha低于alphaCutoff的片段不写深度
+#ifdef LAYERED
+in vec2 gTexCoords;
+#define TEXCOORDS gTexCoords
+#else
+in vec2 vTexCoords;
+#define TEXCOORDS vTexCoords
+#endif
+uniform sampler2D alphaMap;
+uniform sampler2DArray alphaArray;
+uniform bool alphaPacked;
+uniform float alphaLayer;
+uniform vec4 alphaRect;     // 打包纹理的(缩放, 偏移)
+uniform float alphaCutoff;
+
+void main() {
+    vec2 uv = TEXCOORDS;
+    // 与shader.frag的SamplePacked相同：梯度取自连续UV，fract接缝处不跳mip
+    float alpha = alphaPacked
+        ? textureGrad(alphaArray, vec3(fract(uv) * alphaRect.xy + alphaRect.zw, alphaLayer),
+            dFdx(uv) * alphaRect.xy, dFdy(uv) * alphaRect.xy).a
+        : texture(alphaMap, uv).a;
+    if (alpha < alphaCutoff) discard;
+}
+#else
 void main() { /* 空片段着色器 */ }
+#endif
\ No newline at end of file
@@ -1,9 +1,21 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
+#ifdef ALPHA_TEST
+layout (location = 2) in vec2 aTexCoords;
+out vec2 vTexCoords;
+#endif
 uniform mat4 lightSpaceMatrix;
 uniform mat4 model;
 
 void main()
 {
+#ifdef ALPHA_TEST
+    vTexCoords = aTexCoords;
+#endif
+#ifdef LAYERED
+    // 分层渲染：输出世界坐标，由几何着色器按面变换
+    gl_Position = model * vec4(aPos, 1.0);
+#else
     gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+#endif
 }
\ No newline at end of file
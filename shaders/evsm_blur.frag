@@ -0,0 +1,47 @@
+#version 330 core
+// EVSM可分离高斯模糊
+//   FROM_DEPTH：第一遍（水平），从深度数组的一层读取深度，转换为指数矩后模糊
+//   否则：第二遍（竖直），模糊第一遍的矩
+out vec4 FragColor;
+in vec2 TexCoords;
+
+#ifdef FROM_DEPTH
+uniform sampler2DArray depthMap;    // 比较模式已临时关闭
+uniform float layer;
+uniform vec2 exponents;             // 正/负指数，16位浮点下不超过5.54
+#else
+uniform sampler2D source;
+#endif
+uniform vec2 direction;             // 一个纹素的偏移（水平或竖直）
+uniform int radius;
+
+#ifdef FROM_DEPTH
+// 深度映射到[-1,1]后做正负两个指数变形，矩为 (pos, pos^2, neg, neg^2)
+vec4 Moments(float depth) {
+    float d = depth * 2.0 - 1.0;
+    float pos = exp(exponents.x * d);
+    float neg = -exp(-exponents.y * d);
+    return vec4(pos, pos * pos, neg, neg * neg);
+}
+#endif
+
+vec4 Fetch(vec2 uv) {
+#ifdef FROM_DEPTH
+    return Moments(texture(depthMap, vec3(uv, layer)).r);
+#else
+    return texture(source, uv);
+#endif
+}
+
+void main() {
+    // sigma = radius / 2，权重在着色器中计算并归一化
+    float sigma = max(float(radius) * 0.5, 0.5);
+    vec4 sum = vec4(0.0);
+    float weightSum = 0.0;
+    for (int i = -radius; i <= radius; ++i) {
+        float w = exp(-float(i * i) / (2.0 * sigma * sigma));
+        sum += Fetch(TexCoords + direction * float(i)) * w;
+        weightSum += w;
+    }
+    FragColor = sum / weightSum;
+}
@@ -0,0 +1,9 @@
+#version 330 core
+// 全屏三角形，无顶点数据（绑定空VAO绘制3个顶点）
+out vec2 TexCoords;
+
+void main() {
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    TexCoords = pos;
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
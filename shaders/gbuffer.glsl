@@ -0,0 +1,34 @@
+// G-buffer编码（DeferredRenderer）：shader.frag/pbr.frag的DEFERRED变体写入，deferred_lighting.frag读取
+//   0 RGBA8          rgb 反照率/漫反射色，a 着色模型
+//   1 RGBA16         xy 八面体编码的法线，z 粗糙度（Phong为高光指数/256），w 金属度（Phong为高光强度）
+//   2 R11F_G11F_B10F 与光源无关的颜色：PBR的IBL环境光*AO与天鹅绒项，不受光物体的最终颜色
+
+const int SHADING_UNLIT = 0;
+const int SHADING_PHONG = 1;
+const int SHADING_PBR = 2;
+
+float EncodeShadingModel(int model) {
+    return float(model) / 255.0;
+}
+
+int DecodeShadingModel(float value) {
+    return int(value * 255.0 + 0.5);
+}
+
+// 八面体编码：单位向量投影到|x|+|y|+|z|=1再展开到[0,1]^2，两个16位通道的误差远小于法线贴图精度
+vec2 OctWrap(vec2 v) {
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 EncodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.z >= 0.0 ? n.xy : OctWrap(n.xy);
+    return e * 0.5 + 0.5;
+}
+
+vec3 DecodeNormal(vec2 e) {
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) n.xy = OctWrap(n.xy);
+    return normalize(n);
+}
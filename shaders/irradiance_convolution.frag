@@ -1,14 +1,16 @@
 #version 330 core
 out vec4 FragColor;
-in vec3 localPos;
+in vec3 LocalPos;
 
 uniform samplerCube environmentMap;
+uniform float sampleDelta = 0.025;  // 球面步长，由烘焙质量档位决定
+uniform float sourceLod = 0.0;      // 与步长匹配的源mip，避免稀疏采样时的走样
 
 const float PI = 3.14159265359;
 
 
 void main() {
-    vec3 normal = normalize(localPos);
+    vec3 normal = normalize(LocalPos);
     vec3 irradiance = vec3(0.0);
     
     // 正交基向量
@@ -16,7 +18,6 @@ void main() {
     vec3 right = normalize(cross(up, normal));
     up = normalize(cross(normal, right));
     
-    float sampleDelta = 0.025;
     int sampleCount = 0;
     for(float phi = 0.0; phi < 2.0 * PI; phi += sampleDelta) {
         for(float theta = 0.0; theta < 0.5 * PI; theta += sampleDelta) {
@@ -24,7 +25,7 @@ void main() {
             vec3 tangentSample = vec3(sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta));
             vec3 worldSample = tangentSample.x * right + tangentSample.y * up + tangentSample.z * normal;
             
-            irradiance += texture(environmentMap, worldSample).rgb * cos(theta) * sin(theta);
+            irradiance += textureLod(environmentMap, worldSample, sourceLod).rgb * cos(theta) * sin(theta);
             sampleCount++;
         }
     }
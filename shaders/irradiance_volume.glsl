@@ -0,0 +1,35 @@
+// 辐照度体积（IrradianceVolume）：规则网格探针的L1球谐，三张RGBA16F三维纹理分别存放R/G/B通道的(c0, c1, c2, c3)
+// 由shader.frag、pbr.frag和deferred_lighting.frag包含，uniform由IrradianceVolume::Apply设置
+uniform sampler3D irradianceVolumeR;
+uniform sampler3D irradianceVolumeG;
+uniform sampler3D irradianceVolumeB;
+uniform bool irradianceVolumeEnabled = false;
+uniform vec3 volumeMin;
+uniform vec3 volumeMax;
+uniform vec3 volumeResolution;      // 每个轴上的探针数
+
+// 返回rgb = 辐照度 / PI（与IBL辐照度贴图相同的量），a = 权重（体积外为0，边缘一个格子内过渡）
+vec4 SampleIrradianceVolume(vec3 worldPos, vec3 N) {
+    if (!irradianceVolumeEnabled) return vec4(0.0);
+    vec3 cellSize = (volumeMax - volumeMin) / (volumeResolution - 1.0);
+    // 沿法线偏移半个格子，减少表面两侧探针的相互泄漏
+    vec3 p = worldPos + N * (0.5 * min(cellSize.x, min(cellSize.y, cellSize.z)));
+    vec3 cells = (p - volumeMin) / cellSize;
+    vec3 inside = min(cells, volumeResolution - 1.0 - cells);
+    float weight = clamp(1.0 + min(inside.x, min(inside.y, inside.z)), 0.0, 1.0);
+    if (weight <= 0.0) return vec4(0.0);
+
+    // 探针位于纹素中心，硬件三线性插值系数后再求值
+    vec3 uvw = (clamp(cells, vec3(0.0), volumeResolution - 1.0) + 0.5) / volumeResolution;
+    vec4 r = texture(irradianceVolumeR, uvw);
+    vec4 g = texture(irradianceVolumeG, uvw);
+    vec4 b = texture(irradianceVolumeB, uvw);
+    vec4 basis = vec4(0.282095, 0.488603 * N.y, 0.488603 * N.z, 0.488603 * N.x);
+    return vec4(max(vec3(dot(r, basis), dot(g, basis), dot(b, basis)), vec3(0.0)), weight);
+}
+
+// Phong环境光：Phong的漫反射不除以PI，体积辐照度按相同约定换算后与常量环境光混合
+vec3 VolumeAmbient(vec3 ambient, vec3 worldPos, vec3 N) {
+    vec4 volume = SampleIrradianceVolume(worldPos, N);
+    return mix(ambient, volume.rgb * 3.14159265, volume.a);
+}
@@ -1,14 +1,21 @@
 #version 330 core
-out vec4 FragColor;
 in vec2 TexCoords;
 in vec3 WorldPos;
 in vec3 Normal;
 in mat3 TBN;
 
 // ========== IBL纹理 ==========
+#ifdef SH_IRRADIANCE
+uniform vec3 shCoefficients[9];     // L2球谐辐照度（已含余弦卷积与1/PI），两个探针的混合在CPU上完成
+#else
 uniform samplerCube irradianceMap;
+uniform samplerCube irradianceMapB;
+#endif
 uniform samplerCube prefilterMap;
+uniform samplerCube prefilterMapB;  // 第二个环境探针（ProbeManager选择）
+uniform float probeBlend = 0.0;     // 第二个探针的权重，为0时不采样
 uniform sampler2D brdfLUT;
+uniform float maxReflectionLod = 4.0;   // 预滤波贴图的最高mip（随烘焙质量档位变化）
 
 // ========== 材质纹理 ==========
 uniform sampler2D albedoMap;
@@ -29,46 +36,43 @@ uniform float velvetRoughness;      // 天鹅绒材质粗糙度
 uniform float velvetMetallic;       // 天鹅绒材质金属度
 
 // ========== 光照参数 ==========
-uniform vec3 lightPositions[4];
-uniform vec3 lightColors[4];
 uniform vec3 viewPos;
+uniform vec3 dirLightDirection = vec3(-0.5, -1.0, -0.5);
+uniform vec3 dirLightColor = vec3(0.0);  // 平行光辐射度，与shader.frag共用同一个光源
+
+// ========== 阴影、分簇光源和PBR直接光照 ==========
+#include "pbr_lighting.glsl"
+// 烘焙的辐照度体积：体积内替代环境探针的漫反射辐照度
+#include "irradiance_volume.glsl"
 
 // ========== 调试控制 ==========
 uniform int debugMode = 0;
 
-const float PI = 3.14159265359;
-
-// ===================== PBR核心函数 =====================
-float DistributionGGX(vec3 N, vec3 H, float roughness) {
-    float a = roughness * roughness;
-    float a2 = a * a;
-    float NdotH = max(dot(N, H), 0.0);
-    float NdotH2 = NdotH * NdotH;
-    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
-    return a2 / (PI * denom * denom);
-}
-
-float GeometrySchlickGGX(float NdotV, float roughness) {
-    float r = (roughness + 1.0);
-    float k = (r * r) / 8.0;
-    return NdotV / (NdotV * (1.0 - k) + k);
-}
-
-float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness) {
-    float NdotV = max(dot(N, V), 0.0);
-    float NdotL = max(dot(N, L), 0.0);
-    float ggx2 = GeometrySchlickGGX(NdotV, roughness);
-    float ggx1 = GeometrySchlickGGX(NdotL, roughness);
-    return ggx1 * ggx2;
-}
-
-vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness) {
-    return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(1.0 - cosTheta, 5.0);
-}
-
-vec3 fresnelSchlick(float cosTheta, vec3 F0) {
-    return F0 + (1.0 - F0) * pow(1.0 - cosTheta, 5.0);
+#ifdef DEFERRED
+// 延迟着色的几何阶段：写入G-buffer，编码见gbuffer.glsl
+#include "gbuffer.glsl"
+layout(location = 0) out vec4 gAlbedo;
+layout(location = 1) out vec4 gNormalMaterial;
+layout(location = 2) out vec3 gEmission;
+#else
+out vec4 FragColor;
+#endif
+
+#ifdef SH_IRRADIANCE
+// 球谐基函数顺序与SphericalHarmonics.cpp一致
+vec3 EvaluateSH(vec3 n) {
+    vec3 result = shCoefficients[0] * 0.282095
+        + shCoefficients[1] * (0.488603 * n.y)
+        + shCoefficients[2] * (0.488603 * n.z)
+        + shCoefficients[3] * (0.488603 * n.x)
+        + shCoefficients[4] * (1.092548 * n.x * n.y)
+        + shCoefficients[5] * (1.092548 * n.y * n.z)
+        + shCoefficients[6] * (0.315392 * (3.0 * n.z * n.z - 1.0))
+        + shCoefficients[7] * (1.092548 * n.x * n.z)
+        + shCoefficients[8] * (0.546274 * (n.x * n.x - n.y * n.y));
+    return max(result, vec3(0.0));
 }
+#endif
 
 // 1. 天鹅绒BRDF分布函数（Charlie分布）
 float DistributionVelvet(float roughness, float NoH) {
@@ -120,46 +124,29 @@ void main() {
     vec3 kS = F;
     vec3 kD = 1.0 - kS;
     kD *= 1.0 - finalMetallic;
+#ifdef SH_IRRADIANCE
+    vec3 irradiance = EvaluateSH(normal);
+#else
     vec3 irradiance = texture(irradianceMap, normal).rgb;
+    if (probeBlend > 0.0)
+        irradiance = mix(irradiance, texture(irradianceMapB, normal).rgb, probeBlend);
+#endif
+    vec4 volumeIrradiance = SampleIrradianceVolume(WorldPos, normal);
+    irradiance = mix(irradiance, volumeIrradiance.rgb, volumeIrradiance.a);
     vec3 diffuse = irradiance * albedo;
     
     // 镜面反射部分
     vec3 R = reflect(-V, normal);
-    const float MAX_REFLECTION_LOD = 4.0;
-    vec3 prefilteredColor = textureLod(prefilterMap, R, finalRoughness * MAX_REFLECTION_LOD).rgb;
+    vec3 prefilteredColor = textureLod(prefilterMap, R, finalRoughness * maxReflectionLod).rgb;
+    if (probeBlend > 0.0)
+        prefilteredColor = mix(prefilteredColor, textureLod(prefilterMapB, R, finalRoughness * maxReflectionLod).rgb, probeBlend);
     vec2 brdf = texture(brdfLUT, vec2(max(dot(normal, V), 0.0), finalRoughness)).rg;
     vec3 specular = prefilteredColor * (F * brdf.x + brdf.y);
     
     // 环境光组合
     vec3 ambient = (kD * diffuse + specular) * aoVal;
     
-    // 直接光照计算
-    vec3 Lo = vec3(0.0);
-    for(int i = 0; i < 4; i++) {
-        vec3 L = normalize(lightPositions[i] - WorldPos);
-        vec3 H = normalize(V + L);
-        float distance = length(lightPositions[i] - WorldPos);
-        float attenuation = 1.0 / (distance * distance);
-        vec3 radiance = lightColors[i] * attenuation;
-        
-        // BRDF计算
-        float NDF = DistributionGGX(normal, H, finalRoughness);
-        float G = GeometrySmith(normal, V, L, finalRoughness);
-        vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
-        
-        vec3 kS = F;
-        vec3 kD = vec3(1.0) - kS;
-        kD *= 1.0 - finalMetallic;
-        
-        vec3 numerator = NDF * G * F;
-        float denominator = 4.0 * max(dot(normal, V), 0.0) * max(dot(normal, L), 0.0);
-        vec3 brdfSpecular = numerator / max(denominator, 0.001);
-        
-        // 光源贡献
-        float NdotL = max(dot(normal, L), 0.0);
-        Lo += (kD * albedo / PI + brdfSpecular) * radiance * NdotL;
-    }
-        // === 在直接光照循环后添加 ===
+    // 天鹅绒项（与光源无关）
     vec3 velvetTerm = vec3(0.0);
     if (useVelvet && maskVal > 0.01) {
         // 计算绒毛方向向量
@@ -180,6 +167,29 @@ void main() {
         velvetTerm = velvetColor * D_velvet * F_velvet * 
                      velvetStrength * energyCompensation;
     }
+#ifdef DEFERRED
+    // 几何阶段：与光源无关的环境光和天鹅绒项直接写入，直接光照在全屏阶段计算
+    if (debugMode != 0) {
+        vec3 debugColor = debugMode == 1 ? normal * 0.5 + 0.5 : debugMode == 2 ? vec3(aoVal) : albedo;
+        gAlbedo = vec4(0.0, 0.0, 0.0, EncodeShadingModel(SHADING_UNLIT));
+        gEmission = debugColor;
+    }
+    else {
+        gAlbedo = vec4(albedo, EncodeShadingModel(SHADING_PBR));
+        gEmission = ambient + velvetTerm;
+    }
+    gNormalMaterial = vec4(EncodeNormal(normal), finalRoughness, finalMetallic);
+#else
+    // 直接光照计算
+    vec3 Lo = vec3(0.0);
+    // 点光源/聚光灯：只遍历片段所在簇的光源
+    ivec2 cluster = ClusterRange(WorldPos);
+    for (int i = cluster.x; i < cluster.x + cluster.y; ++i)
+        Lo += CalcLocalLightPBR(FetchLight(ClusterLightIndex(i)), normal, V, WorldPos, albedo, finalRoughness,
+            finalMetallic, F0);
+    // 平行光（带级联阴影）
+    Lo += CalcDirLightPBR(dirLightDirection, dirLightColor, normal, V, WorldPos, albedo, finalRoughness, finalMetallic, F0);
+
     // 最终颜色组合
     vec3 color = ambient + Lo +velvetTerm;
     color = color / (color + vec3(1.0));  // ACES色调映射
@@ -190,4 +200,5 @@ void main() {
     else if(debugMode == 2) FragColor = vec4(vec3(aoVal), 1.0);
     else if(debugMode == 3) FragColor = vec4(albedo, 1.0);
     else FragColor = vec4(color, 1.0);
+#endif
 }
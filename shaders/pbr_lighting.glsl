@@ -0,0 +1,76 @@
+// PBR直接光照（Cook-Torrance GGX）：pbr.frag前向着色和deferred_lighting.frag延迟光照共用
+#include "clustered_lights.glsl"
+
+const float PI = 3.14159265359;
+
+// ===================== PBR核心函数 =====================
+float DistributionGGX(vec3 N, vec3 H, float roughness) {
+    float a = roughness * roughness;
+    float a2 = a * a;
+    float NdotH = max(dot(N, H), 0.0);
+    float NdotH2 = NdotH * NdotH;
+    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
+    return a2 / (PI * denom * denom);
+}
+
+float GeometrySchlickGGX(float NdotV, float roughness) {
+    float r = (roughness + 1.0);
+    float k = (r * r) / 8.0;
+    return NdotV / (NdotV * (1.0 - k) + k);
+}
+
+float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness) {
+    float NdotV = max(dot(N, V), 0.0);
+    float NdotL = max(dot(N, L), 0.0);
+    float ggx2 = GeometrySchlickGGX(NdotV, roughness);
+    float ggx1 = GeometrySchlickGGX(NdotL, roughness);
+    return ggx1 * ggx2;
+}
+
+vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness) {
+    return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(1.0 - cosTheta, 5.0);
+}
+
+vec3 fresnelSchlick(float cosTheta, vec3 F0) {
+    return F0 + (1.0 - F0) * pow(1.0 - cosTheta, 5.0);
+}
+
+// 单位辐射度下的反射（漫反射 + GGX镜面），已乘NdotL
+vec3 BRDF(vec3 N, vec3 V, vec3 L, vec3 albedo, float roughness, float metallic, vec3 F0) {
+    vec3 H = normalize(V + L);
+    float NDF = DistributionGGX(N, H, roughness);
+    float G = GeometrySmith(N, V, L, roughness);
+    vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
+
+    vec3 kS = F;
+    vec3 kD = vec3(1.0) - kS;
+    kD *= 1.0 - metallic;
+
+    float NdotL = max(dot(N, L), 0.0);
+    vec3 numerator = NDF * G * F;
+    float denominator = 4.0 * max(dot(N, V), 0.0) * NdotL;
+    vec3 brdfSpecular = numerator / max(denominator, 0.001);
+    return (kD * albedo / PI + brdfSpecular) * NdotL;
+}
+
+// 点光源/聚光灯（分簇光源表中的一项）：平方反比衰减，在光源范围边缘平滑降到0
+vec3 CalcLocalLightPBR(LocalLight light, vec3 N, vec3 V, vec3 worldPos, vec3 albedo, float roughness, float metallic,
+    vec3 F0) {
+    vec3 toLight = light.position - worldPos;
+    float distance = length(toLight);
+    if (distance > light.range) return vec3(0.0);
+    vec3 L = toLight / max(distance, 1e-4);
+    float window = clamp(1.0 - pow(distance / light.range, 4.0), 0.0, 1.0);
+    float attenuation = window * window / max(distance * distance, 1e-4);
+    vec3 radiance = light.diffuse * attenuation * SpotFactor(light, L) * LocalShadow(light, worldPos, N);
+    return BRDF(N, V, L, albedo, roughness, metallic, F0) * radiance;
+}
+
+// 平行光（带级联阴影），lightDirection为光线传播方向
+vec3 CalcDirLightPBR(vec3 lightDirection, vec3 lightColor, vec3 N, vec3 V, vec3 worldPos, vec3 albedo,
+    float roughness, float metallic, vec3 F0) {
+    if (dot(lightColor, lightColor) <= 0.0) return vec3(0.0);
+    vec3 L = normalize(-lightDirection);
+    if (dot(N, L) <= 0.0) return vec3(0.0);
+    return BRDF(N, V, L, albedo, roughness, metallic, F0) * lightColor * DirectionalShadow(worldPos, N, L);
+}
@@ -0,0 +1,56 @@
+// Phong光照模型：shader.frag前向着色和deferred_lighting.frag延迟光照共用
+#include "clustered_lights.glsl"
+
+struct DirLight {
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+// 平行光，shadow为遮挡比例（0 完全受光）
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, float shadow, vec3 diffuseColor, vec3 specularColor,
+    float shininess) {
+    vec3 lightDir = normalize(-light.direction);
+
+    // 环境光
+    vec3 ambient = light.ambient * diffuseColor;
+
+    // 漫反射
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 diffuse = light.diffuse * diff * diffuseColor;
+
+    // 镜面光
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    vec3 specular = light.specular * spec * specularColor;
+
+    // 应用阴影
+    return ambient + (1.0 - shadow) * (diffuse + specular);
+}
+
+// 点光源/聚光灯（分簇光源表中的一项）
+vec3 CalcLocalLight(LocalLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor,
+    float shininess) {
+    // 距离衰减
+    float distance = length(light.position - fragPos);
+    if (distance > light.range) return vec3(0.0);
+    float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance + light.attenuation.z * (distance * distance));
+
+    vec3 lightDir = (light.position - fragPos) / max(distance, 1e-4);
+
+    // 环境光
+    vec3 ambient = light.ambient * diffuseColor;
+
+    // 漫反射
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 diffuse = light.diffuse * diff * diffuseColor;
+
+    // 镜面光
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    vec3 specular = light.specular * spec * specularColor;
+
+    float intensity = SpotFactor(light, lightDir);
+    return (ambient + (diffuse + specular) * intensity * LocalShadow(light, fragPos, normal)) * attenuation;
+}
@@ -1,11 +1,17 @@
 #version 330 core
 out vec4 FragColor;
-in vec3 localPos;
+in vec3 LocalPos;
 
 uniform samplerCube environmentMap;
 uniform float roughness;
-
-const float MAX_REFLECTION_LOD = 4.0;
+uniform int sampleCount = 1024;      // 由烘焙质量档位决定
+uniform float envResolution = 512.0; // 环境立方体贴图的面分辨率
+uniform bool mipFiltered = true;     // 按样本PDF选择源mip；关闭时全部从mip0采样（参考档位）
+// 样本分批：每次绘制只处理 [sampleStart, sampleEnd)，结果除以全部样本的总权重后加性混合累加
+// 视线V = N时权重NdotL与N无关，总权重由CPU按粗糙度算出
+uniform int sampleStart = 0;
+uniform int sampleEnd = 1024;
+uniform float totalWeight = 1.0;
 #define PI 3.1415926535897932384626433832795
 
 // 共享的Hammersley序列生成函数
@@ -53,15 +59,14 @@ vec3 ImportanceSampleGGX(vec2 Xi, vec3 N, float roughness) {
 }
 
 void main() {
-    vec3 N = normalize(localPos);
+    vec3 N = normalize(LocalPos);
     vec3 R = N;
     vec3 V = R;
     
-    const uint SAMPLE_COUNT = 1024u;
+    uint SAMPLE_COUNT = uint(sampleCount);
     vec3 prefilteredColor = vec3(0.0);
-    float totalWeight = 0.0;
     
-    for(uint i = 0u; i < SAMPLE_COUNT; ++i) {
+    for(uint i = uint(sampleStart); i < uint(sampleEnd); ++i) {
         vec2 Xi = Hammersley(i, SAMPLE_COUNT);
         vec3 H = ImportanceSampleGGX(Xi, N, roughness);
         vec3 L = normalize(2.0 * dot(V, H) * H - V);
@@ -74,13 +79,11 @@ void main() {
             float HdotV = max(dot(H, V), 0.0);
             float pdf = D * NdotH / (4.0 * HdotV) + 0.0001;
             
-            float resolution = 512.0; // 立方体贴图分辨率
-            float saTexel = 4.0 * PI / (6.0 * resolution * resolution);
-            float saSample = 1.0 / (SAMPLE_COUNT * pdf + 0.0001);
-            float mipLevel = roughness == 0.0 ? 0.0 : 0.5 * log2(saSample / saTexel);
+            float saTexel = 4.0 * PI / (6.0 * envResolution * envResolution);
+            float saSample = 1.0 / (float(SAMPLE_COUNT) * pdf + 0.0001);
+            float mipLevel = (roughness == 0.0 || !mipFiltered) ? 0.0 : 0.5 * log2(saSample / saTexel);
             
             prefilteredColor += textureLod(environmentMap, L, mipLevel).rgb * NdotL;
-            totalWeight += NdotL;
         }
     }
     
@@ -1,8 +1,11 @@
 #version 330 core
+// BINDLESS变体由Shader按GLSL_VERSION宏改写为#version 400 core（扩展要求GLSL 4.00）
+#ifdef BINDLESS
+#extension GL_ARB_bindless_texture : require
+#endif
 in vec2 TexCoord;
 in vec3 FragPos;
 in vec3 Normal;
-in vec4 FragPosLightSpace;
 uniform float normalStrength = 0.8; // 新增法线强度控制
 // ========== 关键修复：先定义结构体，再声明uniform变量 ==========
 struct Material {
@@ -15,187 +18,117 @@ struct Material {
 uniform bool hasDiffuseTexture;
 uniform bool hasSpecularTexture;
 
-struct DirLight {
-    vec3 direction;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
+// 打包的纹理（数组层/图集）：rect = (缩放u, 缩放v, 偏移u, 偏移v)
+uniform sampler2DArray diffuseArray;
+uniform sampler2DArray specularArray;
+uniform bool diffusePacked = false;
+uniform bool specularPacked = false;
+uniform float diffuseLayer;
+uniform float specularLayer;
+uniform vec4 diffuseRect;
+uniform vec4 specularRect;
 
-struct PointLight {
-    vec3 position;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-    float constant;
-    float linear;
-    float quadratic;
+#ifdef BINDLESS
+// 句柄表：std140下每个uvec4存两个64位句柄
+layout(std140) uniform TextureHandles {
+    uvec4 handles[1024];
 };
+uniform int diffuseIndex;
+uniform int specularIndex;
 
-struct SpotLight {
-    vec3 position;
-    vec3 direction;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-    float cutOff;
-    float outerCutOff;
-    float constant;
-    float linear;
-    float quadratic;
-};
+uvec2 TextureHandle(int index) {
+    uvec4 pair = handles[index >> 1];
+    return (index & 1) == 0 ? pair.xy : pair.zw;
+}
+#endif
+
+// fract实现图集内平铺，梯度取自原始UV，避免单元格边界处选到错误的mip
+vec4 SamplePacked(sampler2DArray tex, float layer, vec4 rect, vec2 uv) {
+    vec2 packedUV = fract(uv) * rect.xy + rect.zw;
+    return textureGrad(tex, vec3(packedUV, layer), dFdx(uv) * rect.xy, dFdy(uv) * rect.xy);
+}
+
+// 阴影、分簇光源和Phong光照函数
+#include "phong_lighting.glsl"
+// 烘焙的辐照度体积（替代常量环境光）
+#include "irradiance_volume.glsl"
 
-// ========== 现在声明uniform变量 ==========
-uniform sampler2D shadowMap;
 uniform Material material;
 uniform DirLight dirLight;
-uniform PointLight pointLights[2];
-uniform SpotLight spotLight;
-uniform bool enableSoftShadows = true; // 软阴影开关
 uniform vec3 viewPos;
 uniform bool useColorOnly = false;
 uniform vec3 diffuseColor;
 uniform float brightness;
+#ifdef LIGHTMAPPED
+// 烘焙的辐照度（RGB9E5，平行光/静态点光源的直接光照 + 间接光，与Phong漫反射相同的约定）
+in vec2 LightmapUV;
+uniform sampler2D lightmap;
+#endif
+#ifdef DEFERRED
+// 延迟着色的几何阶段：写入G-buffer，编码见gbuffer.glsl
+#include "gbuffer.glsl"
+layout(location = 0) out vec4 gAlbedo;
+layout(location = 1) out vec4 gNormalMaterial;
+layout(location = 2) out vec3 gEmission;
+#else
 out vec4 FragColor;
+#endif
 
-// ========== 阴影计算函数 ==========
-float ShadowCalculation(vec4 fragPosLightSpace, vec3 normal) {
-    // 透视除法
-    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
-    projCoords = projCoords * 0.5 + 0.5;
-    vec3 lightDir = normalize(glm::vec3(-0.5f, -1.0f, -0.5f));
-    // 完整范围检查
-    if(projCoords.z > 1.0 || 
-       projCoords.x < 0.0 || projCoords.x > 1.0 || 
-       projCoords.y < 0.0 || projCoords.y > 1.0) {
-        return 0.0;
-    }
-    
-    // 动态bias减少acne现象
-    float bias = max(0.01 * (1.0 - dot(normal, lightDir)), 0.001);//这里前一个0.05，后一个0.005原来是
-    
-    // 根据开关选择软/硬阴影
-    if (enableSoftShadows) {
-        // 5x5 PCF采样
-        float shadow = 0.0;
-        vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
-        for(int x = -2; x <= 2; ++x) {
-            for(int y = -2; y <= 2; ++y) {
-                float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r; 
-                shadow += (projCoords.z - bias) > pcfDepth ? 1.0 : 0.0;
-            }    
-        }
-        shadow /= 25.0;
-        return shadow;
-    } else {
-        // 硬阴影计算
-        float closestDepth = texture(shadowMap, projCoords.xy).r;
-        return (projCoords.z - bias) > closestDepth ? 1.0 : 0.0;
+// 没有登记句柄（句柄表已满等）的纹理下标为-1，退回绑定到纹理单元的采样器
+vec3 SampleDiffuse(vec2 uv) {
+#ifdef BINDLESS
+    if (diffuseIndex >= 0) {
+        uvec2 handle = TextureHandle(diffuseIndex);
+        return diffusePacked ? SamplePacked(sampler2DArray(handle), diffuseLayer, diffuseRect, uv).rgb
+            : texture(sampler2D(handle), uv).rgb;
     }
+#endif
+    return diffusePacked ? SamplePacked(diffuseArray, diffuseLayer, diffuseRect, uv).rgb
+        : texture(material.texture_diffuse, uv).rgb;
 }
 
-// ========== 光照计算函数 ==========
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, float shadow) {
-    vec3 lightDir = normalize(-light.direction);
-    
-    // 漫反射颜色
-    vec3 diffuseColor = hasDiffuseTexture ? 
-        texture(material.texture_diffuse, TexCoord).rgb : 
-        vec3(0.8, 0.8, 0.8);
-    
-    // 镜面反射颜色
-    vec3 specularColor = hasSpecularTexture ? 
-        texture(material.texture_specular, TexCoord).rgb : 
-        vec3(0.3);
-    
-    // 环境光
-    vec3 ambient = light.ambient * diffuseColor;
-    
-    // 漫反射
-    float diff = max(dot(normal, lightDir), 0.0);
-    vec3 diffuse = light.diffuse * diff * diffuseColor;
-    
-    // 镜面光
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    vec3 specular = light.specular * spec * specularColor;
-    
-    // 应用阴影
-    return ambient + (1.0 - shadow) * (diffuse + specular);
-    // vec3 lightDir = normalize(-light.direction);
-    
-    // // 环境光
-    // vec3 ambient = light.ambient * texture(material.texture_diffuse1, TexCoord).rgb; 
-    
-    // // 漫反射
-    // float diff = max(dot(normal, lightDir), 0.0);
-    // vec3 diffuse = light.diffuse * diff * texture(material.texture_diffuse1, TexCoord).rgb; 
-    
-    // // 镜面光
-    // vec3 reflectDir = reflect(-lightDir, normal);
-    // float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    // vec3 specular = light.specular * spec * texture(material.texture_specular1, TexCoord).rgb;
-    
-    // // 应用阴影
-    // return ambient + (1.0 - shadow) * (diffuse + specular);
-}
-
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
-    // 距离衰减
-    float distance = length(light.position - fragPos);
-    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
-    
-    vec3 lightDir = normalize(light.position - fragPos);
-    
-    // 环境光
-    vec3 ambient = light.ambient * texture(material.texture_diffuse1, TexCoord).rgb;
-    
-    // 漫反射
-    float diff = max(dot(normal, lightDir), 0.0);
-    vec3 diffuse = light.diffuse * diff * texture(material.texture_diffuse1, TexCoord).rgb;
-    
-    // 镜面光
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    vec3 specular = light.specular * spec * texture(material.texture_specular1, TexCoord).rgb;
-        // 修复2: 使用新版纹理名称
-    vec3 diffuseColor = hasDiffuseTexture ? 
-        texture(material.texture_diffuse, TexCoord).rgb : 
-        vec3(0.8, 0.8, 0.8);
-    
-    vec3 specularColor = hasSpecularTexture ? 
-        texture(material.texture_specular, TexCoord).rgb : 
-        vec3(0.3);
-    return (ambient + diffuse + specular) * attenuation;
-}
-
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
-    vec3 lightDir = normalize(light.position - fragPos);
-    float theta = dot(lightDir, normalize(-light.direction));
-    float epsilon = light.cutOff - light.outerCutOff;
-    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
-    
-    // 距离衰减
-    float distance = length(light.position - fragPos);
-    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
-    
-    // 环境光
-    vec3 ambient = light.ambient * texture(material.texture_diffuse1, TexCoord).rgb;
-    
-    // 漫反射
-    float diff = max(dot(normal, lightDir), 0.0);
-    vec3 diffuse = light.diffuse * diff * texture(material.texture_diffuse1, TexCoord).rgb;
-    
-    // 镜面光
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    vec3 specular = light.specular * spec * texture(material.texture_specular1, TexCoord).rgb;
-    
-    return (ambient + (diffuse + specular) * intensity) * attenuation;
+vec3 SampleSpecular(vec2 uv) {
+#ifdef BINDLESS
+    if (specularIndex >= 0) {
+        uvec2 handle = TextureHandle(specularIndex);
+        return specularPacked ? SamplePacked(sampler2DArray(handle), specularLayer, specularRect, uv).rgb
+            : texture(sampler2D(handle), uv).rgb;
+    }
+#endif
+    return specularPacked ? SamplePacked(specularArray, specularLayer, specularRect, uv).rgb
+        : texture(material.texture_specular, uv).rgb;
 }
 
 // ========== 主函数 ==========
 void main() {
+#ifdef LIGHTMAPPED
+    // 静态表面：漫反射颜色 * 光照贴图，不计算阴影和动态光源（没有高光）
+    vec3 lightmapped = (hasDiffuseTexture ? SampleDiffuse(TexCoord) : vec3(0.8)) * texture(lightmap, LightmapUV).rgb;
+#ifdef DEFERRED
+    // 写为UNLIT，光照阶段直接输出；光照贴图含平行光直接光，与前向路径相同乘brightness
+    gAlbedo = vec4(0.0, 0.0, 0.0, EncodeShadingModel(SHADING_UNLIT));
+    gNormalMaterial = vec4(EncodeNormal(normalize(Normal)), 0.0, 0.0);
+    gEmission = lightmapped * brightness;
+#else
+    FragColor = vec4(lightmapped * brightness, 1.0);
+#endif
+    return;
+#endif
+#ifdef DEFERRED
+    if (useColorOnly) {
+        gAlbedo = vec4(0.0, 0.0, 0.0, EncodeShadingModel(SHADING_UNLIT));
+        gNormalMaterial = vec4(EncodeNormal(normalize(Normal)), 0.0, 0.0);
+        gEmission = diffuseColor;
+        return;
+    }
+    vec3 surfaceDiffuse = hasDiffuseTexture ? SampleDiffuse(TexCoord) : vec3(0.8, 0.8, 0.8);
+    vec3 surfaceSpecular = hasSpecularTexture ? SampleSpecular(TexCoord) : vec3(0.3);
+    // 高光颜色按亮度压缩为一个强度（高光贴图为灰度），高光指数按256归一化
+    gAlbedo = vec4(surfaceDiffuse, EncodeShadingModel(SHADING_PHONG));
+    gNormalMaterial = vec4(EncodeNormal(normalize(Normal)), clamp(material.shininess / 256.0, 0.0, 1.0),
+        dot(surfaceSpecular, vec3(0.2126, 0.7152, 0.0722)));
+    gEmission = vec3(0.0);
+#else
     if (useColorOnly) {
         FragColor = vec4(diffuseColor, 1.0);
         return;
@@ -206,18 +139,21 @@ void main() {
     vec3 lightDir = normalize(-dirLight.direction); // 从片段指向光源
     
     // 计算阴影
-    float shadow = ShadowCalculation(FragPosLightSpace, norm);
+    float shadow = 1.0 - DirectionalShadow(FragPos, norm, lightDir);
     
     // 计算各光源的贡献
-    vec3 result = CalcDirLight(dirLight, norm, viewDir, shadow); // 平行光
+    vec3 surfaceDiffuse = hasDiffuseTexture ? SampleDiffuse(TexCoord) : vec3(0.8, 0.8, 0.8);
+    vec3 surfaceSpecular = hasSpecularTexture ? SampleSpecular(TexCoord) : vec3(0.3);
+    DirLight sun = dirLight;
+    sun.ambient = VolumeAmbient(dirLight.ambient, FragPos, norm);
+    vec3 result = CalcDirLight(sun, norm, viewDir, shadow, surfaceDiffuse, surfaceSpecular, material.shininess); // 平行光
 
-    // 点光源贡献
-    for(int i = 0; i < 2; i++) {
-        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);
-    }
-    
-    // 聚光灯贡献
-    result += CalcSpotLight(spotLight, norm, FragPos, viewDir);
+    // 点光源/聚光灯贡献：只遍历片段所在簇的光源
+    ivec2 cluster = ClusterRange(FragPos);
+    for (int i = cluster.x; i < cluster.x + cluster.y; ++i)
+        result += CalcLocalLight(FetchLight(ClusterLightIndex(i)), norm, FragPos, viewDir, surfaceDiffuse, surfaceSpecular,
+            material.shininess);
 
     FragColor = vec4(result * brightness, 1.0);
+#endif
 }
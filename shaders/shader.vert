@@ -2,21 +2,25 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoord;
 layout (location = 2) in vec3 aNormal;
+#ifdef LIGHTMAPPED
+layout (location = 4) in vec2 aLightmapUV;     // Lightmapper生成的第二套UV
+out vec2 LightmapUV;
+#endif
 
 out vec2 TexCoord;
 out vec3 FragPos;
 out vec3 Normal;
-out vec4 FragPosLightSpace;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
-uniform mat4 lightSpaceMatrix;
 
 void main() {
-    FragPosLightSpace = lightSpaceMatrix * model * vec4(aPos, 1.0);
     FragPos = vec3(model * vec4(aPos, 1.0));
     Normal = mat3(transpose(inverse(model))) * aNormal;
     TexCoord = aTexCoord;
+#ifdef LIGHTMAPPED
+    LightmapUV = aLightmapUV;
+#endif
     gl_Position = projection * view * model * vec4(aPos, 1.0);
 }
@@ -0,0 +1,113 @@
+// 阴影采样：平行光级联阴影（ShadowMapper）与局部光源阴影图集（ShadowAtlas）
+// 由shader.frag、pbr.frag和deferred_lighting.frag包含，uniform由ShadowMapper::Apply/ShadowAtlas::Apply设置
+
+// ========== 级联阴影 ==========
+// 每层一个级联，按视空间深度选择
+const int MAX_CASCADES = 4;
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 lightSpaceMatrices[MAX_CASCADES];
+uniform float cascadeSplits[MAX_CASCADES];   // 各级远端的视空间深度
+uniform float cascadeBias[MAX_CASCADES];     // 各级一个纹素对应的深度增量
+uniform int cascadeCount = 0;
+uniform mat4 view;
+uniform sampler2DArray shadowMoments;      // EVSM矩（带mip），shadowFilter为3时使用
+uniform int shadowFilter = 2;               // 0 硬阴影，1 PCF 3x3，2 PCF 5x5，3 EVSM
+uniform vec2 evsmExponents = vec2(5.54);
+uniform float evsmBleedReduction = 0.2;
+
+// ========== 局部光源阴影图集 ==========
+// tile的矩阵、图集矩形（缩放xy、偏移zw）和参数
+uniform sampler2DShadow shadowAtlas;
+struct ShadowTile {
+    mat4 matrix;
+    vec4 rect;
+    vec4 params;    // x: 单位距离上一个纹素的世界尺寸
+};
+layout(std140) uniform ShadowTiles {
+    ShadowTile shadowTiles[64];
+};
+
+// 单边切比雪夫上界
+float Chebyshev(vec2 moments, float mean, float minVariance) {
+    float variance = max(moments.y - moments.x * moments.x, minVariance);
+    float d = mean - moments.x;
+    return mean <= moments.x ? 1.0 : variance / (variance + d * d);
+}
+
+// 级联的受光比例：PCF为 (2 * shadowFilter + 1)^2 次硬件比较采样，EVSM为一次三线性/各向异性采样
+float CascadeLit(int cascade, vec2 uv, float ref) {
+    if (shadowFilter == 3) {
+        vec4 moments = texture(shadowMoments, vec3(uv, float(cascade)));
+        float d = ref * 2.0 - 1.0;
+        float pos = exp(evsmExponents.x * d);
+        float neg = -exp(-evsmExponents.y * d);
+        // 最小方差随变形后深度的导数缩放
+        vec2 depthScale = 0.0001 * evsmExponents * vec2(pos, -neg);
+        float lit = min(Chebyshev(moments.xy, pos, depthScale.x * depthScale.x),
+            Chebyshev(moments.zw, neg, depthScale.y * depthScale.y));
+        // 漏光抑制
+        return clamp((lit - evsmBleedReduction) / (1.0 - evsmBleedReduction), 0.0, 1.0);
+    }
+    int radius = shadowFilter;
+    float lit = 0.0;
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    for (int x = -radius; x <= radius; ++x)
+        for (int y = -radius; y <= radius; ++y)
+            lit += texture(shadowMap, vec4(uv + vec2(x, y) * texelSize, float(cascade), ref));
+    float taps = float(2 * radius + 1);
+    return lit / (taps * taps);
+}
+
+// 平行光的受光比例，L为指向光源的单位向量；超出最后一级级联时不投射阴影
+float DirectionalShadow(vec3 worldPos, vec3 N, vec3 L) {
+    float viewDepth = -(view * vec4(worldPos, 1.0)).z;
+    int cascade = cascadeCount;
+    for (int i = 0; i < cascadeCount; ++i) {
+        if (viewDepth < cascadeSplits[i]) {
+            cascade = i;
+            break;
+        }
+    }
+    if (cascade >= cascadeCount) return 1.0;
+
+    // 正交投影，无需透视除法
+    vec3 projCoords = (lightSpaceMatrices[cascade] * vec4(worldPos, 1.0)).xyz * 0.5 + 0.5;
+    if (projCoords.z > 1.0) return 1.0;
+
+    // 斜率缩放bias：以一个纹素的深度跨度为基准，随表面与光线夹角增大
+    float cosTheta = clamp(dot(N, L), 0.0, 1.0);
+    float tanTheta = sqrt(1.0 - cosTheta * cosTheta) / max(cosTheta, 0.05);
+    float ref = projCoords.z - cascadeBias[cascade] * (1.0 + min(tanTheta, 10.0));
+    return CascadeLit(cascade, projCoords.xy, ref);
+}
+
+// 局部光源阴影，返回受光比例：法线偏移一个纹素后投影到tile，3x3 PCF且采样限制在tile内
+float AtlasShadow(int tile, vec3 worldPos, vec3 N, vec3 lightPos) {
+    ShadowTile t = shadowTiles[tile];
+    float distance = length(worldPos - lightPos);
+    vec4 p = t.matrix * vec4(worldPos + N * (t.params.x * distance * 1.5), 1.0);
+    if (p.w <= 0.0) return 1.0;
+    p.xyz /= p.w;
+    if (any(greaterThan(abs(p.xyz), vec3(1.0)))) return 1.0;
+
+    vec2 texel = 1.0 / vec2(textureSize(shadowAtlas, 0));
+    vec2 uv = (p.xy * 0.5 + 0.5) * t.rect.xy + t.rect.zw;
+    vec2 minUV = t.rect.zw + texel * 0.5;
+    vec2 maxUV = t.rect.zw + t.rect.xy - texel * 0.5;
+    float ref = p.z * 0.5 + 0.5 - 0.0001;
+    float lit = 0.0;
+    for (int x = -1; x <= 1; ++x)
+        for (int y = -1; y <= 1; ++y)
+            lit += texture(shadowAtlas, vec3(clamp(uv + vec2(x, y) * texel, minUV, maxUV), ref));
+    return lit / 9.0;
+}
+
+// 点光源：按主轴选择立方体面（+X -X +Y -Y +Z -Z）
+float PointShadow(int firstTile, vec3 worldPos, vec3 N, vec3 lightPos) {
+    if (firstTile < 0) return 1.0;
+    vec3 d = worldPos - lightPos;
+    vec3 a = abs(d);
+    int face = a.x >= a.y && a.x >= a.z ? (d.x > 0.0 ? 0 : 1)
+        : a.y >= a.z ? (d.y > 0.0 ? 2 : 3) : (d.z > 0.0 ? 4 : 5);
+    return AtlasShadow(firstTile + face, worldPos, N, lightPos);
+}
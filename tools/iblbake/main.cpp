@@ -0,0 +1,124 @@
+// iblbake：无GPU环境下批量烘焙IBL缓存
+// 用法：iblbake [选项] a.hdr b.hdr ...
+// 每个HDR旁生成 <hdr>.iblcache，运行时IBL直接加载（键与运行时计算方式相同）
+#include "IBLBaker.h"
+#include "IBLFormats.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void PrintUsage() {
+    std::cout <<
+        "usage: iblbake [options] <file.hdr>...\n"
+        "  --shaders <dir>       bake shader directory used for the cache key (default: shaders)\n"
+        "  --out <dir>           write caches into <dir> instead of next to each HDR\n"
+        "  --quality <tier>      fast | default | reference; the options below override the tier\n"
+        "  --env <size>          environment cubemap face size (default 512)\n"
+        "  --prefilter <size>    prefiltered specular face size (default 128)\n"
+        "  --mips <count>        prefiltered specular mip count (default 5)\n"
+        "  --irradiance <size>   irradiance cubemap face size (default 32)\n"
+        "  --brdf <size>         BRDF LUT size (default 512)\n"
+        "  --samples <count>     prefilter and BRDF samples per texel (default 1024)\n"
+        "  --no-mip-filter       sample the source mip 0 only when prefiltering\n"
+        "  --no-sh               bake an irradiance cubemap instead of SH coefficients\n"
+        "  --bc6h                also store BC6H-compressed env and prefilter blocks\n"
+        "  --threads <count>     worker threads (default: all hardware threads)\n";
+}
+
+int main(int argc, char** argv) {
+    // 先确定质量档位，其余选项在档位参数的基础上覆盖
+    IBLQuality quality = IBLQuality::Default;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--quality") != 0) continue;
+        std::string tier = argv[i + 1];
+        if (tier == "fast") quality = IBLQuality::Fast;
+        else if (tier == "reference") quality = IBLQuality::Reference;
+        else if (tier != "default") {
+            std::cerr << "iblbake: unknown quality tier " << tier << std::endl;
+            return 1;
+        }
+    }
+
+    IBLBakeParams params = IBLBakeParams::ForQuality(quality);
+    IBLBakeOptions options;
+    std::string shaderDir = "shaders";
+    std::string outDir;
+    std::vector<std::string> inputs;
+    bool bc6h = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--quality" && hasValue) ++i;
+        else if (arg == "--shaders" && hasValue) shaderDir = argv[++i];
+        else if (arg == "--out" && hasValue) outDir = argv[++i];
+        else if (arg == "--env" && hasValue) params.envSize = std::atoi(argv[++i]);
+        else if (arg == "--prefilter" && hasValue) params.prefilterSize = std::atoi(argv[++i]);
+        else if (arg == "--mips" && hasValue) params.prefilterMips = std::atoi(argv[++i]);
+        else if (arg == "--irradiance" && hasValue) params.irradianceSize = std::atoi(argv[++i]);
+        else if (arg == "--brdf" && hasValue) params.brdfSize = std::atoi(argv[++i]);
+        else if (arg == "--samples" && hasValue) params.prefilterSamples = params.brdfSamples = std::atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue) options.threads = (unsigned int)std::atoi(argv[++i]);
+        else if (arg == "--no-sh") params.shIrradiance = false;
+        else if (arg == "--no-mip-filter") params.mipFiltered = false;
+        else if (arg == "--bc6h") bc6h = true;
+        else if (arg == "--help" || arg == "-h") { PrintUsage(); return 0; }
+        else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "iblbake: unknown option " << arg << std::endl;
+            PrintUsage();
+            return 1;
+        }
+        else inputs.push_back(arg);
+    }
+    if (inputs.empty() || params.envSize <= 0 || params.prefilterSize <= 0 || params.prefilterMips <= 0 ||
+        params.irradianceSize <= 0 || params.brdfSize <= 0 || params.prefilterSamples <= 0) {
+        PrintUsage();
+        return 1;
+    }
+
+    // 着色器哈希必须与运行时一致，否则运行时会判定缓存过期并重新烘焙
+    params.shaderHash = IBLCache::HashBakeShaders(shaderDir);
+    IBLBaker baker(params, options);
+    std::cout << "iblbake: quality " << IBLBakeParams::QualityName(quality) << std::endl;
+
+    int failed = 0;
+    auto batchStart = std::chrono::steady_clock::now();
+    for (const std::string& input : inputs) {
+        uint64_t contentHash = 0;
+        IBLCacheData cache;
+        if (!IBLCache::HashFile(input, contentHash) || !baker.BakeFile(input, cache)) {
+            std::cerr << "iblbake: failed to bake " << input << std::endl;
+            ++failed;
+            continue;
+        }
+        baker.PrintStats();
+
+        if (bc6h) {
+            // 运行时以BC6H格式加载时直接上传这些块，不再在启动时编码
+            IBLImage env = IBLFormats::BuildMips(cache.env);
+            cache.envBC6H = IBLFormats::EncodeBC6H(env);
+            cache.prefilterBC6H = IBLFormats::EncodeBC6H(cache.prefilter);
+            std::cout << "iblbake: BC6H error env " << IBLFormats::FormatError(env, IBLFormat::BC6H) * 100.0
+                << "%, prefilter " << IBLFormats::FormatError(cache.prefilter, IBLFormat::BC6H) * 100.0 << "%" << std::endl;
+        }
+
+        std::string cachePath = IBLCache::CachePath(input);
+        if (!outDir.empty()) {
+            size_t slash = cachePath.find_last_of("/\\");
+            cachePath = outDir + "/" + (slash == std::string::npos ? cachePath : cachePath.substr(slash + 1));
+        }
+        if (!IBLCache::Save(cachePath, IBLCache::MakeKey(contentHash, params), cache)) {
+            ++failed;
+            continue;
+        }
+        std::cout << "iblbake: wrote " << cachePath << std::endl;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+    std::cout << "iblbake: " << (inputs.size() - failed) << "/" << inputs.size() << " environments in "
+        << seconds << " s" << std::endl;
+    return failed ? 1 : 0;
+}
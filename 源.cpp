@@ -6,52 +6,62 @@
 
 #include "Shader.h"
 #include "Model.h"
-#include "SceneManager.h"  // ͷļ
+#include "SceneManager.h"  // 场景管理器头文件
 #include "camera.h"
 #include "Light.h"
 #include <iostream>
 #include "ShadowMapper.h"
+#include "ShadowAtlas.h"
+#include "ClusteredLights.h"
+#include "DeferredRenderer.h"
+#include "IrradianceVolume.h"
+#include "Lightmapper.h"
 #include "IBL.h"
+#include "ProbeManager.h"
+#include "HotReloader.h"
+#include "ResidencyManager.h"
+#include "TextureStreamer.h"
+#include "BindlessTextures.h"
 
-// 
+// 窗口设置
 const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 720;
 
-// 
-//ʹ÷װõcamera
+// 相机设置
+//使用封装好的camera
 Camera* camera;
-IBL* iblSystem = nullptr;  // IBLϵͳ
+ProbeManager* probeManager = nullptr;  // 环境探针（IBL）
 
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 float brightness = 1.0f;
 
-// MSAA֡
+// MSAA帧缓冲对象
 unsigned int msaaFBO;
 unsigned int msaaColorBuffer;
 unsigned int msaaRBO;
 
-// ص
+// 回调函数声明
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void setupMSAAFramebuffer(unsigned int width, unsigned int height);
 void deleteMSAAFramebuffer();
 
-// ȫֱ
+// 全局变量区域添加
 static float normalStrength = 0.8f;
 static float aoStrength = 0.7f;
 int main() {
 
 
-    // 1. ʼGLFW
+    // 1. 初始化GLFW
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_SAMPLES, 4); // 4x MSAA
+    glfwWindowHint(GLFW_SAMPLES, 4); // 启用4x MSAA
 
-    // 2. 
+    // 2. 创建窗口
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "OpenGL Renderer", NULL, NULL);
     if (window == NULL) {
         std::cout << "Failed to create GLFW window" << std::endl;
@@ -64,74 +74,153 @@ int main() {
     glfwSetScrollCallback(window, scroll_callback);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-    // 3. ʼGLAD
+    // 3. 初始化GLAD
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // 分簇光源、辐照度体积和光照贴图使用16号以后的纹理单元（最高为光照贴图），GL 3.3只保证16个
+    GLint maxTextureUnits = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &maxTextureUnits);
+    if (maxTextureUnits <= (GLint)Lightmapper::LIGHTMAP_UNIT) {
+        std::cout << "ERROR::GL: " << maxTextureUnits << " fragment texture units, renderer needs "
+            << Lightmapper::LIGHTMAP_UNIT + 1 << std::endl;
+        glfwTerminate();
+        return -1;
+    }
 
-    // 4. ȫOpenGL״̬
+    // 4. 配置全局OpenGL状态
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_MULTISAMPLE); // öز
+    glEnable(GL_MULTISAMPLE); // 启用多重采样
 
-    // MSAA֡
+    // 创建MSAA帧缓冲
     setupMSAAFramebuffer(SCR_WIDTH, SCR_HEIGHT);
 
-    // 5. ɫ
-    Shader ourShader("shaders/shader.vert", "shaders/shader.frag");
-    // PBRɫ
-    Shader pbrShader("shaders/pbr.vert", "shaders/pbr.frag");
-    // ɫ
+    // 纹理后端：驱动支持ARB_bindless_texture时使用句柄表，否则保留绑定路径
+    std::vector<std::string> textureDefines;
+    if (BindlessTextures::Get().Init((GLADloadproc)glfwGetProcAddress))
+        textureDefines = BindlessTextures::ShaderDefines();
+
+    // 5. 创建着色器
+    Shader ourShader("shaders/shader.vert", "shaders/shader.frag", textureDefines);
+    // 创建PBR着色器（漫反射环境光使用球谐系数变体）
+    const bool useSHIrradiance = true;
+    std::vector<std::string> pbrDefines;
+    if (useSHIrradiance)
+        pbrDefines.push_back("SH_IRRADIANCE");
+    Shader pbrShader("shaders/pbr.vert", "shaders/pbr.frag", pbrDefines);
+    // 创建深度着色器
     Shader depthShader("shaders/depth.vert", "shaders/depth.frag");
+    // 延迟着色的几何阶段变体：材质采样相同，输出G-buffer
+    std::vector<std::string> gBufferDefines = textureDefines;
+    gBufferDefines.push_back("DEFERRED");
+    Shader ourGBufferShader("shaders/shader.vert", "shaders/shader.frag", gBufferDefines);
+    std::vector<std::string> pbrGBufferDefines = pbrDefines;
+    pbrGBufferDefines.push_back("DEFERRED");
+    Shader pbrGBufferShader("shaders/pbr.vert", "shaders/pbr.frag", pbrGBufferDefines);
 
 
 
-    // 6. 
+    // 6. 创建场景管理器并构建场景
     SceneManager scene;
 
-    // IBLʼ
-    iblSystem = new IBL("textures/industrial_workshop_foundry_4k.hdr");
-    
+    // IBL初始化
+    // 烘焙质量档位：Fast启动最快，Reference仅用于对比；需要各档位耗时/误差时打开报告
+    const IBLQuality iblQuality = IBLQuality::Default;
+    const IBLFormat iblFormat = IBLFormat::R11G11B10F;   // 立方体贴图存储格式（显存为RGB16F的一半）
+    const bool reportIBLQuality = false;
+    if (reportIBLQuality)
+        IBL::ReportQuality("textures/industrial_workshop_foundry_4k.hdr");
+    // 全局探针覆盖整个场景；局部探针按影响体积选择并与全局探针混合，在显存预算内按需异步加载
+    probeManager = new ProbeManager(useSHIrradiance, iblQuality, iblFormat);
+    int globalProbe = probeManager->SetGlobalProbe("textures/industrial_workshop_foundry_4k.hdr");
+    probeManager->SetBudget(64u * 1024u * 1024u);
+    // 动态反射探针：在车辆周围实时捕获场景，每帧最多用1ms GPU时间推进一个面或一级mip
+    const bool useDynamicProbe = true;
+    if (useDynamicProbe) {
+        AABB carProbeBounds;
+        carProbeBounds.Expand(glm::vec3(1.0f, -1.5f, -2.0f));
+        carProbeBounds.Expand(glm::vec3(5.0f, 2.0f, 2.0f));
+        int carProbe = probeManager->AddDynamicProbe(carProbeBounds, 0.5f, 128,
+            [&scene, &ourShader](const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position) {
+                ourShader.use();
+                ourShader.setMat4("projection", projection);
+                ourShader.setMat4("view", view);
+                ourShader.setVec3("viewPos", position);
+                // 簇按主相机划分，其他视图遍历全部光源
+                ourShader.setBool("clusteredLighting", false);
+                scene.RenderScene(ourShader, projection, view, brightness);
+            }, 1.0f);
+        probeManager->GetProbe(carProbe)->SetCapturePosition(glm::vec3(3.0f, 1.0f, 0.0f));
+    }
 
-    // Ӱӳ
+    // 创建阴影映射器（级联阴影）
     ShadowMapper shadowMapper;
-
-
-    //7.
+    ShadowCasterList shadowCasters;
+    // 点光源/聚光灯阴影图集
+    ShadowAtlas shadowAtlas;
+    // 分簇光源剔除：着色器只遍历片段所在簇的局部光源
+    ClusteredLights clusteredLights;
+    // 延迟着色：每帧按局部光源数量在前向与延迟之间选择（F7键切换 自动/前向/延迟）
+    DeferredRenderer deferredRenderer(SCR_WIDTH, SCR_HEIGHT);
+    enum class RenderPath { Auto, Forward, Deferred };
+    RenderPath renderPath = RenderPath::Auto;
+    const int deferredLightThreshold = 32;     // 自动模式下局部光源达到该数量时使用延迟着色
+    bool usedDeferred = false;                 // 上一帧实际使用的路径
+    // 辐照度体积：覆盖地面上方的静态场景，后台烘焙平行光和天空光（含两次反弹），静态几何变化时局部重新烘焙
+    AABB volumeBounds;
+    volumeBounds.Expand(glm::vec3(-5.0f, -1.4f, -5.0f));
+    volumeBounds.Expand(glm::vec3(5.0f, 3.0f, 5.0f));
+    IrradianceVolume irradianceVolume(volumeBounds, glm::ivec3(11, 5, 11));
+    irradianceVolume.SetSky(probeManager->GetProbe(globalProbe)->GetSH());
+
+
+    //7.创建摄像机
     camera = new Camera(window, glm::vec3(0.0f, 0.0f, 5.0f));
 
-    // 8.ʹôƽڵ
-    SceneNode& floorNode = scene.CreatePrimitiveNode("Floor", SceneManager::PrimitiveType::PLANE);
-    floorNode.SetPosition(glm::vec3(0.0f, -1.5f, 0.0f));
-    floorNode.SetScale(glm::vec3(5.0f, 1.0f, 5.0f)); // Ŵƽ
+    // 资源热重载（着色器/纹理/模型），模型加载完成（含懒加载）后登记
+    HotReloader hotReloader({ "shaders", "textures", "models" });
+    hotReloader.RegisterShader(&ourShader);
+    hotReloader.RegisterShader(&pbrShader);
+    hotReloader.RegisterShader(&depthShader);
+    hotReloader.RegisterShader(&ourGBufferShader);
+    hotReloader.RegisterShader(&pbrGBufferShader);
+    hotReloader.RegisterShader(deferredRenderer.GetLightingShader());
+    scene.SetModelLoadedCallback([&hotReloader](Model* model) { hotReloader.RegisterModel(model); });
+
+    // 8.使用代码生成平面节点
+    auto floorNode = scene.CreatePrimitiveNode("Floor", SceneManager::PrimitiveType::PLANE);
+    floorNode->SetPosition(glm::vec3(0.0f, -1.5f, 0.0f));
+    floorNode->SetScale(glm::vec3(5.0f, 1.0f, 5.0f)); // 放大平面
+    // 节点默认为静态阴影投射体；每帧运动的节点应调用SetStatic(false)，避免反复重绘静态阴影缓存
 
 
 
-    // 9.ģͽڵ
-    auto nanosuitNode = scene.CreateModelNode("Nanosuit", "models/nanosuit/nanosuit.obj");
+    // 9.创建主模型节点
+    auto nanosuitNode = scene.CreateModelNode("Nanosuit", "models/nanosuit/nanosuit.obj", true); // 懒加载
     nanosuitNode->SetPosition(glm::vec3(0.0f, -1.0f, 0.0f));
     nanosuitNode->SetScale(glm::vec3(0.4f));
 
-    //// ڶģͽڵ
+    //// 创建第二个模型节点
     //auto secondSuit = scene.CreateModelNode("SecondSuit", "models/nanosuit/nanosuit.obj");
     //secondSuit->SetPosition(glm::vec3(3.0f, -1.0f, 0.0f));
     //secondSuit->SetRotation(45.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-    // ڶģͽڵ㣨ʹPBRģͣ
+    // 创建第二个模型节点（使用PBR模型）
     auto secondSuit = scene.CreateModelNode("ToyCar", "models/ToyCar/glTF/ToyCar.gltf");
-    // ޸ʲã
-    //secondSuit->GetMaterial().metallic = 0.05f;  // ͽ
-    //secondSuit->GetMaterial().roughness = 0.85f; // ߴֲڶ
-    //secondSuit->GetMaterial().ao = 0.8f;        // ͻAOֵ
+    // 修复材质参数设置：
+    //secondSuit->GetMaterial().metallic = 0.05f;  // 极低金属度
+    //secondSuit->GetMaterial().roughness = 0.85f; // 高粗糙度
+    //secondSuit->GetMaterial().ao = 0.8f;        // 降低基础AO值
     secondSuit->SetPosition(glm::vec3(3.0f, 0.0f, 0.0f));
-    secondSuit->SetRotation(90.0f, glm::vec3(1.0f, 0.0f, 0.0f));  // Xת90
-    secondSuit->SetScale(glm::vec3(0.01f));  // С5%
-    //secondSuit->GetMaterial().isPBR = true;    // òΪPBR
+    secondSuit->SetRotation(90.0f, glm::vec3(1.0f, 0.0f, 0.0f));  // 绕X轴旋转90度
+    secondSuit->SetScale(glm::vec3(0.01f));  // 缩小到5%
+    //secondSuit->GetMaterial().isPBR = true;    // 设置材质为PBR
     //secondSuit->GetMaterial().metallic = 0.7f;
     //secondSuit->GetMaterial().roughness = 0.3f;
     //secondSuit->GetMaterial().ao = 1.0f;
-        // PBRʲ
+        // 设置PBR材质参数
     Material& carMaterial = secondSuit->GetMaterial();
     carMaterial.type = Material::PBR;
     carMaterial.metallic = 0.7f;
@@ -141,7 +230,7 @@ int main() {
     carMaterial.velvetRoughness = 0.85f;
     carMaterial.velvetMetallic = 0.05f;
 
-    // 10.ӹԴ
+    // 10.添加光源
     PointLight pointLights[2] = {
         {glm::vec3(2.0f, 1.5f, 1.0f), glm::vec3(0.1f), glm::vec3(0.8f, 0.8f, 0.6f), glm::vec3(1.0f), 1.0f, 0.09f, 0.032f},
         {glm::vec3(-3.0f, 1.5f, -2.0f), glm::vec3(0.1f), glm::vec3(0.6f, 0.8f, 0.8f), glm::vec3(1.0f), 1.0f, 0.09f, 0.032f}
@@ -154,36 +243,93 @@ int main() {
         glm::cos(glm::radians(17.5f)),
         1.0f, 0.09f, 0.032f
     };
+
+    // 光照贴图：地面为静态节点，后台烘焙平行光、两个点光源和天空光的直接/间接光照，结果缓存在磁盘；
+    // 烘焙完成后地面只采样光照贴图，不再计算阴影和遍历局部光源（相机聚光灯不再照亮地面）
+    Lightmapper lightmapper("scene.lightmap");
+    lightmapper.AddNode(floorNode);
+    for (int i = 0; i < 2; i++) {
+        PointLight light = pointLights[i];
+        light.diffuse *= 0.7f;      // 与分簇光源相同的强度
+        lightmapper.AddPointLight(light);
+    }
+    lightmapper.SetSky(probeManager->GetProbe(globalProbe)->GetSH());
+
+    // 登记投射阴影的局部光源
+    int pointShadowIds[2];
+    for (int i = 0; i < 2; i++)
+        pointShadowIds[i] = shadowAtlas.AddPointLight();
+    int spotShadowId = shadowAtlas.AddSpotLight();
+
      
-    bool enableSoftShadows = true;
-    bool softKeyPressed = false;//״̬־ֹظ
+    bool softKeyPressed = false;//按键状态标志防止重复触发
+    bool statsKeyPressed = false;
+    bool pathKeyPressed = false;
 
-    // ========== FIXED: ƽйⷽȫʹã ==========
+    // 显存预算：超出后按LRU降级纹理、释放几何
+    ResidencyManager::Get().SetBudget(256u * 1024u * 1024u);
+
+    // ========== FIXED: 定义平行光方向（全局使用） ==========
     glm::vec3 dirLightDirection = glm::normalize(glm::vec3(-0.5f, -1.0f, -0.5f));
 
-    // End. Ⱦѭ
+    // End. 渲染循环
     while (!glfwWindowShouldClose(window)) {
-        // ֡ʱ
+        // 计算帧时间
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        // 帧边界处理热重载，替换GL对象
+        hotReloader.ProcessPending();
+        ResidencyManager::Get().BeginFrame();
+        probeManager->Update(camera->Position);
         camera->ProcessKeyboard(deltaTime);
-        //¾۹Ƶλ
+        //更新聚光灯的位置
         spotLight.position = camera->Position;
         spotLight.direction = camera->Front;
 
-        // ӰлݼF1
+        // 阴影过滤切换快捷键（F1键）：硬阴影 -> PCF 3x3 -> PCF 5x5 -> EVSM
         if (glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS && !softKeyPressed) {
-            enableSoftShadows = !enableSoftShadows;
-            ourShader.setBool("enableSoftShadows", enableSoftShadows);
-            softKeyPressed = true;  // ǰѰ
-            std::cout << "Soft Shadows: " << (enableSoftShadows ? "ON" : "OFF") << std::endl;
+            shadowMapper.filter = (ShadowFilter)(((int)shadowMapper.filter + 1) % 4);
+            softKeyPressed = true;  // 标记按键已按下
+            std::cout << "Shadow Filter: " << ShadowMapper::FilterName(shadowMapper.filter) << std::endl;
         }
         if (glfwGetKey(window, GLFW_KEY_F1) == GLFW_RELEASE) {
-            softKeyPressed = false;  // ͷź״̬
+            softKeyPressed = false;  // 按键释放后重置状态
+        }
+        // 显存统计（F6键）
+        if (glfwGetKey(window, GLFW_KEY_F6) == GLFW_PRESS && !statsKeyPressed) {
+            ResidencyManager::Get().PrintStats();
+            TextureStreamer::Get().PrintStats();
+            probeManager->PrintStats();
+            shadowAtlas.PrintStats();
+            clusteredLights.PrintStats();
+            deferredRenderer.PrintStats();
+            irradianceVolume.PrintStats();
+            lightmapper.PrintStats();
+            std::cout << "RENDER PATH: " << (usedDeferred ? "deferred" : "forward") << ", "
+                << clusteredLights.GetLightCount() << " local lights" << std::endl;
+            std::cout << "SHADOWS: " << shadowMapper.GetStaticRedraws() << " static cascade redraws, "
+                << shadowCasters.dynamicBounds.size() << " dynamic casters" << std::endl;
+            const SceneNode::DepthStats& depthStats = scene.GetDepthStats();
+            std::cout << "DEPTH PASSES: " << depthStats.drawn << " node draws, " << depthStats.culled << " culled, "
+                << depthStats.alphaTested << " alpha-tested" << std::endl;
+            statsKeyPressed = true;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F6) == GLFW_RELEASE) {
+            statsKeyPressed = false;
+        }
+        // 渲染路径切换（F7键）：自动 -> 前向 -> 延迟
+        if (glfwGetKey(window, GLFW_KEY_F7) == GLFW_PRESS && !pathKeyPressed) {
+            renderPath = (RenderPath)(((int)renderPath + 1) % 3);
+            const char* names[3] = { "Auto", "Forward", "Deferred" };
+            std::cout << "Render Path: " << names[(int)renderPath] << std::endl;
+            pathKeyPressed = true;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F7) == GLFW_RELEASE) {
+            pathKeyPressed = false;
         }
 
-        // ȿ
+        // 亮度控制
         if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
             brightness += 0.1f;
             if (brightness > 3.0f) brightness = 3.0f;
@@ -195,37 +341,7 @@ int main() {
 
 
 
-        // ================== Ⱦͼ ==================
-        glViewport(0, 0, shadowMapper.SHADOW_WIDTH, shadowMapper.SHADOW_HEIGHT);
-        glBindFramebuffer(GL_FRAMEBUFFER, shadowMapper.depthMapFBO);
-        glClear(GL_DEPTH_BUFFER_BIT);
-
-        // ʹƽйⷽԴռ󣨹ؼ޸
-        glm::vec3 lightPos = -dirLightDirection * 10.0f; // ӷ10λԭ
-        // Դռ
-        glm::mat4 lightProjection = glm::ortho(-15.0f, 15.0f, -15.0f, 15.0f, 0.1f, 30.0f);
-        glm::mat4 lightView = glm::lookAt(lightPos,
-            glm::vec3(0.0f),
-            glm::vec3(0.0f, 1.0f, 0.0f));
-        glm::mat4 lightSpaceMatrix = lightProjection * lightView;
-
-        // ʹɫȾ
-        depthShader.use();
-        depthShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
-        //// ʱò
-        //glDisable(GL_TEXTURE_2D);
-        scene.RenderScene(depthShader);  // ע⣺нڵ㶼Ⱦ
-
-        // ================== Ⱦ ==================
-        //glEnable(GL_TEXTURE_2D);
-
-        // 󶨵MSAA֡
-        glBindFramebuffer(GL_FRAMEBUFFER, msaaFBO);
-        // 
-        glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // ͼ/ͶӰ
+        // 设置视图/投影矩阵
         glm::mat4 view = camera->GetViewMatrix();
         glm::mat4 projection = glm::perspective(
             glm::radians(camera->Zoom),
@@ -233,7 +349,62 @@ int main() {
             0.1f, 100.0f
         );
 
-        // Ⱦѭӣ֮
+        // 懒加载：可见或靠近相机的节点开始流送
+        scene.UpdateStreaming(camera->Position, projection * view);
+        // 纹理mip流送按主视图计算屏幕纹素密度
+        TextureStreamer::Get().SetView(camera->Position, glm::radians(camera->Zoom), SCR_HEIGHT);
+
+        // ================== 渲染深度贴图 ==================
+        // 级联阴影：按相机子视锥和投射体包围盒拟合各级光源矩阵，逐层渲染深度
+        // 静态投射体只在其所在级联失效时重绘，非静态节点每帧绘制在缓存之上
+        scene.CollectShadowCasters(shadowCasters);
+        shadowMapper.UpdateCascades(view, glm::radians(camera->Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT,
+            0.1f, 100.0f, dirLightDirection, shadowCasters.bounds);
+        shadowMapper.InvalidateStatic(shadowCasters.invalidated);
+        // 辐照度体积与静态阴影缓存使用相同的失效包围盒；平行光颜色不随brightness变化（与IBL环境光一致）
+        irradianceVolume.SetSun(dirLightDirection, glm::vec3(0.7f));
+        irradianceVolume.Invalidate(shadowCasters.invalidated);
+        irradianceVolume.Update(scene);
+        lightmapper.SetSun(dirLightDirection, glm::vec3(0.7f));
+        lightmapper.Invalidate(shadowCasters.invalidated);
+        lightmapper.Update(scene, deltaTime);
+        // 深度绘制按光源视锥剔除，只读位置流；透明度测试的材质单独分组
+        std::function<void(Shader&, const glm::mat4&)> drawDynamicCasters;
+        if (!shadowCasters.dynamicBounds.empty())
+            drawDynamicCasters = [&scene](Shader& shader, const glm::mat4& lightSpace) {
+                scene.RenderShadowCasters(shader, lightSpace, false);
+            };
+        shadowMapper.RenderCascades(depthShader,
+            [&scene](Shader& shader, const glm::mat4& lightSpace) { scene.RenderShadowCasters(shader, lightSpace, true); },
+            drawDynamicCasters);
+
+        // 局部光源阴影：按屏幕覆盖分配图集tile，每帧只重绘预算内变化的tile
+        // 点光源的六个面在支持视口数组时单遍绘制，节点按各面视锥剔除
+        for (int i = 0; i < 2; i++)
+            shadowAtlas.SetPointLight(pointShadowIds[i], pointLights[i]);
+        shadowAtlas.SetSpotLight(spotShadowId, spotLight);
+        shadowAtlas.Update(camera->Position, projection * view, glm::radians(camera->Zoom), SCR_HEIGHT,
+            shadowCasters.invalidated, shadowCasters.dynamicBounds);
+        shadowAtlas.Render(depthShader, [&scene](Shader& shader, const glm::mat4& lightSpace) {
+            scene.RenderShadowCasters(shader, lightSpace, true);
+            scene.RenderShadowCasters(shader, lightSpace, false);
+        }, [&scene](Shader& shader, const glm::mat4* faceMatrices) {
+            scene.RenderShadowCastersLayered(shader, faceMatrices);
+        });
+
+        // 局部光源按当前相机分簇（阴影tile在图集渲染后确定）
+        clusteredLights.Clear();
+        for (int i = 0; i < 2; i++) {
+            PointLight light = pointLights[i];
+            light.diffuse *= 0.7f;
+            light.specular *= 0.7f;
+            clusteredLights.AddPointLight(light, shadowAtlas.GetShadowTile(pointShadowIds[i]));
+        }
+        clusteredLights.AddSpotLight(spotLight, shadowAtlas.GetShadowTile(spotShadowId));
+        clusteredLights.Update(view, projection, 0.1f, 100.0f, SCR_WIDTH, SCR_HEIGHT);
+
+        // ================== 主场景渲染 ==================
+        // 渲染循环中添加（放在相机处理之后）
         if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS) {
             normalStrength = std::max(0.1f, normalStrength - 0.05f);
             std::cout << "Normal Strength: " << normalStrength << std::endl;
@@ -250,151 +421,172 @@ int main() {
             aoStrength = std::min(1.2f, aoStrength + 0.05f);
             std::cout << "AO Strength: " << aoStrength << std::endl;
         }
-        // ޸4ӻǿȣʹӰ
-        float ambientIntensity = 0.3f * brightness; // ̬
-
-        // ɫ
+        // 修改4：增加环境光强度，使阴影更明显
+        float ambientIntensity = 0.3f * brightness; // 动态调整环境光
+
+        // 相机uniform（前向着色器和G-buffer变体）
+        auto applyCamera = [&](Shader& shader) {
+            shader.setMat4("projection", projection);
+            shader.setMat4("view", view);
+            shader.setVec3("viewPos", camera->Position);
+        };
+        // 光照uniform：前向着色器和延迟光照阶段相同（Phong用dirLight，PBR用dirLightDirection/dirLightColor）
+        auto applyLights = [&](Shader& shader) {
+            shader.setFloat("brightness", brightness);
+            // 绑定级联阴影数组并传递各级光源矩阵
+            shadowMapper.Apply(shader);
+            shadowAtlas.Apply(shader);
+            // 1. 调整平行光参数使阴影更明显
+            shader.setVec3("dirLight.direction", dirLightDirection);
+            shader.setVec3("dirLight.ambient", glm::vec3(ambientIntensity));
+            shader.setVec3("dirLight.diffuse", glm::vec3(0.7f * brightness)); // 降低漫反射强度
+            shader.setVec3("dirLight.specular", glm::vec3(0.5f)); // 降低镜面反射强度
+            shader.setVec3("dirLightDirection", dirLightDirection);
+            shader.setVec3("dirLightColor", glm::vec3(0.7f * brightness));
+            // 2. 点光源/聚光灯：分簇光源表
+            clusteredLights.Apply(shader);
+            // 3. 烘焙的辐照度体积（环境光）
+            irradianceVolume.Apply(shader);
+        };
+        // PBR材质参数与按对象位置选择的环境探针
+        carMaterial.useVelvet = true;
+        carMaterial.velvetColor = glm::vec3(0.9f, 0.1f, 0.1f); // 深红色绒毛
+        glm::vec3 carPosition = glm::vec3(secondSuit->GetWorldTransform()[3]);
+        auto applyPBRMaterial = [&](Shader& shader) {
+            shader.setBool("useVelvet", carMaterial.useVelvet);
+            shader.setVec3("velvetColor", carMaterial.velvetColor);
+            shader.setFloat("velvetStrength", carMaterial.velvetStrength);
+            shader.setFloat("u_NormalStrength", normalStrength);
+            shader.setFloat("u_AOStrength", aoStrength);
+            probeManager->Apply(shader, probeManager->Select(carPosition));
+            // 设置材质遮罩参数
+            shader.setBool("useMaterialMask", carMaterial.useMaterialMask);
+            shader.setFloat("velvetRoughness", carMaterial.velvetRoughness);
+            shader.setFloat("velvetMetallic", carMaterial.velvetMetallic);
+        };
+
+        // 动态探针捕获沿用ourShader本帧的光照uniform，两条路径都要设置
         ourShader.use();
-
-
-        ourShader.setMat4("projection", projection);
-        ourShader.setMat4("view", view);
-        ourShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);  // ݹԴ
-        ourShader.setBool("enableSoftShadows", enableSoftShadows);
-        ourShader.setFloat("brightness", brightness);
-
-        // ӰͼԪ3
-        glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, shadowMapper.depthMap);
-        ourShader.setInt("shadowMap", 3);
-
-        // Դ
-        // 1. ƽйʹӰ
-        ourShader.setVec3("dirLight.direction", dirLightDirection);
-        ourShader.setVec3("dirLight.ambient", glm::vec3(ambientIntensity));
-        ourShader.setVec3("dirLight.diffuse", glm::vec3(0.7f * brightness)); // ǿ
-        ourShader.setVec3("dirLight.specular", glm::vec3(0.5f)); // ;淴ǿ
-        // 2. õԴ
-        for (int i = 0; i < 2; i++) {
-            std::string prefix = "pointLights[" + std::to_string(i) + "].";
-            ourShader.setVec3(prefix + "position", pointLights[i].position);
-            ourShader.setVec3(prefix + "ambient", pointLights[i].ambient);
-            ourShader.setVec3(prefix + "diffuse", pointLights[i].diffuse * 0.7f);
-            ourShader.setVec3(prefix + "specular", pointLights[i].specular * 0.7f);
-            ourShader.setFloat(prefix + "constant", pointLights[i].constant);
-            ourShader.setFloat(prefix + "linear", pointLights[i].linear);
-            ourShader.setFloat(prefix + "quadratic", pointLights[i].quadratic);
+        applyCamera(ourShader);
+        applyLights(ourShader);
+
+        // 渲染路径：局部光源多时延迟着色的光照开销只与像素数有关，少时前向着色省去G-buffer带宽
+        bool deferred = renderPath == RenderPath::Deferred ||
+            (renderPath == RenderPath::Auto && clusteredLights.GetLightCount() >= deferredLightThreshold);
+        usedDeferred = deferred;
+        if (deferred) {
+            // 几何阶段：只写表面属性（不透明物体）
+            deferredRenderer.BeginGeometryPass();
+            ourGBufferShader.use();
+            applyCamera(ourGBufferShader);
+            scene.RenderScene(ourGBufferShader, projection, view, brightness);
+            pbrGBufferShader.use();
+            applyCamera(pbrGBufferShader);
+            applyPBRMaterial(pbrGBufferShader);
+            // PBR环境光在几何阶段计算
+            irradianceVolume.Apply(pbrGBufferShader);
+            secondSuit->Draw(pbrGBufferShader);
+
+            // 光照阶段：直接写入默认帧缓冲，G-buffer不做多重采样
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            deferredRenderer.LightingPass(0, view, projection, camera->Position, applyLights);
         }
-        // 3. þ۹
-        ourShader.setVec3("spotLight.position", spotLight.position);
-        ourShader.setVec3("spotLight.direction", spotLight.direction);
-        ourShader.setVec3("spotLight.ambient", spotLight.ambient);
-        ourShader.setVec3("spotLight.diffuse", spotLight.diffuse);
-        ourShader.setVec3("spotLight.specular", spotLight.specular);
-        ourShader.setFloat("spotLight.cutOff", spotLight.cutOff);
-        ourShader.setFloat("spotLight.outerCutOff", spotLight.outerCutOff);
-        ourShader.setFloat("spotLight.constant", spotLight.constant);
-        ourShader.setFloat("spotLight.linear", spotLight.linear);
-        ourShader.setFloat("spotLight.quadratic", spotLight.quadratic);
-
-        // ȾPBRģ
-        scene.RenderScene(ourShader); 
-
-        // ȾPBRģ
-        pbrShader.use();
-        pbrShader.setBool("useVelvet", carMaterial.useVelvet);
-        carMaterial.useVelvet = true;
-        carMaterial.velvetColor = glm::vec3(0.9f, 0.1f, 0.1f); // ɫë
-        pbrShader.setVec3("velvetColor", carMaterial.velvetColor);
-        pbrShader.setFloat("velvetStrength", carMaterial.velvetStrength);
-
-        pbrShader.setFloat("u_NormalStrength", normalStrength);
-        pbrShader.setFloat("u_AOStrength", aoStrength);
-        pbrShader.setMat4("projection", projection);
-        pbrShader.setMat4("view", view);
-        pbrShader.setVec3("viewPos", camera->Position);
-
-        // IBLͼ
-        iblSystem->BindIrradianceMap(GL_TEXTURE10);
-        pbrShader.setInt("irradianceMap", 10);
-        iblSystem->BindPrefilterMap(GL_TEXTURE11);
-        pbrShader.setInt("prefilterMap", 11);
-        iblSystem->BindBRDFLUT(GL_TEXTURE12);
-        pbrShader.setInt("brdfLUT", 12);
-
-        for (int i = 0; i < 2; i++) {
-            pbrShader.setVec3("lightPositions[" + std::to_string(i) + "]", pointLights[i].position);
-            pbrShader.setVec3("lightColors[" + std::to_string(i) + "]", pointLights[i].diffuse * 0.8f);
+        else {
+            // 绑定到MSAA帧缓冲
+            glBindFramebuffer(GL_FRAMEBUFFER, msaaFBO);
+            // 清除缓冲
+            glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            // 渲染非PBR模型
+            ourShader.use();
+            scene.RenderScene(ourShader, projection, view, brightness);
+
+            // 渲染PBR模型
+            pbrShader.use();
+            applyCamera(pbrShader);
+            applyLights(pbrShader);
+            applyPBRMaterial(pbrShader);
+            secondSuit->Draw(pbrShader);
         }
 
-        // òֲ
-        pbrShader.setBool("useMaterialMask", carMaterial.useMaterialMask);
-        pbrShader.setFloat("velvetRoughness", carMaterial.velvetRoughness);
-        pbrShader.setFloat("velvetMetallic", carMaterial.velvetMetallic);
-        // Ⱦpbrģ
-        secondSuit->Draw(pbrShader);
-
+        // 动态探针分片捕获（沿用本帧已设置的光照uniform）
+        probeManager->UpdateDynamicProbes();
 
+        // 解析MSAA到默认帧缓冲
+        if (!deferred) {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, msaaFBO);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT,
+            GL_COLOR_BUFFER_BIT, GL_LINEAR); // 使用线性过滤
+        }
 
-        // MSAAĬ֡
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, msaaFBO);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT,
-        GL_COLOR_BUFFER_BIT, GL_LINEAR); // ʹԹ
+        // 本帧绘制结束：按本帧需求流送纹理mip，超预算时驱逐未使用的资源
+        TextureStreamer::Get().Update();
+        ResidencyManager::Get().EnforceBudget();
 
-        // 岢ѯ¼
+        // 交换缓冲并轮询事件
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
-    // End+1. Դ
+    // End+1. 清理资源
     deleteMSAAFramebuffer();
-    glfwTerminate();
     shadowMapper.Cleanup();
+    shadowAtlas.Cleanup();
+    clusteredLights.Cleanup();
+    deferredRenderer.Cleanup();
+    irradianceVolume.Cleanup();
+    lightmapper.Cleanup();
+    SceneNode::ReleaseProxy();
+    delete probeManager;  // 清理环境探针（各探针的IBL纹理和捕获帧缓冲）
+    probeManager = nullptr;
+    glfwTerminate();     // GL对象在上下文销毁前释放
     delete camera;
-    delete iblSystem;  // IBLϵͳ
     return 0;
 }
 
-// MSAA֡
+// 设置MSAA帧缓冲
 void setupMSAAFramebuffer(unsigned int width, unsigned int height) {
-    // ֡
+    // 创建帧缓冲
     glGenFramebuffers(1, &msaaFBO);
     glBindFramebuffer(GL_FRAMEBUFFER, msaaFBO);
 
-    // زɫ
+    // 创建多重采样颜色纹理
     glGenTextures(1, &msaaColorBuffer);
     glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, msaaColorBuffer);
     glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, 4, GL_RGB, width, height, GL_TRUE);
     glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, msaaColorBuffer, 0);
 
-    // ȾȺģ壩
+    // 创建渲染缓冲对象（深度和模板）
     glGenRenderbuffers(1, &msaaRBO);
     glBindRenderbuffer(GL_RENDERBUFFER, msaaRBO);
     glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_DEPTH24_STENCIL8, width, height);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, msaaRBO);
 
-    // 
+    // 检查完整性
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
         std::cout << "ERROR::MSAA Framebuffer not complete!" << std::endl;
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-// ɾMSAA֡Դ
+// 删除MSAA帧缓冲资源
 void deleteMSAAFramebuffer() {
     glDeleteFramebuffers(1, &msaaFBO);
     glDeleteTextures(1, &msaaColorBuffer);
     glDeleteRenderbuffers(1, &msaaRBO);
 }
 
-// ڴСص
+// 窗口大小调整回调
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     glViewport(0, 0, width, height);
 }
 
-// ƶص
+// 鼠标移动回调
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
 
     static float lastX = SCR_WIDTH / 2.0f;
@@ -402,14 +594,14 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
     float xpos = static_cast<float>(xposIn);
     float ypos = static_cast<float>(yposIn);
     float xoffset = xpos - lastX;
-    float yoffset = lastY - ypos; // עyᷴת
+    float yoffset = lastY - ypos; // 注意y轴反转
     lastX = xpos;
     lastY = ypos;
-    // ʹദƶ
+    // 使用相机类处理鼠标移动
     camera->ProcessMouseMovement(xoffset, yoffset);
 }
 
-// ֻص
+// 鼠标滚轮回调
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera->ProcessMouseScroll(static_cast<float>(yoffset));
 }